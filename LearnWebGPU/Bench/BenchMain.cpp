@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <charconv>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+#include "Benchmarks.hpp"
+
+namespace {
+    struct Benchmark {
+        const char *Name;
+        int (*Run)(const BenchOptions &options);
+    };
+
+    constexpr Benchmark Benchmarks[] = {
+        { "handles", [](const BenchOptions &) { return RunHandleBenchmark(); } },
+        { "culling", [](const BenchOptions &) { return RunCullingBenchmark(); } },
+        { "transforms", [](const BenchOptions &) { return RunTransformBenchmark(); } },
+        { "kernels", [](const BenchOptions &) { return RunKernelBenchmark(); } },
+        { "textures", [](const BenchOptions &) { return RunTextureBenchmark(); } },
+        { "frames", RunFrameBenchmark },
+    };
+
+    void PrintUsage(const char *program) {
+        std::cerr << "Usage: " << program << " [benchmark...] [options]\n";
+        std::cerr << "Options of the frame benchmark:\n";
+        std::cerr << "  --frames <count>         Frames measured per scene (500)\n";
+        std::cerr << "  --duration <seconds>     Measure each scene for this long instead\n";
+        std::cerr << "  --windowed               Render to a window and present\n";
+        std::cerr << "  --scene <name>           Only run this scene, may be repeated\n";
+        std::cerr << "  --json <path>            Save the results as JSON\n";
+        std::cerr << "  --baseline <path>        Fail if slower than these JSON results\n";
+        std::cerr << "  --threshold <fraction>   Tolerated slowdown of a median (0.05)\n";
+    }
+
+    template <typename T>
+    bool ParseNumber(std::string_view value, T &number) {
+        const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), number);
+        return error == std::errc() && end == value.data() + value.size();
+    }
+
+    bool ParseOptions(int argc, char **argv, BenchOptions &options, std::vector<std::string_view> &names) {
+        for (int i = 1; i < argc; ++i) {
+            const std::string_view arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            bool valid = true;
+            if (arg == "--frames" && hasValue) {
+                valid = ParseNumber(argv[++i], options.Frames) && options.Frames > 0;
+            } else if (arg == "--duration" && hasValue) {
+                valid = ParseNumber(argv[++i], options.Duration) && options.Duration > 0.0;
+            } else if (arg == "--windowed") {
+                options.Windowed = true;
+            } else if (arg == "--scene" && hasValue) {
+                options.Scenes.emplace_back(argv[++i]);
+            } else if (arg == "--json" && hasValue) {
+                options.JsonPath = argv[++i];
+            } else if (arg == "--baseline" && hasValue) {
+                options.BaselinePath = argv[++i];
+            } else if (arg == "--threshold" && hasValue) {
+                valid = ParseNumber(argv[++i], options.Threshold) && options.Threshold >= 0.0;
+            } else if (arg.substr(0, 2) == "--") {
+                valid = false;
+            } else {
+                names.push_back(arg);
+            }
+
+            if (!valid) {
+                std::cerr << "Invalid option: " << arg << '\n';
+                PrintUsage(argv[0]);
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+// Runs the benchmarks named on the command line, or all of them.
+int main(int argc, char **argv) {
+    BenchOptions options;
+    std::vector<std::string_view> names;
+    if (!ParseOptions(argc, argv, options, names)) {
+        return 1;
+    }
+
+    // Every name is checked before anything runs.
+    for (std::string_view name : names) {
+        const bool known = std::any_of(std::begin(Benchmarks), std::end(Benchmarks), [name](const Benchmark &benchmark) { return name == benchmark.Name; });
+        if (!known) {
+            std::cerr << "Unknown benchmark " << name << ", available:";
+            for (const Benchmark &benchmark : Benchmarks) {
+                std::cerr << ' ' << benchmark.Name;
+            }
+            std::cerr << '\n';
+            return 1;
+        }
+    }
+
+    int result = 0;
+    for (const Benchmark &benchmark : Benchmarks) {
+        const bool selected = names.empty() || std::find(names.begin(), names.end(), benchmark.Name) != names.end();
+        if (selected) {
+            result |= benchmark.Run(options);
+            std::cout << '\n';
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Each benchmark prints its results and returns a non-zero value when a
+// correctness check failed.
+
+/**
+ * Command line options of the benchmarks, see BenchMain.cpp. Only the frame
+ * benchmark uses them for now.
+ */
+struct BenchOptions {
+    // Frames measured per scene, after the warm-up.
+    uint32_t Frames = 500;
+    // Seconds measured per scene instead, when not 0.
+    double Duration = 0.0;
+    // Render to a window and present, rather than to an offscreen texture.
+    bool Windowed = false;
+    // Scenes of the frame benchmark, all of them when empty.
+    std::vector<std::string> Scenes;
+    // Save the results as JSON there.
+    std::string JsonPath;
+    // JSON results of a previous run to compare with. Any regression makes
+    // the benchmark fail.
+    std::string BaselinePath;
+    // Relative slowdown of a median tolerated before it counts as a
+    // regression, unless the run to run noise is larger.
+    double Threshold = 0.05;
+};
+
+int RunHandleBenchmark();
+int RunCullingBenchmark();
+int RunTransformBenchmark();
+int RunKernelBenchmark();
+int RunTextureBenchmark();
+int RunFrameBenchmark(const BenchOptions &options);
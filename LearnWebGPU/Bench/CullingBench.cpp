@@ -0,0 +1,82 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "Benchmarks.hpp"
+#include "FrustumCuller.hpp"
+#include "ThreadPool.hpp"
+
+// Culls a million random spheres with every supported kernel, on one thread
+// and on a thread pool, and checks that all of them agree with the scalar
+// version.
+
+namespace {
+    constexpr uint32_t ObjectCount = 1'000'000;
+    constexpr int Iterations = 50;
+}
+
+int RunCullingBenchmark() {
+    // Spread the objects around the frustum so that only some of them are
+    // visible and the compaction is not trivially predictable.
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<float> position(-1.5f, 1.5f);
+    std::uniform_real_distribution<float> depth(-0.5f, 1.5f);
+    std::uniform_real_distribution<float> radius(0.001f, 0.05f);
+
+    FrustumCuller culler;
+    culler.Reserve(ObjectCount);
+    for (uint32_t i = 0; i < ObjectCount; ++i) {
+        culler.Add({ { position(generator), position(generator), depth(generator) }, radius(generator) });
+    }
+
+    // Same mapping as the application's scene.
+    const float viewProjection[16] = {
+        1.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, 4.0f / 3.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 1.0f, 0.0f,
+        0.0f, 0.0f, 0.0f, 1.0f,
+    };
+    const Frustum frustum = MakeFrustum(viewProjection);
+
+    ThreadPool workers;
+    workers.Start();
+
+    std::vector<uint32_t> reference, visible;
+    culler.SetKernel(CullingKernel_Scalar);
+    culler.Cull(frustum, reference);
+
+    std::cout << "Culling benchmark (" << ObjectCount << " spheres, " << reference.size() << " visible, "
+              << workers.GetThreadCount() + 1 << " threads):\n";
+
+    int result = 0;
+    for (CullingKernel kernel : { CullingKernel_Scalar, CullingKernel_SSE, CullingKernel_AVX2 }) {
+        if (!culler.SetKernel(kernel)) {
+            std::cout << " - " << GetCullingKernelName(kernel) << ": not supported\n";
+            continue;
+        }
+
+        for (ThreadPool *pool : { static_cast<ThreadPool *>(nullptr), &workers }) {
+            culler.SetThreadPool(pool);
+
+            double best = 1e9, total = 0.0;
+            for (int i = 0; i < Iterations; ++i) {
+                culler.Cull(frustum, visible);
+                best = std::min(best, culler.GetStats().Seconds);
+                total += culler.GetStats().Seconds;
+            }
+
+            std::cout << " - " << GetCullingKernelName(kernel) << (pool ? ", thread pool: " : ", single thread: ")
+                      << best * 1000.0 << " ms best, " << total / Iterations * 1000.0 << " ms mean\n";
+
+            if (visible != reference) {
+                std::cerr << "The " << GetCullingKernelName(kernel) << " kernel disagrees with the scalar one!\n";
+                result = 1;
+            }
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,664 @@
+#include <GLFW/glfw3.h>
+#include <glfw3webgpu.h>
+
+#include <webgpu/webgpu.h>
+#include <webgpu/wgpu.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Async.hpp"
+#include "Benchmarks.hpp"
+#include "DeviceUtils.hpp"
+#include "DrawList.hpp"
+#include "FrameController.hpp"
+#include "GeometryPool.hpp"
+#include "GpuMemoryTracker.hpp"
+#include "GpuTimer.hpp"
+#include "MeshRegistry.hpp"
+#include "PipelineCache.hpp"
+#include "ReadbackRing.hpp"
+#include "Scene.hpp"
+#include "ShaderCache.hpp"
+#include "SurfaceManager.hpp"
+#include "ThreadPool.hpp"
+#include "WebGPUHandles.hpp"
+
+// Renders the scenes of the application frame after frame, the way
+// Application::RenderFrame() does, and reports the distribution of the CPU
+// time spent encoding, submitting and presenting each frame, and of its GPU
+// time when the adapter has timestamp queries. Headless runs render to an
+// offscreen texture and have no present time.
+//
+// With --json the results are saved, and with --baseline they are compared
+// with a previous run: a median counts as a regression when it is slower by
+// more than the threshold and by more than the noise of either run.
+
+namespace {
+    constexpr uint32_t Width = 640;
+    constexpr uint32_t Height = 480;
+    constexpr uint32_t FramesInFlight = 2;
+    // Lets the driver settle and the caches fill before measuring.
+    constexpr uint32_t WarmUpFrames = 30;
+    // A median beyond this many median absolute deviations is not noise.
+    constexpr double NoiseFactor = 3.0;
+
+    constexpr WGPUTextureFormat DepthFormat = WGPUTextureFormat_Depth24Plus;
+
+    struct Scene {
+        std::string Name;
+        SceneType Type = SceneType_Logo;
+        bool Depth = false;
+        // Built once the meshes are loaded.
+        std::vector<SceneObject> Objects;
+    };
+
+    // The scenes of the application, see BuildSceneObjects(). Overdraw and
+    // grid are measured as --depth draws them.
+    std::vector<Scene> CreateScenes() {
+        std::vector<Scene> scenes;
+        scenes.push_back({ "logo", SceneType_Logo, false, {} });
+        scenes.push_back({ "overdraw", SceneType_Overdraw, true, {} });
+        scenes.push_back({ "grid", SceneType_Grid, true, {} });
+        return scenes;
+    }
+
+    struct Distribution {
+        uint64_t Samples = 0;
+        // In milliseconds.
+        double Mean = 0.0;
+        double P50 = 0.0;
+        double P95 = 0.0;
+        double P99 = 0.0;
+        // Median absolute deviation, a measure of the noise that outliers do
+        // not inflate.
+        double Mad = 0.0;
+    };
+
+    double Percentile(const std::vector<double> &sorted, double fraction) {
+        const auto rank = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+        return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+    }
+
+    Distribution Summarize(std::vector<double> seconds) {
+        Distribution distribution;
+        if (seconds.empty()) {
+            return distribution;
+        }
+        for (double &value : seconds) {
+            value *= 1000.0;
+        }
+        std::sort(seconds.begin(), seconds.end());
+
+        distribution.Samples = seconds.size();
+        for (double value : seconds) {
+            distribution.Mean += value;
+        }
+        distribution.Mean /= seconds.size();
+        distribution.P50 = Percentile(seconds, 0.50);
+        distribution.P95 = Percentile(seconds, 0.95);
+        distribution.P99 = Percentile(seconds, 0.99);
+
+        std::vector<double> deviations;
+        deviations.reserve(seconds.size());
+        for (double value : seconds) {
+            deviations.push_back(std::abs(value - distribution.P50));
+        }
+        std::sort(deviations.begin(), deviations.end());
+        distribution.Mad = Percentile(deviations, 0.50);
+        return distribution;
+    }
+
+    struct Result {
+        std::string Scene;
+        std::string Metric;
+        Distribution Times;
+    };
+
+    struct FrameSamples {
+        // Everything from the start of the frame to the end of the present,
+        // including waits for the GPU.
+        std::vector<double> Frame;
+        std::vector<double> Encode;
+        std::vector<double> Submit;
+        std::vector<double> Present;
+        std::vector<double> Gpu;
+    };
+
+    struct Context {
+        WGPUDevice Device = nullptr;
+        FrameController *Frames = nullptr;
+        ReadbackRing *Readback = nullptr;
+        GpuTimer *Timer = nullptr;
+        GeometryPool *Geometry = nullptr;
+        DrawList *Draws = nullptr;
+        const MeshRegistry *Meshes = nullptr;
+        // Windowed runs present to the surface, headless ones render here.
+        SurfaceManager *Surface = nullptr;
+        WGPUTextureView OffscreenView = nullptr;
+        WGPUTextureView DepthView = nullptr;
+    };
+
+    double Since(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void RenderFrame(const Context &context, const Scene &scene, WGPURenderPipeline pipeline, FrameSamples *samples) {
+        const auto frameStart = std::chrono::steady_clock::now();
+
+        context.Frames->BeginFrame();
+        context.Readback->Collect();
+        double gpuSeconds = 0.0;
+        if (context.Timer->Collect(gpuSeconds) && samples) {
+            samples->Gpu.push_back(gpuSeconds);
+        }
+
+        SurfaceFrame frame;
+        if (context.Surface) {
+            glfwPollEvents();
+            if (!context.Surface->AcquireNextFrame(frame)) {
+                return;
+            }
+        }
+
+        const auto encodeStart = std::chrono::steady_clock::now();
+        WGPUCommandEncoderDescriptor encoderDesc = {};
+        encoderDesc.nextInChain = nullptr;
+        encoderDesc.label = "Frame benchmark encoder";
+        CommandEncoderHandle encoder(wgpuDeviceCreateCommandEncoder(context.Device, &encoderDesc));
+
+        context.Timer->BeginFrame();
+
+        WGPURenderPassColorAttachment colorAttachment = {};
+        colorAttachment.view = context.Surface ? frame.View.Get() : context.OffscreenView;
+        colorAttachment.resolveTarget = nullptr;
+        colorAttachment.loadOp = WGPULoadOp_Clear;
+        colorAttachment.storeOp = WGPUStoreOp_Store;
+        colorAttachment.clearValue = WGPUColor{ 0.9, 0.1, 0.2, 1.0 };
+
+        WGPURenderPassDepthStencilAttachment depthStencilAttachment = {};
+        depthStencilAttachment.view = context.DepthView;
+        depthStencilAttachment.depthClearValue = 1.0f;
+        depthStencilAttachment.depthLoadOp = WGPULoadOp_Clear;
+        depthStencilAttachment.depthStoreOp = WGPUStoreOp_Discard;
+        depthStencilAttachment.depthReadOnly = false;
+        depthStencilAttachment.stencilLoadOp = WGPULoadOp_Undefined;
+        depthStencilAttachment.stencilStoreOp = WGPUStoreOp_Undefined;
+        depthStencilAttachment.stencilReadOnly = true;
+
+        WGPURenderPassDescriptor renderPassDesc = {};
+        renderPassDesc.nextInChain = nullptr;
+        renderPassDesc.label = "Frame benchmark pass";
+        renderPassDesc.colorAttachmentCount = 1;
+        renderPassDesc.colorAttachments = &colorAttachment;
+        renderPassDesc.depthStencilAttachment = scene.Depth ? &depthStencilAttachment : nullptr;
+        renderPassDesc.timestampWrites = context.Timer->GetPassWrites();
+
+        RenderPassEncoderHandle renderPass(wgpuCommandEncoderBeginRenderPass(encoder, &renderPassDesc));
+        wgpuRenderPassEncoderSetPipeline(renderPass, pipeline);
+        context.Draws->Clear();
+        for (const SceneObject &object : scene.Objects) {
+            DrawData draw;
+            draw.Transform = object.Transform;
+            for (GeometryHandle part : context.Meshes->Get(object.Mesh).Parts) {
+                context.Draws->Add(part, draw);
+            }
+        }
+        if (scene.Depth) {
+            context.Draws->SortFrontToBack();
+        }
+        context.Draws->Submit(renderPass, *context.Geometry);
+        wgpuRenderPassEncoderEnd(renderPass);
+        renderPass.Reset();
+
+        context.Timer->Resolve(encoder);
+
+        WGPUCommandBufferDescriptor commandBufferDesc = {};
+        commandBufferDesc.nextInChain = nullptr;
+        commandBufferDesc.label = "Frame benchmark commands";
+        CommandBufferHandle command(wgpuCommandEncoderFinish(encoder, &commandBufferDesc));
+        encoder.Reset();
+        const double encodeSeconds = Since(encodeStart);
+
+        const auto submitStart = std::chrono::steady_clock::now();
+        context.Frames->Submit(command);
+        context.Readback->OnSubmitted();
+        const double submitSeconds = Since(submitStart);
+
+        const auto presentStart = std::chrono::steady_clock::now();
+        if (context.Surface) {
+            context.Surface->Present(frame);
+        }
+        const double presentSeconds = Since(presentStart);
+
+        if (samples) {
+            samples->Encode.push_back(encodeSeconds);
+            samples->Submit.push_back(submitSeconds);
+            if (context.Surface) {
+                samples->Present.push_back(presentSeconds);
+            }
+            samples->Frame.push_back(Since(frameStart));
+        }
+    }
+
+    void PrintResult(const Result &result) {
+        const Distribution &times = result.Times;
+        std::cout << " - " << result.Scene << ' ' << result.Metric << ": mean " << times.Mean << " ms, p50 " << times.P50
+                  << " ms, p95 " << times.P95 << " ms, p99 " << times.P99 << " ms (" << times.Samples << " samples)\n";
+    }
+
+    bool WriteResults(const std::string &path, const std::string &adapterName, bool windowed, const std::vector<Result> &results) {
+        std::ofstream file(path);
+        if (!file.is_open()) {
+            std::cerr << "Could not write " << path << "!\n";
+            return false;
+        }
+
+        // One result per line, which is what ReadBaseline() expects.
+        file << "{\n";
+        file << "  \"benchmark\": \"frames\",\n";
+        file << "  \"adapter\": \"" << adapterName << "\",\n";
+        file << "  \"windowed\": " << (windowed ? "true" : "false") << ",\n";
+        file << "  \"width\": " << Width << ",\n";
+        file << "  \"height\": " << Height << ",\n";
+        file << "  \"results\": [";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result &result = results[i];
+            const Distribution &times = result.Times;
+            file << (i == 0 ? "\n" : ",\n") << "    { \"scene\": \"" << result.Scene << "\", \"metric\": \"" << result.Metric
+                 << "\", \"samples\": " << times.Samples << ", \"mean_ms\": " << times.Mean << ", \"p50_ms\": " << times.P50
+                 << ", \"p95_ms\": " << times.P95 << ", \"p99_ms\": " << times.P99 << ", \"mad_ms\": " << times.Mad << " }";
+        }
+        file << (results.empty() ? "]" : "\n  ]") << "\n}\n";
+        return file.good();
+    }
+
+    bool FindString(const std::string &line, const char *key, std::string &value) {
+        const std::string pattern = std::string("\"") + key + "\": \"";
+        const size_t start = line.find(pattern);
+        if (start == std::string::npos) {
+            return false;
+        }
+        const size_t first = start + pattern.size();
+        const size_t last = line.find('"', first);
+        if (last == std::string::npos) {
+            return false;
+        }
+        value = line.substr(first, last - first);
+        return true;
+    }
+
+    bool FindNumber(const std::string &line, const char *key, double &value) {
+        const std::string pattern = std::string("\"") + key + "\": ";
+        const size_t start = line.find(pattern);
+        if (start == std::string::npos) {
+            return false;
+        }
+        const char *first = line.c_str() + start + pattern.size();
+        char *last = nullptr;
+        value = std::strtod(first, &last);
+        return last != first;
+    }
+
+    // Reads back what WriteResults() wrote, not arbitrary JSON.
+    bool ReadBaseline(const std::string &path, std::vector<Result> &results) {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            std::cerr << "Could not read the baseline " << path << "!\n";
+            return false;
+        }
+        std::string line;
+        while (std::getline(file, line)) {
+            Result result;
+            if (FindString(line, "scene", result.Scene) && FindString(line, "metric", result.Metric)
+                && FindNumber(line, "p50_ms", result.Times.P50) && FindNumber(line, "mad_ms", result.Times.Mad)) {
+                FindNumber(line, "mean_ms", result.Times.Mean);
+                results.push_back(std::move(result));
+            }
+        }
+        return true;
+    }
+
+    // Returns the number of regressions.
+    int CompareWithBaseline(const std::vector<Result> &results, const std::vector<Result> &baseline, double threshold) {
+        std::cout << "Comparison with the baseline (threshold " << threshold * 100.0 << "%):\n";
+        int regressions = 0;
+        for (const Result &result : results) {
+            const auto found = std::find_if(baseline.begin(), baseline.end(), [&result](const Result &candidate) {
+                return candidate.Scene == result.Scene && candidate.Metric == result.Metric;
+            });
+            if (found == baseline.end()) {
+                std::cout << " - " << result.Scene << ' ' << result.Metric << ": not in the baseline\n";
+                continue;
+            }
+
+            const double before = found->Times.P50;
+            const double after = result.Times.P50;
+            const double tolerance = std::max(threshold * before, NoiseFactor * std::max(found->Times.Mad, result.Times.Mad));
+            const bool regressed = after > before + tolerance;
+            regressions += regressed ? 1 : 0;
+
+            std::cout << " - " << result.Scene << ' ' << result.Metric << ": p50 " << after << " ms vs " << before << " ms";
+            if (before > 0.0) {
+                std::cout << " (" << (after - before) / before * 100.0 << "%)";
+            }
+            std::cout << (regressed ? ", REGRESSION" : "") << '\n';
+        }
+        return regressions;
+    }
+
+    TextureHandle CreateTarget(WGPUDevice device, GpuMemoryTracker &memory, WGPUTextureFormat format, const char *label) {
+        WGPUTextureDescriptor textureDesc = {};
+        textureDesc.nextInChain = nullptr;
+        textureDesc.label = label;
+        textureDesc.dimension = WGPUTextureDimension_2D;
+        textureDesc.format = format;
+        textureDesc.mipLevelCount = 1;
+        textureDesc.sampleCount = 1;
+        textureDesc.size = { Width, Height, 1 };
+        textureDesc.usage = WGPUTextureUsage_RenderAttachment;
+        textureDesc.viewFormatCount = 1;
+        textureDesc.viewFormats = &format;
+        return memory.CreateTexture(device, textureDesc, GpuMemoryCategory_Texture);
+    }
+
+    TextureViewHandle CreateView(WGPUTexture texture, WGPUTextureFormat format, WGPUTextureAspect aspect) {
+        WGPUTextureViewDescriptor viewDesc = {};
+        viewDesc.nextInChain = nullptr;
+        viewDesc.label = "Frame benchmark view";
+        viewDesc.format = format;
+        viewDesc.dimension = WGPUTextureViewDimension_2D;
+        viewDesc.baseMipLevel = 0;
+        viewDesc.mipLevelCount = 1;
+        viewDesc.baseArrayLayer = 0;
+        viewDesc.arrayLayerCount = 1;
+        viewDesc.aspect = aspect;
+        return TextureViewHandle(wgpuTextureCreateView(texture, &viewDesc));
+    }
+}
+
+int RunFrameBenchmark(const BenchOptions &options) {
+    std::vector<Scene> scenes = CreateScenes();
+    if (!options.Scenes.empty()) {
+        for (const std::string &name : options.Scenes) {
+            if (std::none_of(scenes.begin(), scenes.end(), [&name](const Scene &scene) { return scene.Name == name; })) {
+                std::cerr << "Frame benchmark: unknown scene " << name << ", available: logo overdraw grid\n";
+                return 1;
+            }
+        }
+        std::erase_if(scenes, [&options](const Scene &scene) {
+            return std::find(options.Scenes.begin(), options.Scenes.end(), scene.Name) == options.Scenes.end();
+        });
+    }
+
+    GLFWwindow *window = nullptr;
+    if (options.Windowed) {
+        if (!glfwInit()) {
+            std::cout << "Frame benchmark: skipped, could not initialize GLFW\n";
+            return 0;
+        }
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+        glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+        window = glfwCreateWindow(Width, Height, "Frame benchmark", nullptr, nullptr);
+        if (!window) {
+            std::cout << "Frame benchmark: skipped, could not open a window\n";
+            glfwTerminate();
+            return 0;
+        }
+    }
+    // Every early return below goes through here.
+    auto closeWindow = [&window] {
+        if (window) {
+            glfwDestroyWindow(window);
+            glfwTerminate();
+            window = nullptr;
+        }
+    };
+
+    InstanceHandle instance(wgpuCreateInstance(nullptr));
+    if (!instance) {
+        std::cout << "Frame benchmark: skipped, could not initialize WebGPU\n";
+        closeWindow();
+        return 0;
+    }
+    SurfaceHandle surface;
+    if (window) {
+        surface.Reset(glfwGetWGPUSurface(instance, window));
+    }
+
+    WGPURequestAdapterOptions adapterOpts = {};
+    adapterOpts.nextInChain = nullptr;
+    adapterOpts.compatibleSurface = surface;
+    adapterOpts.powerPreference = WGPUPowerPreference_HighPerformance;
+    AdapterHandle adapter(RequestAdapterSync(instance, &adapterOpts));
+    if (!adapter) {
+        std::cout << "Frame benchmark: skipped, no adapter\n";
+        surface.Reset();
+        closeWindow();
+        return 0;
+    }
+
+    WGPUAdapterProperties properties = {};
+    properties.nextInChain = nullptr;
+    wgpuAdapterGetProperties(adapter, &properties);
+    const std::string adapterName = properties.name ? properties.name : "unknown";
+
+    // GPU times need timestamp queries, the CPU times do not.
+    std::vector<WGPUFeatureName> requiredFeatures;
+    if (wgpuAdapterHasFeature(adapter, WGPUFeatureName_TimestampQuery)) {
+        requiredFeatures.push_back(WGPUFeatureName_TimestampQuery);
+    }
+
+    // The default limits are enough for the logo and 1024 draws.
+    WGPUDeviceDescriptor deviceDesc = {};
+    deviceDesc.nextInChain = nullptr;
+    deviceDesc.label = "Frame benchmark device";
+    deviceDesc.requiredFeatureCount = requiredFeatures.size();
+    deviceDesc.requiredFeatures = requiredFeatures.data();
+    deviceDesc.defaultQueue.nextInChain = nullptr;
+    deviceDesc.defaultQueue.label = "Frame benchmark queue";
+    DeviceHandle device(RequestDeviceSync(instance, adapter, &deviceDesc));
+    if (!device) {
+        std::cout << "Frame benchmark: skipped, no device\n";
+        surface.Reset();
+        closeWindow();
+        return 0;
+    }
+    QueueHandle queue(wgpuDeviceGetQueue(device));
+
+    // Frame completions, readbacks and pipelines all resume through it.
+    EventPump pump;
+    pump.Initialize(instance);
+    pump.AddDevice(device);
+
+    GpuMemoryTracker memory;
+    FrameController frames;
+    ReadbackRing readback;
+    GpuTimer timer;
+    DrawList drawList;
+    GeometryPool geometry;
+    SurfaceManager surfaceManager;
+    ThreadPool workers;
+    ShaderCache shaderCache;
+    PipelineCache pipelines;
+    MeshRegistry meshes;
+    TextureHandle offscreenTexture, depthTexture;
+    TextureViewHandle offscreenView, depthView;
+    PipelineLayoutHandle pipelineLayout;
+    int result = 0;
+
+    const WGPUTextureFormat colorFormat = surface ? wgpuSurfaceGetPreferredFormat(surface, adapter) : WGPUTextureFormat_BGRA8Unorm;
+
+    bool initialized = frames.Initialize(device, queue, pump, memory, FramesInFlight, DrawList::GetFrameBytes(DrawList::DefaultMaxDraws))
+        && readback.Initialize(device, pump, memory)
+        && drawList.Initialize(device, frames);
+    if (initialized) {
+        // Measured without GPU times rather than skipped.
+        if (!timer.Initialize(device, memory, readback)) {
+            std::cout << "Frame benchmark: no timestamp queries, GPU times will not be measured\n";
+        }
+
+        GeometryPoolDescriptor poolDesc;
+        poolDesc.VertexStride = SceneVertexStride;
+        poolDesc.VertexCapacity = 1 << 16;
+        poolDesc.IndexCapacity = 1 << 18;
+        initialized = geometry.Initialize(device, queue, memory, poolDesc);
+        if (initialized) {
+            meshes.Initialize(geometry, SceneVertexStride, {});
+            initialized = meshes.Load("Resources/Models/webgpu.txt") != InvalidMeshId;
+        }
+        for (Scene &scene : scenes) {
+            scene.Objects = BuildSceneObjects(scene.Type, meshes);
+        }
+    }
+    if (initialized) {
+        if (surface) {
+            // Without vsync when possible, or every frame would take a
+            // refresh interval.
+            WGPUSurfaceCapabilities capabilities = {};
+            capabilities.nextInChain = nullptr;
+            wgpuSurfaceGetCapabilities(surface, adapter, &capabilities);
+            WGPUPresentMode presentMode = WGPUPresentMode_Fifo;
+            for (size_t i = 0; i < capabilities.presentModeCount; ++i) {
+                if (capabilities.presentModes[i] == WGPUPresentMode_Immediate) {
+                    presentMode = WGPUPresentMode_Immediate;
+                }
+            }
+            wgpuSurfaceCapabilitiesFreeMembers(capabilities);
+            initialized = surfaceManager.Initialize(device, surface, colorFormat, Width, Height, presentMode);
+        } else {
+            offscreenTexture = CreateTarget(device, memory, colorFormat, "Frame benchmark target");
+            initialized = static_cast<bool>(offscreenTexture);
+            if (initialized) {
+                offscreenView = CreateView(offscreenTexture, colorFormat, WGPUTextureAspect_All);
+            }
+        }
+        depthTexture = CreateTarget(device, memory, DepthFormat, "Frame benchmark depth");
+        initialized = initialized && depthTexture;
+        if (initialized) {
+            depthView = CreateView(depthTexture, DepthFormat, WGPUTextureAspect_DepthOnly);
+        }
+    }
+    if (!initialized) {
+        std::cerr << "Frame benchmark: could not create the frame resources!\n";
+        result = 1;
+    }
+
+    if (result == 0) {
+        workers.Start();
+        shaderCache.Initialize(device);
+        pipelines.Initialize(device, shaderCache, workers, pump);
+
+        WGPUBindGroupLayout bindGroupLayout = drawList.GetBindGroupLayout();
+        WGPUPipelineLayoutDescriptor layoutDesc = {};
+        layoutDesc.nextInChain = nullptr;
+        layoutDesc.label = "Frame benchmark pipeline layout";
+        layoutDesc.bindGroupLayoutCount = 1;
+        layoutDesc.bindGroupLayouts = &bindGroupLayout;
+        pipelineLayout.Reset(wgpuDeviceCreatePipelineLayout(device, &layoutDesc));
+
+        Context context;
+        context.Device = device;
+        context.Frames = &frames;
+        context.Readback = &readback;
+        context.Timer = &timer;
+        context.Geometry = &geometry;
+        context.Draws = &drawList;
+        context.Meshes = &meshes;
+        context.Surface = surface ? &surfaceManager : nullptr;
+        context.OffscreenView = offscreenView;
+        context.DepthView = depthView;
+
+        std::cout << "Frame benchmark (" << adapterName << ", " << (surface ? "windowed" : "headless") << ", " << Width << 'x' << Height << "):\n";
+        std::vector<Result> results;
+        for (const Scene &scene : scenes) {
+            const WGPURenderPipeline pipeline = pipelines.Wait(pipelines.Request(GetScenePipelineState(colorFormat, scene.Depth ? DepthFormat : WGPUTextureFormat_Undefined, pipelineLayout)));
+            if (!pipeline) {
+                std::cerr << "Frame benchmark: could not create the pipeline of " << scene.Name << "!\n";
+                result = 1;
+                break;
+            }
+
+            for (uint32_t i = 0; i < WarmUpFrames; ++i) {
+                RenderFrame(context, scene, pipeline, nullptr);
+            }
+
+            FrameSamples samples;
+            const auto start = std::chrono::steady_clock::now();
+            for (uint32_t frame = 0;; ++frame) {
+                const bool done = options.Duration > 0.0 ? Since(start) >= options.Duration : frame >= options.Frames;
+                if (done || (window && glfwWindowShouldClose(window))) {
+                    break;
+                }
+                RenderFrame(context, scene, pipeline, &samples);
+            }
+
+            // The last GPU times are still in flight.
+            frames.WaitIdle();
+            readback.Flush();
+            double gpuSeconds = 0.0;
+            if (timer.Collect(gpuSeconds)) {
+                samples.Gpu.push_back(gpuSeconds);
+            }
+
+            const size_t first = results.size();
+            results.push_back({ scene.Name, "frame", Summarize(samples.Frame) });
+            results.push_back({ scene.Name, "encode", Summarize(samples.Encode) });
+            results.push_back({ scene.Name, "submit", Summarize(samples.Submit) });
+            if (!samples.Present.empty()) {
+                results.push_back({ scene.Name, "present", Summarize(samples.Present) });
+            }
+            if (!samples.Gpu.empty()) {
+                results.push_back({ scene.Name, "gpu", Summarize(samples.Gpu) });
+            }
+            for (size_t i = first; i < results.size(); ++i) {
+                PrintResult(results[i]);
+            }
+        }
+
+        if (result == 0 && !options.JsonPath.empty() && !WriteResults(options.JsonPath, adapterName, static_cast<bool>(surface), results)) {
+            result = 1;
+        }
+        if (result == 0 && !options.BaselinePath.empty()) {
+            std::vector<Result> baseline;
+            if (!ReadBaseline(options.BaselinePath, baseline)) {
+                result = 1;
+            } else if (CompareWithBaseline(results, baseline, options.Threshold) > 0) {
+                std::cerr << "Frame times regressed against the baseline!\n";
+                result = 1;
+            }
+        }
+    }
+
+    frames.WaitIdle();
+    pipelines.Terminate();
+    pipelineLayout.Reset();
+    shaderCache.Terminate();
+    timer.Terminate();
+    readback.Terminate();
+    drawList.Terminate();
+    meshes.Terminate();
+    geometry.Terminate();
+    depthView.Reset();
+    offscreenView.Reset();
+    memory.Release(depthTexture);
+    memory.Release(offscreenTexture);
+    surfaceManager.Terminate();
+    frames.Terminate();
+    queue.Reset();
+    pump.RemoveDevice(device);
+    device.Reset();
+    adapter.Reset();
+    surface.Reset();
+    instance.Reset();
+    closeWindow();
+
+    return result;
+}
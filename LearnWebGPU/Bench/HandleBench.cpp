@@ -0,0 +1,127 @@
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Benchmarks.hpp"
+#include "WebGPUHandles.hpp"
+
+// Compares the per-frame pattern of the render loop (create an encoder, a
+// pass and a command buffer, pass them around, release them) written with
+// raw handles and with Handle. The objects are fake so that the benchmark
+// measures the wrapper and nothing else, and it counts every release to
+// check that moving handles around never touches the reference count.
+
+// MSVC ignores attributes from the gnu namespace.
+#ifdef _MSC_VER
+#define LEARNWEBGPU_NOINLINE __declspec(noinline)
+#else
+#define LEARNWEBGPU_NOINLINE [[gnu::noinline]]
+#endif
+
+namespace {
+    struct FakeObject {
+        uint64_t Value = 0;
+    };
+
+    uint64_t g_ReleaseCount = 0;
+
+    // Keep the compiler from optimizing the handles away.
+    LEARNWEBGPU_NOINLINE void Use(FakeObject *object) {
+        object->Value += 1;
+    }
+
+    LEARNWEBGPU_NOINLINE void ReleaseFake(FakeObject *object) {
+        ++g_ReleaseCount;
+        object->Value = 0;
+    }
+}
+
+template <>
+struct HandleTraits<FakeObject *> {
+    static void Release(FakeObject *object) { ReleaseFake(object); }
+    LEARNWEBGPU_HANDLE_COUNTER(FakeObject)
+};
+
+using FakeHandle = Handle<FakeObject *>;
+
+static_assert(sizeof(FakeHandle) == sizeof(FakeObject *));
+static_assert(std::is_nothrow_move_constructible_v<FakeHandle>);
+static_assert(!std::is_copy_constructible_v<FakeHandle>);
+
+namespace {
+    constexpr int Frames = 2'000'000;
+    constexpr int ObjectsPerFrame = 3;
+
+    using Clock = std::chrono::steady_clock;
+
+    double RunRaw(std::vector<FakeObject> &objects) {
+        std::vector<FakeObject *> frame;
+        frame.reserve(ObjectsPerFrame);
+
+        const auto start = Clock::now();
+        for (int i = 0; i < Frames; ++i) {
+            for (int j = 0; j < ObjectsPerFrame; ++j) {
+                FakeObject *object = &objects[j];
+                Use(object);
+                frame.push_back(object);
+            }
+            for (FakeObject *object : frame) {
+                Use(object);
+                ReleaseFake(object);
+            }
+            frame.clear();
+        }
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    double RunWrapped(std::vector<FakeObject> &objects) {
+        std::vector<FakeHandle> frame;
+        frame.reserve(ObjectsPerFrame);
+
+        const auto start = Clock::now();
+        for (int i = 0; i < Frames; ++i) {
+            for (int j = 0; j < ObjectsPerFrame; ++j) {
+                FakeHandle object(&objects[j]);
+                Use(object);
+                frame.push_back(std::move(object));
+            }
+            for (const FakeHandle &object : frame) {
+                Use(object);
+            }
+            frame.clear();
+        }
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+}
+
+int RunHandleBenchmark() {
+    std::vector<FakeObject> objects(ObjectsPerFrame);
+    constexpr uint64_t expectedReleases = uint64_t{ Frames } * ObjectsPerFrame;
+
+    g_ReleaseCount = 0;
+    const double rawSeconds = RunRaw(objects);
+    const uint64_t rawReleases = g_ReleaseCount;
+
+    g_ReleaseCount = 0;
+    const double wrappedSeconds = RunWrapped(objects);
+    const uint64_t wrappedReleases = g_ReleaseCount;
+
+    const double nanosecondsPerObject = 1e9 / expectedReleases;
+    std::cout << "Handle benchmark (" << Frames << " frames, " << ObjectsPerFrame << " objects per frame):\n";
+    std::cout << " - raw handles: " << rawSeconds * nanosecondsPerObject << " ns per object\n";
+    std::cout << " - Handle: " << wrappedSeconds * nanosecondsPerObject << " ns per object ("
+              << wrappedSeconds / rawSeconds << "x)\n";
+    std::cout << " - releases: " << rawReleases << " raw, " << wrappedReleases << " wrapped\n";
+
+    // Timings are only informative, but any extra release means the wrapper
+    // churns reference counts.
+    if (rawReleases != expectedReleases || wrappedReleases != expectedReleases) {
+        std::cerr << "Unexpected number of releases, expected " << expectedReleases << "!\n";
+        return 1;
+    }
+
+    return ReportLeakedHandles() == 0 ? 0 : 1;
+}
@@ -0,0 +1,269 @@
+#include <webgpu/webgpu.h>
+#include <webgpu/wgpu.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "Async.hpp"
+#include "Benchmarks.hpp"
+#include "ComputeKernels.hpp"
+#include "DeviceUtils.hpp"
+#include "GpuMemoryTracker.hpp"
+#include "ReadbackRing.hpp"
+#include "ShaderCache.hpp"
+#include "WebGPUHandles.hpp"
+
+// Runs each compute kernel on a few million random values, checks the
+// result against its CPU reference and compares their throughput. GPU times
+// go from submission to completion, so they include the submission overhead
+// that a real frame would pay too.
+
+namespace {
+    constexpr uint32_t ElementCount = 1 << 22;
+    constexpr int Iterations = 20;
+
+    struct Context {
+        WGPUDevice Device = nullptr;
+        WGPUQueue Queue = nullptr;
+        GpuMemoryTracker *Memory = nullptr;
+        ReadbackRing *Readback = nullptr;
+        EventPump *Pump = nullptr;
+    };
+
+    BufferHandle CreateStorageBuffer(const Context &context, const char *label, uint32_t count) {
+        WGPUBufferDescriptor bufferDesc = {};
+        bufferDesc.nextInChain = nullptr;
+        bufferDesc.label = label;
+        bufferDesc.usage = WGPUBufferUsage_Storage | WGPUBufferUsage_CopySrc | WGPUBufferUsage_CopyDst;
+        bufferDesc.size = uint64_t{ std::max(count, 1u) } * sizeof(uint32_t);
+        bufferDesc.mappedAtCreation = false;
+        return context.Memory->CreateBuffer(context.Device, bufferDesc, GpuMemoryCategory_Storage);
+    }
+
+    // Record with the given function, submit and wait for the GPU to be
+    // done. Returns the elapsed time.
+    double Submit(const Context &context, const std::function<void(WGPUCommandEncoder)> &record) {
+        const auto start = std::chrono::steady_clock::now();
+
+        WGPUCommandEncoderDescriptor encoderDesc = {};
+        encoderDesc.nextInChain = nullptr;
+        encoderDesc.label = "Kernel benchmark encoder";
+        CommandEncoderHandle encoder(wgpuDeviceCreateCommandEncoder(context.Device, &encoderDesc));
+        record(encoder);
+
+        WGPUCommandBufferDescriptor commandBufferDesc = {};
+        commandBufferDesc.nextInChain = nullptr;
+        commandBufferDesc.label = "Kernel benchmark commands";
+        CommandBufferHandle commands(wgpuCommandEncoderFinish(encoder, &commandBufferDesc));
+        WGPUCommandBuffer commandBuffer = commands.Get();
+        const WGPUSubmissionIndex submission = wgpuQueueSubmitForIndex(context.Queue, 1, &commandBuffer);
+        context.Pump->WaitForSubmission(context.Device, context.Queue, submission);
+
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Synchronous on purpose: the readback ring is flushed right away.
+    std::vector<uint32_t> Download(const Context &context, WGPUBuffer buffer, uint32_t count) {
+        std::vector<uint32_t> values(count);
+        if (count == 0) {
+            return values;
+        }
+
+        Submit(context, [&](WGPUCommandEncoder encoder) {
+            context.Readback->ReadBuffer(encoder, buffer, 0, uint64_t{ count } * sizeof(uint32_t), [&values](const ReadbackResult &result) {
+                if (result.Data) {
+                    std::copy_n(static_cast<const uint32_t *>(result.Data), values.size(), values.begin());
+                } else {
+                    std::cerr << "Could not read the kernel benchmark results back!\n";
+                }
+            });
+        });
+        context.Readback->OnSubmitted();
+        context.Readback->Flush();
+        return values;
+    }
+
+    template <typename Function>
+    double TimeCpu(Function function) {
+        double best = 1e9;
+        for (int i = 0; i < Iterations; ++i) {
+            const auto start = std::chrono::steady_clock::now();
+            function();
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    }
+
+    void Report(const char *kernel, double gpuSeconds, double cpuSeconds, bool valid) {
+        std::cout << " - " << kernel << ": GPU " << ElementCount / gpuSeconds / 1e6 << " M elements/s ("
+                  << gpuSeconds * 1000.0 << " ms), CPU reference " << ElementCount / cpuSeconds / 1e6
+                  << " M elements/s (" << cpuSeconds * 1000.0 << " ms)" << (valid ? "" : ", WRONG RESULT") << '\n';
+    }
+}
+
+int RunKernelBenchmark() {
+    // No surface: any adapter able to compute will do.
+    InstanceHandle instance(wgpuCreateInstance(nullptr));
+    if (!instance) {
+        std::cout << "Kernel benchmark: skipped, could not initialize WebGPU\n";
+        return 0;
+    }
+
+    WGPURequestAdapterOptions adapterOpts = {};
+    adapterOpts.nextInChain = nullptr;
+    adapterOpts.powerPreference = WGPUPowerPreference_HighPerformance;
+    AdapterHandle adapter(RequestAdapterSync(instance, &adapterOpts));
+    if (!adapter) {
+        std::cout << "Kernel benchmark: skipped, no adapter\n";
+        return 0;
+    }
+
+    // The default limits are enough for the kernels and for 4M elements.
+    WGPUDeviceDescriptor deviceDesc = {};
+    deviceDesc.nextInChain = nullptr;
+    deviceDesc.label = "Kernel benchmark device";
+    deviceDesc.defaultQueue.nextInChain = nullptr;
+    deviceDesc.defaultQueue.label = "Kernel benchmark queue";
+    DeviceHandle device(RequestDeviceSync(instance, adapter, &deviceDesc));
+    if (!device) {
+        std::cout << "Kernel benchmark: skipped, no device\n";
+        return 0;
+    }
+    QueueHandle queue(wgpuDeviceGetQueue(device));
+
+    GpuMemoryTracker memory;
+    ShaderCache shaderCache;
+    shaderCache.Initialize(device);
+
+    ComputeKernels kernels;
+    if (!kernels.Initialize(device, queue, shaderCache, memory) || !kernels.Reserve(ElementCount)) {
+        std::cerr << "Kernel benchmark: could not initialize the kernels!\n";
+        kernels.Terminate();
+        shaderCache.Terminate();
+        return 1;
+    }
+
+    EventPump pump;
+    pump.Initialize(instance);
+    pump.AddDevice(device);
+    ReadbackRing readback;
+    readback.Initialize(device, pump, memory, 1);
+
+    const Context context{ device, queue, &memory, &readback, &pump };
+
+    std::mt19937 generator(11);
+    std::uniform_int_distribution<uint32_t> anyValue;
+    std::uniform_int_distribution<uint32_t> smallValue(0, 15);
+    std::vector<uint32_t> keys(ElementCount), values(ElementCount), flags(ElementCount);
+    for (uint32_t i = 0; i < ElementCount; ++i) {
+        keys[i] = anyValue(generator);
+        values[i] = smallValue(generator);
+        // Keep about a third of the values.
+        flags[i] = anyValue(generator) % 3 == 0 ? 1 + smallValue(generator) : 0;
+    }
+
+    BufferHandle keysBuffer = CreateStorageBuffer(context, "Benchmark keys", ElementCount);
+    BufferHandle sortBuffer = CreateStorageBuffer(context, "Benchmark sorted keys", ElementCount);
+    BufferHandle valuesBuffer = CreateStorageBuffer(context, "Benchmark values", ElementCount);
+    BufferHandle flagsBuffer = CreateStorageBuffer(context, "Benchmark flags", ElementCount);
+    BufferHandle outputBuffer = CreateStorageBuffer(context, "Benchmark output", ElementCount);
+    BufferHandle countBuffer = CreateStorageBuffer(context, "Benchmark output count", 1);
+    wgpuQueueWriteBuffer(queue, keysBuffer, 0, keys.data(), keys.size() * sizeof(uint32_t));
+    wgpuQueueWriteBuffer(queue, valuesBuffer, 0, values.data(), values.size() * sizeof(uint32_t));
+    wgpuQueueWriteBuffer(queue, flagsBuffer, 0, flags.data(), flags.size() * sizeof(uint32_t));
+
+    const auto timeGpu = [&](const std::function<void(WGPUCommandEncoder)> &record) {
+        // The first run also pays for the lazy creation of driver state.
+        Submit(context, record);
+        double best = 1e9;
+        for (int i = 0; i < Iterations; ++i) {
+            best = std::min(best, Submit(context, record));
+        }
+        return best;
+    };
+
+    std::cout << "Compute kernel benchmark (" << ElementCount << " u32 elements):\n";
+    int result = 0;
+
+    {
+        const double gpuSeconds = timeGpu([&](WGPUCommandEncoder encoder) {
+            kernels.Reduce(encoder, valuesBuffer, ElementCount, countBuffer);
+        });
+        uint32_t reference = 0;
+        const double cpuSeconds = TimeCpu([&] { reference = ReduceReference(values); });
+        const bool valid = Download(context, countBuffer, 1)[0] == reference;
+        Report("reduce", gpuSeconds, cpuSeconds, valid);
+        result |= valid ? 0 : 1;
+    }
+
+    for (ScanType type : { ScanType_Inclusive, ScanType_Exclusive }) {
+        const double gpuSeconds = timeGpu([&](WGPUCommandEncoder encoder) {
+            kernels.Scan(encoder, valuesBuffer, outputBuffer, ElementCount, type);
+        });
+        std::vector<uint32_t> reference;
+        const double cpuSeconds = TimeCpu([&] { reference = ScanReference(values, type); });
+        const bool valid = Download(context, outputBuffer, ElementCount) == reference;
+        Report(type == ScanType_Inclusive ? "inclusive scan" : "exclusive scan", gpuSeconds, cpuSeconds, valid);
+        result |= valid ? 0 : 1;
+    }
+
+    {
+        // Sorting is in place: each run starts from a fresh copy of the keys,
+        // which is left out of the timing.
+        double gpuSeconds = 1e9;
+        for (int i = 0; i <= Iterations; ++i) {
+            Submit(context, [&](WGPUCommandEncoder encoder) {
+                wgpuCommandEncoderCopyBufferToBuffer(encoder, keysBuffer, 0, sortBuffer, 0, uint64_t{ ElementCount } * sizeof(uint32_t));
+            });
+            const double seconds = Submit(context, [&](WGPUCommandEncoder encoder) {
+                kernels.RadixSort(encoder, sortBuffer, ElementCount);
+            });
+            if (i > 0) {
+                gpuSeconds = std::min(gpuSeconds, seconds);
+            }
+        }
+        std::vector<uint32_t> reference;
+        const double cpuSeconds = TimeCpu([&] { reference = RadixSortReference(keys); });
+        const bool valid = Download(context, sortBuffer, ElementCount) == reference;
+        Report("radix sort", gpuSeconds, cpuSeconds, valid);
+        result |= valid ? 0 : 1;
+    }
+
+    {
+        const double gpuSeconds = timeGpu([&](WGPUCommandEncoder encoder) {
+            kernels.Compact(encoder, valuesBuffer, flagsBuffer, ElementCount, outputBuffer, countBuffer);
+        });
+        std::vector<uint32_t> reference;
+        const double cpuSeconds = TimeCpu([&] { reference = CompactReference(values, flags); });
+        const uint32_t count = Download(context, countBuffer, 1)[0];
+        bool valid = count == reference.size();
+        if (valid) {
+            std::vector<uint32_t> compacted = Download(context, outputBuffer, ElementCount);
+            compacted.resize(count);
+            valid = compacted == reference;
+        }
+        Report("compact", gpuSeconds, cpuSeconds, valid);
+        result |= valid ? 0 : 1;
+    }
+
+    if (result != 0) {
+        std::cerr << "A compute kernel disagrees with its CPU reference!\n";
+    }
+
+    memory.Release(keysBuffer);
+    memory.Release(sortBuffer);
+    memory.Release(valuesBuffer);
+    memory.Release(flagsBuffer);
+    memory.Release(outputBuffer);
+    memory.Release(countBuffer);
+    readback.Terminate();
+    kernels.Terminate();
+    shaderCache.Terminate();
+
+    return result;
+}
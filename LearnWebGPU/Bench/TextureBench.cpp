@@ -0,0 +1,268 @@
+#include <webgpu/webgpu.h>
+#include <webgpu/wgpu.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "Async.hpp"
+#include "Benchmarks.hpp"
+#include "DeviceUtils.hpp"
+#include "GpuMemoryTracker.hpp"
+#include "MipmapGenerator.hpp"
+#include "ReadbackRing.hpp"
+#include "ShaderCache.hpp"
+#include "TextureManager.hpp"
+#include "ThreadPool.hpp"
+#include "WebGPUHandles.hpp"
+
+// Uploads a 4K texture and generates its mip chain with the compute shader,
+// then does the same with the mip levels generated on the CPU and uploaded
+// one by one, so that both end up with the same texture on the GPU. The GPU
+// levels are checked against the CPU ones, on the 4K texture and on a
+// smaller one with odd sizes.
+
+namespace {
+    constexpr uint32_t TextureSize = 4096;
+    constexpr uint32_t OddWidth = 333;
+    constexpr uint32_t OddHeight = 101;
+    constexpr int Iterations = 5;
+
+    struct Context {
+        WGPUDevice Device = nullptr;
+        WGPUQueue Queue = nullptr;
+        GpuMemoryTracker *Memory = nullptr;
+        ReadbackRing *Readback = nullptr;
+        EventPump *Pump = nullptr;
+    };
+
+    // Record with the given function, submit and wait for the GPU to be
+    // done. Returns the elapsed time.
+    double Submit(const Context &context, const std::function<void(WGPUCommandEncoder)> &record) {
+        const auto start = std::chrono::steady_clock::now();
+
+        WGPUCommandEncoderDescriptor encoderDesc = {};
+        encoderDesc.nextInChain = nullptr;
+        encoderDesc.label = "Texture benchmark encoder";
+        CommandEncoderHandle encoder(wgpuDeviceCreateCommandEncoder(context.Device, &encoderDesc));
+        record(encoder);
+
+        WGPUCommandBufferDescriptor commandBufferDesc = {};
+        commandBufferDesc.nextInChain = nullptr;
+        commandBufferDesc.label = "Texture benchmark commands";
+        CommandBufferHandle commands(wgpuCommandEncoderFinish(encoder, &commandBufferDesc));
+        WGPUCommandBuffer commandBuffer = commands.Get();
+        const WGPUSubmissionIndex submission = wgpuQueueSubmitForIndex(context.Queue, 1, &commandBuffer);
+        context.Pump->WaitForSubmission(context.Device, context.Queue, submission);
+
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Smooth gradients with some noise on top, so that every level differs
+    // from the next one.
+    std::vector<uint8_t> CreateImage(uint32_t width, uint32_t height) {
+        std::mt19937 generator(5);
+        std::uniform_int_distribution<int> noise(-24, 24);
+        std::vector<uint8_t> pixels(size_t{ width } * height * 4);
+        for (uint32_t y = 0; y < height; ++y) {
+            for (uint32_t x = 0; x < width; ++x) {
+                uint8_t *texel = pixels.data() + (size_t{ y } * width + x) * 4;
+                texel[0] = static_cast<uint8_t>(std::clamp(static_cast<int>(x * 255 / width) + noise(generator), 0, 255));
+                texel[1] = static_cast<uint8_t>(std::clamp(static_cast<int>(y * 255 / height) + noise(generator), 0, 255));
+                texel[2] = static_cast<uint8_t>((x ^ y) & 0xff);
+                texel[3] = static_cast<uint8_t>(std::clamp(192 + noise(generator), 0, 255));
+            }
+        }
+        return pixels;
+    }
+
+    // Read each level of the texture back and compare it with the CPU
+    // levels, allowing for the rounding differences of pow() on the GPU.
+    bool CheckLevels(const Context &context, WGPUTexture texture, uint32_t width, uint32_t height, const std::vector<std::vector<uint8_t>> &reference) {
+        int worstError = 0;
+        bool complete = true;
+        for (uint32_t level = 1; level <= reference.size(); ++level) {
+            const uint32_t levelWidth = std::max(width >> level, 1u);
+            const uint32_t levelHeight = std::max(height >> level, 1u);
+            const std::vector<uint8_t> &expected = reference[level - 1];
+
+            Submit(context, [&](WGPUCommandEncoder encoder) {
+                context.Readback->ReadTexture(encoder, texture, levelWidth, levelHeight, [&](const ReadbackResult &result) {
+                    if (!result.Data || result.Size != expected.size()) {
+                        complete = false;
+                        return;
+                    }
+                    const auto *texels = static_cast<const uint8_t *>(result.Data);
+                    for (size_t i = 0; i < expected.size(); ++i) {
+                        worstError = std::max(worstError, std::abs(static_cast<int>(texels[i]) - static_cast<int>(expected[i])));
+                    }
+                }, level);
+            });
+            context.Readback->OnSubmitted();
+            context.Readback->Flush();
+        }
+        return complete && worstError <= 1;
+    }
+}
+
+int RunTextureBenchmark() {
+    // No surface: any adapter able to compute will do.
+    InstanceHandle instance(wgpuCreateInstance(nullptr));
+    if (!instance) {
+        std::cout << "Texture benchmark: skipped, could not initialize WebGPU\n";
+        return 0;
+    }
+
+    WGPURequestAdapterOptions adapterOpts = {};
+    adapterOpts.nextInChain = nullptr;
+    adapterOpts.powerPreference = WGPUPowerPreference_HighPerformance;
+    AdapterHandle adapter(RequestAdapterSync(instance, &adapterOpts));
+    if (!adapter) {
+        std::cout << "Texture benchmark: skipped, no adapter\n";
+        return 0;
+    }
+
+    // The default limits allow 8K textures and 4 storage textures per
+    // stage.
+    WGPUDeviceDescriptor deviceDesc = {};
+    deviceDesc.nextInChain = nullptr;
+    deviceDesc.label = "Texture benchmark device";
+    deviceDesc.defaultQueue.nextInChain = nullptr;
+    deviceDesc.defaultQueue.label = "Texture benchmark queue";
+    DeviceHandle device(RequestDeviceSync(instance, adapter, &deviceDesc));
+    if (!device) {
+        std::cout << "Texture benchmark: skipped, no device\n";
+        return 0;
+    }
+    QueueHandle queue(wgpuDeviceGetQueue(device));
+
+    GpuMemoryTracker memory;
+    ShaderCache shaderCache;
+    shaderCache.Initialize(device);
+    // Only Load() needs workers, textures are created from memory here.
+    ThreadPool workers;
+
+    TextureManager textures;
+    if (!textures.Initialize(device, queue, shaderCache, memory, workers)) {
+        std::cerr << "Texture benchmark: could not initialize the texture manager!\n";
+        textures.Terminate();
+        shaderCache.Terminate();
+        return 1;
+    }
+
+    EventPump pump;
+    pump.Initialize(instance);
+    pump.AddDevice(device);
+    ReadbackRing readback;
+    readback.Initialize(device, pump, memory, 1);
+
+    const Context context{ device, queue, &memory, &readback, &pump };
+
+    const std::vector<uint8_t> pixels = CreateImage(TextureSize, TextureSize);
+    const uint32_t levelCount = GetMipLevelCount(TextureSize, TextureSize);
+
+    std::cout << "Texture benchmark (" << TextureSize << 'x' << TextureSize << " RGBA8, " << levelCount << " mip levels):\n";
+    int result = 0;
+
+    // The first run also pays for the lazy creation of driver state.
+    double gpuSeconds = 1e9;
+    for (int i = 0; i <= Iterations; ++i) {
+        TextureId texture = InvalidTextureId;
+        const double seconds = Submit(context, [&](WGPUCommandEncoder encoder) {
+            texture = textures.Create(encoder, "Benchmark texture", TextureSize, TextureSize, pixels.data());
+        });
+        if (texture == InvalidTextureId) {
+            std::cerr << "Texture benchmark: could not create the texture!\n";
+            result = 1;
+            break;
+        }
+        if (i > 0) {
+            gpuSeconds = std::min(gpuSeconds, seconds);
+        }
+        textures.Release(texture);
+    }
+
+    // Same texture, but every level is computed on the CPU and written.
+    std::vector<std::vector<uint8_t>> reference;
+    double cpuSeconds = 1e9;
+    double cpuMipSeconds = 1e9;
+    for (int i = 0; i < Iterations && result == 0; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        reference = GenerateMipmapsReference(TextureSize, TextureSize, pixels.data());
+        cpuMipSeconds = std::min(cpuMipSeconds, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+        WGPUTextureDescriptor textureDesc = {};
+        textureDesc.nextInChain = nullptr;
+        textureDesc.label = "Benchmark CPU mipmapped texture";
+        textureDesc.dimension = WGPUTextureDimension_2D;
+        textureDesc.format = MipmapGenerator::Format;
+        textureDesc.mipLevelCount = levelCount;
+        textureDesc.sampleCount = 1;
+        textureDesc.size = { TextureSize, TextureSize, 1 };
+        textureDesc.usage = WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst;
+        textureDesc.viewFormatCount = 0;
+        textureDesc.viewFormats = nullptr;
+        TextureHandle texture = memory.CreateTexture(device, textureDesc, GpuMemoryCategory_Texture);
+
+        for (uint32_t level = 0; level < levelCount; ++level) {
+            const uint32_t levelSize = std::max(TextureSize >> level, 1u);
+            WGPUImageCopyTexture destination = {};
+            destination.nextInChain = nullptr;
+            destination.texture = texture;
+            destination.mipLevel = level;
+            destination.origin = { 0, 0, 0 };
+            destination.aspect = WGPUTextureAspect_All;
+            WGPUTextureDataLayout source = {};
+            source.nextInChain = nullptr;
+            source.offset = 0;
+            source.bytesPerRow = 4 * levelSize;
+            source.rowsPerImage = levelSize;
+            const WGPUExtent3D size = { levelSize, levelSize, 1 };
+            const std::vector<uint8_t> &data = level == 0 ? pixels : reference[level - 1];
+            wgpuQueueWriteTexture(queue, &destination, data.data(), data.size(), &source, &size);
+        }
+        Submit(context, [](WGPUCommandEncoder) {});
+        cpuSeconds = std::min(cpuSeconds, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+        memory.Release(texture);
+    }
+
+    if (result == 0) {
+        // Validate on a fresh texture, then on one whose sizes are odd at
+        // most levels.
+        TextureId texture = InvalidTextureId;
+        Submit(context, [&](WGPUCommandEncoder encoder) {
+            texture = textures.Create(encoder, "Benchmark texture", TextureSize, TextureSize, pixels.data());
+        });
+        bool valid = CheckLevels(context, textures.GetTexture(texture), TextureSize, TextureSize, reference);
+        textures.Release(texture);
+
+        const std::vector<uint8_t> oddPixels = CreateImage(OddWidth, OddHeight);
+        Submit(context, [&](WGPUCommandEncoder encoder) {
+            texture = textures.Create(encoder, "Benchmark odd texture", OddWidth, OddHeight, oddPixels.data());
+        });
+        valid = valid && CheckLevels(context, textures.GetTexture(texture), OddWidth, OddHeight, GenerateMipmapsReference(OddWidth, OddHeight, oddPixels.data()));
+        textures.Release(texture);
+
+        const double megatexels = TextureSize * double{ TextureSize } / 1e6;
+        std::cout << " - upload + GPU mips: " << gpuSeconds * 1000.0 << " ms (" << megatexels / gpuSeconds << " M texels/s)"
+                  << (valid ? "" : ", WRONG RESULT") << '\n';
+        std::cout << " - CPU mips + upload of every level: " << cpuSeconds * 1000.0 << " ms ("
+                  << megatexels / cpuSeconds << " M texels/s), of which " << cpuMipSeconds * 1000.0 << " ms generating\n";
+        if (!valid) {
+            std::cerr << "The GPU mip levels disagree with the CPU ones!\n";
+            result = 1;
+        }
+    }
+
+    readback.Terminate();
+    textures.Terminate();
+    shaderCache.Terminate();
+
+    return result;
+}
@@ -0,0 +1,186 @@
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "Benchmarks.hpp"
+#include "Matrix4.hpp"
+#include "ThreadPool.hpp"
+#include "TransformHierarchy.hpp"
+
+// Propagates a million transforms through a random 7-level hierarchy: all
+// of them, a few subtrees, and none, on one thread and on a thread pool. The
+// same hierarchy inserted depth first (which forces a re-sort) must give the
+// same world matrices as a naive recursive evaluation.
+
+namespace {
+    constexpr uint32_t NodeCount = 1'000'000;
+    // Nodes per level, the last level takes whatever is left.
+    constexpr uint32_t LevelSizes[] = { 1, 10, 100, 1'000, 10'000, 100'000 };
+    constexpr uint32_t MovedSubtrees = 100;
+    constexpr int Iterations = 20;
+
+    void MultiplyScalar(const Matrix4 &a, const Matrix4 &b, Matrix4 &result) {
+        for (uint32_t column = 0; column < 4; ++column) {
+            for (uint32_t row = 0; row < 4; ++row) {
+                float sum = 0.0f;
+                for (uint32_t k = 0; k < 4; ++k) {
+                    sum += a(row, k) * b(k, column);
+                }
+                result(row, column) = sum;
+            }
+        }
+    }
+
+    Matrix4 RandomLocal(std::mt19937 &generator) {
+        std::uniform_real_distribution<float> translation(-0.1f, 0.1f);
+        std::uniform_real_distribution<float> angle(-0.5f, 0.5f);
+        std::uniform_real_distribution<float> scale(0.9f, 1.1f);
+        const float s = scale(generator);
+        return Matrix4::Translation(translation(generator), translation(generator), translation(generator))
+               * Matrix4::RotationZ(angle(generator)) * Matrix4::Scaling(s, s, s);
+    }
+
+    template<typename Function>
+    double Measure(Function &&function) {
+        double best = INFINITY;
+        for (int iteration = 0; iteration < Iterations; ++iteration) {
+            const auto start = std::chrono::steady_clock::now();
+            function();
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    }
+
+    bool NearlyEqual(const Matrix4 &a, const Matrix4 &b) {
+        for (int i = 0; i < 16; ++i) {
+            if (std::abs(a.M[i] - b.M[i]) > 1e-4f * (1.0f + std::abs(b.M[i]))) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int RunTransformBenchmark() {
+    // The scene, in breadth first order: every parent index is smaller than
+    // its children's.
+    std::mt19937 generator(11);
+    std::vector<uint32_t> parents;
+    std::vector<Matrix4> locals;
+    parents.reserve(NodeCount);
+    locals.reserve(NodeCount);
+
+    uint32_t levelBegin = 0, levelEnd = 0;
+    for (uint32_t level = 0; parents.size() < NodeCount; ++level) {
+        const uint32_t size = level < std::size(LevelSizes) ? LevelSizes[level] : NodeCount - static_cast<uint32_t>(parents.size());
+        std::uniform_int_distribution<uint32_t> parent(levelBegin, levelEnd == 0 ? 0 : levelEnd - 1);
+        for (uint32_t i = 0; i < size; ++i) {
+            parents.push_back(level == 0 ? UINT32_MAX : parent(generator));
+            locals.push_back(RandomLocal(generator));
+        }
+        levelBegin = levelEnd;
+        levelEnd = static_cast<uint32_t>(parents.size());
+    }
+
+    ThreadPool workers;
+    workers.Start();
+
+    TransformHierarchy hierarchy;
+    hierarchy.Reserve(NodeCount);
+    for (uint32_t i = 0; i < NodeCount; ++i) {
+        hierarchy.AddNode(parents[i] == UINT32_MAX ? InvalidTransformNode : parents[i], locals[i]);
+    }
+    hierarchy.Update();
+
+    std::cout << "Transform benchmark (" << NodeCount << " nodes in " << hierarchy.GetStats().Levels << " levels, "
+              << workers.GetThreadCount() + 1 << " threads):\n";
+
+    // The raw cost of the matrix products alone.
+    {
+        std::vector<Matrix4> results(NodeCount);
+        const double scalar = Measure([&] {
+            for (uint32_t i = 1; i < NodeCount; ++i) {
+                MultiplyScalar(locals[i - 1], locals[i], results[i]);
+            }
+        });
+        const double simd = Measure([&] {
+            for (uint32_t i = 1; i < NodeCount; ++i) {
+                MultiplyMatrices(locals[i - 1], locals[i], results[i]);
+            }
+        });
+        std::cout << " - " << NodeCount << " 4x4 products: scalar " << scalar * 1000.0 << " ms, SIMD " << simd * 1000.0
+                  << " ms (" << scalar / simd << "x)\n";
+    }
+
+    // Subtree roots in the middle of the hierarchy, each with ~100 nodes
+    // below it.
+    std::vector<TransformNode> moved;
+    std::uniform_int_distribution<uint32_t> middle(1'111, 11'110);
+    for (uint32_t i = 0; i < MovedSubtrees; ++i) {
+        moved.push_back(middle(generator));
+    }
+
+    for (ThreadPool *pool : { static_cast<ThreadPool *>(nullptr), &workers }) {
+        hierarchy.SetThreadPool(pool);
+        const char *name = pool ? "thread pool" : "one thread";
+
+        uint32_t recomputed = 0;
+        const double full = Measure([&] {
+            hierarchy.SetLocal(0, hierarchy.GetLocal(0));
+            recomputed = hierarchy.Update();
+        });
+        std::cout << " - " << name << ", root moved: " << full * 1000.0 << " ms (" << recomputed << " matrices)\n";
+
+        const double partial = Measure([&] {
+            for (TransformNode node : moved) {
+                hierarchy.SetLocal(node, hierarchy.GetLocal(node));
+            }
+            recomputed = hierarchy.Update();
+        });
+        std::cout << " - " << name << ", " << MovedSubtrees << " subtrees moved: " << partial * 1000.0 << " ms ("
+                  << recomputed << " matrices)\n";
+
+        const double clean = Measure([&] { recomputed = hierarchy.Update(); });
+        std::cout << " - " << name << ", nothing moved: " << clean * 1000.0 << " ms\n";
+    }
+
+    // Insert the same nodes depth first, which leaves them unsorted.
+    std::vector<std::vector<uint32_t>> children(NodeCount);
+    for (uint32_t i = 1; i < NodeCount; ++i) {
+        children[parents[i]].push_back(i);
+    }
+    TransformHierarchy depthFirst;
+    depthFirst.Reserve(NodeCount);
+    std::vector<TransformNode> depthFirstNodes(NodeCount);
+    std::vector<uint32_t> stack = { 0 };
+    while (!stack.empty()) {
+        const uint32_t index = stack.back();
+        stack.pop_back();
+        const TransformNode parent = index == 0 ? InvalidTransformNode : depthFirstNodes[parents[index]];
+        depthFirstNodes[index] = depthFirst.AddNode(parent, locals[index]);
+        stack.insert(stack.end(), children[index].begin(), children[index].end());
+    }
+    depthFirst.Update();
+    std::cout << " - depth first insertion: first update with re-sort " << depthFirst.GetStats().Seconds * 1000.0 << " ms\n";
+
+    // Naive evaluation, parents first thanks to the breadth first order.
+    std::vector<Matrix4> reference(NodeCount);
+    int result = 0;
+    for (uint32_t i = 0; i < NodeCount; ++i) {
+        if (parents[i] == UINT32_MAX) {
+            reference[i] = locals[i];
+        } else {
+            MultiplyScalar(reference[parents[i]], locals[i], reference[i]);
+        }
+        if (!NearlyEqual(hierarchy.GetWorld(i), reference[i]) || !NearlyEqual(depthFirst.GetWorld(depthFirstNodes[i]), reference[i])) {
+            std::cout << "   MISMATCH at node " << i << '\n';
+            result = 1;
+            break;
+        }
+    }
+
+    return result;
+}
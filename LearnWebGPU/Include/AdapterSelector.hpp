@@ -0,0 +1,49 @@
+#pragma once
+
+#include <webgpu/webgpu.h>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "WebGPUHandles.hpp"
+
+/**
+ * How to choose between the adapters that meet the requirements.
+ */
+enum AdapterPreference : uint32_t {
+    // The one the instance picks for the surface.
+    AdapterPreference_Default,
+    // Discrete GPUs first, then integrated ones, CPU adapters last.
+    AdapterPreference_HighPerformance,
+    // Integrated GPUs first, then discrete ones, CPU adapters last.
+    AdapterPreference_LowPower,
+    // Only CPU adapters (llvmpipe, WARP...), for hosts without a GPU.
+    AdapterPreference_Software,
+    // The one that runs a short compute kernel the fastest.
+    AdapterPreference_Benchmark,
+};
+
+struct AdapterSelection {
+    AdapterPreference Preference = AdapterPreference_Default;
+    // WGPUBackendType_Undefined accepts every backend.
+    WGPUBackendType Backend = WGPUBackendType_Undefined;
+    // Adapters must be able to present to this surface, when there is one.
+    WGPUSurface CompatibleSurface = nullptr;
+    std::vector<WGPUFeatureName> RequiredFeatures;
+    // The limits the device will be requested with, which may depend on the
+    // adapter. Undefined values (WGPU_LIMIT_*_UNDEFINED) are not checked.
+    std::function<WGPULimits(WGPUAdapter adapter)> RequiredLimits;
+};
+
+/**
+ * Enumerate the adapters of every backend, reject the ones that do not meet
+ * the requirements of selection and pick one of the others by preference.
+ * Every candidate, why it was rejected and why the adapter was chosen are
+ * logged. Returns an empty handle if no adapter fits.
+ */
+AdapterHandle SelectAdapter(WGPUInstance instance, const AdapterSelection &selection);
+
+// Seconds the adapter takes to run the benchmark kernel on a device of its
+// own, or a negative value if it cannot run it.
+double BenchmarkAdapter(WGPUInstance instance, WGPUAdapter adapter);
@@ -4,33 +4,214 @@
 
 #include <webgpu/webgpu.h>
 
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "Async.hpp"
+#include "DrawList.hpp"
+#include "DynamicResolution.hpp"
+#include "FrameController.hpp"
+#include "FrustumCuller.hpp"
+#include "GeometryPool.hpp"
+#include "GpuMemoryTracker.hpp"
+#include "GpuTimer.hpp"
+#include "MeshRegistry.hpp"
+#include "Options.hpp"
+#include "PipelineCache.hpp"
+#include "PipelineStatistics.hpp"
+#include "ReadbackRing.hpp"
+#include "RedrawTracker.hpp"
+#include "RenderThread.hpp"
+#include "SamplerCache.hpp"
+#include "ShaderCache.hpp"
+#include "StartupProfiler.hpp"
+#include "SurfaceManager.hpp"
+#include "TextureManager.hpp"
+#include "ThreadPool.hpp"
+#include "TransformHierarchy.hpp"
+#include "WebGPUHandles.hpp"
+
+/**
+ * One of the windows the scene is shown in, with its own surface,
+ * configuration and depth buffer. Every view shares the device, the
+ * pipelines and the geometry, and all of them are encoded into the same
+ * submission each frame.
+ */
+struct AppView {
+    GLFWwindow *Window = nullptr;
+    SurfaceHandle Surface;
+    SurfaceManager Presenter;
+
+    // Only created with --depth, always the size of the surface.
+    TextureHandle DepthTexture;
+    TextureViewHandle DepthView;
+
+    // Main thread side, sent to the render thread with each frame packet.
+    // Stays 0 once a secondary window is closed.
+    uint32_t FramebufferWidth = 0;
+    uint32_t FramebufferHeight = 0;
+};
+
 class Application {
 
 private:
-    GLFWwindow *m_Window;
-    WGPUDevice m_Device;
-    WGPUQueue m_Queue;
-    WGPUSurface m_Surface;
-    WGPURenderPipeline m_Pipeline;
+    // A geometry file read before the device is requested.
+    struct LoadedMesh {
+        std::string Path;
+        std::vector<float> PointData;
+        std::vector<uint32_t> IndexData;
+    };
+
+    AppOptions m_Options;
+
+    // The first view is the primary one: closing it quits, and dynamic
+    // resolution, GPU timings, pipeline statistics and screenshots only
+    // apply to it. Views never move once created, the callbacks of their
+    // surface managers point at them.
+    std::vector<std::unique_ptr<AppView>> m_Views;
+    InstanceHandle m_Instance;
+    AdapterHandle m_Adapter;
+    DeviceHandle m_Device;
+    QueueHandle m_Queue;
+    // Resumes the coroutines waiting on WebGPU. Pumped by the main thread
+    // during startup, then once per frame by the render thread, which owns
+    // the device.
+    EventPump m_Events;
+    // Every buffer and texture is created through the tracker.
+    GpuMemoryTracker m_MemoryTracker;
+    FrameController m_FrameController;
+    // Everything read back from the GPU (timings, statistics, screenshots)
+    // goes through the ring, which never waits for the GPU.
+    ReadbackRing m_Readback;
+
+    // Shader modules and pipelines are compiled on worker threads.
+    ThreadPool m_Workers;
+    ShaderCache m_ShaderCache;
+    PipelineCache m_PipelineCache;
+    PipelineKey m_PipelineKey = InvalidPipelineKey;
+    PipelineLayoutHandle m_PipelineLayout;
+    SamplerCache m_Samplers;
+    // Preferred by the primary surface, every view is configured with it so
+    // that they share the pipelines.
     WGPUTextureFormat m_SurfaceFormat = WGPUTextureFormat_Undefined;
 
-    WGPUBuffer m_VertexBuffer;
-    uint32_t m_VertexCount;
-    WGPUBuffer m_IndexBuffer;
-    uint32_t m_IndexCount;
-    
+    // With --dynamic-resolution, the scene is rendered to the top left part
+    // of an offscreen target the size of the surface, at a scale driven by
+    // the measured GPU time, then upscaled to the primary surface by a blit
+    // pass.
+    GpuTimer m_GpuTimer;
+    DynamicResolution m_DynamicResolution;
+    TextureHandle m_SceneTexture;
+    TextureViewHandle m_SceneView;
+    // Owned by the sampler cache.
+    WGPUSampler m_BlitSampler = nullptr;
+    BufferHandle m_BlitParams;
+    BindGroupLayoutHandle m_BlitBindGroupLayout;
+    PipelineLayoutHandle m_BlitPipelineLayout;
+    BindGroupHandle m_BlitBindGroup;
+    PipelineKey m_BlitPipelineKey = InvalidPipelineKey;
+    // The render size m_BlitParams currently holds.
+    uint32_t m_BlitWidth = 0;
+    uint32_t m_BlitHeight = 0;
+
+    GeometryPool m_GeometryPool;
+    // Loaded before the device is requested, so that its limits fit the
+    // geometry, and released once uploaded.
+    std::vector<LoadedMesh> m_LoadedMeshes;
+    // Capacity of the draw list, enough for every part of every object.
+    uint32_t m_MaxDraws = 0;
+    // Every mesh, packed into the pool and split into as many parts as the
+    // limits require. Each object is one draw per part of its mesh.
+    MeshRegistry m_Meshes;
+
+    // With --texture, the objects are drawn textured once the image is
+    // decoded and uploaded, and untextured until then (or if it cannot be
+    // loaded). The texture is bind group 1 of the textured pipeline.
+    TextureManager m_Textures;
+    TextureId m_Texture = InvalidTextureId;
+    BindGroupLayoutHandle m_TextureBindGroupLayout;
+    PipelineLayoutHandle m_TexturedPipelineLayout;
+    BindGroupHandle m_TextureBindGroup;
+    PipelineKey m_TexturedPipelineKey = InvalidPipelineKey;
+
+    // Where each object of the scene is drawn: one node per object, whose
+    // world matrix is fed to the draw list every frame.
+    TransformHierarchy m_Transforms;
+    std::vector<TransformNode> m_SceneNodes;
+    // The mesh of each scene node.
+    std::vector<MeshId> m_SceneMeshes;
+    // One bounding sphere per scene node, only the visible ones are drawn.
+    FrustumCuller m_Culler;
+    std::vector<uint32_t> m_VisibleDraws;
+    DrawList m_DrawList;
+    // Counts fragments in the overdraw scene, when the device supports it.
+    PipelineStatistics m_PipelineStatistics;
+
+    // Once initialized, the queue and the surfaces belong to the render
+    // thread. The main thread only talks to it through frame packets.
+    RenderThread m_RenderThread;
+    uint64_t m_FrameNumber = 0;
+    // Set while the main thread sleeps because the packet queue is full, so
+    // that the render thread only wakes it up when needed.
+    std::atomic<bool> m_WaitingForRenderThread = false;
+    // F12 was pressed, sent with the next frame packet.
+    bool m_ScreenshotRequested = false;
+    // Render thread side: waiting for a complete frame (and a free readback
+    // slot) to take the screenshot.
+    bool m_ScreenshotPending = false;
+
+    RedrawTracker m_RedrawTracker;
+
+    // Owned by main(). Until the pipeline is ready, frames only show the
+    // clear color: the first frame and the first complete frame are two
+    // milestones.
+    StartupProfiler *m_Startup = nullptr;
+
 public:
-    bool Initialize();
+    // Each step is recorded as a phase of startup.
+    bool Initialize(const AppOptions &options, StartupProfiler &startup);
 
-    void Terminate() const;
+    void Terminate();
 
-    void MainLoop() const;
+    void MainLoop();
 
     bool IsRunning() const;
 
+    // Ask for a new frame in on-demand mode. Can be called from any thread.
+    void RequestRedraw(RedrawReason reason);
+
+    // With --batch, render and save every frame of the batch file instead
+    // of running the main loop. Returns the process exit code.
+    int RunBatch();
+
 private:
-    WGPUTextureView GetNextSurfaceTextureView() const;
-    void InitializePipeline();
-    void InitializeBuffers();
+    bool InitializeView(AppView &view);
+    AppView *FindView(GLFWwindow *window);
+    void InstallInputCallbacks(GLFWwindow *window);
+    void FillViewPackets(FramePacket &packet) const;
+    void RenderFrame(const FramePacket &packet);
+    // Record the passes that draw the scene to one view, from the draw list
+    // uploaded for this frame. The pipeline is null until it is compiled.
+    void EncodeView(WGPUCommandEncoder encoder, AppView &view, const SurfaceFrame &frame, WGPURenderPipeline pipeline, bool textured);
+    // Parse a geometry file on a worker.
+    Task<bool> LoadMeshAsync(LoadedMesh &mesh);
+    bool InitializePipeline();
+    bool InitializeBuffers();
+    // Of the meshes loaded but not uploaded yet.
+    void GetLoadedGeometrySize(uint64_t &vertexCount, uint64_t &indexCount) const;
+    // Upper bound of the draws of the scene, from the meshes loaded but not
+    // split yet.
+    uint32_t GetMaxDrawCount() const;
+    bool InitializeTextures();
+    // Upload the textures decoded since the last frame, and create the bind
+    // group of the texture once it is ready.
+    void UpdateTextures(WGPUCommandEncoder encoder);
+    void BuildScene();
+    void UpdateCullingSpheres();
+    bool CreateDepthBuffer(AppView &view, uint32_t width, uint32_t height);
+    bool InitializeDynamicResolution();
+    bool CreateSceneTarget(uint32_t width, uint32_t height);
+    bool CaptureScreenshot(WGPUCommandEncoder encoder, const SurfaceFrame &frame);
     WGPURequiredLimits GetRequiredLimits(WGPUAdapter adapter) const;
 };
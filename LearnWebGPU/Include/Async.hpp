@@ -0,0 +1,337 @@
+#pragma once
+
+#include <webgpu/webgpu.h>
+#include <webgpu/wgpu.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "ThreadPool.hpp"
+
+/**
+ * A coroutine returning a T, which may co_await the requests below or other
+ * tasks. It does not start until it is awaited or given to
+ * EventPump::Run(), and the coroutine awaiting it resumes as soon as it
+ * returns. T must be default constructible; there is no Task<void>, return
+ * a bool instead.
+ */
+template <typename T>
+class Task {
+public:
+    struct promise_type {
+        T Value{};
+        std::coroutine_handle<> Continuation;
+
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        auto final_suspend() noexcept {
+            struct FinalAwaiter {
+                bool await_ready() noexcept { return false; }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+                    const std::coroutine_handle<> continuation = handle.promise().Continuation;
+                    return continuation ? continuation : std::noop_coroutine();
+                }
+
+                void await_resume() noexcept {}
+            };
+            return FinalAwaiter{};
+        }
+
+        void return_value(T value) { Value = std::move(value); }
+
+        // The code base does not use exceptions.
+        void unhandled_exception() { std::terminate(); }
+    };
+
+private:
+    std::coroutine_handle<promise_type> m_Handle;
+
+public:
+    Task() = default;
+
+    explicit Task(std::coroutine_handle<promise_type> handle) : m_Handle(handle) {}
+
+    ~Task() {
+        if (m_Handle) {
+            m_Handle.destroy();
+        }
+    }
+
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+
+    Task(Task &&other) noexcept : m_Handle(std::exchange(other.m_Handle, nullptr)) {}
+
+    Task &operator=(Task &&other) noexcept {
+        if (this != &other) {
+            if (m_Handle) {
+                m_Handle.destroy();
+            }
+            m_Handle = std::exchange(other.m_Handle, nullptr);
+        }
+        return *this;
+    }
+
+    // Run until the first suspension.
+    void Start() { m_Handle.resume(); }
+
+    bool IsDone() const { return !m_Handle || m_Handle.done(); }
+
+    T TakeResult() { return std::move(m_Handle.promise().Value); }
+
+    bool await_ready() const noexcept { return IsDone(); }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        m_Handle.promise().Continuation = awaiting;
+        return m_Handle;
+    }
+
+    T await_resume() { return TakeResult(); }
+};
+
+struct EventPumpStats {
+    uint64_t Pumps = 0;
+    uint64_t Resumed = 0;
+    // Calls to Wait() and WaitForSubmission(), which block the thread.
+    uint64_t Waits = 0;
+};
+
+/**
+ * The single place where coroutines waiting on WebGPU resume.
+ *
+ * WebGPU callbacks only fire from within wgpuInstanceProcessEvents(),
+ * wgpuDevicePoll() or the call that started the operation, sometimes right
+ * away. The awaiters below do not resume their coroutine from the callback:
+ * they schedule it, and Pump() resumes it after polling, on the thread that
+ * runs the coroutines. Workers schedule the coroutines waiting on them the
+ * same way.
+ *
+ * Every poll of the application's device goes through the pump: the frame
+ * controller, the readback ring and the pipeline cache all await through it.
+ * Polling fires the callbacks of every device of the instance, so only pump
+ * from the thread that owns the devices. Schedule() is the only thread safe
+ * function.
+ */
+class EventPump {
+private:
+    WGPUInstance m_Instance = nullptr;
+    std::vector<WGPUDevice> m_Devices;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_Wakeup;
+    std::vector<std::coroutine_handle<>> m_Ready;
+
+    EventPumpStats m_Stats;
+
+public:
+    void Initialize(WGPUInstance instance) { m_Instance = instance; }
+
+    // Devices to poll, the pump does not own them.
+    void AddDevice(WGPUDevice device);
+    void RemoveDevice(WGPUDevice device);
+
+    // Resume handle from the next Pump().
+    void Schedule(std::coroutine_handle<> handle);
+
+    // Process the pending events without blocking and resume the coroutines
+    // they completed. Returns how many were resumed.
+    uint32_t Pump();
+
+    // Like Pump(), but sleep until at least one coroutine was resumed. WebGPU
+    // only reports completions when polled, so the devices are polled again
+    // every millisecond while nothing else wakes the thread up.
+    uint32_t Wait();
+
+    // Block until a submission of device is done, then Pump(). Cheaper than
+    // Wait() when the submission is all the caller waits for.
+    uint32_t WaitForSubmission(WGPUDevice device, WGPUQueue queue, WGPUSubmissionIndex submissionIndex);
+
+    // Start a Task, or any awaitable below, and sleep in Wait() until it
+    // completes. For startup and tools: the frame loop calls Pump() instead.
+    template <typename Awaitable>
+    auto Run(Awaitable awaitable);
+
+    const EventPumpStats &GetStats() const { return m_Stats; }
+};
+
+/**
+ * Common part of the awaitables over WebGPU callbacks. The callback calls
+ * Complete(), which resumes the coroutine right away when the operation
+ * completed within Begin(), and through the pump otherwise.
+ */
+class PumpedAwaiter {
+private:
+    EventPump *m_Pump = nullptr;
+    std::coroutine_handle<> m_Waiting;
+    // Set by whichever of await_suspend() and Complete() gets there first,
+    // the second one decides: the callback may fire on another thread.
+    std::atomic<bool> m_Arrived = false;
+
+public:
+    explicit PumpedAwaiter(EventPump &pump) : m_Pump(&pump) {}
+    virtual ~PumpedAwaiter() = default;
+
+    // Only before it is awaited, e.g. to hand it to EventPump::Run().
+    PumpedAwaiter(PumpedAwaiter &&other) noexcept
+        : m_Pump(other.m_Pump), m_Waiting(other.m_Waiting), m_Arrived(other.m_Arrived.load()) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> waiting) {
+        m_Waiting = waiting;
+        Begin();
+        // Stay suspended unless the operation already completed.
+        return !m_Arrived.exchange(true);
+    }
+
+protected:
+    // Start the operation, whose callback must call Complete().
+    virtual void Begin() = 0;
+
+    void Complete() {
+        if (m_Arrived.exchange(true)) {
+            m_Pump->Schedule(m_Waiting);
+        }
+    }
+};
+
+class AdapterRequest : public PumpedAwaiter {
+private:
+    WGPUInstance m_Instance;
+    const WGPURequestAdapterOptions *m_Options;
+    WGPUAdapter m_Adapter = nullptr;
+
+public:
+    AdapterRequest(EventPump &pump, WGPUInstance instance, const WGPURequestAdapterOptions *options)
+        : PumpedAwaiter(pump), m_Instance(instance), m_Options(options) {}
+
+    // nullptr if the request failed, the caller owns the adapter.
+    WGPUAdapter await_resume() const { return m_Adapter; }
+
+protected:
+    void Begin() override;
+};
+
+class DeviceRequest : public PumpedAwaiter {
+private:
+    WGPUAdapter m_Adapter;
+    const WGPUDeviceDescriptor *m_Descriptor;
+    WGPUDevice m_Device = nullptr;
+
+public:
+    DeviceRequest(EventPump &pump, WGPUAdapter adapter, const WGPUDeviceDescriptor *descriptor)
+        : PumpedAwaiter(pump), m_Adapter(adapter), m_Descriptor(descriptor) {}
+
+    // nullptr if the request failed, the caller owns the device.
+    WGPUDevice await_resume() const { return m_Device; }
+
+protected:
+    void Begin() override;
+};
+
+class BufferMapRequest : public PumpedAwaiter {
+private:
+    WGPUBuffer m_Buffer;
+    WGPUMapModeFlags m_Mode;
+    size_t m_Offset;
+    size_t m_Size;
+    WGPUBufferMapAsyncStatus m_Status = WGPUBufferMapAsyncStatus_Unknown;
+
+public:
+    BufferMapRequest(EventPump &pump, WGPUBuffer buffer, WGPUMapModeFlags mode, size_t offset, size_t size)
+        : PumpedAwaiter(pump), m_Buffer(buffer), m_Mode(mode), m_Offset(offset), m_Size(size) {}
+
+    WGPUBufferMapAsyncStatus await_resume() const { return m_Status; }
+
+protected:
+    void Begin() override;
+};
+
+class QueueWorkDoneRequest : public PumpedAwaiter {
+private:
+    WGPUQueue m_Queue;
+    WGPUQueueWorkDoneStatus m_Status = WGPUQueueWorkDoneStatus_Unknown;
+
+public:
+    QueueWorkDoneRequest(EventPump &pump, WGPUQueue queue) : PumpedAwaiter(pump), m_Queue(queue) {}
+
+    WGPUQueueWorkDoneStatus await_resume() const { return m_Status; }
+
+protected:
+    void Begin() override;
+};
+
+/**
+ * Runs a blocking function on a worker and resumes the coroutine through
+ * the pump with its result.
+ */
+template <typename T>
+class WorkerRequest {
+private:
+    EventPump *m_Pump;
+    ThreadPool *m_Workers;
+    std::function<T()> m_Function;
+    T m_Result{};
+
+public:
+    WorkerRequest(EventPump &pump, ThreadPool &workers, std::function<T()> function)
+        : m_Pump(&pump), m_Workers(&workers), m_Function(std::move(function)) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> waiting) {
+        m_Workers->Submit([this, waiting] {
+            m_Result = m_Function();
+            m_Pump->Schedule(waiting);
+        });
+    }
+
+    T await_resume() { return std::move(m_Result); }
+};
+
+inline AdapterRequest RequestAdapterAsync(EventPump &pump, WGPUInstance instance, const WGPURequestAdapterOptions *options) {
+    return AdapterRequest(pump, instance, options);
+}
+
+inline DeviceRequest RequestDeviceAsync(EventPump &pump, WGPUAdapter adapter, const WGPUDeviceDescriptor *descriptor) {
+    return DeviceRequest(pump, adapter, descriptor);
+}
+
+inline BufferMapRequest MapBufferAsync(EventPump &pump, WGPUBuffer buffer, WGPUMapModeFlags mode, size_t offset, size_t size) {
+    return BufferMapRequest(pump, buffer, mode, offset, size);
+}
+
+// Completes once the work submitted so far is done.
+inline QueueWorkDoneRequest QueueWorkDoneAsync(EventPump &pump, WGPUQueue queue) {
+    return QueueWorkDoneRequest(pump, queue);
+}
+
+// wgpu-native does not implement wgpuDeviceCreateRenderPipelineAsync, the
+// pipeline is created on a worker instead. The descriptor must stay valid
+// until the coroutine resumes, which it does when it lives in the frame of
+// the awaiting coroutine.
+WorkerRequest<WGPURenderPipeline> CreateRenderPipelineAsync(EventPump &pump, ThreadPool &workers, WGPUDevice device, const WGPURenderPipelineDescriptor *descriptor);
+
+template <typename Awaitable>
+auto EventPump::Run(Awaitable awaitable) {
+    using Result = decltype(awaitable.await_resume());
+    auto task = [](Awaitable inner) -> Task<Result> { co_return co_await inner; }(std::move(awaitable));
+
+    task.Start();
+    while (!task.IsDone()) {
+        Wait();
+    }
+    return task.TakeResult();
+}
+
+void PrintEventPumpStats(const EventPumpStats &stats);
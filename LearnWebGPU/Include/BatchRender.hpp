@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+/**
+ * The parameters of one frame of a batch render.
+ */
+struct BatchFrame {
+    // Where the center of the logo goes, in scene coordinates.
+    float OffsetX = 0.0f;
+    float OffsetY = 0.0f;
+    float Scale = 1.0f;
+    // Multiplies the colors of the logo.
+    float Tint[3] = { 1.0f, 1.0f, 1.0f };
+    double ClearColor[3] = { 0.05, 0.05, 0.05 };
+};
+
+struct BatchStats {
+    uint64_t Frames = 0;
+    // Until the last frame was submitted, then until the last image was
+    // saved.
+    double SubmitSeconds = 0.0;
+    double TotalSeconds = 0.0;
+    // Frames that found every readback slot in flight and had to wait.
+    uint64_t ReadbackWaits = 0;
+};
+
+/**
+ * Read a batch file: one frame per line, made of
+ *     offsetX offsetY scale tintR tintG tintB [clearR clearG clearB]
+ * Empty lines and lines starting with # are ignored.
+ */
+bool LoadBatchFile(const std::filesystem::path &path, std::vector<BatchFrame> &frames);
+
+// Where frame index of a batch is saved.
+std::filesystem::path GetBatchFramePath(const std::filesystem::path &directory, uint64_t index);
+
+void PrintBatchStats(const BatchStats &stats);
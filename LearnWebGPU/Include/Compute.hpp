@@ -0,0 +1,49 @@
+#pragma once
+
+#include <webgpu/webgpu.h>
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+
+#include "ShaderCache.hpp"
+#include "WebGPUHandles.hpp"
+
+/**
+ * Everything that determines a compute pipeline.
+ */
+struct ComputePipelineState {
+    std::string ShaderPath;
+    std::string EntryPoint = "main";
+    // nullptr lets the implementation derive the layout from the shader.
+    WGPUPipelineLayout Layout = nullptr;
+};
+
+// Create a compute pipeline from a shader of the cache, which compiles the
+// module only once however many entry points are used. Blocks until the
+// pipeline is compiled.
+ComputePipelineHandle CreateComputePipeline(WGPUDevice device, ShaderCache &shaderCache, const ComputePipelineState &state);
+
+// Layout entries of the buffers of a compute shader.
+WGPUBindGroupLayoutEntry StorageBufferLayoutEntry(uint32_t binding, bool readOnly, WGPUShaderStageFlags visibility = WGPUShaderStage_Compute);
+WGPUBindGroupLayoutEntry UniformBufferLayoutEntry(uint32_t binding, uint64_t minBindingSize, WGPUShaderStageFlags visibility = WGPUShaderStage_Compute);
+
+// Layout entries of 2D textures and of samplers.
+WGPUBindGroupLayoutEntry SampledTextureLayoutEntry(uint32_t binding, WGPUTextureSampleType sampleType, WGPUShaderStageFlags visibility = WGPUShaderStage_Compute);
+WGPUBindGroupLayoutEntry StorageTextureLayoutEntry(uint32_t binding, WGPUTextureFormat format, WGPUShaderStageFlags visibility = WGPUShaderStage_Compute);
+WGPUBindGroupLayoutEntry SamplerLayoutEntry(uint32_t binding, WGPUSamplerBindingType type, WGPUShaderStageFlags visibility = WGPUShaderStage_Compute);
+
+WGPUBindGroupEntry BufferBindingEntry(uint32_t binding, WGPUBuffer buffer, uint64_t offset, uint64_t size);
+WGPUBindGroupEntry TextureBindingEntry(uint32_t binding, WGPUTextureView view);
+WGPUBindGroupEntry SamplerBindingEntry(uint32_t binding, WGPUSampler sampler);
+
+BindGroupLayoutHandle CreateBindGroupLayout(WGPUDevice device, const char *label, std::initializer_list<WGPUBindGroupLayoutEntry> entries);
+BindGroupHandle CreateBindGroup(WGPUDevice device, WGPUBindGroupLayout layout, const char *label, std::initializer_list<WGPUBindGroupEntry> entries);
+PipelineLayoutHandle CreatePipelineLayout(WGPUDevice device, const char *label, WGPUBindGroupLayout bindGroupLayout);
+
+inline uint32_t DivideRoundUp(uint32_t count, uint32_t groupSize) {
+    return (count + groupSize - 1) / groupSize;
+}
+
+// Bind group 0 and dispatch a one dimensional grid of workgroups.
+void Dispatch(WGPUComputePassEncoder pass, WGPUComputePipeline pipeline, WGPUBindGroup bindGroup, uint32_t workgroupCount);
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <webgpu/webgpu.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "Compute.hpp"
+#include "GpuMemoryTracker.hpp"
+#include "ShaderCache.hpp"
+#include "WebGPUHandles.hpp"
+
+enum ScanType : uint32_t {
+    // output[i] = input[0] + ... + input[i]
+    ScanType_Inclusive,
+    // output[i] = input[0] + ... + input[i - 1]
+    ScanType_Exclusive,
+};
+
+/**
+ * A small library of data-parallel primitives on arrays of u32, recorded
+ * into a command encoder: reduction, prefix scan, radix sort and stream
+ * compaction. Sums wrap around on overflow like u32 arithmetic does.
+ *
+ * Sizes are given to the shaders through the size of the bindings, so that
+ * no uniform has to be written between dispatches. Each call records one
+ * compute pass, and scratch memory grows to the largest count seen (or
+ * given to Reserve()).
+ *
+ * Kernels read from and write to different buffers: WebGPU does not allow a
+ * buffer to be bound both read-only and writable in the same dispatch.
+ */
+class ComputeKernels {
+public:
+    // Elements per workgroup, which must match the shaders.
+    static constexpr uint32_t ReduceBlockSize = 2048;
+    static constexpr uint32_t BlockSize = 1024;
+    static constexpr uint32_t RadixBits = 4;
+    static constexpr uint32_t RadixSize = 1 << RadixBits;
+    static constexpr uint32_t RadixPasses = 32 / RadixBits;
+
+private:
+    struct ScanLevel {
+        BufferHandle Sums;
+        BufferHandle Offsets;
+    };
+
+    WGPUDevice m_Device = nullptr;
+    GpuMemoryTracker *m_Memory = nullptr;
+    uint32_t m_MaxCount = 0;
+
+    BindGroupLayoutHandle m_ReduceLayout;
+    BindGroupLayoutHandle m_ScanLayout;
+    BindGroupLayoutHandle m_RadixLayout;
+    BindGroupLayoutHandle m_CompactLayout;
+    PipelineLayoutHandle m_ReducePipelineLayout;
+    PipelineLayoutHandle m_ScanPipelineLayout;
+    PipelineLayoutHandle m_RadixPipelineLayout;
+    PipelineLayoutHandle m_CompactPipelineLayout;
+
+    ComputePipelineHandle m_ReduceSum;
+    ComputePipelineHandle m_ScanInclusive;
+    ComputePipelineHandle m_ScanExclusive;
+    ComputePipelineHandle m_ScanFlagsExclusive;
+    ComputePipelineHandle m_AddBlockOffsets;
+    ComputePipelineHandle m_RadixHistogram;
+    ComputePipelineHandle m_RadixScatter;
+    ComputePipelineHandle m_CompactScatter;
+
+    // The shift of each radix pass, one per uniform offset alignment.
+    BufferHandle m_RadixParams;
+    uint32_t m_RadixParamsStride = 256;
+
+    // Scratch memory, sized for m_Capacity elements.
+    uint32_t m_Capacity = 0;
+    std::vector<ScanLevel> m_ScanLevels;
+    BufferHandle m_ReducePartials[2];
+    BufferHandle m_RadixKeys;
+    BufferHandle m_RadixHistograms;
+    BufferHandle m_RadixOffsets;
+    BufferHandle m_CompactPositions;
+
+public:
+    // Compiles every kernel, blocking. Returns false when the device limits
+    // are too low for them.
+    bool Initialize(WGPUDevice device, WGPUQueue queue, ShaderCache &shaderCache, GpuMemoryTracker &memory);
+
+    // The device must be idle.
+    void Terminate();
+
+    // Allocate the scratch memory for count elements now rather than on the
+    // first call that needs it.
+    bool Reserve(uint32_t count);
+
+    // Most elements a single call can process, limited by the number of
+    // workgroups per dispatch.
+    uint32_t GetMaxCount() const { return m_MaxCount; }
+
+    // output[0] = input[0] + ... + input[count - 1]
+    void Reduce(WGPUCommandEncoder encoder, WGPUBuffer input, uint32_t count, WGPUBuffer output);
+
+    void Scan(WGPUCommandEncoder encoder, WGPUBuffer input, WGPUBuffer output, uint32_t count, ScanType type);
+
+    // Sort 32-bit keys in place, in increasing order.
+    void RadixSort(WGPUCommandEncoder encoder, WGPUBuffer keys, uint32_t count);
+
+    // Copy the values whose flag is not zero to output, keeping their order,
+    // and write how many there are to outputCount[0]. output must have room
+    // for count values.
+    void Compact(WGPUCommandEncoder encoder, WGPUBuffer values, WGPUBuffer flags, uint32_t count, WGPUBuffer output, WGPUBuffer outputCount);
+
+private:
+    bool CheckCount(uint32_t count, const char *kernel);
+    WGPUComputePassEncoder BeginPass(WGPUCommandEncoder encoder, const char *label) const;
+    // Scan count elements of input, at the given level of the recursion over
+    // block sums.
+    void RecordScan(WGPUComputePassEncoder pass, WGPUBuffer input, WGPUBuffer output, uint32_t count, WGPUComputePipeline pipeline, uint32_t level);
+    BufferHandle CreateScratchBuffer(const char *label, uint32_t count) const;
+    void ReleaseScratch();
+};
+
+// CPU versions of the kernels, to validate them.
+uint32_t ReduceReference(const std::vector<uint32_t> &input);
+std::vector<uint32_t> ScanReference(const std::vector<uint32_t> &input, ScanType type);
+std::vector<uint32_t> RadixSortReference(const std::vector<uint32_t> &keys);
+std::vector<uint32_t> CompactReference(const std::vector<uint32_t> &values, const std::vector<uint32_t> &flags);
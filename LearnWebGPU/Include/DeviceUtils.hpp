@@ -7,17 +7,20 @@
  *     WGPUAdapter adapter = requestAdapterSync(instance, options);
  * is roughly equivalent to
  *     const adapter = await navigator.gpu.requestAdapter(options);
+ * It pumps the instance's events until the request completes, coroutines
+ * can co_await RequestAdapterAsync() instead (see Async.hpp).
  */
 WGPUAdapter RequestAdapterSync(WGPUInstance instance, WGPURequestAdapterOptions const *options);
 
 /**
  * Utility function to get a WebGPU device, so that
- *     WGPUDevice device = requestDeviceSync(adapter, options);
+ *     WGPUDevice device = requestDeviceSync(instance, adapter, options);
  * is roughly equivalent to
  *     const adapter = await adapter.requestDevice(descriptor);
- * It is very similar to requestAdapter
+ * It is very similar to requestAdapter, the instance is the one whose
+ * events are pumped.
  */
-WGPUDevice RequestDeviceSync(WGPUAdapter adapter, WGPUDeviceDescriptor const *descriptor);
+WGPUDevice RequestDeviceSync(WGPUInstance instance, WGPUAdapter adapter, WGPUDeviceDescriptor const *descriptor);
 
 void InspectAdapter(WGPUAdapter adapter);
 
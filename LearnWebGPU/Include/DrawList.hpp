@@ -0,0 +1,149 @@
+#pragma once
+
+#include <webgpu/webgpu.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "FrameController.hpp"
+#include "GeometryPool.hpp"
+#include "Matrix4.hpp"
+#include "WebGPUHandles.hpp"
+
+/**
+ * Per-draw data, read by the vertex shader from a storage buffer indexed by
+ * @builtin(instance_index). Must match the DrawData struct of the shaders.
+ */
+struct DrawData {
+    // Model to scene, usually the world matrix of a TransformHierarchy node.
+    // The scene's z is the depth in [0, 1], 0 being the closest to the viewer.
+    Matrix4 Transform;
+    // Multiplies the vertex colors, alpha is unused.
+    float Tint[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+};
+
+static_assert(sizeof(DrawData) == 80, "DrawData must match the WGSL layout");
+
+/**
+ * Arguments of one indexed draw, as wgpuRenderPassEncoderMultiDrawIndexedIndirect
+ * reads them from the indirect buffer.
+ */
+struct DrawIndexedIndirectArgs {
+    uint32_t IndexCount = 0;
+    uint32_t InstanceCount = 0;
+    uint32_t FirstIndex = 0;
+    int32_t BaseVertex = 0;
+    uint32_t FirstInstance = 0;
+};
+
+static_assert(sizeof(DrawIndexedIndirectArgs) == 20, "DrawIndexedIndirectArgs must match the GPU layout");
+
+struct DrawListStats {
+    uint32_t Draws = 0;
+    // Number of wgpuRenderPassEncoderDrawIndexed calls, after merging
+    // consecutive draws of the same mesh into instanced draws.
+    uint32_t DrawCalls = 0;
+    // With multi-draw-indirect, those draws are recorded with one call per
+    // run of draws from the same geometry pool page instead.
+    uint32_t MultiDrawCalls = 0;
+    // Draws added to a full list, which are not drawn.
+    uint32_t Dropped = 0;
+    bool Sorted = false;
+};
+
+/**
+ * The opaque draws of one frame.
+ *
+ * Draw data is uploaded through the frame controller and bound once with a
+ * dynamic offset, and each draw reads its own entry through its instance
+ * index. Sorting front to back before submitting lets the depth test reject
+ * hidden fragments before they are shaded (early-Z).
+ *
+ * When the device has the native multi-draw-indirect feature, and indirect
+ * draws may start at a non-zero instance, the arguments of the draws are
+ * uploaded along with their data, and every run of draws from the same
+ * page is a single indirect call.
+ */
+class DrawList {
+public:
+    // Every scene of the application with single-part meshes.
+    static constexpr uint32_t DefaultMaxDraws = 1024;
+
+    // The device's maxStorageBufferBindingSize must be at least this.
+    static constexpr uint64_t GetBindingSize(uint32_t maxDraws) { return uint64_t{ maxDraws } * sizeof(DrawData); }
+    // Frame controller memory a list may use per frame.
+    static constexpr uint64_t GetFrameBytes(uint32_t maxDraws) { return GetBindingSize(maxDraws) + uint64_t{ maxDraws } * sizeof(DrawIndexedIndirectArgs); }
+
+private:
+    // Consecutive draws of the same mesh, drawn as one instanced draw.
+    struct DrawCommand {
+        GeometryHandle Mesh = InvalidGeometryHandle;
+        uint32_t Page = 0;
+        uint32_t FirstInstance = 0;
+        uint32_t InstanceCount = 0;
+    };
+
+    WGPUDevice m_Device = nullptr;
+    FrameController *m_FrameController = nullptr;
+    uint32_t m_MaxDraws = 0;
+
+    BindGroupLayoutHandle m_BindGroupLayout;
+    BindGroupHandle m_BindGroup;
+
+    std::vector<GeometryHandle> m_Meshes;
+    std::vector<DrawData> m_Data;
+    // Depth in the high bits, draw index in the low bits: sorting the keys
+    // sorts the draws without moving them.
+    std::vector<uint64_t> m_Order;
+    bool m_Sorted = false;
+    // Where Upload() put the draw data of this frame, and the draws it
+    // merged them into. Any change to the list requires another upload.
+    uint32_t m_DynamicOffset = 0;
+    std::vector<DrawCommand> m_Commands;
+    bool m_Uploaded = false;
+    uint32_t m_Dropped = 0;
+    // Overflows are only reported once.
+    bool m_OverflowReported = false;
+
+    bool m_MultiDrawIndirect = false;
+    WGPUBuffer m_IndirectBuffer = nullptr;
+    uint64_t m_IndirectOffset = 0;
+
+    DrawListStats m_Stats;
+
+public:
+    // The bind group points at the frame controller's upload buffer, which
+    // must therefore outlive the draw list, and give each frame at least
+    // GetFrameBytes(maxDraws).
+    bool Initialize(WGPUDevice device, FrameController &frameController, uint32_t maxDraws = DefaultMaxDraws);
+
+    void Terminate();
+
+    // Layout of bind group 0 for the pipelines drawing from this list.
+    WGPUBindGroupLayout GetBindGroupLayout() const { return m_BindGroupLayout; }
+
+    void Clear();
+
+    // Returns false, and counts the draw as dropped, when the list is full.
+    // Draws are sorted on the depth of their model space origin.
+    bool Add(GeometryHandle mesh, const DrawData &data);
+
+    void SortFrontToBack();
+
+    // Upload the draw data of this frame, bind it to group 0 and record the
+    // draws, binding the geometry pool pages they draw from.
+    void Submit(WGPURenderPassEncoder renderPass, const GeometryPool &geometryPool);
+
+    // The two halves of Submit(), for lists drawn in several passes: the
+    // data is uploaded once, and each Record() binds it and records the
+    // draws. Upload() returns false when there is nothing to record.
+    bool Upload(const GeometryPool &geometryPool);
+    void Record(WGPURenderPassEncoder renderPass, const GeometryPool &geometryPool);
+
+    bool UsesMultiDrawIndirect() const { return m_MultiDrawIndirect; }
+
+    uint32_t GetDrawCount() const { return static_cast<uint32_t>(m_Data.size()); }
+    uint32_t GetMaxDraws() const { return m_MaxDraws; }
+
+    const DrawListStats &GetStats() const { return m_Stats; }
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+
+struct DynamicResolutionSettings {
+    // GPU time we want a frame to take.
+    double TargetSeconds = 1.0 / 60.0;
+
+    // Fraction of the output size the scene is rendered at.
+    float MinScale = 0.5f;
+    float MaxScale = 1.0f;
+    // Scales are multiples of this, so that noise in the measurements does
+    // not translate into tiny resolution changes.
+    float ScaleStep = 0.05f;
+
+    // Hysteresis band around the target, as ratios of it: the scale goes down
+    // above the upper one and up below the lower one, and stays put between.
+    double UpperThreshold = 1.0;
+    double LowerThreshold = 0.8;
+
+    // Samples ignored after a change. They were mostly rendered at the
+    // previous scale, since GPU timings arrive a few frames late.
+    uint32_t CooldownSamples = 8;
+
+    // Weight of a new sample in the smoothed GPU time.
+    double Smoothing = 0.2;
+};
+
+struct DynamicResolutionStats {
+    uint64_t Samples = 0;
+    uint64_t SamplesOverBudget = 0;
+    uint64_t Increases = 0;
+    uint64_t Decreases = 0;
+    float Scale = 1.0f;
+    float LowestScale = 1.0f;
+    double SmoothedSeconds = 0.0;
+};
+
+/**
+ * Picks the resolution the scene is rendered at from measured GPU frame
+ * times, so that weak or busy GPUs lose sharpness instead of frames.
+ *
+ * The cost of a frame is assumed to grow with its pixel count, i.e. with the
+ * square of the scale. Going down jumps straight to the scale expected to
+ * fit in the middle of the hysteresis band; going up is done one step at a
+ * time since a fast frame says little about how much headroom there is.
+ */
+class DynamicResolution {
+private:
+    DynamicResolutionSettings m_Settings;
+    float m_Scale = 1.0f;
+    double m_SmoothedSeconds = 0.0;
+    bool m_HasSample = false;
+    uint32_t m_Cooldown = 0;
+
+    DynamicResolutionStats m_Stats;
+
+public:
+    // Starts at the maximum scale.
+    void Initialize(const DynamicResolutionSettings &settings);
+
+    // Feed the GPU time of a frame. Returns true when the scale changed.
+    bool AddSample(double gpuSeconds);
+
+    float GetScale() const { return m_Scale; }
+
+    // The size to render at for a given output size, at least 1x1.
+    void GetRenderSize(uint32_t outputWidth, uint32_t outputHeight, uint32_t &width, uint32_t &height) const;
+
+    const DynamicResolutionSettings &GetSettings() const { return m_Settings; }
+    const DynamicResolutionStats &GetStats() const { return m_Stats; }
+};
+
+void PrintDynamicResolutionStats(const DynamicResolutionStats &stats, const DynamicResolutionSettings &settings);
@@ -3,9 +3,23 @@
 #include <webgpu/webgpu.h>
 
 #include <filesystem>
+#include <string>
+#include <vector>
 
 namespace fs = std::filesystem;
 
-bool LoadGeometry(const fs::path &path, std::vector<float> &pointData, std::vector<uint16_t> &indexData);
+// Indices are 32-bit, see SplitMesh() to draw meshes with more than 65536
+// vertices.
+bool LoadGeometry(const fs::path &path, std::vector<float> &pointData, std::vector<uint32_t> &indexData);
 
-WGPUShaderModule LoadShaderModule(const fs::path &path, WGPUDevice device);
\ No newline at end of file
+bool LoadTextFile(const fs::path &path, std::string &text);
+
+WGPUShaderModule CreateShaderModule(const std::string &source, WGPUDevice device, const char *label = nullptr);
+
+// Save tightly packed 8-bit RGBA (or BGRA) pixels as a binary PPM image,
+// without the alpha channel.
+bool SaveImagePPM(const fs::path &path, uint32_t width, uint32_t height, const uint8_t *pixels, bool bgra);
+
+// Load a binary PPM image (P6, 8 bits per channel) as tightly packed RGBA
+// pixels, with an opaque alpha channel.
+bool LoadImagePPM(const fs::path &path, uint32_t &width, uint32_t &height, std::vector<uint8_t> &pixels);
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <webgpu/webgpu.h>
+#include <webgpu/wgpu.h>
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "Async.hpp"
+#include "GpuMemoryTracker.hpp"
+#include "WebGPUHandles.hpp"
+
+/**
+ * A piece of this frame's upload memory. Data written to Data before the
+ * frame is submitted ends up at Offset in Buffer.
+ */
+struct FrameAllocation {
+    WGPUBuffer Buffer = nullptr;
+    uint64_t Offset = 0;
+    uint64_t Size = 0;
+    void *Data = nullptr;
+};
+
+struct FrameStats {
+    uint64_t SubmittedFrames = 0;
+    uint64_t CompletedFrames = 0;
+    // How many times BeginFrame() had to wait for the GPU, and for how long.
+    uint64_t Stalls = 0;
+    double StallSeconds = 0.0;
+    // Time between the submission of the last completed frame and the moment
+    // we noticed it was done.
+    double LastFrameLatencySeconds = 0.0;
+};
+
+/**
+ * Keeps the CPU at most N frames ahead of the GPU.
+ *
+ * Each submission is tracked by a coroutine awaiting QueueWorkDoneAsync(),
+ * resumed by the event pump, and BeginFrame() only blocks when the frame
+ * that last used the same slot has not completed yet. Per-frame resources (uniform slices, staging memory)
+ * live in those slots, so they can be rewritten without waiting on the GPU.
+ */
+class FrameController {
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct FrameSlot {
+        uint64_t FrameNumber = 0;
+        WGPUSubmissionIndex SubmissionIndex = 0;
+        Clock::time_point SubmitTime;
+        // Done once the GPU has finished the frame, or if nothing was
+        // submitted from this slot yet.
+        Task<bool> WorkDone;
+
+        // CPU copy of this slot's range of the upload buffer, flushed with
+        // one wgpuQueueWriteBuffer on submit.
+        std::vector<uint8_t> Staging;
+        uint64_t UsedBytes = 0;
+    };
+
+    WGPUDevice m_Device = nullptr;
+    WGPUQueue m_Queue = nullptr;
+    EventPump *m_Pump = nullptr;
+    GpuMemoryTracker *m_Memory = nullptr;
+
+    std::vector<FrameSlot> m_Slots;
+    BufferHandle m_UploadBuffer;
+    uint64_t m_BytesPerFrame = 0;
+    uint32_t m_Alignment = 256;
+
+    // Frame numbers start at 1 so that 0 means "nothing submitted yet".
+    uint64_t m_FrameNumber = 1;
+    uint64_t m_LastCompletedFrame = 0;
+    bool m_FrameBegun = false;
+
+    FrameStats m_Stats;
+
+public:
+    // Completions are resumed by pump, which must be pumped from the thread
+    // that uses the controller.
+    bool Initialize(WGPUDevice device, WGPUQueue queue, EventPump &pump, GpuMemoryTracker &memory, uint32_t framesInFlight = 2, uint64_t bytesPerFrame = 64 * 1024);
+
+    void Terminate();
+
+    // Wait until the slot of this frame is free again, i.e. until the GPU
+    // is at most framesInFlight - 1 frames behind. Calling it several times
+    // before Submit() is harmless.
+    void BeginFrame();
+
+    // Carve some of this frame's upload memory, aligned for use as a uniform
+    // or storage buffer binding, or as indirect draw arguments. Returns an
+    // allocation with a null Data pointer when the frame has run out of
+    // space.
+    FrameAllocation Allocate(uint64_t size);
+
+    // Upload this frame's staging memory, submit the command buffer and
+    // move on to the next frame.
+    void Submit(WGPUCommandBuffer commandBuffer);
+
+    // Block until every submitted frame has completed.
+    void WaitIdle();
+
+    uint32_t GetFramesInFlight() const { return static_cast<uint32_t>(m_Slots.size()); }
+    uint64_t GetFrameNumber() const { return m_FrameNumber; }
+    WGPUBuffer GetUploadBuffer() const { return m_UploadBuffer; }
+
+    const FrameStats &GetStats() const { return m_Stats; }
+
+private:
+    FrameSlot &CurrentSlot() { return m_Slots[m_FrameNumber % m_Slots.size()]; }
+
+    Task<bool> TrackFrame(uint64_t frameNumber);
+
+    void WaitForFrame(const FrameSlot &slot);
+};
+
+void PrintFrameStats(const FrameStats &stats);
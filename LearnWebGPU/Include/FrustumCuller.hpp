@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "ThreadPool.hpp"
+
+/**
+ * A plane such that Normal . p + Distance >= 0 for the points p in front of
+ * it. Normal is unit length, so the value is a signed distance.
+ */
+struct Plane {
+    float Normal[3] = { 0.0f, 0.0f, 0.0f };
+    float Distance = 0.0f;
+};
+
+struct Frustum {
+    // Left, right, bottom, top, near, far, all facing inwards.
+    Plane Planes[6];
+};
+
+// Extract the frustum planes from a column-major view-projection matrix (the
+// layout of a WGSL mat4x4f), assuming WebGPU clip space: x and y in [-1, 1]
+// and z in [0, 1].
+Frustum MakeFrustum(const float *viewProjection);
+
+struct BoundingSphere {
+    float Center[3] = { 0.0f, 0.0f, 0.0f };
+    float Radius = 0.0f;
+};
+
+/**
+ * Instruction sets the culling loop is implemented with. The best one the
+ * CPU supports is picked at runtime.
+ */
+enum CullingKernel : uint32_t {
+    CullingKernel_Scalar,
+    // 4 spheres per iteration.
+    CullingKernel_SSE,
+    // 8 spheres per iteration, requires AVX2 and FMA.
+    CullingKernel_AVX2,
+};
+
+bool IsCullingKernelSupported(CullingKernel kernel);
+CullingKernel GetBestCullingKernel();
+const char *GetCullingKernelName(CullingKernel kernel);
+
+struct CullingStats {
+    uint32_t Tested = 0;
+    uint32_t Visible = 0;
+    double Seconds = 0.0;
+};
+
+/**
+ * Tests bounding spheres against a view frustum.
+ *
+ * Spheres are stored as structure of arrays so that the SIMD kernels load
+ * the same coordinate of 4 or 8 objects at once. Large sets are split in
+ * chunks culled in parallel on a thread pool, each into its own part of a
+ * scratch buffer, and then compacted into a single list of visible indices
+ * in increasing order.
+ */
+class FrustumCuller {
+public:
+    // Objects per parallel job, big enough to amortize the scheduling.
+    static constexpr uint32_t ChunkSize = 16 * 1024;
+
+private:
+    std::vector<float> m_CenterX;
+    std::vector<float> m_CenterY;
+    std::vector<float> m_CenterZ;
+    std::vector<float> m_Radius;
+
+    CullingKernel m_Kernel = GetBestCullingKernel();
+    ThreadPool *m_Workers = nullptr;
+
+    // Per chunk results, ChunkSize + 8 entries per chunk because the AVX2
+    // kernel always stores 8 indices at once.
+    std::vector<uint32_t> m_ChunkVisible;
+    std::vector<uint32_t> m_ChunkCounts;
+
+    CullingStats m_Stats;
+
+public:
+    // Without a thread pool, everything is culled on the calling thread.
+    void SetThreadPool(ThreadPool *workers) { m_Workers = workers; }
+
+    // Returns false if the CPU does not support the kernel.
+    bool SetKernel(CullingKernel kernel);
+    CullingKernel GetKernel() const { return m_Kernel; }
+
+    void Clear();
+    void Reserve(uint32_t count);
+
+    // Returns the index of the sphere, which is what Cull() outputs.
+    uint32_t Add(const BoundingSphere &sphere);
+    void Set(uint32_t index, const BoundingSphere &sphere);
+
+    uint32_t GetCount() const { return static_cast<uint32_t>(m_Radius.size()); }
+
+    // Replace the content of visible with the indices of the spheres that
+    // intersect the frustum, in increasing order.
+    void Cull(const Frustum &frustum, std::vector<uint32_t> &visible);
+
+    const CullingStats &GetStats() const { return m_Stats; }
+};
+
+// Stats of the last Cull().
+void PrintCullingStats(const CullingStats &stats, CullingKernel kernel);
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <webgpu/webgpu.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "GpuMemoryTracker.hpp"
+#include "RangeAllocator.hpp"
+#include "WebGPUHandles.hpp"
+
+using GeometryHandle = uint32_t;
+constexpr GeometryHandle InvalidGeometryHandle = 0xffffffff;
+
+struct GeometryPoolDescriptor {
+    // Size in bytes of one vertex, must be a multiple of 4.
+    uint32_t VertexStride = 0;
+    // Number of vertices the pooled vertex buffer can hold.
+    uint32_t VertexCapacity = 0;
+    // Number of uint16_t indices the pooled index buffer can hold.
+    uint32_t IndexCapacity = 0;
+    // Number of vertex/index buffer pairs (pages) of the above capacities
+    // the pool may create, the next one when the others are full. A mesh
+    // must fit in one page.
+    uint32_t MaxPages = 1;
+};
+
+/**
+ * Where a mesh lives inside the pooled buffers, expressed in the units
+ * wgpuRenderPassEncoderDrawIndexed expects.
+ */
+struct GeometryRange {
+    uint32_t BaseVertex = 0;
+    uint32_t VertexCount = 0;
+    uint32_t FirstIndex = 0;
+    uint32_t IndexCount = 0;
+};
+
+struct GeometryPageStats {
+    RangeAllocator::Stats Vertices;
+    RangeAllocator::Stats Indices;
+};
+
+struct GeometryPoolStats {
+    std::vector<GeometryPageStats> Pages;
+    uint32_t DefragmentationCount = 0;
+    uint64_t BytesMoved = 0;
+};
+
+/**
+ * Sub-allocates the vertex and index data of many meshes out of a single
+ * vertex buffer and a single index buffer, so that they can all be drawn
+ * with one buffer bind and per-draw baseVertex/firstIndex offsets. When
+ * they are full, and the descriptor allows it, another pair of buffers is
+ * created: meshes of the same page share the bind.
+ *
+ * Meshes are referred to by handle rather than by range, because
+ * Defragment() may move them around.
+ */
+class GeometryPool {
+private:
+    struct Entry {
+        RangeAllocator::Allocation VertexAllocation;
+        RangeAllocator::Allocation IndexAllocation;
+        GeometryRange Range;
+        uint32_t Page = 0;
+        bool Alive = false;
+    };
+
+    struct Page {
+        BufferHandle VertexBuffer;
+        BufferHandle IndexBuffer;
+        RangeAllocator VertexAllocator;
+        RangeAllocator IndexAllocator;
+    };
+
+    WGPUDevice m_Device = nullptr;
+    WGPUQueue m_Queue = nullptr;
+    GpuMemoryTracker *m_Memory = nullptr;
+    GeometryPoolDescriptor m_Descriptor;
+
+    std::vector<Page> m_Pages;
+
+    std::vector<Entry> m_Entries;
+    std::vector<GeometryHandle> m_FreeHandles;
+
+    uint32_t m_DefragmentationCount = 0;
+    uint64_t m_BytesMoved = 0;
+
+public:
+    bool Initialize(WGPUDevice device, WGPUQueue queue, GpuMemoryTracker &memory, const GeometryPoolDescriptor &descriptor);
+
+    void Terminate();
+
+    // Reserve room for a mesh. Returns InvalidGeometryHandle when the pool is
+    // full or the mesh does not fit in a page.
+    GeometryHandle Allocate(uint32_t vertexCount, uint32_t indexCount);
+
+    // Allocate room for a mesh and upload its data right away.
+    GeometryHandle Add(const void *vertexData, uint32_t vertexCount, const uint16_t *indexData, uint32_t indexCount);
+
+    void Upload(GeometryHandle handle, const void *vertexData, const uint16_t *indexData) const;
+
+    void Free(GeometryHandle handle);
+
+    const GeometryRange &GetRange(GeometryHandle handle) const;
+
+    uint32_t GetPage(GeometryHandle handle) const;
+
+    // Bind the buffers of a page once, every mesh of that page can then be
+    // drawn with Draw() until another vertex/index buffer is bound.
+    void Bind(WGPURenderPassEncoder renderPass, uint32_t page, uint32_t slot = 0) const;
+
+    void Draw(WGPURenderPassEncoder renderPass, GeometryHandle handle, uint32_t instanceCount = 1, uint32_t firstInstance = 0) const;
+
+    // Pack every live mesh at the beginning of freshly allocated buffers,
+    // page by page. The copies are recorded in the given encoder, so the
+    // caller must submit it before drawing from the pool again. Returns
+    // false when there was nothing to compact.
+    bool Defragment(WGPUCommandEncoder encoder);
+
+    GeometryPoolStats GetStats() const;
+
+    WGPUBuffer GetVertexBuffer(uint32_t page) const { return m_Pages[page].VertexBuffer; }
+    WGPUBuffer GetIndexBuffer(uint32_t page) const { return m_Pages[page].IndexBuffer; }
+
+private:
+    bool AddPage();
+
+    bool DefragmentPage(WGPUCommandEncoder encoder, uint32_t page);
+
+    void CreateBuffers(BufferHandle &vertexBuffer, BufferHandle &indexBuffer) const;
+};
+
+void PrintGeometryPoolStats(const GeometryPoolStats &stats);
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <webgpu/webgpu.h>
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+#include "WebGPUHandles.hpp"
+
+/**
+ * What a GPU allocation is used for, so that memory can be broken down when
+ * sizing a machine.
+ */
+enum GpuMemoryCategory : uint32_t {
+    GpuMemoryCategory_Vertex,
+    GpuMemoryCategory_Index,
+    GpuMemoryCategory_Uniform,
+    GpuMemoryCategory_Staging,
+    GpuMemoryCategory_Texture,
+    // Storage buffers of compute kernels.
+    GpuMemoryCategory_Storage,
+    GpuMemoryCategory_Count,
+};
+
+const char *GetGpuMemoryCategoryName(GpuMemoryCategory category);
+
+struct GpuMemoryStats {
+    uint64_t LiveBytes[GpuMemoryCategory_Count] = {};
+    uint64_t PeakBytes[GpuMemoryCategory_Count] = {};
+    uint64_t TotalLiveBytes = 0;
+    uint64_t TotalPeakBytes = 0;
+    uint64_t LiveAllocations = 0;
+    // 0 means unlimited.
+    uint64_t Budget = 0;
+
+    // Bytes allocated and freed during the last frame, and the worst frame
+    // so far (allocated + freed).
+    uint64_t FrameAllocatedBytes = 0;
+    uint64_t FrameFreedBytes = 0;
+    uint64_t PeakFrameChurnBytes = 0;
+
+    uint32_t RefusedAllocations = 0;
+};
+
+/**
+ * Creates every buffer and texture of the application and keeps track of
+ * how much memory they take.
+ *
+ * WebGPU does not tell how much memory an object really uses, so sizes are
+ * the ones requested (buffer size, texel size times the number of texels of
+ * every mip level and sample), which is a lower bound of what the driver
+ * allocates.
+ *
+ * When a budget is set, an allocation that would exceed it is refused.
+ */
+class GpuMemoryTracker {
+private:
+    struct Allocation {
+        uint64_t Size = 0;
+        GpuMemoryCategory Category = GpuMemoryCategory_Vertex;
+    };
+
+    mutable std::mutex m_Mutex;
+    std::unordered_map<const void *, Allocation> m_Allocations;
+
+    GpuMemoryStats m_Stats;
+    // Accumulated during the current frame, moved to m_Stats by EndFrame().
+    uint64_t m_FrameAllocatedBytes = 0;
+    uint64_t m_FrameFreedBytes = 0;
+
+public:
+    // Limit the total number of bytes alive at once, 0 for no limit.
+    void SetBudget(uint64_t bytes);
+
+    // Return a null handle, after printing why, if the budget does not
+    // allow the allocation or if the device could not create it.
+    BufferHandle CreateBuffer(WGPUDevice device, const WGPUBufferDescriptor &descriptor, GpuMemoryCategory category);
+    TextureHandle CreateTexture(WGPUDevice device, const WGPUTextureDescriptor &descriptor, GpuMemoryCategory category);
+
+    // Objects created by the tracker must be released through it for the
+    // accounting to stay right.
+    void Release(BufferHandle &buffer);
+    void Release(TextureHandle &texture);
+
+    // Close the current frame for the per-frame churn statistics.
+    void EndFrame();
+
+    GpuMemoryStats GetStats() const;
+
+private:
+    bool Reserve(uint64_t size, GpuMemoryCategory category, const char *label);
+    void Track(const void *object, uint64_t size, GpuMemoryCategory category);
+    // Give back a reservation whose object could not be created, which is
+    // neither an allocation nor a free.
+    void Unreserve(uint64_t size, GpuMemoryCategory category);
+    void Untrack(const void *object);
+};
+
+// Size in bytes of a texture with all its mip levels, layers and samples.
+uint64_t EstimateTextureSize(const WGPUTextureDescriptor &descriptor);
+
+void PrintGpuMemoryStats(const GpuMemoryStats &stats);
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <webgpu/webgpu.h>
+
+#include <cstdint>
+
+#include "GpuMemoryTracker.hpp"
+#include "ReadbackRing.hpp"
+#include "WebGPUHandles.hpp"
+
+struct GpuTimerStats {
+    uint64_t SampledFrames = 0;
+    double TotalSeconds = 0.0;
+    double LastSeconds = 0.0;
+    double MaxSeconds = 0.0;
+};
+
+/**
+ * Measures the GPU time of a frame with timestamp queries: one written when
+ * the first render pass begins, one when the last render pass ends.
+ *
+ * Results come back through the readback ring a couple of frames late.
+ * Frames are only sampled while the ring has room, so the GPU never waits
+ * on us.
+ */
+class GpuTimer {
+private:
+    GpuMemoryTracker *m_Memory = nullptr;
+    ReadbackRing *m_Readback = nullptr;
+
+    QuerySetHandle m_QuerySet;
+    BufferHandle m_ResolveBuffer;
+
+    WGPURenderPassTimestampWrites m_BeginWrites = {};
+    WGPURenderPassTimestampWrites m_EndWrites = {};
+    WGPURenderPassTimestampWrites m_PassWrites = {};
+
+    bool m_FrameActive = false;
+    // The latest result delivered by the readback ring, until collected.
+    bool m_HasResult = false;
+    double m_Result = 0.0;
+
+    GpuTimerStats m_Stats;
+
+public:
+    // Returns false when the device was not created with
+    // WGPUFeatureName_TimestampQuery.
+    bool Initialize(WGPUDevice device, GpuMemoryTracker &memory, ReadbackRing &readback);
+
+    // The device must be idle.
+    void Terminate();
+
+    bool IsAvailable() const { return static_cast<bool>(m_QuerySet); }
+
+    // Decide whether this frame is sampled, before encoding its passes.
+    void BeginFrame();
+
+    // Timestamp writes to put in the descriptors of the first and last
+    // render passes of the frame, or nullptr when the frame is not sampled.
+    const WGPURenderPassTimestampWrites *GetBeginWrites() const { return m_FrameActive ? &m_BeginWrites : nullptr; }
+    const WGPURenderPassTimestampWrites *GetEndWrites() const { return m_FrameActive ? &m_EndWrites : nullptr; }
+    // For frames made of a single render pass.
+    const WGPURenderPassTimestampWrites *GetPassWrites() const { return m_FrameActive ? &m_PassWrites : nullptr; }
+
+    // Record the readback of the results, after the last render pass has
+    // ended.
+    void Resolve(WGPUCommandEncoder encoder);
+
+    // Returns true, with the GPU time of a past frame, when a result arrived
+    // since the last call. ReadbackRing::Collect() delivers them.
+    bool Collect(double &seconds);
+
+    const GpuTimerStats &GetStats() const { return m_Stats; }
+};
+
+void PrintGpuTimerStats(const GpuTimerStats &stats);
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// 64-bit FNV-1a, good enough to key caches by content.
+constexpr uint64_t HashSeed = 0xcbf29ce484222325ull;
+
+inline uint64_t HashBytes(const void *data, size_t size, uint64_t hash = HashSeed) {
+    const auto *bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+inline uint64_t HashString(std::string_view text, uint64_t hash = HashSeed) {
+    // Hash the length too, so that consecutive strings cannot be confused
+    // with a different split of the same characters.
+    const uint64_t size = text.size();
+    hash = HashBytes(&size, sizeof(size), hash);
+    return HashBytes(text.data(), text.size(), hash);
+}
+
+template <typename T>
+uint64_t HashValue(const T &value, uint64_t hash = HashSeed) {
+    return HashBytes(&value, sizeof(T), hash);
+}
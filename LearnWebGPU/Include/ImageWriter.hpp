@@ -0,0 +1,53 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <vector>
+
+#include "ThreadPool.hpp"
+
+struct ImageWriterStats {
+    uint64_t ImagesWritten = 0;
+    uint64_t Failures = 0;
+    uint64_t BytesWritten = 0;
+    // Summed over the worker threads.
+    double EncodeSeconds = 0.0;
+    // Times Write() had to wait for the backlog to shrink, and for how long.
+    uint64_t BacklogWaits = 0;
+    double BacklogWaitSeconds = 0.0;
+};
+
+/**
+ * Encodes and saves images on a thread pool, so that whoever produces them
+ * (typically readback callbacks) never waits on the disk or the encoder.
+ *
+ * At most maxPending images are queued at once: beyond that, Write() blocks
+ * until one is done, which keeps memory bounded when the GPU produces
+ * frames faster than they can be saved.
+ */
+class ImageWriter {
+private:
+    ThreadPool *m_Workers = nullptr;
+    uint32_t m_MaxPending = 0;
+
+    mutable std::mutex m_Mutex;
+    std::condition_variable m_Done;
+    uint32_t m_Pending = 0;
+
+    ImageWriterStats m_Stats;
+
+public:
+    void Initialize(ThreadPool &workers, uint32_t maxPending);
+
+    // Save tightly packed 8-bit RGBA (or BGRA) pixels as a PPM image.
+    void Write(std::filesystem::path path, uint32_t width, uint32_t height, std::vector<uint8_t> pixels, bool bgra);
+
+    // Block until every image has been saved.
+    void Wait();
+
+    ImageWriterStats GetStats() const;
+};
+
+void PrintImageWriterStats(const ImageWriterStats &stats);
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * A column-major 4x4 float matrix, laid out like a WGSL mat4x4f so that it
+ * can be copied to GPU buffers as is.
+ */
+struct alignas(16) Matrix4 {
+    float M[16] = {
+        1.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, 1.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 1.0f, 0.0f,
+        0.0f, 0.0f, 0.0f, 1.0f,
+    };
+
+    static Matrix4 Identity() { return {}; }
+    static Matrix4 Translation(float x, float y, float z);
+    static Matrix4 Scaling(float x, float y, float z);
+    static Matrix4 RotationZ(float angle);
+
+    // Element at the given row and column.
+    float &operator()(uint32_t row, uint32_t column) { return M[column * 4 + row]; }
+    float operator()(uint32_t row, uint32_t column) const { return M[column * 4 + row]; }
+};
+
+static_assert(sizeof(Matrix4) == 64);
+
+// result = a * b, using SSE where available. result may alias a or b.
+void MultiplyMatrices(const Matrix4 &a, const Matrix4 &b, Matrix4 &result);
+
+inline Matrix4 operator*(const Matrix4 &a, const Matrix4 &b) {
+    Matrix4 result;
+    MultiplyMatrices(a, b, result);
+    return result;
+}
+
+// Transform the point (x, y, z, 1), ignoring the projective row.
+void TransformPoint(const Matrix4 &matrix, const float *point, float *result);
+
+// Largest scale factor applied by the upper 3x3 part, to scale bounding
+// sphere radii.
+float GetMaxScale(const Matrix4 &matrix);
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "FileLoader.hpp"
+#include "FrustumCuller.hpp"
+#include "GeometryPool.hpp"
+#include "MeshSplitter.hpp"
+
+using MeshId = uint32_t;
+constexpr MeshId InvalidMeshId = 0xffffffff;
+
+struct MeshInfo {
+    // The file it was loaded from, or the name it was added under.
+    std::string Name;
+    // One geometry pool mesh per part, see SplitMesh(). Drawing the mesh is
+    // one draw per part.
+    std::vector<GeometryHandle> Parts;
+    // In model space, a sphere around the bounding box of the 2D positions.
+    BoundingSphere Bounds;
+    uint32_t VertexCount = 0;
+    uint32_t IndexCount = 0;
+};
+
+struct MeshRegistryStats {
+    uint32_t Meshes = 0;
+    uint32_t Parts = 0;
+    uint64_t Vertices = 0;
+    uint64_t Indices = 0;
+    // Loads of a mesh that was already registered.
+    uint32_t DuplicateLoads = 0;
+};
+
+/**
+ * Every mesh of the application, packed into the shared vertex and index
+ * buffers of a geometry pool, each at its own baseVertex/firstIndex range.
+ *
+ * Meshes are split into parts that fit the pages of the pool and 16-bit
+ * indices, and registered by name: loading the same file twice returns the
+ * same mesh. The first two floats of each vertex are its 2D position.
+ */
+class MeshRegistry {
+private:
+    GeometryPool *m_Pool = nullptr;
+    uint32_t m_FloatsPerVertex = 0;
+    MeshSplitLimits m_SplitLimits;
+
+    std::vector<MeshInfo> m_Meshes;
+    std::unordered_map<std::string, MeshId> m_Names;
+    uint32_t m_DuplicateLoads = 0;
+
+public:
+    // The pool must outlive the registry.
+    void Initialize(GeometryPool &pool, uint32_t vertexStride, const MeshSplitLimits &splitLimits);
+
+    // Free the parts of every mesh from the pool.
+    void Terminate();
+
+    // Load a geometry file, see LoadGeometry(). Returns InvalidMeshId when
+    // it cannot be loaded or does not fit in the pool.
+    MeshId Load(const fs::path &path);
+
+    // Register geometry that is already in memory.
+    MeshId Add(const std::string &name, const std::vector<float> &pointData, const std::vector<uint32_t> &indexData);
+
+    MeshId Find(const std::string &name) const;
+
+    const MeshInfo &Get(MeshId id) const { return m_Meshes[id]; }
+
+    uint32_t GetMeshCount() const { return static_cast<uint32_t>(m_Meshes.size()); }
+
+    MeshRegistryStats GetStats() const;
+};
+
+void PrintMeshRegistryStats(const MeshRegistryStats &stats);
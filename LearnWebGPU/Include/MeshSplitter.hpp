@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * A piece of a mesh small enough to be drawn on its own, with 16-bit
+ * indices into its own vertices.
+ */
+struct MeshPart {
+    std::vector<float> PointData;
+    std::vector<uint16_t> IndexData;
+    uint32_t VertexCount = 0;
+};
+
+struct MeshSplitLimits {
+    // At most 65536, what 16-bit indices can address.
+    uint32_t MaxVertices = 1 << 16;
+    // Rounded down to whole triangles.
+    uint32_t MaxIndices = 0xffffffff;
+};
+
+/**
+ * Split an indexed triangle list into parts within the limits, typically
+ * the 16-bit index range and the size of the buffers the parts go to.
+ * Triangles are kept in order and vertices shared by triangles of different
+ * parts are duplicated. A mesh that already fits is returned as one part.
+ * Fails on out of range indices and on limits smaller than a triangle.
+ */
+bool SplitMesh(const std::vector<float> &pointData, uint32_t floatsPerVertex, const std::vector<uint32_t> &indexData, const MeshSplitLimits &limits, std::vector<MeshPart> &parts);
+
+// Upper bound of the number of parts SplitMesh() gives for indexCount
+// indices, without splitting. It only grows as the limits shrink, so lower
+// bounds of the limits give a bound too.
+uint32_t GetMaxPartCount(uint64_t indexCount, const MeshSplitLimits &limits);
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <webgpu/webgpu.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "ShaderCache.hpp"
+#include "WebGPUHandles.hpp"
+
+/**
+ * Fills the mip chain of a texture from its first level on the GPU, with
+ * one compute dispatch per level, each reading the level above it.
+ *
+ * Storage textures cannot have an sRGB format, so textures are created as
+ * RGBA8Unorm holding sRGB-encoded colors, and the shader does the
+ * conversions itself. They can still be sampled through an RGBA8UnormSrgb
+ * view when that format is in their view formats.
+ */
+class MipmapGenerator {
+public:
+    static constexpr WGPUTextureFormat Format = WGPUTextureFormat_RGBA8Unorm;
+    // Must match the shader.
+    static constexpr uint32_t WorkgroupSize = 8;
+
+private:
+    WGPUDevice m_Device = nullptr;
+
+    BindGroupLayoutHandle m_BindGroupLayout;
+    PipelineLayoutHandle m_PipelineLayout;
+    ComputePipelineHandle m_Downsample;
+
+public:
+    // Compiles the shader, blocking.
+    bool Initialize(WGPUDevice device, ShaderCache &shaderCache);
+
+    void Terminate();
+
+    // Record the generation of every level but the first one. The texture
+    // must have the Format format and the TextureBinding and StorageBinding
+    // usages. Returns the number of levels generated.
+    uint32_t Generate(WGPUCommandEncoder encoder, WGPUTexture texture) const;
+};
+
+// Number of levels of a full mip chain, down to 1x1.
+uint32_t GetMipLevelCount(uint32_t width, uint32_t height);
+
+// CPU version of the generation, to validate it and compare with: levels 1
+// to GetMipLevelCount() - 1 of tightly packed RGBA8 pixels.
+std::vector<std::vector<uint8_t>> GenerateMipmapsReference(uint32_t width, uint32_t height, const uint8_t *pixels);
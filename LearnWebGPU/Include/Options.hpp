@@ -0,0 +1,88 @@
+#pragma once
+
+#include <webgpu/webgpu.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "AdapterSelector.hpp"
+
+/**
+ * What the application draws.
+ */
+enum SceneType : uint32_t {
+    // The WebGPU logo, once.
+    SceneType_Logo,
+    // Hundreds of overlapping, screen-filling copies of the logo at random
+    // depths, to measure the effect of depth testing and draw sorting.
+    SceneType_Overdraw,
+    // A grid of a thousand small copies of the logo, for the overhead of
+    // many small draws rather than fill rate.
+    SceneType_Grid,
+};
+
+/**
+ * Command line options of the application.
+ */
+struct AppOptions {
+    // Which adapter to run on, see SelectAdapter().
+    AdapterPreference Adapter = AdapterPreference_Default;
+    // WGPUBackendType_Undefined for any.
+    WGPUBackendType Backend = WGPUBackendType_Undefined;
+
+    // Windows showing the scene, all rendered from the same device. With
+    // several monitors, each window opens on its own.
+    uint32_t WindowCount = 1;
+
+    // Only render when something changed (input, resize, resources,
+    // animations) instead of as fast as the present mode allows.
+    bool OnDemand = false;
+
+    // Maximum number of bytes of GPU memory the application may allocate,
+    // 0 for no limit.
+    uint64_t MemoryBudget = 0;
+
+    SceneType Scene = SceneType_Logo;
+    // Geometry files drawn by the scene, the WebGPU logo when empty. The
+    // logo scene shows them side by side, the overdraw scene cycles
+    // through them.
+    std::vector<std::string> MeshPaths;
+    // Render with a depth buffer.
+    bool Depth = false;
+    // With a depth buffer, draw opaque objects front to back.
+    bool SortDraws = true;
+
+    // GPU frame time the dynamic resolution aims for, in seconds. 0 renders
+    // at the size of the surface.
+    double DynamicResolutionTarget = 0.0;
+
+    // Texture the objects with this binary PPM image, decoded in the
+    // background. Untextured until it is ready.
+    std::string TexturePath;
+
+    // Where F12 saves a screenshot, as a binary PPM image.
+    std::string ScreenshotPath = "screenshot.ppm";
+    // Also save one of the first complete frame.
+    bool ScreenshotFirstFrame = false;
+
+    // Render the frames listed in this file offscreen, as fast as possible,
+    // and save them to BatchOutput instead of opening a window. See
+    // LoadBatchFile() for the format.
+    std::string BatchPath;
+    std::string BatchOutput = "frames";
+    uint32_t BatchWidth = 640;
+    uint32_t BatchHeight = 480;
+
+    // Print the limits, features and properties of the adapter and device,
+    // which takes a while on slow consoles.
+    bool Inspect = true;
+    // Save the startup phases as JSON there at exit, see StartupProfiler.
+    std::string StartupReportPath;
+};
+
+/**
+ * Fill options from the command line. Returns false (after printing the
+ * usage) when an argument is not recognized.
+ */
+bool ParseOptions(int argc, char **argv, AppOptions &options);
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <webgpu/webgpu.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Async.hpp"
+#include "ShaderCache.hpp"
+#include "ThreadPool.hpp"
+
+using PipelineKey = uint64_t;
+constexpr PipelineKey InvalidPipelineKey = 0;
+
+// Values of the pipeline-overridable constants (WGSL `override`
+// declarations) of a shader, by name. Sorted, so that the same set always
+// gives the same key.
+using PipelineConstants = std::map<std::string, double>;
+
+struct VertexBufferState {
+    uint64_t ArrayStride = 0;
+    WGPUVertexStepMode StepMode = WGPUVertexStepMode_Vertex;
+    std::vector<WGPUVertexAttribute> Attributes;
+};
+
+/**
+ * Everything that determines a render pipeline, as plain values so that it
+ * can be hashed and outlive the call that requested the pipeline.
+ */
+struct RenderPipelineState {
+    std::string ShaderPath;
+    // Given to the shader preprocessor, to select a permutation.
+    ShaderDefines Defines;
+    std::string VertexEntryPoint = "vs_main";
+    std::string FragmentEntryPoint = "fs_main";
+    // Given to both stages. Every name must be declared by the shader, and
+    // the overrides without a default value must be given a value.
+    PipelineConstants Constants;
+
+    std::vector<VertexBufferState> VertexBuffers;
+
+    WGPUPrimitiveTopology Topology = WGPUPrimitiveTopology_TriangleList;
+    WGPUFrontFace FrontFace = WGPUFrontFace_CCW;
+    WGPUCullMode CullMode = WGPUCullMode_None;
+
+    WGPUTextureFormat ColorFormat = WGPUTextureFormat_Undefined;
+    bool BlendEnabled = false;
+    WGPUBlendState Blend = {};
+    WGPUColorWriteMaskFlags WriteMask = WGPUColorWriteMask_All;
+
+    // WGPUTextureFormat_Undefined means no depth attachment.
+    WGPUTextureFormat DepthFormat = WGPUTextureFormat_Undefined;
+    bool DepthWriteEnabled = true;
+    WGPUCompareFunction DepthCompare = WGPUCompareFunction_Less;
+
+    uint32_t SampleCount = 1;
+
+    // nullptr lets the implementation derive the layout from the shader.
+    WGPUPipelineLayout Layout = nullptr;
+};
+
+struct PipelineCacheStats {
+    uint32_t Requests = 0;
+    uint32_t Hits = 0;
+    uint32_t Compiles = 0;
+    uint32_t Pending = 0;
+    uint32_t Failures = 0;
+    double CompileSeconds = 0.0;
+    double LongestCompileSeconds = 0.0;
+};
+
+/**
+ * Render pipelines keyed by a hash of their full state (shader contents,
+ * vertex layout, blending, target format, topology, sample count...).
+ *
+ * Misses are compiled by a coroutine that awaits its shader module and
+ * then CreateRenderPipelineAsync(), both on worker threads, and stores the
+ * pipeline once the event pump resumes it. Until a pipeline is ready, Get()
+ * returns the fallback pipeline if one was given, or nullptr, and the caller
+ * is expected to skip the draws that need it.
+ */
+class PipelineCache {
+public:
+    using ReadyCallback = std::function<void(PipelineKey key)>;
+
+private:
+    struct Entry {
+        RenderPipelineState State;
+        std::atomic<WGPURenderPipeline> Pipeline = nullptr;
+        bool Done = false;
+        Task<bool> Compilation;
+    };
+
+    WGPUDevice m_Device = nullptr;
+    ShaderCache *m_ShaderCache = nullptr;
+    ThreadPool *m_Workers = nullptr;
+    EventPump *m_Pump = nullptr;
+    ReadyCallback m_OnReady;
+
+    mutable std::mutex m_Mutex;
+    std::unordered_map<PipelineKey, std::unique_ptr<Entry>> m_Entries;
+
+    PipelineCacheStats m_Stats;
+
+public:
+    // Compilations complete on the thread that pumps the events of pump.
+    void Initialize(WGPUDevice device, ShaderCache &shaderCache, ThreadPool &workers, EventPump &pump);
+
+    // Waits for the compilations in progress, then releases every pipeline.
+    // Like Wait(), on the thread that pumps the events.
+    void Terminate();
+
+    // Called from the thread that pumps the events whenever a pipeline
+    // becomes available.
+    void SetReadyCallback(ReadyCallback callback) { m_OnReady = std::move(callback); }
+
+    // Look the state up and start compiling it in the background if it is
+    // not in the cache yet. Returns InvalidPipelineKey if the shader source
+    // cannot be loaded.
+    PipelineKey Request(const RenderPipelineState &state);
+
+    // Request a variant of an already requested pipeline, with some of its
+    // constants replaced or added. Variants are cached like any other state,
+    // by their full constant set. Returns InvalidPipelineKey if key is
+    // unknown.
+    PipelineKey Specialize(PipelineKey key, const PipelineConstants &constants);
+
+    // Non-blocking: the pipeline if it is ready, else the fallback pipeline
+    // if it is ready, else nullptr.
+    WGPURenderPipeline Get(PipelineKey key, PipelineKey fallback = InvalidPipelineKey) const;
+
+    // Blocking: wait for the pipeline to be compiled, pumping the events
+    // meanwhile. Only from the thread that pumps them.
+    WGPURenderPipeline Wait(PipelineKey key);
+
+    PipelineCacheStats GetStats() const;
+
+private:
+    Task<bool> Compile(PipelineKey key, Entry &entry, ShaderHash shaderHash);
+};
+
+void PrintPipelineCacheStats(const PipelineCacheStats &stats, const ShaderCacheStats &shaderStats);
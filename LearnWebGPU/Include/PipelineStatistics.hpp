@@ -0,0 +1,59 @@
+#pragma once
+
+#include <webgpu/webgpu.h>
+
+#include <cstdint>
+
+#include "GpuMemoryTracker.hpp"
+#include "ReadbackRing.hpp"
+#include "WebGPUHandles.hpp"
+
+struct PipelineStatisticsStats {
+    uint64_t SampledFrames = 0;
+    uint64_t VertexInvocations = 0;
+    uint64_t FragmentInvocations = 0;
+    uint64_t LastFragmentInvocations = 0;
+};
+
+/**
+ * Counts vertex and fragment shader invocations of the main render pass
+ * with wgpu-native's pipeline statistics queries, to measure overdraw.
+ *
+ * Results come back through the readback ring. Frames are only sampled
+ * while it has room, so the GPU never waits on us.
+ */
+class PipelineStatistics {
+private:
+    GpuMemoryTracker *m_Memory = nullptr;
+    ReadbackRing *m_Readback = nullptr;
+
+    QuerySetHandle m_QuerySet;
+    BufferHandle m_ResolveBuffer;
+
+    bool m_QueryActive = false;
+
+    PipelineStatisticsStats m_Stats;
+
+public:
+    // Returns false when the device was not created with
+    // WGPUNativeFeature_PipelineStatisticsQuery.
+    bool Initialize(WGPUDevice device, GpuMemoryTracker &memory, ReadbackRing &readback);
+
+    // The device must be idle.
+    void Terminate();
+
+    bool IsAvailable() const { return static_cast<bool>(m_QuerySet); }
+
+    // Wrap the draws of a render pass.
+    void BeginPass(WGPURenderPassEncoder renderPass);
+    void EndPass(WGPURenderPassEncoder renderPass);
+
+    // Record the readback of the results, after the render pass has ended.
+    // They are accumulated as ReadbackRing::Collect() delivers them.
+    void Resolve(WGPUCommandEncoder encoder);
+
+    const PipelineStatisticsStats &GetStats() const { return m_Stats; }
+};
+
+// pixelCount is used to express fragment counts as an overdraw factor.
+void PrintPipelineStatistics(const PipelineStatisticsStats &stats, uint64_t pixelCount);
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * A TLSF (two-level segregated fit) allocator handing out ranges of an
+ * abstract address space, e.g. vertices or indices inside a large GPU buffer.
+ * It never touches the memory itself: it only keeps track of which
+ * [Offset, Offset + Size) ranges are in use, so it can be used to carve any
+ * kind of resource.
+ *
+ * Allocation and free are O(1): free ranges are bucketed by size in a
+ * two-level table (power of two, then 8 linear subdivisions) and adjacent
+ * free ranges are merged back together on free.
+ */
+class RangeAllocator {
+public:
+    static constexpr uint32_t InvalidOffset = 0xffffffff;
+    static constexpr uint32_t InvalidNode = 0xffffffff;
+
+    static constexpr uint32_t SecondLevelLog2 = 3;
+    static constexpr uint32_t SecondLevelCount = 1 << SecondLevelLog2;
+    static constexpr uint32_t FirstLevelCount = 32;
+
+    struct Allocation {
+        uint32_t Offset = InvalidOffset;
+        uint32_t Node = InvalidNode;
+
+        bool IsValid() const { return Offset != InvalidOffset; }
+    };
+
+    struct Stats {
+        uint32_t Capacity = 0;
+        uint32_t UsedSize = 0;
+        uint32_t FreeSize = 0;
+        uint32_t LargestFreeRange = 0;
+        uint32_t FreeRangeCount = 0;
+        uint32_t AllocationCount = 0;
+        // Fraction of the capacity currently handed out.
+        float Utilization = 0.0f;
+        // 0 when all the free space is one contiguous range, close to 1 when
+        // it is scattered in many small holes.
+        float Fragmentation = 0.0f;
+    };
+
+    explicit RangeAllocator(uint32_t capacity = 0);
+
+    // Forget every allocation and start over with a single free range.
+    void Reset(uint32_t capacity);
+
+    // Returns an invalid allocation when no free range is large enough.
+    // The alignment must be a power of two.
+    Allocation Allocate(uint32_t size, uint32_t alignment = 1);
+
+    void Free(Allocation allocation);
+
+    Stats GetStats() const;
+
+private:
+    struct Node {
+        uint32_t Offset = 0;
+        uint32_t Size = 0;
+        // Neighbours in address order, used to merge free ranges.
+        uint32_t PrevPhysical = InvalidNode;
+        uint32_t NextPhysical = InvalidNode;
+        // Neighbours in the free list of the bin this node belongs to.
+        uint32_t PrevFree = InvalidNode;
+        uint32_t NextFree = InvalidNode;
+        bool Used = false;
+    };
+
+    uint32_t m_Capacity = 0;
+    uint32_t m_UsedSize = 0;
+    uint32_t m_FreeRangeCount = 0;
+    uint32_t m_AllocationCount = 0;
+
+    std::vector<Node> m_Nodes;
+    std::vector<uint32_t> m_UnusedNodes;
+
+    uint32_t m_FirstLevelBitmap = 0;
+    uint32_t m_SecondLevelBitmaps[FirstLevelCount] = {};
+    uint32_t m_FreeHeads[FirstLevelCount][SecondLevelCount] = {};
+
+private:
+    uint32_t CreateNode();
+    void DestroyNode(uint32_t node);
+
+    void InsertFreeNode(uint32_t node);
+    void RemoveFreeNode(uint32_t node);
+
+    uint32_t FindFreeNode(uint32_t size) const;
+};
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <webgpu/webgpu.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "Async.hpp"
+#include "GpuMemoryTracker.hpp"
+#include "WebGPUHandles.hpp"
+
+/**
+ * Data read back from the GPU, valid for the duration of the callback only.
+ */
+struct ReadbackResult {
+    // nullptr when the buffer could not be mapped.
+    const void *Data = nullptr;
+    uint64_t Size = 0;
+
+    // For textures: rows are tightly packed, RowBytes = Width * texel size,
+    // whatever padding the copy needed.
+    uint32_t Width = 0;
+    uint32_t Height = 0;
+    uint32_t RowBytes = 0;
+    WGPUTextureFormat Format = WGPUTextureFormat_Undefined;
+
+    // How many Collect() calls (frames) it took to get there.
+    uint64_t LatencyFrames = 0;
+};
+
+using ReadbackCallback = std::function<void(const ReadbackResult &result)>;
+
+struct ReadbackStats {
+    uint64_t Requests = 0;
+    uint64_t Completed = 0;
+    uint64_t Failed = 0;
+    // Requests refused because every slot was in flight.
+    uint64_t Dropped = 0;
+    uint64_t BytesRead = 0;
+    // Row padding that was copied but not handed to the callbacks.
+    uint64_t PaddingBytes = 0;
+    uint64_t TotalLatencyFrames = 0;
+    uint64_t BuffersCreated = 0;
+};
+
+// Size in bytes of a texel of the formats that can be read back, 0 for the
+// others (compressed, packed depth/stencil...).
+uint32_t GetTexelSize(WGPUTextureFormat format);
+
+/**
+ * Reads buffers and textures back from the GPU without ever waiting on it.
+ *
+ * Copies are recorded into the frame's command encoder, towards one of a
+ * fixed number of MapRead buffers. Once the frame is submitted the buffers
+ * are mapped by coroutines awaiting MapBufferAsync(), and a later Collect()
+ * pumps the events and hands the data to the callbacks, in request order. When every slot is in flight, new requests
+ * are dropped rather than stalling the frame.
+ *
+ * Texture rows are copied with the 256 bytes row pitch WebGPU requires and
+ * repacked before the callback sees them.
+ */
+class ReadbackRing {
+private:
+    enum SlotState : uint32_t {
+        SlotState_Free,
+        // The copy is in a command buffer that was not submitted yet.
+        SlotState_Recorded,
+        SlotState_Mapping,
+        SlotState_Mapped,
+        SlotState_Failed,
+    };
+
+    struct Slot {
+        BufferHandle Buffer;
+        uint64_t Capacity = 0;
+        // Written by the coroutine mapping the slot, see MapSlot().
+        std::atomic<uint32_t> State = SlotState_Free;
+        Task<bool> Map;
+
+        ReadbackCallback Callback;
+        uint64_t Size = 0;
+        uint32_t Width = 0;
+        uint32_t Height = 0;
+        uint32_t RowBytes = 0;
+        uint32_t PaddedRowBytes = 0;
+        WGPUTextureFormat Format = WGPUTextureFormat_Undefined;
+        uint64_t RequestFrame = 0;
+    };
+
+    WGPUDevice m_Device = nullptr;
+    EventPump *m_Pump = nullptr;
+    GpuMemoryTracker *m_Memory = nullptr;
+
+    std::unique_ptr<Slot[]> m_Slots;
+    uint32_t m_SlotCount = 0;
+    // Slots are used in order: [m_Tail, m_Head) are in flight.
+    uint64_t m_Head = 0;
+    uint64_t m_Tail = 0;
+    uint64_t m_Frame = 0;
+
+    // Repacked texture rows, kept around to not allocate every time.
+    std::vector<uint8_t> m_Packed;
+
+    ReadbackStats m_Stats;
+
+public:
+    // Maps complete through pump, which must be pumped from the thread that
+    // uses the ring.
+    bool Initialize(WGPUDevice device, EventPump &pump, GpuMemoryTracker &memory, uint32_t slotCount = 8);
+
+    // The device must be idle. Pending callbacks are dropped without being
+    // called.
+    void Terminate();
+
+    bool HasFreeSlot() const { return m_Head - m_Tail < m_SlotCount; }
+
+    // Record the copy of size bytes of source, from offset. Both must be
+    // multiples of 4, and source must have the CopySrc usage. Returns false
+    // when the request was dropped.
+    bool ReadBuffer(WGPUCommandEncoder encoder, WGPUBuffer source, uint64_t offset, uint64_t size, ReadbackCallback callback);
+
+    // Record the copy of the top left width x height texels of a mip level
+    // of texture, which must have the CopySrc usage.
+    bool ReadTexture(WGPUCommandEncoder encoder, WGPUTexture texture, uint32_t width, uint32_t height, ReadbackCallback callback, uint32_t mipLevel = 0);
+
+    // Start mapping what was recorded, once the command buffer holding the
+    // copies has been submitted.
+    void OnSubmitted();
+
+    // Call the callbacks of the readbacks that completed, once per frame.
+    void Collect();
+
+    // Block until every submitted readback has been delivered. For tests
+    // and tools, never on the frame path.
+    void Flush();
+
+    const ReadbackStats &GetStats() const { return m_Stats; }
+
+private:
+    Slot *AcquireSlot(uint64_t size);
+
+    Task<bool> MapSlot(Slot &slot);
+
+    // Some slot is waiting for its buffer to be mapped.
+    bool IsMapping() const;
+};
+
+void PrintReadbackStats(const ReadbackStats &stats);
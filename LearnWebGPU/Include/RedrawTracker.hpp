@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Why a new frame is needed. Several reasons can be pending at once.
+ */
+enum RedrawReason : uint32_t {
+    RedrawReason_None = 0,
+    RedrawReason_Input = 1 << 0,
+    RedrawReason_Resize = 1 << 1,
+    RedrawReason_Resource = 1 << 2,
+    // The window system lost the window contents and asks for them again.
+    RedrawReason_Expose = 1 << 3,
+    RedrawReason_Count = 4,
+};
+
+struct RedrawStats {
+    uint64_t Loops = 0;
+    uint64_t RedrawnFrames = 0;
+    // Times the main thread woke up and found nothing to redraw.
+    uint64_t IdleWakeups = 0;
+    double IdleSeconds = 0.0;
+    uint64_t ReasonCounts[RedrawReason_Count] = {};
+};
+
+/**
+ * Dirty tracking for on-demand rendering. Anything that changes what is on
+ * screen calls MarkDirty(), from any thread; the main loop only renders a
+ * frame when the tracker is dirty and otherwise sleeps in
+ * glfwWaitEventsTimeout.
+ */
+class RedrawTracker {
+private:
+    std::atomic<uint32_t> m_PendingReasons = RedrawReason_None;
+    // Upper bound on how long the main loop sleeps without any event, so
+    // that it still wakes up from time to time on a completely idle kiosk.
+    static constexpr double MaxIdleSeconds = 1.0;
+
+    RedrawStats m_Stats;
+
+public:
+    void MarkDirty(RedrawReason reason);
+
+    // Returns the reasons pending since the last call (RedrawReason_None if
+    // nothing changed) and clears them. Only called by the main loop.
+    uint32_t ConsumeReasons();
+
+    // How long the main loop may sleep waiting for events: zero while
+    // something is pending, MaxIdleSeconds otherwise.
+    double GetWaitTimeout() const;
+
+    void RecordIdle(double seconds);
+
+    const RedrawStats &GetStats() const { return m_Stats; }
+};
+
+void PrintRedrawStats(const RedrawStats &stats);
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+#include "SpscQueue.hpp"
+
+// How many windows a frame may be rendered to.
+constexpr uint32_t MaxFrameViews = 8;
+
+struct ViewPacket {
+    // 0 while the window is minimized or hidden, which skips the view.
+    uint32_t FramebufferWidth = 0;
+    uint32_t FramebufferHeight = 0;
+};
+
+/**
+ * Everything the render thread needs to know to render one frame. It is
+ * built by the main thread after handling events, so it must be
+ * self-contained: the render thread never looks at the windows.
+ */
+struct FramePacket {
+    uint64_t FrameNumber = 0;
+    double Time = 0.0;
+    // One per window, in the order the application created them.
+    std::array<ViewPacket, MaxFrameViews> Views;
+    uint32_t ViewCount = 0;
+    // Save this frame, or the next complete one, to a file.
+    bool Screenshot = false;
+    bool Quit = false;
+};
+
+struct RenderThreadStats {
+    uint64_t RenderedPackets = 0;
+    // Times the main thread found the queue full and had to wait.
+    uint64_t ProducerWaits = 0;
+    // Time the render thread spent waiting for the main thread.
+    double ConsumerIdleSeconds = 0.0;
+};
+
+/**
+ * Runs the GPU side of the frame (acquire, encode, submit, present) on its
+ * own thread, so that a blocking present never delays event handling and
+ * the main thread can prepare frame N + 1 while frame N is being rendered.
+ */
+class RenderThread {
+public:
+    using RenderFunction = std::function<void(const FramePacket &packet)>;
+    using ConsumedFunction = std::function<void()>;
+
+    // How many frames the main thread may get ahead of the render thread.
+    static constexpr size_t QueueCapacity = 2;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::thread m_Thread;
+    SpscQueue<FramePacket, QueueCapacity> m_Queue;
+    RenderFunction m_Render;
+    ConsumedFunction m_OnConsumed;
+
+    std::atomic<uint64_t> m_RenderedPackets = 0;
+    uint64_t m_ProducerWaits = 0;
+    double m_ConsumerIdleSeconds = 0.0;
+
+public:
+    ~RenderThread();
+
+    // onConsumed is called from the render thread every time it takes a
+    // packet, typically to wake up a main thread waiting on the queue. It
+    // runs after a sequentially consistent fence, so a producer that sets a
+    // flag, issues the same fence and then retries TrySubmit() never misses
+    // the wakeup.
+    void Start(RenderFunction render, ConsumedFunction onConsumed = nullptr);
+
+    // Ask the render thread to finish the frames already queued, then join
+    // it.
+    void Stop();
+
+    // Main thread side. Returns false when the render thread is already
+    // QueueCapacity frames behind.
+    bool TrySubmit(const FramePacket &packet);
+
+    // Only meaningful once the thread has been stopped.
+    RenderThreadStats GetStats() const;
+
+private:
+    void Run();
+};
+
+void PrintRenderThreadStats(const RenderThreadStats &stats);
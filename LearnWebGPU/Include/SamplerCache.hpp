@@ -0,0 +1,59 @@
+#pragma once
+
+#include <webgpu/webgpu.h>
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+#include "WebGPUHandles.hpp"
+
+/**
+ * Everything that determines a sampler, with the defaults of WebGPU.
+ */
+struct SamplerState {
+    WGPUAddressMode AddressModeU = WGPUAddressMode_ClampToEdge;
+    WGPUAddressMode AddressModeV = WGPUAddressMode_ClampToEdge;
+    WGPUAddressMode AddressModeW = WGPUAddressMode_ClampToEdge;
+    WGPUFilterMode MagFilter = WGPUFilterMode_Nearest;
+    WGPUFilterMode MinFilter = WGPUFilterMode_Nearest;
+    WGPUMipmapFilterMode MipmapFilter = WGPUMipmapFilterMode_Nearest;
+    float LodMinClamp = 0.0f;
+    float LodMaxClamp = 32.0f;
+    // WGPUCompareFunction_Undefined for a regular sampler.
+    WGPUCompareFunction Compare = WGPUCompareFunction_Undefined;
+    // Above 1, every filter must be linear.
+    uint16_t MaxAnisotropy = 1;
+};
+
+struct SamplerCacheStats {
+    uint32_t Requests = 0;
+    uint32_t SamplersCreated = 0;
+};
+
+/**
+ * One sampler per distinct state, shared by every texture that uses it.
+ * Samplers are small, but some backends can only have a couple thousands
+ * of them alive at once (2048 in a D3D12 heap). Safe to use from several
+ * threads.
+ */
+class SamplerCache {
+private:
+    WGPUDevice m_Device = nullptr;
+
+    mutable std::mutex m_Mutex;
+    std::unordered_map<uint64_t, SamplerHandle> m_Samplers;
+
+    SamplerCacheStats m_Stats;
+
+public:
+    void Initialize(WGPUDevice device);
+
+    void Terminate();
+
+    // Create the sampler or return the cached one, which lives as long as
+    // the cache. Returns nullptr if the sampler cannot be created.
+    WGPUSampler Get(const SamplerState &state);
+
+    SamplerCacheStats GetStats() const;
+};
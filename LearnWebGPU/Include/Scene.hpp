@@ -0,0 +1,45 @@
+#pragma once
+
+#include <webgpu/webgpu.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "Matrix4.hpp"
+#include "MeshRegistry.hpp"
+#include "Options.hpp"
+#include "PipelineCache.hpp"
+
+// Vertices are a 2D position followed by an RGB color.
+constexpr uint32_t SceneVertexStride = 5 * sizeof(float);
+constexpr uint32_t SceneVertexAttributeCount = 2;
+
+// Given to the shaders as the AspectRatio constant, and used to cull.
+constexpr float SceneAspectRatio = 640.0f / 480.0f;
+
+struct SceneObject {
+    MeshId Mesh = InvalidMeshId;
+    // Model to scene, see DrawData::Transform.
+    Matrix4 Transform;
+};
+
+/**
+ * The objects of a scene, shared by the application and the frame
+ * benchmark so that both draw the same thing.
+ *
+ * Scenes use every mesh of the registry in turn, each placed relative to the
+ * center of its bounds. The order is part of the scene: draws are submitted
+ * in this order unless they are sorted.
+ */
+std::vector<SceneObject> BuildSceneObjects(SceneType type, const MeshRegistry &meshes);
+
+// How many objects BuildSceneObjects() gives with meshCount meshes, before
+// the meshes are registered.
+uint32_t GetSceneObjectCount(SceneType type, uint32_t meshCount);
+
+/**
+ * The state of the pipeline drawing the scenes: opaque with a depth test
+ * when depthFormat is not Undefined, blended without. Bind group 0 of the
+ * layout holds the per-draw data, see DrawList.
+ */
+RenderPipelineState GetScenePipelineState(WGPUTextureFormat colorFormat, WGPUTextureFormat depthFormat, WGPUPipelineLayout layout);
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <webgpu/webgpu.h>
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "ShaderPreprocessor.hpp"
+#include "WebGPUHandles.hpp"
+
+using ShaderHash = uint64_t;
+
+struct ShaderCacheStats {
+    uint32_t SourcesLoaded = 0;
+    // Expanded permutations of the loaded shaders, requested or enumerated
+    // from their options, and how many distinct sources they gave.
+    uint32_t Permutations = 0;
+    uint32_t Variants = 0;
+    uint32_t ModulesCompiled = 0;
+    uint32_t ModuleHits = 0;
+    double CompileSeconds = 0.0;
+};
+
+/**
+ * Loads WGSL sources once and creates one shader module per distinct
+ * source, whatever the number of pipelines using it. Sources are identified
+ * by the hash of their contents, which is what pipeline keys are built
+ * from. Safe to use from several threads.
+ *
+ * Sources go through the preprocessor, once per set of defines. The first
+ * time a file is loaded, every permutation of its options is expanded too,
+ * which is cheap, and permutations giving the same text share a module.
+ * Modules are only compiled for the permutations that are used.
+ */
+class ShaderCache {
+private:
+    WGPUDevice m_Device = nullptr;
+
+    mutable std::mutex m_Mutex;
+    // By hash of the path and the defines.
+    std::unordered_map<uint64_t, ShaderHash> m_PermutationHashes;
+    std::unordered_set<std::string> m_LoadedPaths;
+    std::unordered_map<ShaderHash, std::string> m_Sources;
+    std::unordered_map<ShaderHash, ShaderModuleHandle> m_Modules;
+
+    ShaderCacheStats m_Stats;
+
+public:
+    void Initialize(WGPUDevice device);
+
+    void Terminate();
+
+    // Load and preprocess the source at path with the given defines if
+    // needed, and return the hash of the result. Returns false if the file
+    // cannot be read or preprocessed.
+    bool GetSourceHash(const std::string &path, ShaderHash &hash, const ShaderDefines &defines = {});
+
+    // Create the module of a known source, or return the cached one.
+    WGPUShaderModule GetModule(ShaderHash hash);
+
+    ShaderCacheStats GetStats() const;
+
+private:
+    void ExpandPermutations(const std::string &path, const std::vector<std::string> &options);
+
+    // m_Mutex must be held.
+    void AddPermutation(uint64_t key, ShaderHash hash, std::string source);
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+// Macros given to the preprocessor, by name. An empty value only marks the
+// name as defined. Sorted, so that the same set always gives the same key.
+using ShaderDefines = std::map<std::string, std::string>;
+
+struct PreprocessedShader {
+    std::string Source;
+    // Names declared with #option by the shader and its includes, sorted.
+    std::vector<std::string> Options;
+    // Every file that was read, the shader first.
+    std::vector<std::filesystem::path> Files;
+};
+
+/**
+ * Expands the directives of a WGSL source, so that shader variants share a
+ * single file rather than being copies of one another. Directives take a
+ * whole line:
+ *  - #include "path", relative to the including file. A file is only
+ *    included once, the next #include of it is ignored.
+ *  - #define NAME [value] and #undef NAME. Whole identifiers NAME in the
+ *    lines that follow are replaced by value, if there is one, which is not
+ *    expanded again.
+ *  - #ifdef NAME, #ifndef NAME, #else and #endif.
+ *  - #option NAME declares a switch the shader can be compiled with or
+ *    without. The options give the permutations of the shader.
+ *
+ * The defines given are set before the first line. Returns false, after
+ * printing where, if a file cannot be read or a directive is malformed.
+ */
+bool PreprocessShader(const std::filesystem::path &path, const ShaderDefines &defines, PreprocessedShader &shader);
+
+// Every combination of the options being defined or not: 2^n define sets,
+// starting with the empty one.
+std::vector<ShaderDefines> EnumeratePermutations(const std::vector<std::string> &options);
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+/**
+ * Lock-free bounded queue for exactly one producer thread and one consumer
+ * thread. Pushing and popping never take a lock; the Wait* functions let
+ * either side sleep (through C++20 atomic waits) instead of spinning when
+ * there is nothing to do.
+ */
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+private:
+    // Keep the two indices on separate cache lines, the producer only ever
+    // writes one of them and the consumer the other.
+    alignas(64) std::atomic<size_t> m_WriteIndex = 0;
+    alignas(64) std::atomic<size_t> m_ReadIndex = 0;
+    alignas(64) std::array<T, Capacity> m_Items;
+
+public:
+    // Producer side. Returns false when the queue is full.
+    bool TryPush(T item) {
+        const size_t write = m_WriteIndex.load(std::memory_order_relaxed);
+        if (write - m_ReadIndex.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        m_Items[write & (Capacity - 1)] = std::move(item);
+        m_WriteIndex.store(write + 1, std::memory_order_release);
+        m_WriteIndex.notify_one();
+        return true;
+    }
+
+    // Consumer side. Returns false when the queue is empty.
+    bool TryPop(T &item) {
+        const size_t read = m_ReadIndex.load(std::memory_order_relaxed);
+        if (read == m_WriteIndex.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = std::move(m_Items[read & (Capacity - 1)]);
+        m_ReadIndex.store(read + 1, std::memory_order_release);
+        m_ReadIndex.notify_one();
+        return true;
+    }
+
+    // Consumer side: sleep until there is at least one item.
+    void WaitForItem() const {
+        const size_t read = m_ReadIndex.load(std::memory_order_relaxed);
+        m_WriteIndex.wait(read, std::memory_order_acquire);
+    }
+
+    // Producer side: sleep until there is room for one more item.
+    void WaitForSpace() const {
+        const size_t write = m_WriteIndex.load(std::memory_order_relaxed);
+        m_ReadIndex.wait(write - Capacity, std::memory_order_acquire);
+    }
+
+    size_t Size() const {
+        return m_WriteIndex.load(std::memory_order_acquire) - m_ReadIndex.load(std::memory_order_acquire);
+    }
+};
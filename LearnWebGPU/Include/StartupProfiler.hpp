@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct StartupPhase {
+    std::string Name;
+    // Since the profiler was created.
+    double StartSeconds = 0.0;
+    double Seconds = 0.0;
+    // Resident set size at the end of the phase, 0 when unknown.
+    uint64_t ResidentBytes = 0;
+};
+
+/**
+ * Breaks the time to first frame down into phases, for the cold start
+ * report.
+ *
+ * The main thread ends phases one after the other, each lasting since the
+ * end of the previous one. Milestones, such as the first frame, may be
+ * marked from any thread. Work that overlaps the phases, like shader and
+ * pipeline compilation on the workers, is reported separately as
+ * background time.
+ */
+class StartupProfiler {
+private:
+    std::chrono::steady_clock::time_point m_Start;
+    std::chrono::steady_clock::time_point m_PhaseStart;
+
+    mutable std::mutex m_Mutex;
+    std::vector<StartupPhase> m_Phases;
+    std::vector<StartupPhase> m_Milestones;
+    std::vector<StartupPhase> m_Background;
+
+public:
+    StartupProfiler();
+
+    // Record the phase that ran since the previous one ended.
+    void EndPhase(const char *name);
+
+    // Only the first mark of each milestone is kept.
+    void MarkMilestone(const char *name);
+
+    // Time spent on other threads during startup.
+    void RecordBackground(const char *name, double seconds);
+
+    // Save the phases, milestones and background times as JSON.
+    bool WriteReport(const std::filesystem::path &path) const;
+
+    std::vector<StartupPhase> GetPhases() const;
+    std::vector<StartupPhase> GetMilestones() const;
+
+private:
+    double Elapsed() const;
+};
+
+// Resident set size of the process in bytes, 0 when the platform does not
+// tell.
+uint64_t GetResidentMemory();
+
+void PrintStartupReport(const StartupProfiler &profiler);
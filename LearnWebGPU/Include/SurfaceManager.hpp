@@ -0,0 +1,102 @@
+#pragma once
+
+#include <webgpu/webgpu.h>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "WebGPUHandles.hpp"
+
+/**
+ * The texture we render to this frame, acquired from the surface. It must be
+ * handed back with SurfaceManager::Present(), which releases both the view
+ * and the texture.
+ */
+struct SurfaceFrame {
+    TextureHandle Texture;
+    TextureViewHandle View;
+    uint32_t Width = 0;
+    uint32_t Height = 0;
+};
+
+struct SurfaceStats {
+    uint64_t AcquiredFrames = 0;
+    uint64_t SkippedFrames = 0;
+    uint64_t Reconfigurations = 0;
+    uint64_t Timeouts = 0;
+    uint64_t Outdated = 0;
+    uint64_t Lost = 0;
+    uint64_t Suboptimal = 0;
+};
+
+/**
+ * Owns the configuration of a surface and keeps it in sync with the window.
+ *
+ * Window resizes are debounced: a drag produces dozens of size events per
+ * second, and reconfiguring the swap chain for each of them costs more than
+ * rendering a frame at a slightly wrong size. The surface is only
+ * reconfigured once the size has been stable for a short while, or right
+ * away if the surface reports it can no longer be presented to.
+ */
+class SurfaceManager {
+public:
+    using ResizeCallback = std::function<void(uint32_t width, uint32_t height)>;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    WGPUDevice m_Device = nullptr;
+    WGPUSurface m_Surface = nullptr;
+    WGPUSurfaceConfiguration m_Config = {};
+    bool m_Configured = false;
+
+    // The size the window currently has, which may differ from the
+    // configured size while a resize is being debounced.
+    uint32_t m_PendingWidth = 0;
+    uint32_t m_PendingHeight = 0;
+    bool m_ResizePending = false;
+    bool m_ReconfigureRequired = false;
+    Clock::time_point m_LastResizeEvent;
+
+    std::vector<ResizeCallback> m_ResizeCallbacks;
+
+    SurfaceStats m_Stats;
+
+public:
+    bool Initialize(WGPUDevice device, WGPUSurface surface, WGPUTextureFormat format, uint32_t width, uint32_t height, WGPUPresentMode presentMode);
+
+    void Terminate();
+
+    // To be called with the current size of the window's framebuffer, as
+    // often as convenient.
+    void Resize(uint32_t width, uint32_t height);
+
+    // Register a callback that recreates resources that depend on the size
+    // of the surface (depth buffers, offscreen targets...). It is called
+    // every time the surface is actually reconfigured to a new size.
+    void AddResizeCallback(ResizeCallback callback);
+
+    // Returns false when there is nothing to render to this frame (window
+    // minimized, acquire timeout...). The frame is then counted as skipped.
+    bool AcquireNextFrame(SurfaceFrame &frame);
+
+    void Present(SurfaceFrame &frame);
+
+    WGPUTextureFormat GetFormat() const { return m_Config.format; }
+    uint32_t GetWidth() const { return m_Config.width; }
+    uint32_t GetHeight() const { return m_Config.height; }
+
+    // False while the window is minimized.
+    bool IsConfigured() const { return m_Configured; }
+    // True while a resize is being debounced.
+    bool HasPendingResize() const { return m_ResizePending; }
+
+    const SurfaceStats &GetStats() const { return m_Stats; }
+
+private:
+    void Configure(uint32_t width, uint32_t height);
+};
+
+void PrintSurfaceStats(const SurfaceStats &stats);
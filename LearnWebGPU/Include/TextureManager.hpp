@@ -0,0 +1,128 @@
+#pragma once
+
+#include <webgpu/webgpu.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "GpuMemoryTracker.hpp"
+#include "MipmapGenerator.hpp"
+#include "SamplerCache.hpp"
+#include "ShaderCache.hpp"
+#include "ThreadPool.hpp"
+#include "WebGPUHandles.hpp"
+
+using TextureId = uint32_t;
+constexpr TextureId InvalidTextureId = UINT32_MAX;
+
+struct TextureStats {
+    uint32_t Requested = 0;
+    uint32_t Loaded = 0;
+    uint32_t Failed = 0;
+    // Only the first level of each texture, the others are generated.
+    uint64_t BytesUploaded = 0;
+    uint32_t MipLevelsGenerated = 0;
+    // Summed over the worker threads.
+    double DecodeSeconds = 0.0;
+    // On the thread that owns the queue: writing the first level and
+    // recording the mip generation.
+    double UploadSeconds = 0.0;
+};
+
+/**
+ * Color textures, decoded on worker threads and uploaded by the thread that
+ * owns the queue.
+ *
+ * Load() returns right away and decodes the image on a worker. The next
+ * Update() writes its first level with wgpuQueueWriteTexture and records
+ * the generation of the rest of its mip chain into the frame's command
+ * encoder, after which GetView() stops returning nullptr.
+ *
+ * Every texture is RGBA8 with sRGB colors, sampled through an sRGB view so
+ * that filtering blends linear colors. Apart from the decoding, everything
+ * must happen on the thread that owns the queue.
+ */
+class TextureManager {
+public:
+    // Called from a worker thread once an image is ready to be uploaded.
+    using DecodedCallback = std::function<void(TextureId id)>;
+
+private:
+    struct Entry {
+        std::string Name;
+        TextureHandle Texture;
+        TextureViewHandle View;
+        uint32_t Width = 0;
+        uint32_t Height = 0;
+        // Released while its image was being decoded.
+        bool Released = false;
+    };
+
+    struct DecodedImage {
+        TextureId Id = InvalidTextureId;
+        uint32_t Width = 0;
+        uint32_t Height = 0;
+        // Empty when the image could not be decoded.
+        std::vector<uint8_t> Pixels;
+    };
+
+    WGPUDevice m_Device = nullptr;
+    WGPUQueue m_Queue = nullptr;
+    GpuMemoryTracker *m_Memory = nullptr;
+    ThreadPool *m_Workers = nullptr;
+    MipmapGenerator m_Mipmaps;
+    uint32_t m_MaxDimension = 0;
+    DecodedCallback m_OnDecoded;
+
+    std::vector<Entry> m_Textures;
+
+    // Shared with the workers.
+    mutable std::mutex m_Mutex;
+    std::condition_variable m_Decoded;
+    std::vector<DecodedImage> m_DecodedImages;
+    uint32_t m_PendingDecodes = 0;
+
+    TextureStats m_Stats;
+
+public:
+    bool Initialize(WGPUDevice device, WGPUQueue queue, ShaderCache &shaderCache, GpuMemoryTracker &memory, ThreadPool &workers);
+
+    // Waits for the images being decoded. The device must be idle.
+    void Terminate();
+
+    void SetDecodedCallback(DecodedCallback callback) { m_OnDecoded = std::move(callback); }
+
+    // Decode the image at path in the background. Only binary PPM images
+    // are supported.
+    TextureId Load(const std::string &path);
+
+    // Create a texture from tightly packed RGBA8 pixels, whose generation
+    // is recorded into encoder. Returns InvalidTextureId on failure.
+    TextureId Create(WGPUCommandEncoder encoder, const std::string &name, uint32_t width, uint32_t height, const uint8_t *pixels);
+
+    // Upload the images decoded since the last call. Returns the number of
+    // textures that became ready.
+    uint32_t Update(WGPUCommandEncoder encoder);
+
+    // Block until every image passed to Load() is decoded, for tools that
+    // cannot wait for a later frame.
+    void WaitForDecodes();
+
+    void Release(TextureId id);
+
+    // nullptr until the texture is ready, or if it failed to load.
+    WGPUTextureView GetView(TextureId id) const;
+    WGPUTexture GetTexture(TextureId id) const;
+
+    TextureStats GetStats() const;
+
+private:
+    bool Upload(WGPUCommandEncoder encoder, TextureId id, uint32_t width, uint32_t height, const uint8_t *pixels);
+};
+
+void PrintTextureStats(const TextureStats &stats, const SamplerCacheStats &samplerStats);
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A fixed set of worker threads pulling jobs from a shared queue. Used for
+ * anything that should not run on the main or render thread: pipeline
+ * compilation, asset decoding, encoding of output images...
+ */
+class ThreadPool {
+public:
+    using Job = std::function<void()>;
+    // Processes the items [begin, end) of a ParallelFor().
+    using RangeJob = std::function<void(uint32_t begin, uint32_t end)>;
+
+private:
+    std::vector<std::thread> m_Threads;
+    std::deque<Job> m_Jobs;
+    std::mutex m_Mutex;
+    std::condition_variable m_JobAvailable;
+    std::condition_variable m_JobsDone;
+    uint32_t m_ActiveJobs = 0;
+    bool m_Stopping = false;
+
+public:
+    ~ThreadPool();
+
+    // A thread count of 0 means one thread per hardware thread, minus one
+    // for the thread that submits the jobs.
+    void Start(uint32_t threadCount = 0);
+
+    // Finish the queued jobs, then join every worker.
+    void Stop();
+
+    void Submit(Job job);
+
+    // Block until the queue is empty and no job is running.
+    void Wait();
+
+    // Split [0, count) in ranges of grainSize items and process them on the
+    // workers and on the calling thread, returning once every range is done.
+    // Unlike Wait(), this does not wait for unrelated jobs: if the workers
+    // are busy, the calling thread ends up doing all the work itself.
+    void ParallelFor(uint32_t count, uint32_t grainSize, const RangeJob &job);
+
+    uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_Threads.size()); }
+
+private:
+    void WorkerLoop();
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Matrix4.hpp"
+#include "ThreadPool.hpp"
+
+using TransformNode = uint32_t;
+constexpr TransformNode InvalidTransformNode = UINT32_MAX;
+
+struct TransformStats {
+    uint32_t Nodes = 0;
+    uint32_t Levels = 0;
+    // Of the last Update().
+    uint32_t Recomputed = 0;
+    double Seconds = 0.0;
+    // How many times the nodes had to be re-sorted by depth.
+    uint64_t Rebuilds = 0;
+};
+
+/**
+ * Parent/child transforms, stored as structure of arrays sorted by depth.
+ *
+ * Since every parent comes before its children, world matrices are
+ * propagated in a single pass over contiguous arrays, and all the nodes of a
+ * level can be processed in parallel. Changing a local matrix marks its node
+ * dirty, and Update() only recomputes the dirty nodes and their descendants.
+ *
+ * Nodes are referred to by stable handles, which are translated to their
+ * position in the sorted arrays.
+ */
+class TransformHierarchy {
+public:
+    // Nodes per parallel job. Below that, a level is processed on the
+    // calling thread.
+    static constexpr uint32_t GrainSize = 16 * 1024;
+
+private:
+    static constexpr uint32_t NoParent = UINT32_MAX;
+
+    // Indexed by position, i.e. sorted by depth.
+    std::vector<uint32_t> m_Parents;
+    std::vector<uint32_t> m_Depths;
+    std::vector<Matrix4> m_Local;
+    std::vector<Matrix4> m_World;
+    std::vector<uint8_t> m_Dirty;
+    std::vector<TransformNode> m_PositionToNode;
+
+    // Indexed by handle.
+    std::vector<uint32_t> m_NodeToPosition;
+
+    // First position of each depth, plus the end of the last one. Only valid
+    // while the nodes are sorted.
+    std::vector<uint32_t> m_LevelStarts;
+    bool m_Sorted = true;
+    bool m_AnyDirty = false;
+
+    ThreadPool *m_Workers = nullptr;
+
+    TransformStats m_Stats;
+
+public:
+    // Without a thread pool, everything is updated on the calling thread.
+    void SetThreadPool(ThreadPool *workers) { m_Workers = workers; }
+
+    void Clear();
+    void Reserve(uint32_t count);
+
+    // The parent must already exist, or be InvalidTransformNode for a root.
+    // Nodes added parents first, level by level, stay sorted; any other
+    // order costs a re-sort at the next Update().
+    TransformNode AddNode(TransformNode parent, const Matrix4 &local = Matrix4::Identity());
+
+    void SetLocal(TransformNode node, const Matrix4 &local);
+    const Matrix4 &GetLocal(TransformNode node) const { return m_Local[m_NodeToPosition[node]]; }
+
+    // Only up to date after Update().
+    const Matrix4 &GetWorld(TransformNode node) const { return m_World[m_NodeToPosition[node]]; }
+
+    // Recompute the world matrices of the dirty nodes and of everything
+    // below them. Returns the number of matrices recomputed.
+    uint32_t Update();
+
+    uint32_t GetNodeCount() const { return static_cast<uint32_t>(m_Parents.size()); }
+
+    const TransformStats &GetStats() const { return m_Stats; }
+
+private:
+    void SortByDepth();
+    uint32_t UpdateRange(uint32_t begin, uint32_t end);
+};
+
+void PrintTransformStats(const TransformStats &stats);
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <webgpu/webgpu.h>
+
+#include <cstdint>
+#include <utility>
+
+#ifdef LEARNWEBGPU_TRACK_HANDLES
+#include <atomic>
+
+/**
+ * Number of objects of one handle type created and released through Handle,
+ * used to report leaks at shutdown. Only compiled in when
+ * LEARNWEBGPU_TRACK_HANDLES is defined (debug builds), so that release
+ * builds pay nothing for it.
+ */
+struct HandleCounter {
+    const char *Name;
+    std::atomic<int64_t> Created = 0;
+    std::atomic<int64_t> Released = 0;
+
+    // Registers the counter in the list walked by ReportLeakedHandles().
+    explicit HandleCounter(const char *name);
+};
+
+#define LEARNWEBGPU_HANDLE_COUNTER(Type)              \
+    static HandleCounter &Counter() {                 \
+        static HandleCounter counter(#Type);          \
+        return counter;                               \
+    }
+#else
+#define LEARNWEBGPU_HANDLE_COUNTER(Type)
+#endif
+
+// Specialized for every handle type, see LEARNWEBGPU_DEFINE_HANDLE below.
+template <typename T>
+struct HandleTraits;
+
+/**
+ * Owns one reference to a WebGPU object and releases it when destroyed.
+ *
+ * It is exactly the size of the raw handle and moving it only moves the
+ * pointer: the only call into WebGPU it ever makes is the final
+ * wgpu*Release, so wrapping hot-path objects (encoders, passes, command
+ * buffers) costs nothing compared to raw handles. It converts implicitly to
+ * the raw handle so that it can be passed straight to the C API.
+ */
+template <typename T>
+class Handle {
+private:
+    T m_Handle = nullptr;
+
+public:
+    Handle() = default;
+
+    explicit Handle(T handle) : m_Handle(handle) {
+        Track(handle, &Counter::Created);
+    }
+
+    ~Handle() {
+        Reset();
+    }
+
+    Handle(const Handle &) = delete;
+    Handle &operator=(const Handle &) = delete;
+
+    Handle(Handle &&other) noexcept : m_Handle(std::exchange(other.m_Handle, nullptr)) {}
+
+    Handle &operator=(Handle &&other) noexcept {
+        if (this != &other) {
+            Reset();
+            m_Handle = std::exchange(other.m_Handle, nullptr);
+        }
+        return *this;
+    }
+
+    // Release the current object, if any, and take ownership of handle.
+    void Reset(T handle = nullptr) {
+        if (m_Handle) {
+            HandleTraits<T>::Release(m_Handle);
+            Track(m_Handle, &Counter::Released);
+        }
+        m_Handle = handle;
+        Track(handle, &Counter::Created);
+    }
+
+    // Give up ownership without releasing. The caller becomes responsible
+    // for the reference, which is no longer counted by the leak registry.
+    T Detach() {
+        Track(m_Handle, &Counter::Released);
+        return std::exchange(m_Handle, nullptr);
+    }
+
+    T Get() const { return m_Handle; }
+
+    // For C functions taking an array of handles.
+    const T *GetAddress() const { return &m_Handle; }
+
+    operator T() const { return m_Handle; }
+
+    explicit operator bool() const { return m_Handle != nullptr; }
+
+private:
+#ifdef LEARNWEBGPU_TRACK_HANDLES
+    using Counter = HandleCounter;
+
+    static void Track(T handle, std::atomic<int64_t> HandleCounter::*field) {
+        if (handle) {
+            (HandleTraits<T>::Counter().*field).fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+#else
+    struct Counter {
+        int Created;
+        int Released;
+    };
+
+    static void Track(T, int Counter::*) {}
+#endif
+};
+
+#define LEARNWEBGPU_DEFINE_HANDLE(Type)                                  \
+    template <>                                                          \
+    struct HandleTraits<WGPU##Type> {                                    \
+        static void Release(WGPU##Type handle) { wgpu##Type##Release(handle); } \
+        LEARNWEBGPU_HANDLE_COUNTER(WGPU##Type)                           \
+    };                                                                   \
+    using Type##Handle = Handle<WGPU##Type>;
+
+LEARNWEBGPU_DEFINE_HANDLE(Instance)
+LEARNWEBGPU_DEFINE_HANDLE(Adapter)
+LEARNWEBGPU_DEFINE_HANDLE(Device)
+LEARNWEBGPU_DEFINE_HANDLE(Queue)
+LEARNWEBGPU_DEFINE_HANDLE(Surface)
+LEARNWEBGPU_DEFINE_HANDLE(Buffer)
+LEARNWEBGPU_DEFINE_HANDLE(Texture)
+LEARNWEBGPU_DEFINE_HANDLE(TextureView)
+LEARNWEBGPU_DEFINE_HANDLE(Sampler)
+LEARNWEBGPU_DEFINE_HANDLE(ShaderModule)
+LEARNWEBGPU_DEFINE_HANDLE(RenderPipeline)
+LEARNWEBGPU_DEFINE_HANDLE(ComputePipeline)
+LEARNWEBGPU_DEFINE_HANDLE(BindGroup)
+LEARNWEBGPU_DEFINE_HANDLE(BindGroupLayout)
+LEARNWEBGPU_DEFINE_HANDLE(PipelineLayout)
+LEARNWEBGPU_DEFINE_HANDLE(QuerySet)
+LEARNWEBGPU_DEFINE_HANDLE(CommandEncoder)
+LEARNWEBGPU_DEFINE_HANDLE(CommandBuffer)
+LEARNWEBGPU_DEFINE_HANDLE(RenderPassEncoder)
+LEARNWEBGPU_DEFINE_HANDLE(ComputePassEncoder)
+
+static_assert(sizeof(BufferHandle) == sizeof(WGPUBuffer), "Handle must not add any storage");
+
+/**
+ * Print the number of objects of each type still alive and return the
+ * total. Always returns 0 when LEARNWEBGPU_TRACK_HANDLES is not defined.
+ */
+int64_t ReportLeakedHandles();
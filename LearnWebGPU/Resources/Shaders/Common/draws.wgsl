@@ -0,0 +1,13 @@
+/**
+ * Where to draw one object, must match DrawData in DrawList.hpp.
+ */
+struct DrawData {
+    // Model to scene. The scene's z is the depth, between 0 (closest) and 1
+    // (farthest).
+    transform: mat4x4f,
+    // Multiplies the vertex colors.
+    tint: vec4f,
+};
+
+// One entry per draw, the instance index tells which one is ours.
+@group(0) @binding(0) var<storage, read> draws: array<DrawData>;
@@ -0,0 +1,23 @@
+/**
+ * A short kernel timed on every adapter when the adapter is chosen by
+ * benchmark, see BenchmarkAdapter(). Mostly arithmetic, with one read and
+ * one write of a few MiB so that memory is not left out entirely.
+ */
+
+const WorkgroupSize: u32 = 256u;
+const Iterations: u32 = 256u;
+
+@group(0) @binding(0) var<storage, read_write> values: array<vec4f>;
+
+@compute @workgroup_size(WorkgroupSize)
+fn main(@builtin(global_invocation_id) id: vec3u) {
+    if (id.x >= arrayLength(&values)) {
+        return;
+    }
+
+    var value = values[id.x];
+    for (var i = 0u; i < Iterations; i++) {
+        value = fma(value, vec4f(0.999), vec4f(0.001));
+    }
+    values[id.x] = value;
+}
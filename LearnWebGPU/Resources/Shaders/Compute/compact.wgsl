@@ -0,0 +1,33 @@
+/**
+ * Stream compaction: copies the values whose flag is not zero, in order.
+ *
+ * positions holds the exclusive scan of the flags counted as 0 or 1 (see
+ * scan_flags_exclusive), which is where each kept value goes. The number of
+ * values is the length of the values binding.
+ */
+const WorkgroupSize: u32 = 256u;
+const ItemsPerThread: u32 = 4u;
+const BlockSize: u32 = WorkgroupSize * ItemsPerThread;
+
+@group(0) @binding(0) var<storage, read> values: array<u32>;
+@group(0) @binding(1) var<storage, read> flags: array<u32>;
+@group(0) @binding(2) var<storage, read> positions: array<u32>;
+@group(0) @binding(3) var<storage, read_write> output: array<u32>;
+@group(0) @binding(4) var<storage, read_write> outputCount: array<u32>;
+
+@compute @workgroup_size(WorkgroupSize)
+fn compact_scatter(@builtin(local_invocation_index) localIndex: u32, @builtin(workgroup_id) groupId: vec3u) {
+    let count = arrayLength(&values);
+    for (var i = 0u; i < ItemsPerThread; i++) {
+        let index = groupId.x * BlockSize + i * WorkgroupSize + localIndex;
+        if (index < count) {
+            let keep = flags[index] != 0u;
+            if (keep) {
+                output[positions[index]] = values[index];
+            }
+            if (index == count - 1u) {
+                outputCount[0] = positions[index] + select(0u, 1u, keep);
+            }
+        }
+    }
+}
@@ -0,0 +1,70 @@
+/**
+ * Generates one mip level of an RGBA8 texture from the level above it.
+ *
+ * Colors are sRGB-encoded, so they are averaged once converted to linear
+ * and encoded again when stored: averaging the encoded values would make
+ * every level darker than the previous one.
+ *
+ * Along a dimension whose source size is even, each destination texel
+ * averages two source texels. When it is odd, the destination is rounded
+ * down and each of its texels covers a little more than two source texels:
+ * three of them are weighted by how much of each is covered, so that no
+ * row or column of the source is dropped.
+ */
+const WorkgroupSize: u32 = 8u;
+
+@group(0) @binding(0) var source: texture_2d<f32>;
+@group(0) @binding(1) var destination: texture_storage_2d<rgba8unorm, write>;
+
+fn srgb_to_linear(color: vec3f) -> vec3f {
+    let low = color / 12.92;
+    let high = pow((color + 0.055) / 1.055, vec3f(2.4));
+    return select(high, low, color <= vec3f(0.04045));
+}
+
+fn linear_to_srgb(color: vec3f) -> vec3f {
+    let low = color * 12.92;
+    let high = 1.055 * pow(color, vec3f(1.0 / 2.4)) - 0.055;
+    return select(high, low, color <= vec3f(0.0031308));
+}
+
+// Weights of the source texels 2x, 2x + 1 and 2x + 2 along one dimension.
+fn footprint_weights(x: u32, sourceSize: u32, destinationSize: u32) -> vec3f {
+    if (sourceSize == 1u) {
+        return vec3f(1.0, 0.0, 0.0);
+    }
+    if (sourceSize % 2u == 0u) {
+        return vec3f(0.5, 0.5, 0.0);
+    }
+    let n = f32(sourceSize);
+    let m = f32(destinationSize);
+    let i = f32(x);
+    return vec3f((m - i) / n, m / n, (i + 1.0) / n);
+}
+
+@compute @workgroup_size(WorkgroupSize, WorkgroupSize)
+fn downsample(@builtin(global_invocation_id) id: vec3u) {
+    let destinationSize = textureDimensions(destination);
+    if (any(id.xy >= destinationSize)) {
+        return;
+    }
+
+    let sourceSize = textureDimensions(source);
+    let weightsX = footprint_weights(id.x, sourceSize.x, destinationSize.x);
+    let weightsY = footprint_weights(id.y, sourceSize.y, destinationSize.y);
+    let origin = id.xy * 2u;
+    let last = sourceSize - 1u;
+
+    var sum = vec4f(0.0);
+    for (var j = 0u; j < 3u; j++) {
+        for (var i = 0u; i < 3u; i++) {
+            let weight = weightsX[i] * weightsY[j];
+            if (weight > 0.0) {
+                let texel = textureLoad(source, min(origin + vec2u(i, j), last), 0);
+                sum += weight * vec4f(srgb_to_linear(texel.rgb), texel.a);
+            }
+        }
+    }
+
+    textureStore(destination, id.xy, vec4f(linear_to_srgb(sum.rgb), sum.a));
+}
@@ -0,0 +1,132 @@
+/**
+ * One pass of a least significant digit radix sort of u32 keys, RadixBits
+ * bits at a time.
+ *
+ * radix_histogram counts the digits of each block of BlockSize keys, digit
+ * major, so that an exclusive scan of the histograms gives, for each digit
+ * and block, where the first key of that digit in that block goes.
+ * radix_scatter then ranks the keys of a block among the ones with the same
+ * digit, which keeps the sort stable, and writes them there.
+ */
+const WorkgroupSize: u32 = 256u;
+const ItemsPerThread: u32 = 4u;
+const BlockSize: u32 = WorkgroupSize * ItemsPerThread;
+const RadixBits: u32 = 4u;
+const RadixSize: u32 = 16u;
+// Digit counts are packed two per u32, 16 bits each. A count never exceeds
+// BlockSize, so the halves never carry into each other.
+const PackedWords: u32 = RadixSize / 2u;
+
+struct RadixParams {
+    shift: u32,
+};
+
+@group(0) @binding(0) var<storage, read> keysIn: array<u32>;
+// The histograms for radix_histogram, the sorted keys for radix_scatter.
+@group(0) @binding(1) var<storage, read_write> output: array<u32>;
+@group(0) @binding(2) var<uniform> params: RadixParams;
+// Exclusive scan of the histograms.
+@group(0) @binding(3) var<storage, read> offsets: array<u32>;
+
+var<workgroup> digitCounts: array<atomic<u32>, RadixSize>;
+var<workgroup> keyTile: array<u32, BlockSize>;
+var<workgroup> packedCounts: array<array<u32, WorkgroupSize>, PackedWords>;
+
+fn get_digit(key: u32) -> u32 {
+    return (key >> params.shift) & (RadixSize - 1u);
+}
+
+@compute @workgroup_size(WorkgroupSize)
+fn radix_histogram(
+    @builtin(local_invocation_index) localIndex: u32,
+    @builtin(workgroup_id) groupId: vec3u,
+    @builtin(num_workgroups) groupCount: vec3u
+) {
+    if (localIndex < RadixSize) {
+        atomicStore(&digitCounts[localIndex], 0u);
+    }
+    workgroupBarrier();
+
+    let count = arrayLength(&keysIn);
+    for (var i = 0u; i < ItemsPerThread; i++) {
+        let index = groupId.x * BlockSize + i * WorkgroupSize + localIndex;
+        if (index < count) {
+            atomicAdd(&digitCounts[get_digit(keysIn[index])], 1u);
+        }
+    }
+    workgroupBarrier();
+
+    if (localIndex < RadixSize) {
+        output[localIndex * groupCount.x + groupId.x] = atomicLoad(&digitCounts[localIndex]);
+    }
+}
+
+@compute @workgroup_size(WorkgroupSize)
+fn radix_scatter(
+    @builtin(local_invocation_index) localIndex: u32,
+    @builtin(workgroup_id) groupId: vec3u,
+    @builtin(num_workgroups) groupCount: vec3u
+) {
+    let count = arrayLength(&keysIn);
+    let blockStart = groupId.x * BlockSize;
+
+    // Coalesced loads, each thread then takes ItemsPerThread consecutive
+    // keys so that thread order is key order.
+    for (var i = 0u; i < ItemsPerThread; i++) {
+        let index = blockStart + i * WorkgroupSize + localIndex;
+        if (index < count) {
+            keyTile[i * WorkgroupSize + localIndex] = keysIn[index];
+        }
+    }
+    workgroupBarrier();
+
+    let first = localIndex * ItemsPerThread;
+    var keys: array<u32, ItemsPerThread>;
+    var digits: array<u32, ItemsPerThread>;
+    // Rank of each key among the keys of the same digit of this thread.
+    var threadRanks: array<u32, ItemsPerThread>;
+    var counts: array<u32, PackedWords>;
+    for (var i = 0u; i < ItemsPerThread; i++) {
+        if (blockStart + first + i < count) {
+            let key = keyTile[first + i];
+            let digit = get_digit(key);
+            let shift = (digit & 1u) * 16u;
+            keys[i] = key;
+            digits[i] = digit;
+            threadRanks[i] = (counts[digit / 2u] >> shift) & 0xffffu;
+            counts[digit / 2u] += 1u << shift;
+        }
+    }
+
+    for (var word = 0u; word < PackedWords; word++) {
+        packedCounts[word][localIndex] = counts[word];
+    }
+    workgroupBarrier();
+
+    // Inclusive scan of the packed counts across threads, all digits at
+    // once.
+    for (var offset = 1u; offset < WorkgroupSize; offset <<= 1u) {
+        var others: array<u32, PackedWords>;
+        if (localIndex >= offset) {
+            for (var word = 0u; word < PackedWords; word++) {
+                others[word] = packedCounts[word][localIndex - offset];
+            }
+        }
+        workgroupBarrier();
+        for (var word = 0u; word < PackedWords; word++) {
+            packedCounts[word][localIndex] += others[word];
+        }
+        workgroupBarrier();
+    }
+
+    for (var i = 0u; i < ItemsPerThread; i++) {
+        if (blockStart + first + i < count) {
+            let digit = digits[i];
+            let word = digit / 2u;
+            let shift = (digit & 1u) * 16u;
+            // Keys of the same digit in the previous threads of the block.
+            let before = ((packedCounts[word][localIndex] - counts[word]) >> shift) & 0xffffu;
+            output[offsets[digit * groupCount.x + groupId.x] + before + threadRanks[i]] = keys[i];
+        }
+    }
+}
@@ -0,0 +1,46 @@
+/**
+ * Sum of u32 values, wrapping around on overflow.
+ *
+ * Each workgroup sums a block of BlockSize consecutive values into one
+ * output value, so n values are summed in ceil(log_BlockSize(n))
+ * dispatches. The number of values is the length of the input binding.
+ */
+const WorkgroupSize: u32 = 256u;
+const ItemsPerThread: u32 = 8u;
+const BlockSize: u32 = WorkgroupSize * ItemsPerThread;
+
+@group(0) @binding(0) var<storage, read> input: array<u32>;
+@group(0) @binding(1) var<storage, read_write> output: array<u32>;
+
+var<workgroup> partialSums: array<u32, WorkgroupSize>;
+
+@compute @workgroup_size(WorkgroupSize)
+fn reduce_sum(@builtin(local_invocation_index) localIndex: u32, @builtin(workgroup_id) groupId: vec3u) {
+    let count = arrayLength(&input);
+    let blockStart = groupId.x * BlockSize;
+
+    // Neighbouring threads read neighbouring values, so that the loads of a
+    // workgroup are coalesced. Summing several values per thread first
+    // keeps most of the work out of the barriers below.
+    var sum = 0u;
+    for (var i = 0u; i < ItemsPerThread; i++) {
+        let index = blockStart + i * WorkgroupSize + localIndex;
+        if (index < count) {
+            sum += input[index];
+        }
+    }
+    partialSums[localIndex] = sum;
+    workgroupBarrier();
+
+    // Tree reduction, halving the number of active threads at each step.
+    for (var stride = WorkgroupSize / 2u; stride > 0u; stride >>= 1u) {
+        if (localIndex < stride) {
+            partialSums[localIndex] += partialSums[localIndex + stride];
+        }
+        workgroupBarrier();
+    }
+
+    if (localIndex == 0u) {
+        output[groupId.x] = partialSums[0];
+    }
+}
@@ -0,0 +1,118 @@
+/**
+ * Prefix sums of u32 values.
+ *
+ * Each workgroup scans a block of BlockSize values and writes the total of
+ * the block to blockSums. When there is more than one block, the block sums
+ * are scanned in turn (exclusively) and add_block_offsets adds the result
+ * back to every value of the blocks. The number of values is the length of
+ * the input binding.
+ */
+const WorkgroupSize: u32 = 256u;
+const ItemsPerThread: u32 = 4u;
+const BlockSize: u32 = WorkgroupSize * ItemsPerThread;
+
+@group(0) @binding(0) var<storage, read> input: array<u32>;
+@group(0) @binding(1) var<storage, read_write> output: array<u32>;
+@group(0) @binding(2) var<storage, read_write> blockSums: array<u32>;
+
+var<workgroup> tile: array<u32, BlockSize>;
+var<workgroup> threadSums: array<u32, WorkgroupSize>;
+
+fn scan_block(localIndex: u32, groupIndex: u32, exclusive: bool, countFlags: bool) {
+    let count = arrayLength(&input);
+    let blockStart = groupIndex * BlockSize;
+
+    // Coalesced loads into workgroup memory...
+    for (var i = 0u; i < ItemsPerThread; i++) {
+        let index = blockStart + i * WorkgroupSize + localIndex;
+        var value = 0u;
+        if (index < count) {
+            value = input[index];
+            // Counting non-zero flags is what stream compaction needs.
+            if (countFlags) {
+                value = select(0u, 1u, value != 0u);
+            }
+        }
+        tile[i * WorkgroupSize + localIndex] = value;
+    }
+    workgroupBarrier();
+
+    // ...from which each thread takes ItemsPerThread consecutive values.
+    let first = localIndex * ItemsPerThread;
+    var threadSum = 0u;
+    for (var i = 0u; i < ItemsPerThread; i++) {
+        threadSum += tile[first + i];
+    }
+    threadSums[localIndex] = threadSum;
+    workgroupBarrier();
+
+    // Inclusive scan of the sums of the threads (Hillis-Steele): only
+    // log2(WorkgroupSize) steps, which beats a work-efficient scan at this
+    // size.
+    for (var offset = 1u; offset < WorkgroupSize; offset <<= 1u) {
+        var other = 0u;
+        if (localIndex >= offset) {
+            other = threadSums[localIndex - offset];
+        }
+        workgroupBarrier();
+        threadSums[localIndex] += other;
+        workgroupBarrier();
+    }
+
+    // Every thread owns its values in the tile, no barrier needed until
+    // they are written out.
+    var prefix = threadSums[localIndex] - threadSum;
+    for (var i = 0u; i < ItemsPerThread; i++) {
+        let value = tile[first + i];
+        if (exclusive) {
+            tile[first + i] = prefix;
+            prefix += value;
+        } else {
+            prefix += value;
+            tile[first + i] = prefix;
+        }
+    }
+    workgroupBarrier();
+
+    for (var i = 0u; i < ItemsPerThread; i++) {
+        let index = blockStart + i * WorkgroupSize + localIndex;
+        if (index < count) {
+            output[index] = tile[i * WorkgroupSize + localIndex];
+        }
+    }
+
+    if (localIndex == WorkgroupSize - 1u && groupIndex < arrayLength(&blockSums)) {
+        blockSums[groupIndex] = threadSums[WorkgroupSize - 1u];
+    }
+}
+
+@compute @workgroup_size(WorkgroupSize)
+fn scan_inclusive(@builtin(local_invocation_index) localIndex: u32, @builtin(workgroup_id) groupId: vec3u) {
+    scan_block(localIndex, groupId.x, false, false);
+}
+
+@compute @workgroup_size(WorkgroupSize)
+fn scan_exclusive(@builtin(local_invocation_index) localIndex: u32, @builtin(workgroup_id) groupId: vec3u) {
+    scan_block(localIndex, groupId.x, true, false);
+}
+
+// Exclusive scan of (value != 0), i.e. where each kept value goes when
+// compacting.
+@compute @workgroup_size(WorkgroupSize)
+fn scan_flags_exclusive(@builtin(local_invocation_index) localIndex: u32, @builtin(workgroup_id) groupId: vec3u) {
+    scan_block(localIndex, groupId.x, true, true);
+}
+
+// input holds the exclusive scan of the block sums, output the values to
+// offset.
+@compute @workgroup_size(WorkgroupSize)
+fn add_block_offsets(@builtin(local_invocation_index) localIndex: u32, @builtin(workgroup_id) groupId: vec3u) {
+    let count = arrayLength(&output);
+    let offset = input[groupId.x];
+    for (var i = 0u; i < ItemsPerThread; i++) {
+        let index = groupId.x * BlockSize + i * WorkgroupSize + localIndex;
+        if (index < count) {
+            output[index] += offset;
+        }
+    }
+}
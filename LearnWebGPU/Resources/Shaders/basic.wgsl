@@ -1,3 +1,8 @@
+// Compiled with TEXTURED defined, a texture modulates the vertex colors.
+#option TEXTURED
+
+#include "Common/draws.wgsl"
+
 /**
  * A structure with fields labeled with vertex attribute locations can be used
  * as input to the entry point of a shader.
@@ -19,20 +24,50 @@ struct VertexOutput {
     // (It can also refer to another field of another struct that would be used
     // as input to the fragment shader.)
     @location(0) color: vec3f,
+#ifdef TEXTURED
+    @location(1) uv: vec2f,
+#endif
 };
 
+// Pipeline-overridable constants, given by the application when it creates
+// the pipeline. They cost nothing per vertex: the compiler folds them like
+// literals.
+// Width over height of the target surface.
+override AspectRatio: f32 = 1.0;
+// Gamma the vertex colors are encoded with.
+override ColorGamma: f32 = 2.2;
+
+#ifdef TEXTURED
+// How many times the texture repeats per model space unit.
+override TextureScale: f32 = 2.0;
+
+// Bound through an sRGB view: samples are already linear.
+@group(1) @binding(0) var baseColorTexture: texture_2d<f32>;
+@group(1) @binding(1) var baseColorSampler: sampler;
+#endif
+
 @vertex
-fn vs_main(in: VertexInput) -> VertexOutput {
+fn vs_main(in: VertexInput, @builtin(instance_index) instanceIndex: u32) -> VertexOutput {
     var out: VertexOutput; // Create the output struct.
-    let ratio = 640.0 / 480.0; // The width and the height of the target surface.
-    let offset = vec2f(-0.6875, -0.463);
-    out.position = vec4f(in.position.x + offset.x, (in.position.y + offset.y) * ratio, 0.0, 1.0); // Same as what we used to directly return.
-    out.color = in.color; // Forward the color attribute to the fragment shader.
+    let draw = draws[instanceIndex];
+    let position = draw.transform * vec4f(in.position, 0.0, 1.0);
+    out.position = vec4f(position.x, position.y * AspectRatio, position.z, position.w);
+    out.color = in.color * draw.tint.rgb; // Forward the color attribute to the fragment shader.
+#ifdef TEXTURED
+    // The mesh has no texture coordinates: they are derived from the model
+    // space position, so the texture repeats across the object. Texture
+    // coordinates go down, model space goes up.
+    out.uv = vec2f(in.position.x, -in.position.y) * TextureScale;
+#endif
     return out;
 }
 
 @fragment
 fn fs_main(in: VertexOutput) -> @location(0) vec4f {
-    let linear_color = pow(in.color, vec3f(2.2));
+#ifdef TEXTURED
+    let linear_color = pow(in.color, vec3f(ColorGamma)) * textureSample(baseColorTexture, baseColorSampler, in.uv).rgb;
+#else
+    let linear_color = pow(in.color, vec3f(ColorGamma));
+#endif
     return vec4f(linear_color, 1.0); // Use the interpolated color coming from the vertex shader.
-}
\ No newline at end of file
+}
@@ -0,0 +1,38 @@
+/**
+ * Upscales the part of the offscreen scene texture that was rendered to,
+ * to the whole surface.
+ */
+struct BlitParams {
+    // Size in pixels of the rendered part, which starts at the top left
+    // corner of the texture.
+    renderSize: vec2f,
+};
+
+@group(0) @binding(0) var sceneTexture: texture_2d<f32>;
+@group(0) @binding(1) var sceneSampler: sampler;
+@group(0) @binding(2) var<uniform> params: BlitParams;
+
+struct VertexOutput {
+    @builtin(position) position: vec4f,
+    // 0 to 1 across the surface, with y going down like texture coordinates.
+    @location(0) uv: vec2f,
+};
+
+@vertex
+fn vs_main(@builtin(vertex_index) vertexIndex: u32) -> VertexOutput {
+    // A single triangle covering the whole screen, no vertex buffer needed.
+    let uv = vec2f(f32((vertexIndex << 1u) & 2u), f32(vertexIndex & 2u));
+    var out: VertexOutput;
+    out.position = vec4f(uv.x * 2.0 - 1.0, 1.0 - uv.y * 2.0, 0.0, 1.0);
+    out.uv = uv;
+    return out;
+}
+
+@fragment
+fn fs_main(in: VertexOutput) -> @location(0) vec4f {
+    // Stay half a texel inside the rendered part, so that bilinear filtering
+    // never blends in the pixels around it.
+    let pixel = clamp(in.uv * params.renderSize, vec2f(0.5), params.renderSize - vec2f(0.5));
+    let size = vec2f(textureDimensions(sceneTexture));
+    return textureSampleLevel(sceneTexture, sceneSampler, pixel / size, 0.0);
+}
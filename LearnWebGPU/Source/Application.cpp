@@ -8,71 +8,209 @@
 
 #include <magic_enum/magic_enum.hpp>
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
 #include <cstdint>
 #include <iostream>
+#include <string>
+#include <utility>
 #include <vector>
 
+#include "AdapterSelector.hpp"
+#include "BatchRender.hpp"
+#include "Compute.hpp"
 #include "DeviceUtils.hpp"
 #include "FileLoader.hpp"
+#include "ImageWriter.hpp"
+#include "MeshSplitter.hpp"
+#include "Scene.hpp"
+
+namespace {
+    // Every mesh is sub-allocated from the same pooled buffers, sized once
+    // for the whole run: the minimum capacities below, or the loaded
+    // geometry, within the device's maxBufferSize.
+    constexpr uint32_t VertexPoolCapacity = 1 << 16;
+    constexpr uint32_t IndexPoolCapacity = 1 << 18;
+    // The WebGPU default, enough for screenshots of very large windows.
+    constexpr uint64_t DefaultMaxBufferSize = uint64_t{ 256 } << 20;
+
+    constexpr uint32_t FramesInFlight = 2;
+
+    constexpr WGPUTextureFormat DepthFormat = WGPUTextureFormat_Depth24Plus;
+
+    // The 8-bit color formats images can be saved from.
+    bool IsImageFormat(WGPUTextureFormat format, bool &bgra) {
+        bgra = format == WGPUTextureFormat_BGRA8Unorm || format == WGPUTextureFormat_BGRA8UnormSrgb;
+        return bgra || format == WGPUTextureFormat_RGBA8Unorm || format == WGPUTextureFormat_RGBA8UnormSrgb;
+    }
+}
+
+bool Application::Initialize(const AppOptions &options, StartupProfiler &startup) {
+    m_Options = options;
+    m_Startup = &startup;
+
+    // The device limits depend on the geometry, so it must be parsed before
+    // the adapter is selected. It is parsed on the workers while the windows
+    // and the instance are created. A file given twice is only loaded once.
+    m_Workers.Start();
+    std::vector<std::string> meshPaths = m_Options.MeshPaths;
+    if (meshPaths.empty()) {
+        meshPaths.push_back("Resources/Models/webgpu.txt");
+    }
+    for (const std::string &path : meshPaths) {
+        if (std::none_of(m_LoadedMeshes.begin(), m_LoadedMeshes.end(), [&path](const LoadedMesh &mesh) { return mesh.Path == path; })) {
+            m_LoadedMeshes.emplace_back().Path = path;
+        }
+    }
+    // The meshes no longer move, the coroutines can keep references to them.
+    std::vector<Task<bool>> meshLoads;
+    for (LoadedMesh &mesh : m_LoadedMeshes) {
+        meshLoads.push_back(LoadMeshAsync(mesh));
+        meshLoads.back().Start();
+    }
+    // Also before returning early: a task must not be destroyed while a
+    // worker still holds its coroutine.
+    auto finishMeshLoads = [this, &meshLoads] {
+        bool loaded = true;
+        for (Task<bool> &load : meshLoads) {
+            while (!load.IsDone()) {
+                m_Events.Wait();
+            }
+            loaded = load.TakeResult() && loaded;
+        }
+        meshLoads.clear();
+        return loaded;
+    };
 
-bool Application::Initialize() {
     if (!glfwInit()) {
         std::cerr << "Could not intialize GLFW!\n";
+        finishMeshLoads();
         return false;
     }
+    startup.EndPhase("glfw init");
 
     glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
-
-    m_Window = glfwCreateWindow(640, 480, "Learn WebGPU", nullptr, nullptr);
+    // Batch mode only renders offscreen, but still needs a surface to pick
+    // an adapter and a format.
+    if (!m_Options.BatchPath.empty()) {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    }
 
-    if (!m_Window) {
-        std::cerr << "Could not open window!";
-        glfwTerminate();
-        return false;
+    // Every window shows the same scene. With enough monitors, each
+    // secondary window opens on its own one, otherwise they are staggered.
+    const uint32_t windowCount = m_Options.BatchPath.empty() ? m_Options.WindowCount : 1;
+    int monitorCount = 0;
+    GLFWmonitor **monitors = glfwGetMonitors(&monitorCount);
+    for (uint32_t i = 0; i < windowCount; ++i) {
+        const std::string title = i == 0 ? "Learn WebGPU" : "Learn WebGPU (" + std::to_string(i + 1) + ")";
+        GLFWwindow *window = glfwCreateWindow(640, 480, title.c_str(), nullptr, nullptr);
+
+        if (!window) {
+            std::cerr << "Could not open window!";
+            finishMeshLoads();
+            glfwTerminate();
+            return false;
+        }
+
+        if (i > 0) {
+            int x = 0, y = 0;
+            if (i < static_cast<uint32_t>(monitorCount)) {
+                glfwGetMonitorPos(monitors[i], &x, &y);
+                glfwSetWindowPos(window, x + 64, y + 64);
+            } else {
+                glfwGetWindowPos(m_Views.front()->Window, &x, &y);
+                glfwSetWindowPos(window, x + 32 * static_cast<int>(i), y + 32 * static_cast<int>(i));
+            }
+        }
+
+        auto view = std::make_unique<AppView>();
+        view->Window = window;
+        m_Views.push_back(std::move(view));
     }
+    startup.EndPhase("window");
 
     // We create a descriptor.
     WGPUInstanceDescriptor desc;
     desc.nextInChain = nullptr;
 
     // We create the instance using this descriptor.
-    WGPUInstance instance = wgpuCreateInstance(&desc);
+    m_Instance.Reset(wgpuCreateInstance(&desc));
 
     // We check whether there is actually an instance created.
-    if (!instance) {
+    if (!m_Instance) {
         std::cerr << "Could not initialize WebGPU!\n";
+        finishMeshLoads();
         return false;
     }
 
     // Display the object (WGPUInstance is a simple pointer, it may be
     // copied around without worrying about its size).
-    std::cout << "WGPU instance: " << instance << '\n';
+    std::cout << "WGPU instance: " << m_Instance.Get() << '\n';
+    m_Events.Initialize(m_Instance);
+    startup.EndPhase("instance");
+
+    // Only the part of the parsing that did not overlap is measured.
+    if (!finishMeshLoads()) {
+        return false;
+    }
+    m_MaxDraws = GetMaxDrawCount();
+    startup.EndPhase("geometry parse");
 
     std::cout << "Requesting adapter...\n";
-    m_Surface = glfwGetWGPUSurface(instance, m_Window);
+    for (const auto &view : m_Views) {
+        view->Surface.Reset(glfwGetWGPUSurface(m_Instance, view->Window));
+    }
 
-    WGPURequestAdapterOptions adapterOpts = {};
-    adapterOpts.nextInChain = nullptr;
-    adapterOpts.compatibleSurface = m_Surface;
+    // Only adapters that can present to the primary window and give the
+    // device the limits it is requested with are considered.
+    AdapterSelection adapterSelection;
+    adapterSelection.Preference = m_Options.Adapter;
+    adapterSelection.Backend = m_Options.Backend;
+    adapterSelection.CompatibleSurface = m_Views.front()->Surface;
+    adapterSelection.RequiredLimits = [this](WGPUAdapter adapter) { return GetRequiredLimits(adapter).limits; };
 
-    WGPUAdapter adapter = RequestAdapterSync(instance, &adapterOpts);
+    m_Adapter = SelectAdapter(m_Instance, adapterSelection);
+    if (!m_Adapter) {
+        return false;
+    }
 
-    std::cout << "Got adapter: " << adapter << '\n';
+    std::cout << "Got adapter: " << m_Adapter.Get() << '\n';
+    startup.EndPhase("adapter");
 
     // We display informations about the adapter.
-    InspectAdapter(adapter);
+    if (m_Options.Inspect) {
+        InspectAdapter(m_Adapter);
+        startup.EndPhase("inspect adapter");
+    }
 
     std::cout << "Requesting device..." << '\n';
 
     WGPUDeviceDescriptor deviceDesc = {};
     deviceDesc.nextInChain = nullptr;
     deviceDesc.label = "WebGPU Device";
-    deviceDesc.requiredFeatureCount = 0;
-    deviceDesc.requiredFeatures = nullptr;
+    // The overdraw scene counts shader invocations when the adapter can.
+    std::vector<WGPUFeatureName> requiredFeatures;
+    if (m_Options.Scene == SceneType_Overdraw && wgpuAdapterHasFeature(m_Adapter, static_cast<WGPUFeatureName>(WGPUNativeFeature_PipelineStatisticsQuery))) {
+        requiredFeatures.push_back(static_cast<WGPUFeatureName>(WGPUNativeFeature_PipelineStatisticsQuery));
+    }
+    // The draw list records each page of draws with one indirect call when
+    // the adapter can, see DrawList.
+    const auto multiDrawIndirect = static_cast<WGPUFeatureName>(WGPUNativeFeature_MultiDrawIndirect);
+    if (wgpuAdapterHasFeature(m_Adapter, multiDrawIndirect) && wgpuAdapterHasFeature(m_Adapter, WGPUFeatureName_IndirectFirstInstance)) {
+        requiredFeatures.push_back(multiDrawIndirect);
+        requiredFeatures.push_back(WGPUFeatureName_IndirectFirstInstance);
+    }
+    // Dynamic resolution is driven by timestamp queries.
+    if (m_Options.DynamicResolutionTarget > 0.0 && wgpuAdapterHasFeature(m_Adapter, WGPUFeatureName_TimestampQuery)) {
+        requiredFeatures.push_back(WGPUFeatureName_TimestampQuery);
+    }
+    deviceDesc.requiredFeatureCount = requiredFeatures.size();
+    deviceDesc.requiredFeatures = requiredFeatures.data();
 
-    WGPURequiredLimits requiredLimits = GetRequiredLimits(adapter);
+    WGPURequiredLimits requiredLimits = GetRequiredLimits(m_Adapter);
     deviceDesc.requiredLimits = &requiredLimits;
     
     deviceDesc.defaultQueue.nextInChain = nullptr;
@@ -83,80 +221,520 @@ bool Application::Initialize() {
         std::cout << '\n';
     };
 
-    m_Device = RequestDeviceSync(adapter, &deviceDesc);
+    m_Device.Reset(m_Events.Run(RequestDeviceAsync(m_Events, m_Adapter, &deviceDesc)));
+    if (m_Device) {
+        m_Events.AddDevice(m_Device);
+    }
 
-    std::cout << "Got device: " << m_Device << '\n';
+    std::cout << "Got device: " << m_Device.Get() << '\n';
 
     auto onDeviceError = [](WGPUErrorType type, char const *message, void */* pUserData */) {
         std::cout << "Uncaptured device error: type " << type;
         if (message) std::cout << " (" << message << ")";
         std::cout << '\n';
     };
-    wgpuDeviceSetUncapturedErrorCallback(m_Device, onDeviceError, nullptr /* pUserData */),
+    wgpuDeviceSetUncapturedErrorCallback(m_Device, onDeviceError, nullptr /* pUserData */);
+    startup.EndPhase("device");
 
-    InspectDevice(m_Device);
+    if (m_Options.Inspect) {
+        InspectDevice(m_Device);
+        startup.EndPhase("inspect device");
+    }
 
-    m_Queue = wgpuDeviceGetQueue(m_Device);
+    m_Queue.Reset(wgpuDeviceGetQueue(m_Device));
 
-    WGPUSurfaceConfiguration config;
-    config.nextInChain = nullptr;
+    m_MemoryTracker.SetBudget(m_Options.MemoryBudget);
 
-    config.width = 640;
-    config.height = 480;
+    // Let the CPU prepare the next frame while the GPU renders the current
+    // one, but never more than that.
+    if (!m_FrameController.Initialize(m_Device, m_Queue, m_Events, m_MemoryTracker, FramesInFlight, DrawList::GetFrameBytes(m_MaxDraws))) {
+        return false;
+    }
 
-    m_SurfaceFormat = wgpuSurfaceGetPreferredFormat(m_Surface, adapter);
-    config.format = m_SurfaceFormat;
+    if (!m_DrawList.Initialize(m_Device, m_FrameController, m_MaxDraws)) {
+        return false;
+    }
 
-    config.viewFormatCount = 0;
-    config.viewFormats = nullptr;
+    if (!m_Readback.Initialize(m_Device, m_Events, m_MemoryTracker)) {
+        return false;
+    }
 
-    config.usage = WGPUTextureUsage_RenderAttachment;
+    if (m_Options.Scene == SceneType_Overdraw && !m_PipelineStatistics.Initialize(m_Device, m_MemoryTracker, m_Readback)) {
+        std::cout << "Pipeline statistics queries are not supported, fragments will not be counted.\n";
+    }
+    startup.EndPhase("frame resources");
 
-    config.device = m_Device;
+    m_SurfaceFormat = wgpuSurfaceGetPreferredFormat(m_Views.front()->Surface, m_Adapter);
+    for (const auto &view : m_Views) {
+        if (!InitializeView(*view)) {
+            return false;
+        }
+    }
 
-    config.presentMode = WGPUPresentMode_Fifo;
+    std::cout << "Surface format: " << magic_enum::enum_name<WGPUTextureFormat>(m_SurfaceFormat) << '\n';
+    startup.EndPhase("surface configure");
+
+    m_Culler.SetThreadPool(&m_Workers);
+    m_Transforms.SetThreadPool(&m_Workers);
+    m_ShaderCache.Initialize(m_Device);
+    m_PipelineCache.Initialize(m_Device, m_ShaderCache, m_Workers, m_Events);
+    // A pipeline that becomes ready is a reason to redraw in on-demand mode.
+    m_PipelineCache.SetReadyCallback([this](PipelineKey) {
+        RequestRedraw(RedrawReason_Resource);
+        glfwPostEmptyEvent();
+    });
+
+    m_Samplers.Initialize(m_Device);
+    startup.EndPhase("workers and caches");
+
+    // Decoding starts before the textured pipeline is requested, both run
+    // in the background.
+    if (!m_Options.TexturePath.empty()) {
+        if (!InitializeTextures()) {
+            return false;
+        }
+        startup.EndPhase("texture load");
+    }
 
-    config.alphaMode = WGPUCompositeAlphaMode_Auto;
+    // Compilation runs in the background while we load and upload the
+    // geometry: this only loads the shader sources and queues the
+    // pipelines, the compile times are reported as background time.
+    if (!InitializePipeline()) {
+        return false;
+    }
+    startup.EndPhase("shader load and pipeline requests");
 
-    wgpuSurfaceConfigure(m_Surface, &config);
+    if (m_Options.DynamicResolutionTarget > 0.0) {
+        if (!InitializeDynamicResolution()) {
+            return false;
+        }
+        startup.EndPhase("dynamic resolution");
+    }
 
-    std::cout << "Surface format: " << magic_enum::enum_name<WGPUTextureFormat>(m_SurfaceFormat) << '\n';
+    if (!InitializeBuffers()) {
+        return false;
+    }
+    startup.EndPhase("geometry upload");
+
+    BuildScene();
+    startup.EndPhase("scene");
 
-    InitializePipeline();
+    // Batch mode renders from the main thread, the window is never shown.
+    if (!m_Options.BatchPath.empty()) {
+        return true;
+    }
 
-    InitializeBuffers();
+    // From now on every GPU call happens on the render thread. It wakes the
+    // main thread up whenever it frees a slot in the packet queue.
+    m_RenderThread.Start(
+        [this](const FramePacket &packet) { RenderFrame(packet); },
+        [this] {
+            if (m_WaitingForRenderThread.load()) {
+                glfwPostEmptyEvent();
+            }
+        }
+    );
+    startup.EndPhase("render thread");
+
+    // The first frame is always drawn.
+    m_RedrawTracker.MarkDirty(RedrawReason_Resource);
+    m_ScreenshotPending = m_Options.ScreenshotFirstFrame;
 
     return true;
 }
 
-void Application::Terminate() const {
-    wgpuBufferRelease(m_VertexBuffer);
-    wgpuRenderPipelineRelease(m_Pipeline);
-    wgpuSurfaceUnconfigure(m_Surface);
-    wgpuQueueRelease(m_Queue);
-    wgpuSurfaceRelease(m_Surface);
-    wgpuDeviceRelease(m_Device);
-    glfwDestroyWindow(m_Window);
+bool Application::InitializeView(AppView &view) {
+    // The pipelines are compiled for the format of the primary surface, the
+    // other surfaces must support it too.
+    if (&view != m_Views.front().get()) {
+        WGPUSurfaceCapabilities capabilities = {};
+        capabilities.nextInChain = nullptr;
+        wgpuSurfaceGetCapabilities(view.Surface, m_Adapter, &capabilities);
+        const bool supported = std::find(capabilities.formats, capabilities.formats + capabilities.formatCount, m_SurfaceFormat) != capabilities.formats + capabilities.formatCount;
+        wgpuSurfaceCapabilitiesFreeMembers(capabilities);
+        if (!supported) {
+            std::cerr << "A window cannot be presented to with the format of the first one!\n";
+            return false;
+        }
+    }
+
+    int width, height;
+    glfwGetFramebufferSize(view.Window, &width, &height);
+    view.FramebufferWidth = width;
+    view.FramebufferHeight = height;
+    view.Presenter.Initialize(m_Device, view.Surface, m_SurfaceFormat, width, height, WGPUPresentMode_Fifo);
+
+    // The depth buffer follows the size of the surface. The callback runs on
+    // the render thread, right before the new size is first rendered to.
+    if (m_Options.Depth) {
+        if (!CreateDepthBuffer(view, view.Presenter.GetWidth(), view.Presenter.GetHeight())) {
+            return false;
+        }
+        view.Presenter.AddResizeCallback([this, &view](uint32_t newWidth, uint32_t newHeight) {
+            CreateDepthBuffer(view, newWidth, newHeight);
+        });
+    }
+
+    // The surface follows the size of the window. The new size travels to
+    // the render thread with the next frame packet, where the surface
+    // manager takes care of reconfiguring once the resize is over.
+    glfwSetWindowUserPointer(view.Window, this);
+    glfwSetFramebufferSizeCallback(view.Window, [](GLFWwindow *window, int newWidth, int newHeight) {
+        auto *app = static_cast<Application *>(glfwGetWindowUserPointer(window));
+        AppView *resized = app->FindView(window);
+        resized->FramebufferWidth = newWidth;
+        resized->FramebufferHeight = newHeight;
+        app->RequestRedraw(RedrawReason_Resize);
+    });
+
+    // Closing a secondary window only hides it, and a size of 0 makes the
+    // render thread skip it from then on.
+    if (&view != m_Views.front().get()) {
+        glfwSetWindowCloseCallback(view.Window, [](GLFWwindow *window) {
+            auto *app = static_cast<Application *>(glfwGetWindowUserPointer(window));
+            AppView *closed = app->FindView(window);
+            glfwSetWindowShouldClose(window, GLFW_FALSE);
+            glfwHideWindow(window);
+            closed->FramebufferWidth = 0;
+            closed->FramebufferHeight = 0;
+            app->RequestRedraw(RedrawReason_Resize);
+        });
+    }
+    InstallInputCallbacks(view.Window);
+
+    return true;
+}
+
+AppView *Application::FindView(GLFWwindow *window) {
+    for (const auto &view : m_Views) {
+        if (view->Window == window) {
+            return view.get();
+        }
+    }
+    return nullptr;
+}
+
+void Application::Terminate() {
+    // Let the render thread finish the frames it was given, then nothing may
+    // be released while the GPU still uses it.
+    m_RenderThread.Stop();
+    m_FrameController.Terminate();
+
+    PrintRenderThreadStats(m_RenderThread.GetStats());
+    PrintEventPumpStats(m_Events.GetStats());
+    for (const auto &view : m_Views) {
+        PrintSurfaceStats(view->Presenter.GetStats());
+    }
+    PrintFrameStats(m_FrameController.GetStats());
+    if (m_Options.OnDemand) {
+        PrintRedrawStats(m_RedrawTracker.GetStats());
+    }
+
+    PrintReadbackStats(m_Readback.GetStats());
+    if (m_Texture != InvalidTextureId) {
+        PrintTextureStats(m_Textures.GetStats(), m_Samplers.GetStats());
+    }
+    PrintTransformStats(m_Transforms.GetStats());
+    PrintCullingStats(m_Culler.GetStats(), m_Culler.GetKernel());
+    if (m_PipelineStatistics.IsAvailable()) {
+        PrintPipelineStatistics(m_PipelineStatistics.GetStats(), uint64_t{ m_Views.front()->Presenter.GetWidth() } * m_Views.front()->Presenter.GetHeight());
+    }
+    if (m_GpuTimer.IsAvailable()) {
+        PrintGpuTimerStats(m_GpuTimer.GetStats());
+        PrintDynamicResolutionStats(m_DynamicResolution.GetStats(), m_DynamicResolution.GetSettings());
+    }
+
+    m_GpuTimer.Terminate();
+    m_BlitBindGroup.Reset();
+    m_SceneView.Reset();
+    m_MemoryTracker.Release(m_SceneTexture);
+    m_MemoryTracker.Release(m_BlitParams);
+    m_TextureBindGroup.Reset();
+    m_Textures.Terminate();
+    m_Samplers.Terminate();
+    m_PipelineStatistics.Terminate();
+    m_Readback.Terminate();
+    m_DrawList.Terminate();
+    PrintMeshRegistryStats(m_Meshes.GetStats());
+    m_Meshes.Terminate();
+    for (const auto &view : m_Views) {
+        view->DepthView.Reset();
+        m_MemoryTracker.Release(view->DepthTexture);
+    }
+    m_GeometryPool.Terminate();
+    PrintGpuMemoryStats(m_MemoryTracker.GetStats());
+    PrintPipelineCacheStats(m_PipelineCache.GetStats(), m_ShaderCache.GetStats());
+    m_Startup->RecordBackground("shader compilation", m_ShaderCache.GetStats().CompileSeconds);
+    m_Startup->RecordBackground("pipeline compilation", m_PipelineCache.GetStats().CompileSeconds);
+    PrintStartupReport(*m_Startup);
+
+    m_PipelineCache.Terminate();
+    m_PipelineLayout.Reset();
+    m_BlitPipelineLayout.Reset();
+    m_BlitBindGroupLayout.Reset();
+    m_TexturedPipelineLayout.Reset();
+    m_TextureBindGroupLayout.Reset();
+    m_ShaderCache.Terminate();
+    m_Workers.Stop();
+    for (const auto &view : m_Views) {
+        view->Presenter.Terminate();
+    }
+    m_Queue.Reset();
+    for (const auto &view : m_Views) {
+        view->Surface.Reset();
+    }
+    if (m_Device) {
+        m_Events.RemoveDevice(m_Device);
+    }
+    m_Device.Reset();
+    m_Adapter.Reset();
+    m_Instance.Reset();
+    for (const auto &view : m_Views) {
+        glfwDestroyWindow(view->Window);
+    }
+    m_Views.clear();
     glfwTerminate();
 }
 
-void Application::MainLoop() const {
-    glfwPollEvents();
+void Application::MainLoop() {
+    if (m_Options.OnDemand) {
+        // Sleep until something happens, unless a redraw is already pending.
+        const double timeout = m_RedrawTracker.GetWaitTimeout();
+        if (timeout > 0.0) {
+            const double start = glfwGetTime();
+            glfwWaitEventsTimeout(timeout);
+            m_RedrawTracker.RecordIdle(glfwGetTime() - start);
+        } else {
+            glfwPollEvents();
+        }
+
+        if (m_RedrawTracker.ConsumeReasons() == RedrawReason_None) {
+            return;
+        }
+    } else {
+        glfwPollEvents();
+    }
+
+    FramePacket packet;
+    packet.FrameNumber = m_FrameNumber++;
+    packet.Time = glfwGetTime();
+    FillViewPackets(packet);
+    packet.Screenshot = std::exchange(m_ScreenshotRequested, false);
+
+    // If the render thread is already a full queue behind, keep handling
+    // events while we wait for it rather than blocking.
+    while (!m_RenderThread.TrySubmit(packet)) {
+        m_WaitingForRenderThread = true;
+        // The render thread may have made room before it saw the flag. The
+        // fence keeps the retry from reading the queue before the flag is
+        // stored, see RenderThread::Start().
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_RenderThread.TrySubmit(packet)) {
+            m_WaitingForRenderThread = false;
+            break;
+        }
+        glfwWaitEvents();
+        m_WaitingForRenderThread = false;
+        FillViewPackets(packet);
+        if (!IsRunning()) {
+            return;
+        }
+    }
+}
+
+void Application::RequestRedraw(RedrawReason reason) {
+    m_RedrawTracker.MarkDirty(reason);
+}
+
+void Application::FillViewPackets(FramePacket &packet) const {
+    packet.ViewCount = static_cast<uint32_t>(m_Views.size());
+    for (size_t i = 0; i < m_Views.size(); ++i) {
+        packet.Views[i].FramebufferWidth = m_Views[i]->FramebufferWidth;
+        packet.Views[i].FramebufferHeight = m_Views[i]->FramebufferHeight;
+    }
+}
+
+void Application::InstallInputCallbacks(GLFWwindow *window) {
+    // In on-demand mode, keys, clicks and scrolling redraw. Nothing on
+    // screen follows the cursor, so moving it does not.
+    glfwSetKeyCallback(window, [](GLFWwindow *window, int key, int, int action, int) {
+        auto *app = static_cast<Application *>(glfwGetWindowUserPointer(window));
+        if (key == GLFW_KEY_F12 && action == GLFW_PRESS) {
+            app->m_ScreenshotRequested = true;
+        }
+        app->RequestRedraw(RedrawReason_Input);
+    });
+    glfwSetMouseButtonCallback(window, [](GLFWwindow *window, int, int, int) {
+        static_cast<Application *>(glfwGetWindowUserPointer(window))->RequestRedraw(RedrawReason_Input);
+    });
+    glfwSetScrollCallback(window, [](GLFWwindow *window, double, double) {
+        static_cast<Application *>(glfwGetWindowUserPointer(window))->RequestRedraw(RedrawReason_Input);
+    });
+    // The window system lost the window contents (e.g. it was uncovered).
+    glfwSetWindowRefreshCallback(window, [](GLFWwindow *window) {
+        static_cast<Application *>(glfwGetWindowUserPointer(window))->RequestRedraw(RedrawReason_Expose);
+    });
+}
 
-    WGPUTextureView targetView = GetNextSurfaceTextureView();
-    if (!targetView) return;
+void Application::RenderFrame(const FramePacket &packet) {
+    // Polling fires the frame controller's callbacks too, so the pump
+    // belongs to the render thread once it runs.
+    m_Events.Pump();
+
+    for (uint32_t i = 0; i < packet.ViewCount; ++i) {
+        m_Views[i]->Presenter.Resize(packet.Views[i].FramebufferWidth, packet.Views[i].FramebufferHeight);
+    }
+
+    // Blocks only if the GPU is more than FramesInFlight frames behind.
+    m_FrameController.BeginFrame();
+    // Hand the statistics, timings and screenshots that arrived since the
+    // last frame to their owners.
+    m_Readback.Collect();
+    double gpuSeconds = 0.0;
+    if (m_GpuTimer.Collect(gpuSeconds)) {
+        m_DynamicResolution.AddSample(gpuSeconds);
+    }
+
+    // Views with nothing to render to this frame (minimized or hidden
+    // window, acquire timeout...) are skipped, the others are all drawn.
+    std::array<SurfaceFrame, MaxFrameViews> frames;
+    bool acquiredAny = false;
+    bool retry = false;
+    for (size_t i = 0; i < m_Views.size(); ++i) {
+        const bool acquired = m_Views[i]->Presenter.AcquireNextFrame(frames[i]);
+        acquiredAny |= acquired;
+        retry |= !acquired && m_Views[i]->Presenter.IsConfigured();
+    }
+    // Unless the window is minimized, try again on the next loop so that
+    // on-demand mode does not leave a stale frame on screen.
+    if (retry && m_Options.OnDemand) {
+        RequestRedraw(RedrawReason_Expose);
+        glfwPostEmptyEvent();
+    }
+    if (!acquiredAny) {
+        return;
+    }
 
     WGPUCommandEncoderDescriptor encoderDesc;
     encoderDesc.nextInChain = nullptr;
     encoderDesc.label = "Command encoder";
-    WGPUCommandEncoder encoder = wgpuDeviceCreateCommandEncoder(m_Device,  &encoderDesc);
+    CommandEncoderHandle encoder(wgpuDeviceCreateCommandEncoder(m_Device, &encoderDesc));
+
+    UpdateTextures(encoder);
+
+    // The pipeline may still be compiling, in which case this frame only
+    // shows the clear color. Until the texture and its pipeline are ready,
+    // objects are drawn untextured.
+    WGPURenderPipeline pipeline = m_PipelineCache.Get(m_PipelineKey);
+    const WGPURenderPipeline texturedPipeline = m_TextureBindGroup ? m_PipelineCache.Get(m_TexturedPipelineKey) : nullptr;
+    if (texturedPipeline) {
+        pipeline = texturedPipeline;
+    }
+    if (pipeline) {
+        // Only the nodes that moved since the last frame, and their
+        // children, get new world matrices and bounding spheres.
+        if (m_Transforms.Update() > 0) {
+            UpdateCullingSpheres();
+        }
+
+        // The shader maps the scene to clip space with this (column-major)
+        // matrix, so it also gives the frustum. Every view shows the scene
+        // the same way, it is culled once for all of them.
+        const float viewProjection[16] = {
+            1.0f, 0.0f, 0.0f, 0.0f,
+            0.0f, SceneAspectRatio, 0.0f, 0.0f,
+            0.0f, 0.0f, 1.0f, 0.0f,
+            0.0f, 0.0f, 0.0f, 1.0f,
+        };
+        m_Culler.Cull(MakeFrustum(viewProjection), m_VisibleDraws);
+
+        m_DrawList.Clear();
+        for (uint32_t index : m_VisibleDraws) {
+            DrawData draw;
+            draw.Transform = m_Transforms.GetWorld(m_SceneNodes[index]);
+            for (GeometryHandle part : m_Meshes.Get(m_SceneMeshes[index]).Parts) {
+                m_DrawList.Add(part, draw);
+            }
+        }
+        // Sorting only pays off when the depth test can reject the hidden
+        // fragments of the draws that come later.
+        if (m_Options.Depth && m_Options.SortDraws) {
+            m_DrawList.SortFrontToBack();
+        }
+        // Uploaded once, then recorded into the pass of every view.
+        m_DrawList.Upload(m_GeometryPool);
+    }
+
+    for (size_t i = 0; i < m_Views.size(); ++i) {
+        if (frames[i].View) {
+            EncodeView(encoder, *m_Views[i], frames[i], pipeline, texturedPipeline != nullptr);
+        }
+    }
+
+    m_PipelineStatistics.Resolve(encoder);
+    m_GpuTimer.Resolve(encoder);
+
+    // Screenshots are only taken of complete frames of the primary view.
+    // When the readback ring is full, we try again with the next one.
+    m_ScreenshotPending |= packet.Screenshot;
+    if (m_ScreenshotPending && pipeline && frames[0].View && CaptureScreenshot(encoder, frames[0])) {
+        m_ScreenshotPending = false;
+    }
+
+    WGPUCommandBufferDescriptor commandBufferDesc;
+    commandBufferDesc.nextInChain = nullptr;
+    commandBufferDesc.label = "Command buffer";
+    CommandBufferHandle command(wgpuCommandEncoderFinish(encoder, &commandBufferDesc));
+    encoder.Reset();
+
+    // A single submission for all the views.
+    m_FrameController.Submit(command);
+    command.Reset();
+    m_Readback.OnSubmitted();
+    m_MemoryTracker.EndFrame();
+
+    bool resizePending = false;
+    for (size_t i = 0; i < m_Views.size(); ++i) {
+        if (frames[i].View) {
+            m_Views[i]->Presenter.Present(frames[i]);
+        }
+        resizePending |= m_Views[i]->Presenter.HasPendingResize();
+    }
+
+    m_Startup->MarkMilestone("first frame");
+    if (pipeline) {
+        m_Startup->MarkMilestone("first complete frame");
+    }
+
+    // The frame was drawn at the old size while a resize is being debounced,
+    // come back for it once the size has settled.
+    if (resizePending && m_Options.OnDemand) {
+        RequestRedraw(RedrawReason_Resize);
+        glfwPostEmptyEvent();
+    }
+}
+
+void Application::EncodeView(WGPUCommandEncoder encoder, AppView &view, const SurfaceFrame &frame, WGPURenderPipeline pipeline, bool textured) {
+    const bool primary = &view == m_Views.front().get();
 
     WGPURenderPassDescriptor renderPassDesc = {};
     renderPassDesc.nextInChain = nullptr;
 
     WGPURenderPassColorAttachment renderPassColorAttachment = {};
 
-    renderPassColorAttachment.view = targetView;
+    // Until the blit pipeline is ready, the scene goes straight to the
+    // surface at full resolution.
+    const WGPURenderPipeline blitPipeline = primary && m_SceneView ? m_PipelineCache.Get(m_BlitPipelineKey) : nullptr;
+    uint32_t renderWidth = frame.Width;
+    uint32_t renderHeight = frame.Height;
+    if (blitPipeline) {
+        m_DynamicResolution.GetRenderSize(frame.Width, frame.Height, renderWidth, renderHeight);
+    }
+    if (primary) {
+        m_GpuTimer.BeginFrame();
+    }
+
+    renderPassColorAttachment.view = blitPipeline ? m_SceneView.Get() : frame.View.Get();
 
     renderPassColorAttachment.resolveTarget = nullptr;
 
@@ -167,200 +745,679 @@ void Application::MainLoop() const {
     renderPassDesc.colorAttachmentCount = 1;
     renderPassDesc.colorAttachments = &renderPassColorAttachment;
 
-    renderPassDesc.depthStencilAttachment = nullptr;
-    renderPassDesc.timestampWrites = nullptr;
+    WGPURenderPassDepthStencilAttachment depthStencilAttachment = {};
+    if (view.DepthView) {
+        depthStencilAttachment.view = view.DepthView;
+        // Everything starts as far as possible.
+        depthStencilAttachment.depthClearValue = 1.0f;
+        depthStencilAttachment.depthLoadOp = WGPULoadOp_Clear;
+        // The depth buffer is not needed once the frame is rendered.
+        depthStencilAttachment.depthStoreOp = WGPUStoreOp_Discard;
+        depthStencilAttachment.depthReadOnly = false;
+        // The depth format has no stencil aspect.
+        depthStencilAttachment.stencilClearValue = 0;
+        depthStencilAttachment.stencilLoadOp = WGPULoadOp_Undefined;
+        depthStencilAttachment.stencilStoreOp = WGPUStoreOp_Undefined;
+        depthStencilAttachment.stencilReadOnly = true;
+        renderPassDesc.depthStencilAttachment = &depthStencilAttachment;
+    } else {
+        renderPassDesc.depthStencilAttachment = nullptr;
+    }
+    if (primary) {
+        renderPassDesc.timestampWrites = blitPipeline ? m_GpuTimer.GetBeginWrites() : m_GpuTimer.GetPassWrites();
+    }
 
-    WGPURenderPassEncoder renderPass = wgpuCommandEncoderBeginRenderPass(encoder, &renderPassDesc);
+    RenderPassEncoderHandle renderPass(wgpuCommandEncoderBeginRenderPass(encoder, &renderPassDesc));
+    if (primary) {
+        m_PipelineStatistics.BeginPass(renderPass);
+    }
 
-    // Select which render pipeline to use.
-    wgpuRenderPassEncoderSetPipeline(renderPass, m_Pipeline);
+    // Only the top left part of the offscreen target is rendered to.
+    if (blitPipeline) {
+        wgpuRenderPassEncoderSetViewport(renderPass, 0.0f, 0.0f, static_cast<float>(renderWidth), static_cast<float>(renderHeight), 0.0f, 1.0f);
+        wgpuRenderPassEncoderSetScissorRect(renderPass, 0, 0, renderWidth, renderHeight);
+    }
 
-    // Set vertex buffer while encoding the render pass.
-    wgpuRenderPassEncoderSetVertexBuffer(renderPass, 0, m_VertexBuffer, 0, wgpuBufferGetSize(m_VertexBuffer));
-    // The second argument must correspond to the choice of uint16_t or uint32_t
-    // we've done when creating the index buffer.
-    wgpuRenderPassEncoderSetIndexBuffer(renderPass, m_IndexBuffer, WGPUIndexFormat_Uint16, 0, m_IndexCount * sizeof(uint16_t));
-    
-    wgpuRenderPassEncoderDrawIndexed(renderPass, m_IndexCount, 1, 0, 0, 0);
+    if (pipeline) {
+        // Select which render pipeline to use.
+        wgpuRenderPassEncoderSetPipeline(renderPass, pipeline);
+        if (textured) {
+            wgpuRenderPassEncoderSetBindGroup(renderPass, 1, m_TextureBindGroup, 0, nullptr);
+        }
+        // The draw list binds the pooled vertex and index buffers, every mesh
+        // is then drawn from its own baseVertex/firstIndex range.
+        m_DrawList.Record(renderPass, m_GeometryPool);
+    }
 
+    if (primary) {
+        m_PipelineStatistics.EndPass(renderPass);
+    }
     wgpuRenderPassEncoderEnd(renderPass);
-    wgpuRenderPassEncoderRelease(renderPass);
+    renderPass.Reset();
+
+    if (blitPipeline) {
+        if (renderWidth != m_BlitWidth || renderHeight != m_BlitHeight) {
+            const float renderSize[2] = { static_cast<float>(renderWidth), static_cast<float>(renderHeight) };
+            wgpuQueueWriteBuffer(m_Queue, m_BlitParams, 0, renderSize, sizeof(renderSize));
+            m_BlitWidth = renderWidth;
+            m_BlitHeight = renderHeight;
+        }
+
+        WGPURenderPassColorAttachment blitAttachment = {};
+        blitAttachment.view = frame.View;
+        blitAttachment.resolveTarget = nullptr;
+        // Every pixel is overwritten.
+        blitAttachment.loadOp = WGPULoadOp_Clear;
+        blitAttachment.storeOp = WGPUStoreOp_Store;
+        blitAttachment.clearValue = WGPUColor{ 0.0, 0.0, 0.0, 1.0 };
+
+        WGPURenderPassDescriptor blitPassDesc = {};
+        blitPassDesc.nextInChain = nullptr;
+        blitPassDesc.label = "Upscale pass";
+        blitPassDesc.colorAttachmentCount = 1;
+        blitPassDesc.colorAttachments = &blitAttachment;
+        blitPassDesc.depthStencilAttachment = nullptr;
+        blitPassDesc.timestampWrites = m_GpuTimer.GetEndWrites();
+
+        RenderPassEncoderHandle blitPass(wgpuCommandEncoderBeginRenderPass(encoder, &blitPassDesc));
+        wgpuRenderPassEncoderSetPipeline(blitPass, blitPipeline);
+        wgpuRenderPassEncoderSetBindGroup(blitPass, 0, m_BlitBindGroup, 0, nullptr);
+        wgpuRenderPassEncoderDraw(blitPass, 3, 1, 0, 0);
+        wgpuRenderPassEncoderEnd(blitPass);
+    }
+}
 
-    WGPUCommandBufferDescriptor commandBufferDesc;
-    commandBufferDesc.nextInChain = nullptr;
-    commandBufferDesc.label = "Command buffer";
-    WGPUCommandBuffer command = wgpuCommandEncoderFinish(encoder, &commandBufferDesc);
-    wgpuCommandEncoderRelease(encoder);
+bool Application::IsRunning() const {
+    return !glfwWindowShouldClose(m_Views.front()->Window);
+}
 
-    wgpuQueueSubmit(m_Queue, 1, &command);
-    wgpuCommandBufferRelease(command);
+Task<bool> Application::LoadMeshAsync(LoadedMesh &mesh) {
+    const bool loaded = co_await WorkerRequest<bool>(m_Events, m_Workers, [&mesh] {
+        return LoadGeometry(mesh.Path, mesh.PointData, mesh.IndexData);
+    });
+    if (!loaded) {
+        std::cerr << "Could not load geometry from " << mesh.Path << "!\n";
+    }
+    co_return loaded;
+}
 
-    wgpuTextureViewRelease(targetView);
-    wgpuSurfacePresent(m_Surface);
+bool Application::InitializePipeline() {
+    // Bind group 0 holds the per-draw data.
+    WGPUBindGroupLayout bindGroupLayout = m_DrawList.GetBindGroupLayout();
+    WGPUPipelineLayoutDescriptor layoutDesc = {};
+    layoutDesc.nextInChain = nullptr;
+    layoutDesc.label = "Pipeline layout";
+    layoutDesc.bindGroupLayoutCount = 1;
+    layoutDesc.bindGroupLayouts = &bindGroupLayout;
+    m_PipelineLayout.Reset(wgpuDeviceCreatePipelineLayout(m_Device, &layoutDesc));
+
+    RenderPipelineState state = GetScenePipelineState(m_SurfaceFormat, m_Options.Depth ? DepthFormat : WGPUTextureFormat_Undefined, m_PipelineLayout);
+
+    std::cout << "Requesting render pipeline...\n";
+    m_PipelineKey = m_PipelineCache.Request(state);
+    if (m_PipelineKey == InvalidPipelineKey) {
+        return false;
+    }
 
-    wgpuDevicePoll(m_Device, false, nullptr);
-}
+    // The textured permutation of the shader only differs by its layout,
+    // where bind group 1 holds the texture.
+    if (m_TextureBindGroupLayout) {
+        const WGPUBindGroupLayout bindGroupLayouts[2] = { bindGroupLayout, m_TextureBindGroupLayout };
+        layoutDesc.label = "Textured pipeline layout";
+        layoutDesc.bindGroupLayoutCount = 2;
+        layoutDesc.bindGroupLayouts = bindGroupLayouts;
+        m_TexturedPipelineLayout.Reset(wgpuDeviceCreatePipelineLayout(m_Device, &layoutDesc));
+
+        state.Defines["TEXTURED"] = "";
+        state.Layout = m_TexturedPipelineLayout;
+        m_TexturedPipelineKey = m_PipelineCache.Request(state);
+        if (m_TexturedPipelineKey == InvalidPipelineKey) {
+            return false;
+        }
+    }
 
-bool Application::IsRunning() const {
-    return !glfwWindowShouldClose(m_Window);
+    return true;
 }
 
-WGPUTextureView Application::GetNextSurfaceTextureView() const {
-    WGPUSurfaceTexture surfaceTexture;
-    wgpuSurfaceGetCurrentTexture(m_Surface, &surfaceTexture);
+bool Application::InitializeBuffers() {
+    // Pages hold the whole geometry when the device allows buffers that
+    // large, and a part of it otherwise.
+    WGPUSupportedLimits deviceLimits = {};
+    deviceLimits.nextInChain = nullptr;
+    wgpuDeviceGetLimits(m_Device, &deviceLimits);
+    const uint64_t maxBufferSize = deviceLimits.limits.maxBufferSize;
+
+    uint64_t vertexCount = 0, indexCount = 0;
+    GetLoadedGeometrySize(vertexCount, indexCount);
+
+    GeometryPoolDescriptor poolDesc;
+    poolDesc.VertexStride = SceneVertexStride;
+    poolDesc.VertexCapacity = static_cast<uint32_t>(std::min(std::max<uint64_t>(VertexPoolCapacity, vertexCount), maxBufferSize / SceneVertexStride));
+    // Index ranges are padded to an even count.
+    poolDesc.IndexCapacity = static_cast<uint32_t>(std::min(std::max<uint64_t>(IndexPoolCapacity, indexCount), maxBufferSize / sizeof(uint16_t))) & ~1u;
+
+    // Splitting duplicates the vertices shared by several parts, but the
+    // parts of a split mesh never have more vertices than indices in total.
+    uint64_t partVertices = 0;
+    for (const LoadedMesh &mesh : m_LoadedMeshes) {
+        partVertices += std::max<uint64_t>(mesh.PointData.size() * sizeof(float) / SceneVertexStride, mesh.IndexData.size());
+    }
+    // First fit leaves every page but the last at least half full.
+    const uint64_t fullPages = std::max(
+        (partVertices + poolDesc.VertexCapacity - 1) / poolDesc.VertexCapacity,
+        (indexCount + poolDesc.IndexCapacity - 1) / poolDesc.IndexCapacity
+    );
+    poolDesc.MaxPages = static_cast<uint32_t>(2 * fullPages + 1);
+
+    if (!m_GeometryPool.Initialize(m_Device, m_Queue, m_MemoryTracker, poolDesc)) {
+        return false;
+    }
 
-    if (surfaceTexture.status != WGPUSurfaceGetCurrentTextureStatus_Success) {
-        return nullptr;
+    // Parts must also stay within the range of 16-bit indices.
+    MeshSplitLimits splitLimits;
+    splitLimits.MaxVertices = std::min(splitLimits.MaxVertices, poolDesc.VertexCapacity);
+    splitLimits.MaxIndices = poolDesc.IndexCapacity;
+    m_Meshes.Initialize(m_GeometryPool, SceneVertexStride, splitLimits);
+
+    for (const LoadedMesh &loaded : m_LoadedMeshes) {
+        const MeshId id = m_Meshes.Add(loaded.Path, loaded.PointData, loaded.IndexData);
+        if (id == InvalidMeshId) {
+            return false;
+        }
+        const MeshInfo &mesh = m_Meshes.Get(id);
+        if (mesh.Parts.size() > 1) {
+            std::cout << "Split " << mesh.Name << " (" << mesh.VertexCount << " vertices, " << mesh.IndexCount << " indices) into "
+                      << mesh.Parts.size() << " parts\n";
+        }
     }
+    m_LoadedMeshes = {};
 
-    WGPUTextureViewDescriptor viewDescriptor;
-    viewDescriptor.nextInChain = nullptr;
-    viewDescriptor.label= "Surface texture view";
-    viewDescriptor.format = wgpuTextureGetFormat(surfaceTexture.texture);
-    viewDescriptor.dimension = WGPUTextureViewDimension_2D;
-    viewDescriptor.baseMipLevel = 0;
-    viewDescriptor.mipLevelCount = 1;
-    viewDescriptor.baseArrayLayer = 0;
-    viewDescriptor.arrayLayerCount = 1;
-    viewDescriptor.aspect = WGPUTextureAspect_All;
-    WGPUTextureView targetView = wgpuTextureCreateView(surfaceTexture.texture, &viewDescriptor);
+    PrintGeometryPoolStats(m_GeometryPool.GetStats());
 
-    return targetView;
+    return true;
 }
 
-void Application::InitializePipeline() {
-    std::cout << "Creating shader module...\n";
-    WGPUShaderModule shaderModule = LoadShaderModule("Resources/Shaders/basic.wgsl", m_Device);
-    std::cout << "Shader module: " << shaderModule << '\n';
-    
-    WGPURenderPipelineDescriptor pipelineDesc = {};
-    pipelineDesc.nextInChain = nullptr;
+void Application::GetLoadedGeometrySize(uint64_t &vertexCount, uint64_t &indexCount) const {
+    vertexCount = 0;
+    indexCount = 0;
+    for (const LoadedMesh &mesh : m_LoadedMeshes) {
+        vertexCount += mesh.PointData.size() * sizeof(float) / SceneVertexStride;
+        indexCount += mesh.IndexData.size();
+    }
+}
+
+uint32_t Application::GetMaxDrawCount() const {
+    // InitializeBuffers() never splits with smaller limits: every device
+    // allows buffers of DefaultMaxBufferSize, more than the pool capacities.
+    MeshSplitLimits splitLimits;
+    splitLimits.MaxVertices = std::min(splitLimits.MaxVertices, VertexPoolCapacity);
+    splitLimits.MaxIndices = IndexPoolCapacity;
 
-    WGPUVertexBufferLayout vertexBufferLayout{};
+    uint32_t maxParts = 1;
+    for (const LoadedMesh &mesh : m_LoadedMeshes) {
+        maxParts = std::max(maxParts, GetMaxPartCount(mesh.IndexData.size(), splitLimits));
+    }
+    return GetSceneObjectCount(m_Options.Scene, static_cast<uint32_t>(m_LoadedMeshes.size())) * maxParts;
+}
 
-    std::array<WGPUVertexAttribute, 2> vertexAttribs;
+bool Application::InitializeTextures() {
+    if (!m_Textures.Initialize(m_Device, m_Queue, m_ShaderCache, m_MemoryTracker, m_Workers)) {
+        return false;
+    }
+    // A decoded image is a reason to redraw in on-demand mode.
+    m_Textures.SetDecodedCallback([this](TextureId) {
+        RequestRedraw(RedrawReason_Resource);
+        glfwPostEmptyEvent();
+    });
+
+    m_TextureBindGroupLayout = CreateBindGroupLayout(m_Device, "Texture bind group layout", {
+        SampledTextureLayoutEntry(0, WGPUTextureSampleType_Float, WGPUShaderStage_Fragment),
+        SamplerLayoutEntry(1, WGPUSamplerBindingType_Filtering, WGPUShaderStage_Fragment),
+    });
+    if (!m_TextureBindGroupLayout) {
+        std::cerr << "Could not create the texture bind group layout!\n";
+        return false;
+    }
 
-    // == For each attribute, describe its layout, i.e, how to interpret the raw data ==
+    m_Texture = m_Textures.Load(m_Options.TexturePath);
+    return true;
+}
 
-    // Position
-    // Corresponds to @location(...)
-    vertexAttribs[0].shaderLocation = 0;
-    // Means vec2f in the shader.
-    vertexAttribs[0].format = WGPUVertexFormat_Float32x2;
-    // Index of the first element.
-    vertexAttribs[0].offset = 0;
+void Application::UpdateTextures(WGPUCommandEncoder encoder) {
+    if (m_Texture == InvalidTextureId) {
+        return;
+    }
 
-    // Color
-    vertexAttribs[1].shaderLocation = 1;
-    vertexAttribs[1].format = WGPUVertexFormat_Float32x3;
-    vertexAttribs[1].offset = 2 * sizeof(float);
+    m_Textures.Update(encoder);
 
-    vertexBufferLayout.attributeCount = vertexAttribs.size();
-    vertexBufferLayout.attributes = vertexAttribs.data();
+    const WGPUTextureView view = m_Textures.GetView(m_Texture);
+    if (m_TextureBindGroup || !view) {
+        return;
+    }
 
-    // == Common to attributes from the same buffer ==
-    vertexBufferLayout.arrayStride = 5 * sizeof(float);
-    vertexBufferLayout.stepMode = WGPUVertexStepMode_Vertex;
+    // Trilinear filtering, the texture repeats across the objects.
+    SamplerState samplerState;
+    samplerState.AddressModeU = WGPUAddressMode_Repeat;
+    samplerState.AddressModeV = WGPUAddressMode_Repeat;
+    samplerState.MagFilter = WGPUFilterMode_Linear;
+    samplerState.MinFilter = WGPUFilterMode_Linear;
+    samplerState.MipmapFilter = WGPUMipmapFilterMode_Linear;
+
+    m_TextureBindGroup = CreateBindGroup(m_Device, m_TextureBindGroupLayout, "Texture bind group", {
+        TextureBindingEntry(0, view),
+        SamplerBindingEntry(1, m_Samplers.Get(samplerState)),
+    });
+}
 
-    pipelineDesc.vertex.bufferCount = 1;
-    pipelineDesc.vertex.buffers = &vertexBufferLayout;
+void Application::BuildScene() {
+    m_Transforms.Clear();
+    m_SceneNodes.clear();
+    m_SceneMeshes.clear();
 
-    pipelineDesc.vertex.module = shaderModule;
-    pipelineDesc.vertex.entryPoint = "vs_main";
-    pipelineDesc.vertex.constantCount = 0;
-    pipelineDesc.vertex.constants = nullptr;
+    const TransformNode root = m_Transforms.AddNode(InvalidTransformNode);
+    for (const SceneObject &object : BuildSceneObjects(m_Options.Scene, m_Meshes)) {
+        m_SceneNodes.push_back(m_Transforms.AddNode(root, object.Transform));
+        m_SceneMeshes.push_back(object.Mesh);
+    }
+}
 
-    // Each sequence of 3 vertices is considered a triangle.
-    pipelineDesc.primitive.topology = WGPUPrimitiveTopology_TriangleList;
+void Application::UpdateCullingSpheres() {
+    m_Culler.Clear();
+    m_Culler.Reserve(static_cast<uint32_t>(m_SceneNodes.size()));
+    for (size_t i = 0; i < m_SceneNodes.size(); ++i) {
+        // Where the vertex shader puts the mesh's bounding sphere.
+        const Matrix4 &world = m_Transforms.GetWorld(m_SceneNodes[i]);
+        const BoundingSphere &bounds = m_Meshes.Get(m_SceneMeshes[i]).Bounds;
+        BoundingSphere sphere;
+        TransformPoint(world, bounds.Center, sphere.Center);
+        sphere.Radius = bounds.Radius * GetMaxScale(world);
+        m_Culler.Add(sphere);
+    }
+}
 
-    // We'll see later how to specify the order in which vertices should be
-    // connected. When not specified, vertices are considered sequencially.
-    pipelineDesc.primitive.stripIndexFormat = WGPUIndexFormat_Undefined;
+bool Application::CreateDepthBuffer(AppView &view, uint32_t width, uint32_t height) {
+    view.DepthView.Reset();
+    m_MemoryTracker.Release(view.DepthTexture);
 
-    // The face orientation is defined by assuming thate when looking
-    // from the front of the face, its corner vertices are enumerated
-    // in the counter-clockwise (CCW) order.
-    pipelineDesc.primitive.frontFace = WGPUFrontFace_CCW;
+    // Nothing is rendered while the window is minimized.
+    if (width == 0 || height == 0) {
+        return true;
+    }
 
-    // But the face orientation does not matter much because we do not
-    // cull (i.e. "hide") the faces pointing away from us (which is often
-    // used for optimization).
-    pipelineDesc.primitive.cullMode = WGPUCullMode_None;
+    WGPUTextureDescriptor depthTextureDesc = {};
+    depthTextureDesc.nextInChain = nullptr;
+    depthTextureDesc.label = "Depth texture";
+    depthTextureDesc.dimension = WGPUTextureDimension_2D;
+    depthTextureDesc.format = DepthFormat;
+    depthTextureDesc.mipLevelCount = 1;
+    depthTextureDesc.sampleCount = 1;
+    depthTextureDesc.size = { width, height, 1 };
+    depthTextureDesc.usage = WGPUTextureUsage_RenderAttachment;
+    depthTextureDesc.viewFormatCount = 1;
+    depthTextureDesc.viewFormats = &DepthFormat;
+    view.DepthTexture = m_MemoryTracker.CreateTexture(m_Device, depthTextureDesc, GpuMemoryCategory_Texture);
+    if (!view.DepthTexture) {
+        std::cerr << "Could not create the depth texture!\n";
+        return false;
+    }
 
-    // We tell that the programmable fragment shader stage is described
-    // by the function called 'fs_main' in the shader module.
-    WGPUFragmentState fragmentState{};
-    fragmentState.module = shaderModule;
-    fragmentState.entryPoint = "fs_main";
-    fragmentState.constantCount = 0;
-    fragmentState.constants = nullptr;
+    WGPUTextureViewDescriptor depthViewDesc = {};
+    depthViewDesc.nextInChain = nullptr;
+    depthViewDesc.label = "Depth texture view";
+    depthViewDesc.aspect = WGPUTextureAspect_DepthOnly;
+    depthViewDesc.baseArrayLayer = 0;
+    depthViewDesc.arrayLayerCount = 1;
+    depthViewDesc.baseMipLevel = 0;
+    depthViewDesc.mipLevelCount = 1;
+    depthViewDesc.dimension = WGPUTextureViewDimension_2D;
+    depthViewDesc.format = DepthFormat;
+    view.DepthView.Reset(wgpuTextureCreateView(view.DepthTexture, &depthViewDesc));
+
+    return static_cast<bool>(view.DepthView);
+}
 
-    WGPUBlendState blendState;
-    blendState.color.srcFactor = WGPUBlendFactor_SrcAlpha;
-    blendState.color.dstFactor = WGPUBlendFactor_OneMinusSrcAlpha;
-    blendState.color.operation = WGPUBlendOperation_Add;
+bool Application::InitializeDynamicResolution() {
+    if (!m_GpuTimer.Initialize(m_Device, m_MemoryTracker, m_Readback)) {
+        std::cout << "Timestamp queries are not supported, dynamic resolution is disabled.\n";
+        return true;
+    }
 
-    blendState.alpha.srcFactor = WGPUBlendFactor_Zero;
-    blendState.alpha.dstFactor = WGPUBlendFactor_One;
-    blendState.alpha.operation = WGPUBlendOperation_Add;
+    DynamicResolutionSettings settings;
+    settings.TargetSeconds = m_Options.DynamicResolutionTarget;
+    m_DynamicResolution.Initialize(settings);
+
+    // Bilinear filtering for the upscale.
+    SamplerState samplerState;
+    samplerState.MagFilter = WGPUFilterMode_Linear;
+    samplerState.MinFilter = WGPUFilterMode_Linear;
+    samplerState.LodMaxClamp = 1.0f;
+    m_BlitSampler = m_Samplers.Get(samplerState);
+
+    // The size of the rendered part of the scene target, in pixels.
+    WGPUBufferDescriptor paramsDesc = {};
+    paramsDesc.nextInChain = nullptr;
+    paramsDesc.label = "Upscale parameters";
+    paramsDesc.usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Uniform;
+    paramsDesc.size = 2 * sizeof(float);
+    paramsDesc.mappedAtCreation = false;
+    m_BlitParams = m_MemoryTracker.CreateBuffer(m_Device, paramsDesc, GpuMemoryCategory_Uniform);
+
+    WGPUBindGroupLayoutEntry layoutEntries[3] = {};
+    layoutEntries[0].binding = 0;
+    layoutEntries[0].visibility = WGPUShaderStage_Fragment;
+    layoutEntries[0].texture.sampleType = WGPUTextureSampleType_Float;
+    layoutEntries[0].texture.viewDimension = WGPUTextureViewDimension_2D;
+    layoutEntries[0].texture.multisampled = false;
+    layoutEntries[1].binding = 1;
+    layoutEntries[1].visibility = WGPUShaderStage_Fragment;
+    layoutEntries[1].sampler.type = WGPUSamplerBindingType_Filtering;
+    layoutEntries[2].binding = 2;
+    layoutEntries[2].visibility = WGPUShaderStage_Fragment;
+    layoutEntries[2].buffer.type = WGPUBufferBindingType_Uniform;
+    layoutEntries[2].buffer.minBindingSize = 2 * sizeof(float);
+
+    WGPUBindGroupLayoutDescriptor bindGroupLayoutDesc = {};
+    bindGroupLayoutDesc.nextInChain = nullptr;
+    bindGroupLayoutDesc.label = "Upscale bind group layout";
+    bindGroupLayoutDesc.entryCount = 3;
+    bindGroupLayoutDesc.entries = layoutEntries;
+    m_BlitBindGroupLayout.Reset(wgpuDeviceCreateBindGroupLayout(m_Device, &bindGroupLayoutDesc));
+
+    WGPUBindGroupLayout bindGroupLayout = m_BlitBindGroupLayout;
+    WGPUPipelineLayoutDescriptor layoutDesc = {};
+    layoutDesc.nextInChain = nullptr;
+    layoutDesc.label = "Upscale pipeline layout";
+    layoutDesc.bindGroupLayoutCount = 1;
+    layoutDesc.bindGroupLayouts = &bindGroupLayout;
+    m_BlitPipelineLayout.Reset(wgpuDeviceCreatePipelineLayout(m_Device, &layoutDesc));
+
+    if (!m_BlitSampler || !m_BlitParams || !m_BlitBindGroupLayout || !m_BlitPipelineLayout) {
+        std::cerr << "Could not create the upscale resources!\n";
+        return false;
+    }
 
-    WGPUColorTargetState colorTarget{};
-    colorTarget.format = m_SurfaceFormat;
-    colorTarget.blend = &blendState;
-    colorTarget.writeMask = WGPUColorWriteMask_All; // We could write to only some of the color channels.
+    // A full screen triangle generated from the vertex index.
+    RenderPipelineState state;
+    state.ShaderPath = "Resources/Shaders/blit.wgsl";
+    state.ColorFormat = m_SurfaceFormat;
+    state.Layout = m_BlitPipelineLayout;
+    m_BlitPipelineKey = m_PipelineCache.Request(state);
+    if (m_BlitPipelineKey == InvalidPipelineKey) {
+        return false;
+    }
 
-    // We have only one target because our render pass has only one output color
-    // attachment.
-    fragmentState.targetCount = 1;
-    fragmentState.targets = &colorTarget;
+    // The scene target follows the size of the surface, like the depth
+    // buffer.
+    SurfaceManager &presenter = m_Views.front()->Presenter;
+    if (!CreateSceneTarget(presenter.GetWidth(), presenter.GetHeight())) {
+        return false;
+    }
+    presenter.AddResizeCallback([this](uint32_t newWidth, uint32_t newHeight) {
+        CreateSceneTarget(newWidth, newHeight);
+    });
 
-    pipelineDesc.fragment = &fragmentState;
+    return true;
+}
 
-    // We do not use stencil/depth testing for now.
-    pipelineDesc.depthStencil = nullptr;
+bool Application::CreateSceneTarget(uint32_t width, uint32_t height) {
+    m_BlitBindGroup.Reset();
+    m_SceneView.Reset();
+    m_MemoryTracker.Release(m_SceneTexture);
 
-    // Samples per pixel
-    pipelineDesc.multisample.count = 1;
-    // Default value for the mask, meaning "all bits on".
-    pipelineDesc.multisample.mask = ~0u;
-    // Default value as well (irrelevant for count = 1 anyways).
-    pipelineDesc.multisample.alphaToCoverageEnabled = false;
+    // Nothing is rendered while the window is minimized.
+    if (width == 0 || height == 0) {
+        return true;
+    }
 
-    pipelineDesc.layout = nullptr;
+    // Allocated at full size once: changing the scale only changes the
+    // viewport, never the texture.
+    WGPUTextureDescriptor textureDesc = {};
+    textureDesc.nextInChain = nullptr;
+    textureDesc.label = "Scene color texture";
+    textureDesc.dimension = WGPUTextureDimension_2D;
+    textureDesc.format = m_SurfaceFormat;
+    textureDesc.mipLevelCount = 1;
+    textureDesc.sampleCount = 1;
+    textureDesc.size = { width, height, 1 };
+    textureDesc.usage = WGPUTextureUsage_RenderAttachment | WGPUTextureUsage_TextureBinding;
+    textureDesc.viewFormatCount = 1;
+    textureDesc.viewFormats = &m_SurfaceFormat;
+    m_SceneTexture = m_MemoryTracker.CreateTexture(m_Device, textureDesc, GpuMemoryCategory_Texture);
+    if (!m_SceneTexture) {
+        std::cerr << "Could not create the scene color texture!\n";
+        return false;
+    }
 
-    m_Pipeline = wgpuDeviceCreateRenderPipeline(m_Device, &pipelineDesc);
+    WGPUTextureViewDescriptor viewDesc = {};
+    viewDesc.nextInChain = nullptr;
+    viewDesc.label = "Scene color texture view";
+    viewDesc.aspect = WGPUTextureAspect_All;
+    viewDesc.baseArrayLayer = 0;
+    viewDesc.arrayLayerCount = 1;
+    viewDesc.baseMipLevel = 0;
+    viewDesc.mipLevelCount = 1;
+    viewDesc.dimension = WGPUTextureViewDimension_2D;
+    viewDesc.format = m_SurfaceFormat;
+    m_SceneView.Reset(wgpuTextureCreateView(m_SceneTexture, &viewDesc));
+
+    WGPUBindGroupEntry entries[3] = {};
+    entries[0].binding = 0;
+    entries[0].textureView = m_SceneView;
+    entries[1].binding = 1;
+    entries[1].sampler = m_BlitSampler;
+    entries[2].binding = 2;
+    entries[2].buffer = m_BlitParams;
+    entries[2].offset = 0;
+    entries[2].size = 2 * sizeof(float);
+
+    WGPUBindGroupDescriptor bindGroupDesc = {};
+    bindGroupDesc.nextInChain = nullptr;
+    bindGroupDesc.label = "Upscale bind group";
+    bindGroupDesc.layout = m_BlitBindGroupLayout;
+    bindGroupDesc.entryCount = 3;
+    bindGroupDesc.entries = entries;
+    m_BlitBindGroup.Reset(wgpuDeviceCreateBindGroup(m_Device, &bindGroupDesc));
+
+    return m_SceneView && m_BlitBindGroup;
+}
 
-    // We no longer need to access the shader module
-    wgpuShaderModuleRelease(shaderModule);
+bool Application::CaptureScreenshot(WGPUCommandEncoder encoder, const SurfaceFrame &frame) {
+    // The callback runs a few frames later, when the options may be gone.
+    const std::string path = m_Options.ScreenshotPath;
+    return m_Readback.ReadTexture(encoder, frame.Texture, frame.Width, frame.Height, [path](const ReadbackResult &result) {
+        bool bgra = false;
+        if (!result.Data || !IsImageFormat(result.Format, bgra)) {
+            std::cerr << "Could not read the screenshot back!\n";
+            return;
+        }
+
+        if (SaveImagePPM(path, result.Width, result.Height, static_cast<const uint8_t *>(result.Data), bgra)) {
+            std::cout << "Screenshot saved to " << path << " (" << result.Width << "x" << result.Height
+                      << ", " << result.LatencyFrames << " frames later)\n";
+        } else {
+            std::cerr << "Could not write the screenshot to " << path << '\n';
+        }
+    });
 }
 
-void Application::InitializeBuffers() {
-    std::vector<float> pointData;
-    std::vector<uint16_t> indexData;
+int Application::RunBatch() {
+    std::vector<BatchFrame> frames;
+    if (!LoadBatchFile(m_Options.BatchPath, frames)) {
+        return 1;
+    }
 
-    bool success = LoadGeometry("Resources/Models/webgpu.txt", pointData, indexData);
-    
-    m_VertexCount = static_cast<uint32_t>(pointData.size() / 5);
-    
-    m_IndexCount = static_cast<int>(indexData.size());
-    
-    WGPUBufferDescriptor bufferDesc;
-    bufferDesc.nextInChain = nullptr;
-    bufferDesc.label = "Vertex buffer";
-    bufferDesc.usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Vertex;
-    bufferDesc.size = pointData.size() * sizeof(float);
-    bufferDesc.mappedAtCreation = false;
-    m_VertexBuffer = wgpuDeviceCreateBuffer(m_Device, &bufferDesc);
-
-    wgpuQueueWriteBuffer(m_Queue, m_VertexBuffer, 0, pointData.data(), bufferDesc.size);
-
-    bufferDesc.label = "Index buffer";
-    bufferDesc.size = indexData.size() * sizeof(uint16_t);
-    bufferDesc.size = (bufferDesc.size + 3) & ~3; // Round up to the next multiple of 4.
-    bufferDesc.usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Index;
-    m_IndexBuffer = wgpuDeviceCreateBuffer(m_Device, &bufferDesc);
-
-    wgpuQueueWriteBuffer(m_Queue, m_IndexBuffer, 0, indexData.data(), bufferDesc.size);
+    std::error_code error;
+    const fs::path outputDirectory = m_Options.BatchOutput;
+    fs::create_directories(outputDirectory, error);
+    if (error) {
+        std::cerr << "Could not create " << outputDirectory.string() << ": " << error.message() << '\n';
+        return 1;
+    }
+
+    const uint32_t width = m_Options.BatchWidth;
+    const uint32_t height = m_Options.BatchHeight;
+
+    // A single target is enough: the queue runs the copy of a frame before
+    // the render pass of the next one overwrites it.
+    WGPUTextureDescriptor textureDesc = {};
+    textureDesc.nextInChain = nullptr;
+    textureDesc.label = "Batch color texture";
+    textureDesc.dimension = WGPUTextureDimension_2D;
+    textureDesc.format = m_SurfaceFormat;
+    textureDesc.mipLevelCount = 1;
+    textureDesc.sampleCount = 1;
+    textureDesc.size = { width, height, 1 };
+    textureDesc.usage = WGPUTextureUsage_RenderAttachment | WGPUTextureUsage_CopySrc;
+    textureDesc.viewFormatCount = 0;
+    textureDesc.viewFormats = nullptr;
+    TextureHandle target = m_MemoryTracker.CreateTexture(m_Device, textureDesc, GpuMemoryCategory_Texture);
+    bool bgra = false;
+    if (!target || !IsImageFormat(m_SurfaceFormat, bgra)) {
+        std::cerr << "Could not create the batch color texture!\n";
+        m_MemoryTracker.Release(target);
+        return 1;
+    }
+    TextureViewHandle targetView(wgpuTextureCreateView(target, nullptr));
+
+    // Batch mode only has the primary view.
+    AppView &view = *m_Views.front();
+    if (m_Options.Depth && !CreateDepthBuffer(view, width, height)) {
+        m_MemoryTracker.Release(target);
+        return 1;
+    }
+
+    // The images do not have the window's shape: specialize the pipelines
+    // for theirs rather than stretching the scene.
+    const PipelineConstants batchConstants = { { "AspectRatio", static_cast<double>(width) / height } };
+    WGPURenderPipeline pipeline = m_PipelineCache.Wait(m_PipelineCache.Specialize(m_PipelineKey, batchConstants));
+    if (!pipeline) {
+        std::cerr << "Could not create the batch render pipeline!\n";
+        m_MemoryTracker.Release(target);
+        return 1;
+    }
+    // Every frame is complete: the texture is uploaded with the first one.
+    m_Textures.WaitForDecodes();
+    const PipelineKey texturedPipelineKey = m_PipelineCache.Specialize(m_TexturedPipelineKey, batchConstants);
+    const WGPURenderPipeline texturedPipeline = texturedPipelineKey != InvalidPipelineKey ? m_PipelineCache.Wait(texturedPipelineKey) : nullptr;
+
+    // Enough images in the backlog to keep every worker busy, no more.
+    ImageWriter writer;
+    writer.Initialize(m_Workers, 2 * m_Workers.GetThreadCount() + 2);
+
+    BatchStats stats;
+    const auto start = std::chrono::steady_clock::now();
+
+    // Batch frames draw the first mesh, placed relative to its center.
+    const float *meshCenter = m_Meshes.Get(0).Bounds.Center;
+    const Matrix4 centerMesh = Matrix4::Translation(-meshCenter[0], -meshCenter[1], -meshCenter[2]);
+
+    for (uint64_t index = 0; index < frames.size(); ++index) {
+        const BatchFrame &params = frames[index];
+
+        // Blocks only when the GPU is FramesInFlight frames behind, then
+        // hands finished frames to the image writer.
+        m_FrameController.BeginFrame();
+        m_Readback.Collect();
+        while (!m_Readback.HasFreeSlot()) {
+            ++stats.ReadbackWaits;
+            m_Events.Wait();
+            m_Readback.Collect();
+        }
+
+        WGPUCommandEncoderDescriptor encoderDesc = {};
+        encoderDesc.nextInChain = nullptr;
+        encoderDesc.label = "Batch command encoder";
+        CommandEncoderHandle encoder(wgpuDeviceCreateCommandEncoder(m_Device, &encoderDesc));
+        UpdateTextures(encoder);
+
+        WGPURenderPassColorAttachment colorAttachment = {};
+        colorAttachment.view = targetView;
+        colorAttachment.resolveTarget = nullptr;
+        colorAttachment.loadOp = WGPULoadOp_Clear;
+        colorAttachment.storeOp = WGPUStoreOp_Store;
+        colorAttachment.clearValue = WGPUColor{ params.ClearColor[0], params.ClearColor[1], params.ClearColor[2], 1.0 };
+
+        WGPURenderPassDepthStencilAttachment depthStencilAttachment = {};
+        depthStencilAttachment.view = view.DepthView;
+        depthStencilAttachment.depthClearValue = 1.0f;
+        depthStencilAttachment.depthLoadOp = WGPULoadOp_Clear;
+        depthStencilAttachment.depthStoreOp = WGPUStoreOp_Discard;
+        depthStencilAttachment.depthReadOnly = false;
+        depthStencilAttachment.stencilLoadOp = WGPULoadOp_Undefined;
+        depthStencilAttachment.stencilStoreOp = WGPUStoreOp_Undefined;
+        depthStencilAttachment.stencilReadOnly = true;
+
+        WGPURenderPassDescriptor renderPassDesc = {};
+        renderPassDesc.nextInChain = nullptr;
+        renderPassDesc.label = "Batch render pass";
+        renderPassDesc.colorAttachmentCount = 1;
+        renderPassDesc.colorAttachments = &colorAttachment;
+        renderPassDesc.depthStencilAttachment = view.DepthView ? &depthStencilAttachment : nullptr;
+        renderPassDesc.timestampWrites = nullptr;
+
+        RenderPassEncoderHandle renderPass(wgpuCommandEncoderBeginRenderPass(encoder, &renderPassDesc));
+        if (texturedPipeline && m_TextureBindGroup) {
+            wgpuRenderPassEncoderSetPipeline(renderPass, texturedPipeline);
+            wgpuRenderPassEncoderSetBindGroup(renderPass, 1, m_TextureBindGroup, 0, nullptr);
+        } else {
+            wgpuRenderPassEncoderSetPipeline(renderPass, pipeline);
+        }
+
+        DrawData draw;
+        draw.Transform = Matrix4::Translation(params.OffsetX, params.OffsetY, 0.5f) * Matrix4::Scaling(params.Scale, params.Scale, 1.0f) * centerMesh;
+        std::copy(params.Tint, params.Tint + 3, draw.Tint);
+        m_DrawList.Clear();
+        for (GeometryHandle part : m_Meshes.Get(0).Parts) {
+            m_DrawList.Add(part, draw);
+        }
+        m_DrawList.Submit(renderPass, m_GeometryPool);
+
+        wgpuRenderPassEncoderEnd(renderPass);
+        renderPass.Reset();
+
+        // The pixels only live as long as the callback, the writer gets its
+        // own copy to encode on a worker.
+        const fs::path path = GetBatchFramePath(outputDirectory, index);
+        m_Readback.ReadTexture(encoder, target, width, height, [&writer, path, bgra](const ReadbackResult &result) {
+            if (!result.Data) {
+                std::cerr << "Could not read " << path.string() << " back!\n";
+                return;
+            }
+            const auto *pixels = static_cast<const uint8_t *>(result.Data);
+            writer.Write(path, result.Width, result.Height, std::vector<uint8_t>(pixels, pixels + result.Size), bgra);
+        });
+
+        WGPUCommandBufferDescriptor commandBufferDesc = {};
+        commandBufferDesc.nextInChain = nullptr;
+        commandBufferDesc.label = "Batch command buffer";
+        CommandBufferHandle command(wgpuCommandEncoderFinish(encoder, &commandBufferDesc));
+        encoder.Reset();
+
+        m_FrameController.Submit(command);
+        m_Readback.OnSubmitted();
+        m_MemoryTracker.EndFrame();
+        ++stats.Frames;
+
+        // Batch frames are always complete, the pipelines were waited for.
+        if (index == 0) {
+            m_Startup->MarkMilestone("first frame");
+            m_Startup->MarkMilestone("first complete frame");
+        }
+    }
+
+    stats.SubmitSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    m_Readback.Flush();
+    writer.Wait();
+    stats.TotalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const ImageWriterStats writerStats = writer.GetStats();
+    PrintBatchStats(stats);
+    PrintImageWriterStats(writerStats);
+
+    targetView.Reset();
+    m_MemoryTracker.Release(target);
+
+    return writerStats.ImagesWritten == frames.size() ? 0 : 1;
 }
 
 // Initialize the WGPULimits structure.
@@ -408,16 +1465,45 @@ WGPURequiredLimits Application::GetRequiredLimits(WGPUAdapter adapter) const {
     WGPURequiredLimits requiredLimits{};
     SetDefaults(requiredLimits.limits);
 
-    // We use at most 2 vertex attribute for now.
-    requiredLimits.limits.maxVertexAttributes = 2;
+    // Every vertex has the attributes of the loaded geometry.
+    requiredLimits.limits.maxVertexAttributes = SceneVertexAttributeCount;
     // We should also tell that we use 1 vertex buffer.
     requiredLimits.limits.maxVertexBuffers = 1;
-    // Maximum size of a buffer is 15 vertices of 5 floats each.
-    requiredLimits.limits.maxBufferSize = 15 * 5 * sizeof(float);
+    // The largest buffers we create are the pooled vertex and index buffers,
+    // sized for the loaded geometry, and the readback of screenshots, whose
+    // size depends on the window. Beyond what the adapter supports, the
+    // geometry is split over several pages of the pool instead.
+    uint64_t vertexCount = 0, indexCount = 0;
+    GetLoadedGeometrySize(vertexCount, indexCount);
+    requiredLimits.limits.maxBufferSize = std::min(std::max<uint64_t>({
+        std::max<uint64_t>(VertexPoolCapacity, vertexCount) * SceneVertexStride,
+        std::max<uint64_t>(IndexPoolCapacity, indexCount) * sizeof(uint16_t),
+        DefaultMaxBufferSize,
+    }), supportedLimits.limits.maxBufferSize);
     // Maximum stride between 5 consecutive vertices in the vertex buffer.
-    requiredLimits.limits.maxVertexBufferArrayStride = 5 * sizeof(float);
-    // There is a maximum of 3 floats forwarded from vertex to fragment shader.
-    requiredLimits.limits.maxInterStageShaderComponents = 3;
+    requiredLimits.limits.maxVertexBufferArrayStride = SceneVertexStride;
+    // There is a maximum of 5 floats forwarded from vertex to fragment
+    // shader: the color, and the texture coordinates when textured.
+    requiredLimits.limits.maxInterStageShaderComponents = 5;
+
+    // The per-draw data is one storage buffer bound with a dynamic offset,
+    // the texture of the textured pipeline is in a second bind group.
+    requiredLimits.limits.maxBindGroups = 2;
+    requiredLimits.limits.maxStorageBuffersPerShaderStage = 1;
+    requiredLimits.limits.maxDynamicStorageBuffersPerPipelineLayout = 1;
+    requiredLimits.limits.maxStorageBufferBindingSize = DrawList::GetBindingSize(m_MaxDraws);
+    // The dynamic resolution blit and the textured pipeline sample one
+    // texture each, the blit is sized by a small uniform. Mip levels are
+    // generated with storage textures, within the default limits.
+    requiredLimits.limits.maxSampledTexturesPerShaderStage = 1;
+    requiredLimits.limits.maxSamplersPerShaderStage = 1;
+    requiredLimits.limits.maxUniformBuffersPerShaderStage = 1;
+    requiredLimits.limits.maxUniformBufferBindingSize = 2 * sizeof(float);
+    // These two limits are different because they are "minimum" limits,
+    // they are the only ones we may forward from the adapter's supported
+    // limits.
+    requiredLimits.limits.minUniformBufferOffsetAlignment = supportedLimits.limits.minUniformBufferOffsetAlignment;
+    requiredLimits.limits.minStorageBufferOffsetAlignment = supportedLimits.limits.minStorageBufferOffsetAlignment;
 
     return requiredLimits;
 }
@@ -0,0 +1,133 @@
+#include "Async.hpp"
+
+#include <webgpu/webgpu.h>
+#include <webgpu/wgpu.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace {
+    // How often Wait() polls the devices while it sleeps.
+    constexpr std::chrono::milliseconds PollInterval(1);
+}
+
+void EventPump::AddDevice(WGPUDevice device) {
+    m_Devices.push_back(device);
+}
+
+void EventPump::RemoveDevice(WGPUDevice device) {
+    m_Devices.erase(std::remove(m_Devices.begin(), m_Devices.end(), device), m_Devices.end());
+}
+
+void EventPump::Schedule(std::coroutine_handle<> handle) {
+    {
+        std::lock_guard lock(m_Mutex);
+        m_Ready.push_back(handle);
+    }
+    m_Wakeup.notify_one();
+}
+
+uint32_t EventPump::Pump() {
+    ++m_Stats.Pumps;
+
+    if (m_Instance) {
+        wgpuInstanceProcessEvents(m_Instance);
+    }
+    for (WGPUDevice device : m_Devices) {
+        wgpuDevicePoll(device, false, nullptr);
+    }
+
+    // Resumed coroutines may schedule others, which wait for the next call.
+    std::vector<std::coroutine_handle<>> ready;
+    {
+        std::lock_guard lock(m_Mutex);
+        ready.swap(m_Ready);
+    }
+    for (std::coroutine_handle<> handle : ready) {
+        handle.resume();
+    }
+
+    m_Stats.Resumed += ready.size();
+    return static_cast<uint32_t>(ready.size());
+}
+
+uint32_t EventPump::Wait() {
+    ++m_Stats.Waits;
+    uint32_t resumed = Pump();
+    while (resumed == 0) {
+        {
+            std::unique_lock lock(m_Mutex);
+            m_Wakeup.wait_for(lock, PollInterval, [this] { return !m_Ready.empty(); });
+        }
+        resumed = Pump();
+    }
+    return resumed;
+}
+
+uint32_t EventPump::WaitForSubmission(WGPUDevice device, WGPUQueue queue, WGPUSubmissionIndex submissionIndex) {
+    ++m_Stats.Waits;
+    // Polling with wait = true blocks until that submission is done and
+    // fires the callbacks of everything that completed, which Pump() then
+    // resumes.
+    WGPUWrappedSubmissionIndex wrappedIndex;
+    wrappedIndex.queue = queue;
+    wrappedIndex.submissionIndex = submissionIndex;
+    wgpuDevicePoll(device, true, &wrappedIndex);
+    return Pump();
+}
+
+void AdapterRequest::Begin() {
+    auto onAdapterRequestEnded = [](WGPURequestAdapterStatus status, WGPUAdapter adapter, char const *message, void *pUserData) {
+        AdapterRequest &request = *static_cast<AdapterRequest *>(pUserData);
+        if (status == WGPURequestAdapterStatus_Success) {
+            request.m_Adapter = adapter;
+        } else {
+            std::cerr << "Could not get WebGPU adapter: " << (message ? message : "unknown error") << '\n';
+        }
+        request.Complete();
+    };
+    wgpuInstanceRequestAdapter(m_Instance, m_Options, onAdapterRequestEnded, this);
+}
+
+void DeviceRequest::Begin() {
+    auto onDeviceRequestEnded = [](WGPURequestDeviceStatus status, WGPUDevice device, char const *message, void *pUserData) {
+        DeviceRequest &request = *static_cast<DeviceRequest *>(pUserData);
+        if (status == WGPURequestDeviceStatus_Success) {
+            request.m_Device = device;
+        } else {
+            std::cerr << "Could not get WebGPU device: " << (message ? message : "unknown error") << '\n';
+        }
+        request.Complete();
+    };
+    wgpuAdapterRequestDevice(m_Adapter, m_Descriptor, onDeviceRequestEnded, this);
+}
+
+void BufferMapRequest::Begin() {
+    auto onMapped = [](WGPUBufferMapAsyncStatus status, void *pUserData) {
+        BufferMapRequest &request = *static_cast<BufferMapRequest *>(pUserData);
+        request.m_Status = status;
+        request.Complete();
+    };
+    wgpuBufferMapAsync(m_Buffer, m_Mode, m_Offset, m_Size, onMapped, this);
+}
+
+void QueueWorkDoneRequest::Begin() {
+    auto onWorkDone = [](WGPUQueueWorkDoneStatus status, void *pUserData) {
+        QueueWorkDoneRequest &request = *static_cast<QueueWorkDoneRequest *>(pUserData);
+        request.m_Status = status;
+        request.Complete();
+    };
+    wgpuQueueOnSubmittedWorkDone(m_Queue, onWorkDone, this);
+}
+
+WorkerRequest<WGPURenderPipeline> CreateRenderPipelineAsync(EventPump &pump, ThreadPool &workers, WGPUDevice device, const WGPURenderPipelineDescriptor *descriptor) {
+    return WorkerRequest<WGPURenderPipeline>(pump, workers, [device, descriptor] {
+        return wgpuDeviceCreateRenderPipeline(device, descriptor);
+    });
+}
+
+void PrintEventPumpStats(const EventPumpStats &stats) {
+    std::cout << "Event pump:\n";
+    std::cout << " - pumps: " << stats.Pumps << " (" << stats.Waits << " blocking), coroutines resumed: " << stats.Resumed << '\n';
+}
@@ -0,0 +1,73 @@
+#include "BatchRender.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+bool LoadBatchFile(const std::filesystem::path &path, std::vector<BatchFrame> &frames) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Could not open batch file " << path.string() << '\n';
+        return false;
+    }
+
+    frames.clear();
+    std::string line;
+    uint32_t lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        std::istringstream iss(line);
+        BatchFrame frame;
+        iss >> frame.OffsetX >> frame.OffsetY >> frame.Scale >> frame.Tint[0] >> frame.Tint[1] >> frame.Tint[2];
+        if (!iss) {
+            std::cerr << path.string() << ':' << lineNumber << ": expected offsetX offsetY scale tintR tintG tintB\n";
+            return false;
+        }
+
+        // The clear color is optional, but all three components must be
+        // there.
+        double clearColor[3];
+        if (iss >> clearColor[0]) {
+            iss >> clearColor[1] >> clearColor[2];
+            if (!iss) {
+                std::cerr << path.string() << ':' << lineNumber << ": expected clearR clearG clearB\n";
+                return false;
+            }
+            std::copy(clearColor, clearColor + 3, frame.ClearColor);
+        }
+
+        frames.push_back(frame);
+    }
+
+    if (frames.empty()) {
+        std::cerr << "Batch file " << path.string() << " has no frame\n";
+        return false;
+    }
+    return true;
+}
+
+std::filesystem::path GetBatchFramePath(const std::filesystem::path &directory, uint64_t index) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "frame_%05llu.ppm", static_cast<unsigned long long>(index));
+    return directory / name;
+}
+
+void PrintBatchStats(const BatchStats &stats) {
+    std::cout << "Batch:\n";
+    std::cout << " - frames: " << stats.Frames << '\n';
+    if (stats.TotalSeconds > 0.0) {
+        std::cout << " - submitted in " << stats.SubmitSeconds << " s, saved in " << stats.TotalSeconds << " s: "
+                  << stats.Frames / stats.TotalSeconds << " frames/s end to end\n";
+    }
+    std::cout << " - readback waits: " << stats.ReadbackWaits << '\n';
+}
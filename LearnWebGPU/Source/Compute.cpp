@@ -0,0 +1,140 @@
+#include "Compute.hpp"
+
+#include <webgpu/webgpu.h>
+
+#include <iostream>
+
+ComputePipelineHandle CreateComputePipeline(WGPUDevice device, ShaderCache &shaderCache, const ComputePipelineState &state) {
+    ShaderHash shaderHash;
+    if (!shaderCache.GetSourceHash(state.ShaderPath, shaderHash)) {
+        return {};
+    }
+
+    WGPUShaderModule module = shaderCache.GetModule(shaderHash);
+    if (!module) {
+        std::cerr << "Could not create shader module " << state.ShaderPath << '\n';
+        return {};
+    }
+
+    WGPUComputePipelineDescriptor pipelineDesc = {};
+    pipelineDesc.nextInChain = nullptr;
+    pipelineDesc.label = state.EntryPoint.c_str();
+    pipelineDesc.layout = state.Layout;
+    pipelineDesc.compute.nextInChain = nullptr;
+    pipelineDesc.compute.module = module;
+    pipelineDesc.compute.entryPoint = state.EntryPoint.c_str();
+    pipelineDesc.compute.constantCount = 0;
+    pipelineDesc.compute.constants = nullptr;
+
+    ComputePipelineHandle pipeline(wgpuDeviceCreateComputePipeline(device, &pipelineDesc));
+    if (!pipeline) {
+        std::cerr << "Could not create compute pipeline " << state.ShaderPath << ':' << state.EntryPoint << '\n';
+    }
+    return pipeline;
+}
+
+WGPUBindGroupLayoutEntry StorageBufferLayoutEntry(uint32_t binding, bool readOnly, WGPUShaderStageFlags visibility) {
+    WGPUBindGroupLayoutEntry entry = {};
+    entry.binding = binding;
+    entry.visibility = visibility;
+    entry.buffer.type = readOnly ? WGPUBufferBindingType_ReadOnlyStorage : WGPUBufferBindingType_Storage;
+    entry.buffer.hasDynamicOffset = false;
+    // Every kernel works on arrays of 32-bit values.
+    entry.buffer.minBindingSize = sizeof(uint32_t);
+    return entry;
+}
+
+WGPUBindGroupLayoutEntry UniformBufferLayoutEntry(uint32_t binding, uint64_t minBindingSize, WGPUShaderStageFlags visibility) {
+    WGPUBindGroupLayoutEntry entry = {};
+    entry.binding = binding;
+    entry.visibility = visibility;
+    entry.buffer.type = WGPUBufferBindingType_Uniform;
+    entry.buffer.hasDynamicOffset = false;
+    entry.buffer.minBindingSize = minBindingSize;
+    return entry;
+}
+
+WGPUBindGroupLayoutEntry SampledTextureLayoutEntry(uint32_t binding, WGPUTextureSampleType sampleType, WGPUShaderStageFlags visibility) {
+    WGPUBindGroupLayoutEntry entry = {};
+    entry.binding = binding;
+    entry.visibility = visibility;
+    entry.texture.sampleType = sampleType;
+    entry.texture.viewDimension = WGPUTextureViewDimension_2D;
+    entry.texture.multisampled = false;
+    return entry;
+}
+
+WGPUBindGroupLayoutEntry StorageTextureLayoutEntry(uint32_t binding, WGPUTextureFormat format, WGPUShaderStageFlags visibility) {
+    WGPUBindGroupLayoutEntry entry = {};
+    entry.binding = binding;
+    entry.visibility = visibility;
+    entry.storageTexture.access = WGPUStorageTextureAccess_WriteOnly;
+    entry.storageTexture.format = format;
+    entry.storageTexture.viewDimension = WGPUTextureViewDimension_2D;
+    return entry;
+}
+
+WGPUBindGroupLayoutEntry SamplerLayoutEntry(uint32_t binding, WGPUSamplerBindingType type, WGPUShaderStageFlags visibility) {
+    WGPUBindGroupLayoutEntry entry = {};
+    entry.binding = binding;
+    entry.visibility = visibility;
+    entry.sampler.type = type;
+    return entry;
+}
+
+WGPUBindGroupEntry BufferBindingEntry(uint32_t binding, WGPUBuffer buffer, uint64_t offset, uint64_t size) {
+    WGPUBindGroupEntry entry = {};
+    entry.binding = binding;
+    entry.buffer = buffer;
+    entry.offset = offset;
+    entry.size = size;
+    return entry;
+}
+
+WGPUBindGroupEntry TextureBindingEntry(uint32_t binding, WGPUTextureView view) {
+    WGPUBindGroupEntry entry = {};
+    entry.binding = binding;
+    entry.textureView = view;
+    return entry;
+}
+
+WGPUBindGroupEntry SamplerBindingEntry(uint32_t binding, WGPUSampler sampler) {
+    WGPUBindGroupEntry entry = {};
+    entry.binding = binding;
+    entry.sampler = sampler;
+    return entry;
+}
+
+BindGroupLayoutHandle CreateBindGroupLayout(WGPUDevice device, const char *label, std::initializer_list<WGPUBindGroupLayoutEntry> entries) {
+    WGPUBindGroupLayoutDescriptor layoutDesc = {};
+    layoutDesc.nextInChain = nullptr;
+    layoutDesc.label = label;
+    layoutDesc.entryCount = entries.size();
+    layoutDesc.entries = entries.begin();
+    return BindGroupLayoutHandle(wgpuDeviceCreateBindGroupLayout(device, &layoutDesc));
+}
+
+BindGroupHandle CreateBindGroup(WGPUDevice device, WGPUBindGroupLayout layout, const char *label, std::initializer_list<WGPUBindGroupEntry> entries) {
+    WGPUBindGroupDescriptor bindGroupDesc = {};
+    bindGroupDesc.nextInChain = nullptr;
+    bindGroupDesc.label = label;
+    bindGroupDesc.layout = layout;
+    bindGroupDesc.entryCount = entries.size();
+    bindGroupDesc.entries = entries.begin();
+    return BindGroupHandle(wgpuDeviceCreateBindGroup(device, &bindGroupDesc));
+}
+
+PipelineLayoutHandle CreatePipelineLayout(WGPUDevice device, const char *label, WGPUBindGroupLayout bindGroupLayout) {
+    WGPUPipelineLayoutDescriptor layoutDesc = {};
+    layoutDesc.nextInChain = nullptr;
+    layoutDesc.label = label;
+    layoutDesc.bindGroupLayoutCount = 1;
+    layoutDesc.bindGroupLayouts = &bindGroupLayout;
+    return PipelineLayoutHandle(wgpuDeviceCreatePipelineLayout(device, &layoutDesc));
+}
+
+void Dispatch(WGPUComputePassEncoder pass, WGPUComputePipeline pipeline, WGPUBindGroup bindGroup, uint32_t workgroupCount) {
+    wgpuComputePassEncoderSetPipeline(pass, pipeline);
+    wgpuComputePassEncoderSetBindGroup(pass, 0, bindGroup, 0, nullptr);
+    wgpuComputePassEncoderDispatchWorkgroups(pass, workgroupCount, 1, 1);
+}
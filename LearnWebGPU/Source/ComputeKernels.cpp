@@ -0,0 +1,401 @@
+#include "ComputeKernels.hpp"
+
+#include <webgpu/webgpu.h>
+
+#include <algorithm>
+#include <iostream>
+
+namespace {
+    constexpr const char *ReduceShader = "Resources/Shaders/Compute/reduce.wgsl";
+    constexpr const char *ScanShader = "Resources/Shaders/Compute/scan.wgsl";
+    constexpr const char *RadixSortShader = "Resources/Shaders/Compute/radix_sort.wgsl";
+    constexpr const char *CompactShader = "Resources/Shaders/Compute/compact.wgsl";
+
+    // What the kernels need beyond the defaults of some limits.
+    constexpr uint32_t WorkgroupSize = 256;
+    constexpr uint32_t StorageBuffersPerStage = 5;
+    // radix_scatter's tile of keys and packed digit counts.
+    constexpr uint32_t WorkgroupStorageSize = (ComputeKernels::BlockSize + WorkgroupSize * ComputeKernels::RadixSize / 2 + ComputeKernels::RadixSize) * sizeof(uint32_t);
+
+    uint64_t GetByteSize(uint32_t count) {
+        return uint64_t{ count } * sizeof(uint32_t);
+    }
+}
+
+static_assert(ComputeKernels::RadixPasses % 2 == 0, "The sorted keys must end up in the input buffer");
+
+bool ComputeKernels::Initialize(WGPUDevice device, WGPUQueue queue, ShaderCache &shaderCache, GpuMemoryTracker &memory) {
+    m_Device = device;
+    m_Memory = &memory;
+
+    WGPUSupportedLimits supportedLimits = {};
+    supportedLimits.nextInChain = nullptr;
+    wgpuDeviceGetLimits(device, &supportedLimits);
+    const WGPULimits &limits = supportedLimits.limits;
+    if (limits.maxStorageBuffersPerShaderStage < StorageBuffersPerStage
+        || limits.maxComputeInvocationsPerWorkgroup < WorkgroupSize
+        || limits.maxComputeWorkgroupSizeX < WorkgroupSize
+        || limits.maxComputeWorkgroupStorageSize < WorkgroupStorageSize) {
+        std::cerr << "The device limits are too low for the compute kernels!\n";
+        return false;
+    }
+
+    const uint64_t maxCount = std::min(
+        uint64_t{ limits.maxComputeWorkgroupsPerDimension } * BlockSize,
+        limits.maxStorageBufferBindingSize / sizeof(uint32_t)
+    );
+    m_MaxCount = static_cast<uint32_t>(std::min<uint64_t>(maxCount, UINT32_MAX));
+    m_RadixParamsStride = std::max<uint32_t>(limits.minUniformBufferOffsetAlignment, sizeof(uint32_t));
+
+    m_ReduceLayout = CreateBindGroupLayout(device, "Reduce bind group layout", {
+        StorageBufferLayoutEntry(0, true),
+        StorageBufferLayoutEntry(1, false),
+    });
+    m_ScanLayout = CreateBindGroupLayout(device, "Scan bind group layout", {
+        StorageBufferLayoutEntry(0, true),
+        StorageBufferLayoutEntry(1, false),
+        StorageBufferLayoutEntry(2, false),
+    });
+    m_RadixLayout = CreateBindGroupLayout(device, "Radix sort bind group layout", {
+        StorageBufferLayoutEntry(0, true),
+        StorageBufferLayoutEntry(1, false),
+        UniformBufferLayoutEntry(2, sizeof(uint32_t)),
+        StorageBufferLayoutEntry(3, true),
+    });
+    m_CompactLayout = CreateBindGroupLayout(device, "Compact bind group layout", {
+        StorageBufferLayoutEntry(0, true),
+        StorageBufferLayoutEntry(1, true),
+        StorageBufferLayoutEntry(2, true),
+        StorageBufferLayoutEntry(3, false),
+        StorageBufferLayoutEntry(4, false),
+    });
+    m_ReducePipelineLayout = CreatePipelineLayout(device, "Reduce pipeline layout", m_ReduceLayout);
+    m_ScanPipelineLayout = CreatePipelineLayout(device, "Scan pipeline layout", m_ScanLayout);
+    m_RadixPipelineLayout = CreatePipelineLayout(device, "Radix sort pipeline layout", m_RadixLayout);
+    m_CompactPipelineLayout = CreatePipelineLayout(device, "Compact pipeline layout", m_CompactLayout);
+
+    m_ReduceSum = CreateComputePipeline(device, shaderCache, { ReduceShader, "reduce_sum", m_ReducePipelineLayout });
+    m_ScanInclusive = CreateComputePipeline(device, shaderCache, { ScanShader, "scan_inclusive", m_ScanPipelineLayout });
+    m_ScanExclusive = CreateComputePipeline(device, shaderCache, { ScanShader, "scan_exclusive", m_ScanPipelineLayout });
+    m_ScanFlagsExclusive = CreateComputePipeline(device, shaderCache, { ScanShader, "scan_flags_exclusive", m_ScanPipelineLayout });
+    // Reads the scanned block sums, offsets the output: the reduce layout.
+    m_AddBlockOffsets = CreateComputePipeline(device, shaderCache, { ScanShader, "add_block_offsets", m_ReducePipelineLayout });
+    m_RadixHistogram = CreateComputePipeline(device, shaderCache, { RadixSortShader, "radix_histogram", m_RadixPipelineLayout });
+    m_RadixScatter = CreateComputePipeline(device, shaderCache, { RadixSortShader, "radix_scatter", m_RadixPipelineLayout });
+    m_CompactScatter = CreateComputePipeline(device, shaderCache, { CompactShader, "compact_scatter", m_CompactPipelineLayout });
+
+    // The shift of each radix pass never changes, it is uploaded once.
+    WGPUBufferDescriptor paramsDesc = {};
+    paramsDesc.nextInChain = nullptr;
+    paramsDesc.label = "Radix sort parameters";
+    paramsDesc.usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Uniform;
+    paramsDesc.size = uint64_t{ m_RadixParamsStride } * RadixPasses;
+    paramsDesc.mappedAtCreation = false;
+    m_RadixParams = memory.CreateBuffer(device, paramsDesc, GpuMemoryCategory_Uniform);
+
+    if (!m_ReduceSum || !m_ScanInclusive || !m_ScanExclusive || !m_ScanFlagsExclusive || !m_AddBlockOffsets
+        || !m_RadixHistogram || !m_RadixScatter || !m_CompactScatter || !m_RadixParams) {
+        std::cerr << "Could not create the compute kernels!\n";
+        Terminate();
+        return false;
+    }
+
+    std::vector<uint8_t> params(paramsDesc.size, 0);
+    for (uint32_t pass = 0; pass < RadixPasses; ++pass) {
+        const uint32_t shift = pass * RadixBits;
+        std::copy_n(reinterpret_cast<const uint8_t *>(&shift), sizeof(shift), params.data() + size_t{ pass } * m_RadixParamsStride);
+    }
+    wgpuQueueWriteBuffer(queue, m_RadixParams, 0, params.data(), params.size());
+
+    return true;
+}
+
+void ComputeKernels::Terminate() {
+    ReleaseScratch();
+    if (m_Memory) {
+        m_Memory->Release(m_RadixParams);
+    }
+
+    m_ReduceSum.Reset();
+    m_ScanInclusive.Reset();
+    m_ScanExclusive.Reset();
+    m_ScanFlagsExclusive.Reset();
+    m_AddBlockOffsets.Reset();
+    m_RadixHistogram.Reset();
+    m_RadixScatter.Reset();
+    m_CompactScatter.Reset();
+
+    m_ReducePipelineLayout.Reset();
+    m_ScanPipelineLayout.Reset();
+    m_RadixPipelineLayout.Reset();
+    m_CompactPipelineLayout.Reset();
+    m_ReduceLayout.Reset();
+    m_ScanLayout.Reset();
+    m_RadixLayout.Reset();
+    m_CompactLayout.Reset();
+}
+
+bool ComputeKernels::Reserve(uint32_t count) {
+    if (count <= m_Capacity) {
+        return true;
+    }
+    if (!CheckCount(count, "Reserve")) {
+        return false;
+    }
+
+    // The encoders that used the previous buffers keep them alive.
+    ReleaseScratch();
+
+    const uint32_t blockCount = DivideRoundUp(count, BlockSize);
+    const uint32_t histogramCount = RadixSize * blockCount;
+
+    // One level per recursion of the scan, down to a single block. Radix
+    // histograms are scanned too, and are longer than the keys when there
+    // are only a few of them.
+    uint32_t scanCount = std::max(count, histogramCount);
+    uint32_t groups;
+    do {
+        groups = DivideRoundUp(scanCount, BlockSize);
+        ScanLevel &level = m_ScanLevels.emplace_back();
+        level.Sums = CreateScratchBuffer("Scan block sums", groups);
+        level.Offsets = CreateScratchBuffer("Scan block offsets", groups);
+        scanCount = groups;
+    } while (groups > 1);
+
+    m_ReducePartials[0] = CreateScratchBuffer("Reduce partial sums", DivideRoundUp(count, ReduceBlockSize));
+    m_ReducePartials[1] = CreateScratchBuffer("Reduce partial sums", DivideRoundUp(count, ReduceBlockSize));
+    m_RadixKeys = CreateScratchBuffer("Radix sort keys", count);
+    m_RadixHistograms = CreateScratchBuffer("Radix sort histograms", histogramCount);
+    m_RadixOffsets = CreateScratchBuffer("Radix sort offsets", histogramCount);
+    m_CompactPositions = CreateScratchBuffer("Compact positions", count);
+
+    bool allocated = m_ReducePartials[0] && m_ReducePartials[1] && m_RadixKeys && m_RadixHistograms && m_RadixOffsets && m_CompactPositions;
+    for (const ScanLevel &level : m_ScanLevels) {
+        allocated = allocated && level.Sums && level.Offsets;
+    }
+    if (!allocated) {
+        std::cerr << "Could not allocate the compute kernels scratch memory for " << count << " elements!\n";
+        return false;
+    }
+
+    m_Capacity = count;
+    return true;
+}
+
+void ComputeKernels::Reduce(WGPUCommandEncoder encoder, WGPUBuffer input, uint32_t count, WGPUBuffer output) {
+    if (count == 0) {
+        wgpuCommandEncoderClearBuffer(encoder, output, 0, sizeof(uint32_t));
+        return;
+    }
+    if (!Reserve(count)) {
+        return;
+    }
+
+    ComputePassEncoderHandle pass(BeginPass(encoder, "Reduce"));
+
+    // Each level sums blocks of the previous one, until a single value is
+    // left, which goes to the output.
+    WGPUBuffer source = input;
+    uint32_t sourceCount = count;
+    uint32_t partials = 0;
+    while (true) {
+        const uint32_t groups = DivideRoundUp(sourceCount, ReduceBlockSize);
+        WGPUBuffer destination = groups == 1 ? output : m_ReducePartials[partials].Get();
+
+        BindGroupHandle bindGroup = CreateBindGroup(m_Device, m_ReduceLayout, "Reduce bind group", {
+            BufferBindingEntry(0, source, 0, GetByteSize(sourceCount)),
+            BufferBindingEntry(1, destination, 0, GetByteSize(groups)),
+        });
+        Dispatch(pass, m_ReduceSum, bindGroup, groups);
+
+        if (groups == 1) {
+            break;
+        }
+        source = destination;
+        sourceCount = groups;
+        partials ^= 1;
+    }
+
+    wgpuComputePassEncoderEnd(pass);
+}
+
+void ComputeKernels::Scan(WGPUCommandEncoder encoder, WGPUBuffer input, WGPUBuffer output, uint32_t count, ScanType type) {
+    if (count == 0 || !Reserve(count)) {
+        return;
+    }
+
+    ComputePassEncoderHandle pass(BeginPass(encoder, "Scan"));
+    RecordScan(pass, input, output, count, type == ScanType_Inclusive ? m_ScanInclusive.Get() : m_ScanExclusive.Get(), 0);
+    wgpuComputePassEncoderEnd(pass);
+}
+
+void ComputeKernels::RadixSort(WGPUCommandEncoder encoder, WGPUBuffer keys, uint32_t count) {
+    if (count <= 1 || !Reserve(count)) {
+        return;
+    }
+
+    const uint32_t groups = DivideRoundUp(count, BlockSize);
+    const uint32_t histogramCount = RadixSize * groups;
+
+    ComputePassEncoderHandle pass(BeginPass(encoder, "Radix sort"));
+
+    // Keys go back and forth between the input and the scratch buffer, an
+    // even number of times.
+    for (uint32_t radixPass = 0; radixPass < RadixPasses; ++radixPass) {
+        WGPUBuffer source = radixPass % 2 == 0 ? keys : m_RadixKeys.Get();
+        WGPUBuffer destination = radixPass % 2 == 0 ? m_RadixKeys.Get() : keys;
+        const WGPUBindGroupEntry params = BufferBindingEntry(2, m_RadixParams, uint64_t{ radixPass } * m_RadixParamsStride, sizeof(uint32_t));
+
+        BindGroupHandle histogramGroup = CreateBindGroup(m_Device, m_RadixLayout, "Radix histogram bind group", {
+            BufferBindingEntry(0, source, 0, GetByteSize(count)),
+            BufferBindingEntry(1, m_RadixHistograms, 0, GetByteSize(histogramCount)),
+            params,
+            BufferBindingEntry(3, m_RadixOffsets, 0, GetByteSize(histogramCount)),
+        });
+        Dispatch(pass, m_RadixHistogram, histogramGroup, groups);
+
+        RecordScan(pass, m_RadixHistograms, m_RadixOffsets, histogramCount, m_ScanExclusive, 0);
+
+        BindGroupHandle scatterGroup = CreateBindGroup(m_Device, m_RadixLayout, "Radix scatter bind group", {
+            BufferBindingEntry(0, source, 0, GetByteSize(count)),
+            BufferBindingEntry(1, destination, 0, GetByteSize(count)),
+            params,
+            BufferBindingEntry(3, m_RadixOffsets, 0, GetByteSize(histogramCount)),
+        });
+        Dispatch(pass, m_RadixScatter, scatterGroup, groups);
+    }
+
+    wgpuComputePassEncoderEnd(pass);
+}
+
+void ComputeKernels::Compact(WGPUCommandEncoder encoder, WGPUBuffer values, WGPUBuffer flags, uint32_t count, WGPUBuffer output, WGPUBuffer outputCount) {
+    if (count == 0) {
+        wgpuCommandEncoderClearBuffer(encoder, outputCount, 0, sizeof(uint32_t));
+        return;
+    }
+    if (!Reserve(count)) {
+        return;
+    }
+
+    ComputePassEncoderHandle pass(BeginPass(encoder, "Compact"));
+
+    RecordScan(pass, flags, m_CompactPositions, count, m_ScanFlagsExclusive, 0);
+
+    BindGroupHandle bindGroup = CreateBindGroup(m_Device, m_CompactLayout, "Compact bind group", {
+        BufferBindingEntry(0, values, 0, GetByteSize(count)),
+        BufferBindingEntry(1, flags, 0, GetByteSize(count)),
+        BufferBindingEntry(2, m_CompactPositions, 0, GetByteSize(count)),
+        BufferBindingEntry(3, output, 0, GetByteSize(count)),
+        BufferBindingEntry(4, outputCount, 0, sizeof(uint32_t)),
+    });
+    Dispatch(pass, m_CompactScatter, bindGroup, DivideRoundUp(count, BlockSize));
+
+    wgpuComputePassEncoderEnd(pass);
+}
+
+bool ComputeKernels::CheckCount(uint32_t count, const char *kernel) {
+    if (count > m_MaxCount) {
+        std::cerr << kernel << ": " << count << " elements is more than the " << m_MaxCount << " the device can process at once!\n";
+        return false;
+    }
+    return true;
+}
+
+WGPUComputePassEncoder ComputeKernels::BeginPass(WGPUCommandEncoder encoder, const char *label) const {
+    WGPUComputePassDescriptor passDesc = {};
+    passDesc.nextInChain = nullptr;
+    passDesc.label = label;
+    passDesc.timestampWrites = nullptr;
+    return wgpuCommandEncoderBeginComputePass(encoder, &passDesc);
+}
+
+void ComputeKernels::RecordScan(WGPUComputePassEncoder pass, WGPUBuffer input, WGPUBuffer output, uint32_t count, WGPUComputePipeline pipeline, uint32_t level) {
+    const uint32_t groups = DivideRoundUp(count, BlockSize);
+    const ScanLevel &scratch = m_ScanLevels[level];
+
+    BindGroupHandle scanGroup = CreateBindGroup(m_Device, m_ScanLayout, "Scan bind group", {
+        BufferBindingEntry(0, input, 0, GetByteSize(count)),
+        BufferBindingEntry(1, output, 0, GetByteSize(count)),
+        BufferBindingEntry(2, scratch.Sums, 0, GetByteSize(groups)),
+    });
+    Dispatch(pass, pipeline, scanGroup, groups);
+
+    if (groups == 1) {
+        return;
+    }
+
+    // Where each block starts, which is then added to all of its values.
+    RecordScan(pass, scratch.Sums, scratch.Offsets, groups, m_ScanExclusive, level + 1);
+
+    BindGroupHandle addGroup = CreateBindGroup(m_Device, m_ReduceLayout, "Scan offsets bind group", {
+        BufferBindingEntry(0, scratch.Offsets, 0, GetByteSize(groups)),
+        BufferBindingEntry(1, output, 0, GetByteSize(count)),
+    });
+    Dispatch(pass, m_AddBlockOffsets, addGroup, groups);
+}
+
+BufferHandle ComputeKernels::CreateScratchBuffer(const char *label, uint32_t count) const {
+    WGPUBufferDescriptor bufferDesc = {};
+    bufferDesc.nextInChain = nullptr;
+    bufferDesc.label = label;
+    bufferDesc.usage = WGPUBufferUsage_Storage | WGPUBufferUsage_CopySrc | WGPUBufferUsage_CopyDst;
+    bufferDesc.size = GetByteSize(std::max(count, 1u));
+    bufferDesc.mappedAtCreation = false;
+    return m_Memory->CreateBuffer(m_Device, bufferDesc, GpuMemoryCategory_Storage);
+}
+
+void ComputeKernels::ReleaseScratch() {
+    if (m_Memory) {
+        for (ScanLevel &level : m_ScanLevels) {
+            m_Memory->Release(level.Sums);
+            m_Memory->Release(level.Offsets);
+        }
+        m_Memory->Release(m_ReducePartials[0]);
+        m_Memory->Release(m_ReducePartials[1]);
+        m_Memory->Release(m_RadixKeys);
+        m_Memory->Release(m_RadixHistograms);
+        m_Memory->Release(m_RadixOffsets);
+        m_Memory->Release(m_CompactPositions);
+    }
+    m_ScanLevels.clear();
+    m_Capacity = 0;
+}
+
+uint32_t ReduceReference(const std::vector<uint32_t> &input) {
+    uint32_t sum = 0;
+    for (uint32_t value : input) {
+        sum += value;
+    }
+    return sum;
+}
+
+std::vector<uint32_t> ScanReference(const std::vector<uint32_t> &input, ScanType type) {
+    std::vector<uint32_t> output(input.size());
+    uint32_t sum = 0;
+    for (size_t i = 0; i < input.size(); ++i) {
+        if (type == ScanType_Exclusive) {
+            output[i] = sum;
+            sum += input[i];
+        } else {
+            sum += input[i];
+            output[i] = sum;
+        }
+    }
+    return output;
+}
+
+std::vector<uint32_t> RadixSortReference(const std::vector<uint32_t> &keys) {
+    std::vector<uint32_t> sorted = keys;
+    std::sort(sorted.begin(), sorted.end());
+    return sorted;
+}
+
+std::vector<uint32_t> CompactReference(const std::vector<uint32_t> &values, const std::vector<uint32_t> &flags) {
+    std::vector<uint32_t> output;
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (flags[i] != 0) {
+            output.push_back(values[i]);
+        }
+    }
+    return output;
+}
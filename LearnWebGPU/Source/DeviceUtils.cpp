@@ -4,77 +4,23 @@
 
 #include <magic_enum/magic_enum.hpp>
 
-#include <cassert>
 #include <iostream>
 #include <vector>
 
+#include "Async.hpp"
+
 WGPUAdapter RequestAdapterSync(WGPUInstance instance, WGPURequestAdapterOptions const *options) {
-    // A simple structure holding the local information shared with the
-    // onAdapterRequestEnded callback.
-    struct UserData {
-        WGPUAdapter Adapter = nullptr;
-        bool RequestEnded = false;
-    };
-    UserData userData;
-
-    // Callback called by wgpuInstanceRequestAdapter when the request returns.
-    // This is a C++ lambda function, but could be any function defined in the
-    // global scope. It must be non-capturing (the brackets [] are empty) so
-    // that it behaves like a regular C function pointer, which is what
-    // wgpuInstanceRequestAdapter expects (WebGPU being a C API). The workaround
-    // is to convey what we want to capture through the pUserData pointer,
-    // provided as the last argument of wgpuInstanceRequestAdapter and received
-    // by the callback as its last argument.
-    auto onAdapterRequestEnded = [](WGPURequestAdapterStatus status, WGPUAdapter adapter, char const *message, void *pUserData) {
-        auto &[Adapter, RequestEnded] = *static_cast<UserData *>(pUserData);
-        if (status == WGPURequestAdapterStatus_Success) {
-            Adapter = adapter;
-        } else {
-            std::cerr << "Could not get WebGPU adapter: " << message << '\n';
-        }
-        RequestEnded = true;
-    };
-
-    // Call to the WebGPU request adapter procedure.
-    wgpuInstanceRequestAdapter(
-        instance /* equivalent of navigator.gpu */,
-        options,
-        onAdapterRequestEnded,
-        (void *) &userData
-        );
-
-    assert(userData.RequestEnded);
-
-    return userData.Adapter;
+    // The callback may fire within wgpuInstanceRequestAdapter or later, from
+    // wgpuInstanceProcessEvents: the pump handles both.
+    EventPump pump;
+    pump.Initialize(instance);
+    return pump.Run(RequestAdapterAsync(pump, instance, options));
 }
 
-WGPUDevice RequestDeviceSync(WGPUAdapter adapter, WGPUDeviceDescriptor const *descriptor) {
-    struct UserData {
-        WGPUDevice Device = nullptr;
-        bool RequestEnded = false;
-    };
-    UserData userData;
-
-    auto onDeviceRequestEnded = [](WGPURequestDeviceStatus status, WGPUDevice device, char const *message, void *pUserData) {
-        UserData &requestData = *static_cast<UserData *>(pUserData);
-        if (status == WGPURequestDeviceStatus_Success) {
-            requestData.Device = device;
-        } else {
-            std::cerr << "Could not get WebGPU device: " << message << '\n';
-        }
-        requestData.RequestEnded = true;
-    };
-
-    wgpuAdapterRequestDevice(
-        adapter,
-        descriptor,
-        onDeviceRequestEnded,
-        &userData
-    );
-
-    assert(userData.RequestEnded);
-
-    return userData.Device;
+WGPUDevice RequestDeviceSync(WGPUInstance instance, WGPUAdapter adapter, WGPUDeviceDescriptor const *descriptor) {
+    EventPump pump;
+    pump.Initialize(instance);
+    return pump.Run(RequestDeviceAsync(pump, adapter, descriptor));
 }
 
 void InspectAdapter(WGPUAdapter adapter) {
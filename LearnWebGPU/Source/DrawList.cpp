@@ -0,0 +1,224 @@
+#include "DrawList.hpp"
+
+#include <webgpu/webgpu.h>
+#include <webgpu/wgpu.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <iostream>
+
+namespace {
+    uint64_t MakeSortKey(float depth, uint32_t index) {
+        // The bits of a non-negative float compare like the float itself.
+        const uint32_t depthBits = std::bit_cast<uint32_t>(std::max(depth, 0.0f));
+        return (uint64_t{ depthBits } << 32) | index;
+    }
+}
+
+bool DrawList::Initialize(WGPUDevice device, FrameController &frameController, uint32_t maxDraws) {
+    m_Device = device;
+    m_FrameController = &frameController;
+    m_MaxDraws = maxDraws;
+
+    // Without indirect first instance, the instance index of every indirect
+    // draw would start at 0 and all of them would read the first entry.
+    m_MultiDrawIndirect = wgpuDeviceHasFeature(device, static_cast<WGPUFeatureName>(WGPUNativeFeature_MultiDrawIndirect))
+        && wgpuDeviceHasFeature(device, WGPUFeatureName_IndirectFirstInstance);
+
+    // One read-only storage buffer for the vertex stage. Its offset changes
+    // every frame, so it is dynamic and the bind group is created only once.
+    WGPUBindGroupLayoutEntry layoutEntry = {};
+    layoutEntry.binding = 0;
+    layoutEntry.visibility = WGPUShaderStage_Vertex;
+    layoutEntry.buffer.type = WGPUBufferBindingType_ReadOnlyStorage;
+    layoutEntry.buffer.hasDynamicOffset = true;
+    layoutEntry.buffer.minBindingSize = sizeof(DrawData);
+
+    WGPUBindGroupLayoutDescriptor layoutDesc = {};
+    layoutDesc.nextInChain = nullptr;
+    layoutDesc.label = "Draw data bind group layout";
+    layoutDesc.entryCount = 1;
+    layoutDesc.entries = &layoutEntry;
+    m_BindGroupLayout.Reset(wgpuDeviceCreateBindGroupLayout(device, &layoutDesc));
+
+    WGPUBindGroupEntry entry = {};
+    entry.binding = 0;
+    entry.buffer = frameController.GetUploadBuffer();
+    entry.offset = 0;
+    entry.size = GetBindingSize(m_MaxDraws);
+
+    WGPUBindGroupDescriptor bindGroupDesc = {};
+    bindGroupDesc.nextInChain = nullptr;
+    bindGroupDesc.label = "Draw data bind group";
+    bindGroupDesc.layout = m_BindGroupLayout;
+    bindGroupDesc.entryCount = 1;
+    bindGroupDesc.entries = &entry;
+    m_BindGroup.Reset(wgpuDeviceCreateBindGroup(device, &bindGroupDesc));
+
+    if (!m_BindGroupLayout || !m_BindGroup) {
+        std::cerr << "Could not create the draw list bind group!\n";
+        return false;
+    }
+
+    m_Meshes.reserve(m_MaxDraws);
+    m_Data.reserve(m_MaxDraws);
+    m_Order.reserve(m_MaxDraws);
+    m_Commands.reserve(m_MaxDraws);
+
+    return true;
+}
+
+void DrawList::Terminate() {
+    m_BindGroup.Reset();
+    m_BindGroupLayout.Reset();
+    Clear();
+}
+
+void DrawList::Clear() {
+    m_Meshes.clear();
+    m_Data.clear();
+    m_Order.clear();
+    m_Sorted = false;
+    m_Uploaded = false;
+    m_Dropped = 0;
+}
+
+bool DrawList::Add(GeometryHandle mesh, const DrawData &data) {
+    if (m_Data.size() >= m_MaxDraws) {
+        if (!m_OverflowReported) {
+            std::cerr << "Draw list is full (" << m_MaxDraws << " draws), the draws that do not fit are dropped!\n";
+            m_OverflowReported = true;
+        }
+        ++m_Dropped;
+        return false;
+    }
+
+    const auto index = static_cast<uint32_t>(m_Data.size());
+    m_Meshes.push_back(mesh);
+    m_Data.push_back(data);
+    m_Order.push_back(MakeSortKey(data.Transform(2, 3), index));
+    m_Uploaded = false;
+    return true;
+}
+
+void DrawList::SortFrontToBack() {
+    // Ties keep submission order thanks to the index in the low bits.
+    std::sort(m_Order.begin(), m_Order.end());
+    m_Sorted = true;
+    m_Uploaded = false;
+}
+
+void DrawList::Submit(WGPURenderPassEncoder renderPass, const GeometryPool &geometryPool) {
+    if (Upload(geometryPool)) {
+        Record(renderPass, geometryPool);
+    }
+}
+
+bool DrawList::Upload(const GeometryPool &geometryPool) {
+    m_Stats = {};
+    m_Stats.Draws = GetDrawCount();
+    m_Stats.Dropped = m_Dropped;
+    m_Stats.Sorted = m_Sorted;
+    m_Commands.clear();
+    m_Uploaded = false;
+
+    if (m_Data.empty()) {
+        return false;
+    }
+
+    // Always carve the full binding size, so that the dynamic offset plus
+    // the binding size never goes past the end of the upload buffer.
+    const FrameAllocation allocation = m_FrameController->Allocate(GetBindingSize(m_MaxDraws));
+    if (!allocation.Data) {
+        std::cerr << "Out of frame memory for draw data!\n";
+        return false;
+    }
+
+    // Write the data in draw order, so that the instance index of the i-th
+    // draw is simply i.
+    auto *data = static_cast<DrawData *>(allocation.Data);
+    for (size_t i = 0; i < m_Order.size(); ++i) {
+        data[i] = m_Data[static_cast<uint32_t>(m_Order[i])];
+    }
+    m_DynamicOffset = static_cast<uint32_t>(allocation.Offset);
+
+    // Consecutive draws of the same mesh become a single instanced draw.
+    // Instances are rasterized in order, so this keeps the sort order.
+    uint32_t first = 0;
+    while (first < m_Order.size()) {
+        const GeometryHandle mesh = m_Meshes[static_cast<uint32_t>(m_Order[first])];
+        uint32_t last = first + 1;
+        while (last < m_Order.size() && m_Meshes[static_cast<uint32_t>(m_Order[last])] == mesh) {
+            ++last;
+        }
+
+        DrawCommand command;
+        command.Mesh = mesh;
+        command.Page = geometryPool.GetPage(mesh);
+        command.FirstInstance = first;
+        command.InstanceCount = last - first;
+        m_Commands.push_back(command);
+        first = last;
+    }
+    m_Stats.DrawCalls = static_cast<uint32_t>(m_Commands.size());
+
+    if (m_MultiDrawIndirect) {
+        const FrameAllocation arguments = m_FrameController->Allocate(m_Commands.size() * sizeof(DrawIndexedIndirectArgs));
+        if (!arguments.Data) {
+            std::cerr << "Out of frame memory for indirect draws!\n";
+            return false;
+        }
+
+        auto *args = static_cast<DrawIndexedIndirectArgs *>(arguments.Data);
+        for (size_t i = 0; i < m_Commands.size(); ++i) {
+            const DrawCommand &command = m_Commands[i];
+            const GeometryRange &range = geometryPool.GetRange(command.Mesh);
+            args[i].IndexCount = range.IndexCount;
+            args[i].InstanceCount = command.InstanceCount;
+            args[i].FirstIndex = range.FirstIndex;
+            args[i].BaseVertex = static_cast<int32_t>(range.BaseVertex);
+            args[i].FirstInstance = command.FirstInstance;
+        }
+        m_IndirectBuffer = arguments.Buffer;
+        m_IndirectOffset = arguments.Offset;
+    }
+
+    m_Uploaded = true;
+    return true;
+}
+
+void DrawList::Record(WGPURenderPassEncoder renderPass, const GeometryPool &geometryPool) {
+    if (!m_Uploaded) {
+        return;
+    }
+
+    wgpuRenderPassEncoderSetBindGroup(renderPass, 0, m_BindGroup, 1, &m_DynamicOffset);
+
+    // Pages only change between meshes too big to share one: each run of
+    // draws from the same page is one bind, then either consecutive
+    // indexed draws or a single indirect call.
+    size_t first = 0;
+    uint32_t multiDrawCalls = 0;
+    while (first < m_Commands.size()) {
+        const uint32_t page = m_Commands[first].Page;
+        size_t last = first + 1;
+        while (last < m_Commands.size() && m_Commands[last].Page == page) {
+            ++last;
+        }
+
+        geometryPool.Bind(renderPass, page);
+        if (m_MultiDrawIndirect) {
+            const uint64_t offset = m_IndirectOffset + first * sizeof(DrawIndexedIndirectArgs);
+            wgpuRenderPassEncoderMultiDrawIndexedIndirect(renderPass, m_IndirectBuffer, offset, static_cast<uint32_t>(last - first));
+            ++multiDrawCalls;
+        } else {
+            for (size_t i = first; i < last; ++i) {
+                geometryPool.Draw(renderPass, m_Commands[i].Mesh, m_Commands[i].InstanceCount, m_Commands[i].FirstInstance);
+            }
+        }
+        first = last;
+    }
+    // The same for every pass the list is recorded into.
+    m_Stats.MultiDrawCalls = multiDrawCalls;
+}
@@ -0,0 +1,91 @@
+#include "DynamicResolution.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+void DynamicResolution::Initialize(const DynamicResolutionSettings &settings) {
+    m_Settings = settings;
+    m_Scale = settings.MaxScale;
+    m_SmoothedSeconds = 0.0;
+    m_HasSample = false;
+    m_Cooldown = 0;
+
+    m_Stats = {};
+    m_Stats.Scale = m_Scale;
+    m_Stats.LowestScale = m_Scale;
+}
+
+bool DynamicResolution::AddSample(double gpuSeconds) {
+    ++m_Stats.Samples;
+    if (gpuSeconds > m_Settings.TargetSeconds) {
+        ++m_Stats.SamplesOverBudget;
+    }
+
+    if (m_Cooldown > 0) {
+        --m_Cooldown;
+        return false;
+    }
+
+    m_SmoothedSeconds = m_HasSample ? m_SmoothedSeconds + m_Settings.Smoothing * (gpuSeconds - m_SmoothedSeconds) : gpuSeconds;
+    m_HasSample = true;
+    m_Stats.SmoothedSeconds = m_SmoothedSeconds;
+
+    const double upper = m_Settings.TargetSeconds * m_Settings.UpperThreshold;
+    const double lower = m_Settings.TargetSeconds * m_Settings.LowerThreshold;
+    if (m_SmoothedSeconds >= lower && m_SmoothedSeconds <= upper) {
+        return false;
+    }
+
+    const float step = m_Settings.ScaleStep;
+    float scale = m_Scale;
+    if (m_SmoothedSeconds > upper) {
+        // Aim for the middle of the band, rounding down so that we end up
+        // inside of it rather than just above.
+        const double aim = 0.5 * (upper + lower);
+        const auto ideal = static_cast<float>(m_Scale * std::sqrt(aim / m_SmoothedSeconds));
+        scale = std::min(std::floor(ideal / step) * step, m_Scale - step);
+    } else {
+        scale = m_Scale + step;
+    }
+    // Snap to the grid again so that repeated steps do not drift.
+    scale = std::clamp(std::round(scale / step) * step, m_Settings.MinScale, m_Settings.MaxScale);
+
+    if (std::abs(scale - m_Scale) < 0.5f * step) {
+        return false;
+    }
+
+    std::cout << "Dynamic resolution: " << m_Scale * 100.0f << "% -> " << scale * 100.0f << "% (GPU "
+              << m_SmoothedSeconds * 1000.0 << " ms, target " << m_Settings.TargetSeconds * 1000.0 << " ms)\n";
+
+    if (scale > m_Scale) {
+        ++m_Stats.Increases;
+    } else {
+        ++m_Stats.Decreases;
+    }
+    m_Scale = scale;
+    m_Stats.Scale = scale;
+    m_Stats.LowestScale = std::min(m_Stats.LowestScale, scale);
+
+    // Start measuring the new scale from scratch.
+    m_HasSample = false;
+    m_Cooldown = m_Settings.CooldownSamples;
+    return true;
+}
+
+void DynamicResolution::GetRenderSize(uint32_t outputWidth, uint32_t outputHeight, uint32_t &width, uint32_t &height) const {
+    width = std::max(1u, static_cast<uint32_t>(std::lround(outputWidth * m_Scale)));
+    height = std::max(1u, static_cast<uint32_t>(std::lround(outputHeight * m_Scale)));
+    width = std::min(width, outputWidth);
+    height = std::min(height, outputHeight);
+}
+
+void PrintDynamicResolutionStats(const DynamicResolutionStats &stats, const DynamicResolutionSettings &settings) {
+    std::cout << "Dynamic resolution:\n";
+    std::cout << " - target: " << settings.TargetSeconds * 1000.0 << " ms, scale between "
+              << settings.MinScale * 100.0f << "% and " << settings.MaxScale * 100.0f << "%\n";
+    std::cout << " - samples: " << stats.Samples << " (" << stats.SamplesOverBudget << " over budget)\n";
+    std::cout << " - scale: " << stats.Scale * 100.0f << "% (lowest " << stats.LowestScale * 100.0f << "%), "
+              << stats.Decreases << " decreases, " << stats.Increases << " increases\n";
+    std::cout << " - smoothed GPU time: " << stats.SmoothedSeconds * 1000.0 << " ms\n";
+}
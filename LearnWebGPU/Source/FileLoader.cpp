@@ -1,11 +1,13 @@
 ﻿#include "FileLoader.hpp"
 
 #include <filesystem>
+#include <cstdlib>
 #include <fstream>
+#include <limits>
 #include <sstream>
 #include <string>
 
-bool LoadGeometry(const fs::path& path, std::vector<float>& pointData, std::vector<uint16_t>& indexData) {
+bool LoadGeometry(const fs::path& path, std::vector<float>& pointData, std::vector<uint32_t>& indexData) {
     std::ifstream file(path);
     if (!file.is_open()) {
         return false;
@@ -22,7 +24,7 @@ bool LoadGeometry(const fs::path& path, std::vector<float>& pointData, std::vect
     Section currentSection = Section::None;
 
     float value;
-    uint16_t index;
+    uint32_t index;
     std::string line;
     while (!file.eof()) {
         getline(file, line);
@@ -61,25 +63,99 @@ bool LoadGeometry(const fs::path& path, std::vector<float>& pointData, std::vect
     return true;
 }
 
-WGPUShaderModule LoadShaderModule(const fs::path &path, WGPUDevice device) {
+bool LoadTextFile(const fs::path &path, std::string &text) {
     std::ifstream file(path);
     if (!file.is_open()) {
-        return nullptr;
+        return false;
     }
     file.seekg(0, std::ios::end);
     size_t size = file.tellg();
-    std::string shaderSource(size, ' ');
+    text.assign(size, ' ');
     file.seekg(0);
-    file.read(shaderSource.data(), size);
+    file.read(text.data(), size);
+    // In text mode, line ending conversions may have made the file shorter
+    // than what tellg() reported.
+    text.resize(file.gcount());
+    return true;
+}
 
+WGPUShaderModule CreateShaderModule(const std::string &source, WGPUDevice device, const char *label) {
     WGPUShaderModuleWGSLDescriptor shaderCodeDesc{};
     shaderCodeDesc.chain.next = nullptr;
     shaderCodeDesc.chain.sType = WGPUSType_ShaderModuleWGSLDescriptor;
-    shaderCodeDesc.code = shaderSource.c_str();
+    shaderCodeDesc.code = source.c_str();
     WGPUShaderModuleDescriptor shaderDesc{};
     shaderDesc.nextInChain = nullptr;
+    shaderDesc.label = label;
     shaderDesc.hintCount = 0;
     shaderDesc.hints = nullptr;
     shaderDesc.nextInChain = &shaderCodeDesc.chain;
     return wgpuDeviceCreateShaderModule(device, &shaderDesc);
 }
+
+bool SaveImagePPM(const fs::path &path, uint32_t width, uint32_t height, const uint8_t *pixels, bool bgra) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    file << "P6\n" << width << ' ' << height << "\n255\n";
+
+    std::vector<char> row(size_t{ width } * 3);
+    for (uint32_t y = 0; y < height; ++y) {
+        const uint8_t *source = pixels + size_t{ y } * width * 4;
+        for (uint32_t x = 0; x < width; ++x) {
+            row[x * 3 + 0] = static_cast<char>(source[x * 4 + (bgra ? 2 : 0)]);
+            row[x * 3 + 1] = static_cast<char>(source[x * 4 + 1]);
+            row[x * 3 + 2] = static_cast<char>(source[x * 4 + (bgra ? 0 : 2)]);
+        }
+        file.write(row.data(), static_cast<std::streamsize>(row.size()));
+    }
+    return static_cast<bool>(file);
+}
+
+bool LoadImagePPM(const fs::path &path, uint32_t &width, uint32_t &height, std::vector<uint8_t> &pixels) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    // The header is made of whitespace separated tokens, and may contain
+    // comments up to the end of their line.
+    std::string tokens[4];
+    for (std::string &token : tokens) {
+        file >> std::ws;
+        while (file.peek() == '#') {
+            file.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            file >> std::ws;
+        }
+        file >> token;
+    }
+    // A single whitespace character separates the header from the pixels.
+    file.get();
+
+    if (!file || tokens[0] != "P6" || tokens[3] != "255") {
+        return false;
+    }
+    width = static_cast<uint32_t>(std::strtoul(tokens[1].c_str(), nullptr, 10));
+    height = static_cast<uint32_t>(std::strtoul(tokens[2].c_str(), nullptr, 10));
+    if (width == 0 || height == 0) {
+        return false;
+    }
+
+    // Expand the texels in place, from the last one so that none is
+    // overwritten before it is read.
+    const size_t texelCount = size_t{ width } * height;
+    pixels.resize(texelCount * 4);
+    file.read(reinterpret_cast<char *>(pixels.data()), static_cast<std::streamsize>(texelCount * 3));
+    if (static_cast<size_t>(file.gcount()) != texelCount * 3) {
+        return false;
+    }
+    for (size_t i = texelCount; i-- > 0;) {
+        pixels[i * 4 + 3] = 255;
+        pixels[i * 4 + 2] = pixels[i * 3 + 2];
+        pixels[i * 4 + 1] = pixels[i * 3 + 1];
+        pixels[i * 4 + 0] = pixels[i * 3 + 0];
+    }
+    return true;
+}
@@ -0,0 +1,172 @@
+#include "FrameController.hpp"
+
+#include <webgpu/webgpu.h>
+#include <webgpu/wgpu.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+bool FrameController::Initialize(WGPUDevice device, WGPUQueue queue, EventPump &pump, GpuMemoryTracker &memory, uint32_t framesInFlight, uint64_t bytesPerFrame) {
+    assert(framesInFlight > 0);
+
+    m_Device = device;
+    m_Queue = queue;
+    m_Pump = &pump;
+    m_Memory = &memory;
+
+    WGPUSupportedLimits supportedLimits;
+    supportedLimits.nextInChain = nullptr;
+    if (wgpuDeviceGetLimits(device, &supportedLimits)) {
+        m_Alignment = std::max(supportedLimits.limits.minUniformBufferOffsetAlignment, supportedLimits.limits.minStorageBufferOffsetAlignment);
+    }
+
+    // Each slot gets its own aligned range of one shared upload buffer.
+    m_BytesPerFrame = (bytesPerFrame + m_Alignment - 1) / m_Alignment * m_Alignment;
+
+    m_Slots.clear();
+    m_Slots.resize(framesInFlight);
+    for (FrameSlot &slot : m_Slots) {
+        slot.Staging.resize(m_BytesPerFrame);
+    }
+
+    WGPUBufferDescriptor bufferDesc;
+    bufferDesc.nextInChain = nullptr;
+    bufferDesc.label = "Frame upload buffer";
+    // Also holds the arguments of indirect draws.
+    bufferDesc.usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Uniform | WGPUBufferUsage_Storage | WGPUBufferUsage_Indirect;
+    bufferDesc.size = m_BytesPerFrame * framesInFlight;
+    bufferDesc.mappedAtCreation = false;
+    m_UploadBuffer = memory.CreateBuffer(device, bufferDesc, GpuMemoryCategory_Uniform);
+
+    if (!m_UploadBuffer) {
+        std::cerr << "Could not create the frame upload buffer!\n";
+        return false;
+    }
+
+    m_FrameNumber = 1;
+    m_LastCompletedFrame = 0;
+    m_FrameBegun = false;
+    m_Stats = {};
+
+    return true;
+}
+
+void FrameController::Terminate() {
+    WaitIdle();
+
+    if (m_Memory) {
+        m_Memory->Release(m_UploadBuffer);
+    }
+    m_Slots.clear();
+}
+
+void FrameController::BeginFrame() {
+    if (m_FrameBegun) {
+        return;
+    }
+
+    FrameSlot &slot = CurrentSlot();
+    if (!slot.WorkDone.IsDone()) {
+        // The GPU may well be done already and just not have told us, so
+        // first collect pending callbacks without blocking.
+        m_Pump->Pump();
+    }
+    if (!slot.WorkDone.IsDone()) {
+        const Clock::time_point start = Clock::now();
+        WaitForFrame(slot);
+        ++m_Stats.Stalls;
+        m_Stats.StallSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    slot.FrameNumber = m_FrameNumber;
+    slot.UsedBytes = 0;
+    m_FrameBegun = true;
+}
+
+FrameAllocation FrameController::Allocate(uint64_t size) {
+    BeginFrame();
+
+    FrameSlot &slot = CurrentSlot();
+    const uint64_t offset = (slot.UsedBytes + m_Alignment - 1) / m_Alignment * m_Alignment;
+    if (offset + size > m_BytesPerFrame) {
+        std::cerr << "Frame upload memory exhausted (" << size << " bytes requested)!\n";
+        return {};
+    }
+    slot.UsedBytes = offset + size;
+
+    const uint64_t slotIndex = m_FrameNumber % m_Slots.size();
+
+    FrameAllocation allocation;
+    allocation.Buffer = m_UploadBuffer;
+    allocation.Offset = slotIndex * m_BytesPerFrame + offset;
+    allocation.Size = size;
+    allocation.Data = slot.Staging.data() + offset;
+    return allocation;
+}
+
+void FrameController::Submit(WGPUCommandBuffer commandBuffer) {
+    BeginFrame();
+
+    FrameSlot &slot = CurrentSlot();
+
+    // One upload for everything that was allocated this frame. Queue writes
+    // are ordered before the command buffer that follows them.
+    if (slot.UsedBytes > 0) {
+        const uint64_t slotIndex = m_FrameNumber % m_Slots.size();
+        const uint64_t size = (slot.UsedBytes + 3) & ~uint64_t{ 3 };
+        wgpuQueueWriteBuffer(m_Queue, m_UploadBuffer, slotIndex * m_BytesPerFrame, slot.Staging.data(), size);
+    }
+
+    slot.SubmissionIndex = wgpuQueueSubmitForIndex(m_Queue, 1, &commandBuffer);
+    slot.SubmitTime = Clock::now();
+
+    // BeginFrame() waited for the previous frame of the slot, its coroutine
+    // is done.
+    slot.WorkDone = TrackFrame(m_FrameNumber);
+    slot.WorkDone.Start();
+
+    ++m_Stats.SubmittedFrames;
+    ++m_FrameNumber;
+    m_FrameBegun = false;
+}
+
+void FrameController::WaitIdle() {
+    for (const FrameSlot &slot : m_Slots) {
+        if (!slot.WorkDone.IsDone()) {
+            WaitForFrame(slot);
+        }
+    }
+}
+
+Task<bool> FrameController::TrackFrame(uint64_t frameNumber) {
+    const WGPUQueueWorkDoneStatus status = co_await QueueWorkDoneAsync(*m_Pump, m_Queue);
+    if (status != WGPUQueueWorkDoneStatus_Success) {
+        std::cerr << "Frame " << frameNumber << " did not complete successfully (status " << status << ")\n";
+    }
+    if (frameNumber > m_LastCompletedFrame) {
+        const FrameSlot &slot = m_Slots[frameNumber % m_Slots.size()];
+        m_Stats.LastFrameLatencySeconds = std::chrono::duration<double>(Clock::now() - slot.SubmitTime).count();
+        m_Stats.CompletedFrames += frameNumber - m_LastCompletedFrame;
+        m_LastCompletedFrame = frameNumber;
+    }
+    co_return status == WGPUQueueWorkDoneStatus_Success;
+}
+
+void FrameController::WaitForFrame(const FrameSlot &slot) {
+    // Blocks until that submission is done, which fires the work-done
+    // callbacks of everything that completed, ours included.
+    m_Pump->WaitForSubmission(m_Device, m_Queue, slot.SubmissionIndex);
+    while (!slot.WorkDone.IsDone()) {
+        m_Pump->Wait();
+    }
+}
+
+void PrintFrameStats(const FrameStats &stats) {
+    std::cout << "Frames in flight:\n";
+    std::cout << " - submitted frames: " << stats.SubmittedFrames << '\n';
+    std::cout << " - completed frames: " << stats.CompletedFrames << '\n';
+    std::cout << " - stalls: " << stats.Stalls << " (" << stats.StallSeconds * 1000.0 << " ms total)\n";
+    std::cout << " - last frame latency: " << stats.LastFrameLatencySeconds * 1000.0 << " ms\n";
+}
@@ -0,0 +1,330 @@
+#include "FrustumCuller.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LEARNWEBGPU_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC lets any function use any intrinsic, GCC and Clang must be told which
+// functions may use instructions beyond the baseline of the build.
+#if defined(LEARNWEBGPU_X86) && !defined(_MSC_VER)
+#define LEARNWEBGPU_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define LEARNWEBGPU_TARGET_AVX2
+#endif
+
+namespace {
+    struct SphereArrays {
+        const float *CenterX;
+        const float *CenterY;
+        const float *CenterZ;
+        const float *Radius;
+    };
+
+    // Every kernel writes the indices of the visible spheres of [begin, end)
+    // to visible and returns how many there are.
+    using KernelFunction = uint32_t (*)(const SphereArrays &, const Frustum &, uint32_t begin, uint32_t end, uint32_t *visible);
+
+    uint32_t CullScalar(const SphereArrays &spheres, const Frustum &frustum, uint32_t begin, uint32_t end, uint32_t *visible) {
+        uint32_t count = 0;
+        for (uint32_t i = begin; i < end; ++i) {
+            bool inside = true;
+            for (const Plane &plane : frustum.Planes) {
+                const float distance = plane.Normal[0] * spheres.CenterX[i] + plane.Normal[1] * spheres.CenterY[i]
+                                     + plane.Normal[2] * spheres.CenterZ[i] + plane.Distance;
+                inside &= distance >= -spheres.Radius[i];
+            }
+            // Branchless: always write, only advance when visible.
+            visible[count] = i;
+            count += inside;
+        }
+        return count;
+    }
+
+#ifdef LEARNWEBGPU_X86
+    uint32_t CullSSE(const SphereArrays &spheres, const Frustum &frustum, uint32_t begin, uint32_t end, uint32_t *visible) {
+        __m128 normalX[6], normalY[6], normalZ[6], distance[6];
+        for (int p = 0; p < 6; ++p) {
+            normalX[p] = _mm_set1_ps(frustum.Planes[p].Normal[0]);
+            normalY[p] = _mm_set1_ps(frustum.Planes[p].Normal[1]);
+            normalZ[p] = _mm_set1_ps(frustum.Planes[p].Normal[2]);
+            distance[p] = _mm_set1_ps(frustum.Planes[p].Distance);
+        }
+        const __m128 signBit = _mm_set1_ps(-0.0f);
+
+        uint32_t count = 0;
+        uint32_t i = begin;
+        for (; i + 4 <= end; i += 4) {
+            const __m128 x = _mm_loadu_ps(spheres.CenterX + i);
+            const __m128 y = _mm_loadu_ps(spheres.CenterY + i);
+            const __m128 z = _mm_loadu_ps(spheres.CenterZ + i);
+            const __m128 negativeRadius = _mm_xor_ps(_mm_loadu_ps(spheres.Radius + i), signBit);
+
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (int p = 0; p < 6; ++p) {
+                __m128 d = _mm_add_ps(_mm_mul_ps(normalX[p], x), distance[p]);
+                d = _mm_add_ps(_mm_mul_ps(normalY[p], y), d);
+                d = _mm_add_ps(_mm_mul_ps(normalZ[p], z), d);
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(d, negativeRadius));
+            }
+
+            uint32_t mask = static_cast<uint32_t>(_mm_movemask_ps(inside));
+            while (mask) {
+                visible[count++] = i + std::countr_zero(mask);
+                mask &= mask - 1;
+            }
+        }
+
+        return count + CullScalar(spheres, frustum, i, end, visible + count);
+    }
+
+    // For each 8-bit mask, the lanes whose bit is set, packed at the front.
+    // Lets the AVX2 kernel compact its results without branches.
+    constexpr std::array<std::array<uint32_t, 8>, 256> MakeCompactionTable() {
+        std::array<std::array<uint32_t, 8>, 256> table{};
+        for (uint32_t mask = 0; mask < 256; ++mask) {
+            uint32_t count = 0;
+            for (uint32_t lane = 0; lane < 8; ++lane) {
+                if (mask & (1u << lane)) {
+                    table[mask][count++] = lane;
+                }
+            }
+        }
+        return table;
+    }
+
+    alignas(32) constexpr std::array<std::array<uint32_t, 8>, 256> CompactionTable = MakeCompactionTable();
+
+    LEARNWEBGPU_TARGET_AVX2
+    uint32_t CullAVX2(const SphereArrays &spheres, const Frustum &frustum, uint32_t begin, uint32_t end, uint32_t *visible) {
+        __m256 normalX[6], normalY[6], normalZ[6], distance[6];
+        for (int p = 0; p < 6; ++p) {
+            normalX[p] = _mm256_set1_ps(frustum.Planes[p].Normal[0]);
+            normalY[p] = _mm256_set1_ps(frustum.Planes[p].Normal[1]);
+            normalZ[p] = _mm256_set1_ps(frustum.Planes[p].Normal[2]);
+            distance[p] = _mm256_set1_ps(frustum.Planes[p].Distance);
+        }
+        const __m256 signBit = _mm256_set1_ps(-0.0f);
+        const __m256i laneIndices = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+        uint32_t count = 0;
+        uint32_t i = begin;
+        for (; i + 8 <= end; i += 8) {
+            const __m256 x = _mm256_loadu_ps(spheres.CenterX + i);
+            const __m256 y = _mm256_loadu_ps(spheres.CenterY + i);
+            const __m256 z = _mm256_loadu_ps(spheres.CenterZ + i);
+            const __m256 negativeRadius = _mm256_xor_ps(_mm256_loadu_ps(spheres.Radius + i), signBit);
+
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (int p = 0; p < 6; ++p) {
+                __m256 d = _mm256_fmadd_ps(normalX[p], x, distance[p]);
+                d = _mm256_fmadd_ps(normalY[p], y, d);
+                d = _mm256_fmadd_ps(normalZ[p], z, d);
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, negativeRadius, _CMP_GE_OQ));
+            }
+
+            // Pack the indices of the visible lanes at the front and store
+            // all 8; the ones past the visible count get overwritten next.
+            const auto mask = static_cast<uint32_t>(_mm256_movemask_ps(inside));
+            const __m256i permutation = _mm256_load_si256(reinterpret_cast<const __m256i *>(CompactionTable[mask].data()));
+            const __m256i indices = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(i)), laneIndices);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(visible + count), _mm256_permutevar8x32_epi32(indices, permutation));
+            count += std::popcount(mask);
+        }
+
+        return count + CullScalar(spheres, frustum, i, end, visible + count);
+    }
+
+    bool CpuSupportsAVX2() {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) {
+            return false;
+        }
+        __cpuid(info, 1);
+        const bool osSavesYmm = (info[2] & (1 << 27)) && (_xgetbv(0) & 0x6) == 0x6;
+        const bool fma = info[2] & (1 << 12);
+        __cpuidex(info, 7, 0);
+        const bool avx2 = info[1] & (1 << 5);
+        return osSavesYmm && fma && avx2;
+#else
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+    }
+#endif
+
+    KernelFunction GetKernelFunction(CullingKernel kernel) {
+        switch (kernel) {
+#ifdef LEARNWEBGPU_X86
+            case CullingKernel_SSE:
+                return CullSSE;
+            case CullingKernel_AVX2:
+                return CullAVX2;
+#endif
+            default:
+                return CullScalar;
+        }
+    }
+
+    Plane NormalizePlane(float a, float b, float c, float d) {
+        const float length = std::sqrt(a * a + b * b + c * c);
+        const float scale = length > 0.0f ? 1.0f / length : 0.0f;
+        return { { a * scale, b * scale, c * scale }, d * scale };
+    }
+}
+
+Frustum MakeFrustum(const float *m) {
+    // Rows of the matrix, stored column-major: row i is m[i], m[4 + i]...
+    auto row = [m](int i, int column) { return m[column * 4 + i]; };
+
+    Frustum frustum;
+    for (int side = 0; side < 2; ++side) {
+        const float sign = side == 0 ? 1.0f : -1.0f;
+        // w + x >= 0 (left), w - x >= 0 (right), and the same for y.
+        frustum.Planes[0 + side] = NormalizePlane(
+            row(3, 0) + sign * row(0, 0), row(3, 1) + sign * row(0, 1), row(3, 2) + sign * row(0, 2), row(3, 3) + sign * row(0, 3));
+        frustum.Planes[2 + side] = NormalizePlane(
+            row(3, 0) + sign * row(1, 0), row(3, 1) + sign * row(1, 1), row(3, 2) + sign * row(1, 2), row(3, 3) + sign * row(1, 3));
+    }
+    // z >= 0 (near) and w - z >= 0 (far).
+    frustum.Planes[4] = NormalizePlane(row(2, 0), row(2, 1), row(2, 2), row(2, 3));
+    frustum.Planes[5] = NormalizePlane(row(3, 0) - row(2, 0), row(3, 1) - row(2, 1), row(3, 2) - row(2, 2), row(3, 3) - row(2, 3));
+    return frustum;
+}
+
+bool IsCullingKernelSupported(CullingKernel kernel) {
+    switch (kernel) {
+        case CullingKernel_Scalar:
+            return true;
+#ifdef LEARNWEBGPU_X86
+        case CullingKernel_SSE:
+            // Part of the x86-64 baseline.
+            return true;
+        case CullingKernel_AVX2: {
+            static const bool supported = CpuSupportsAVX2();
+            return supported;
+        }
+#endif
+        default:
+            return false;
+    }
+}
+
+CullingKernel GetBestCullingKernel() {
+    if (IsCullingKernelSupported(CullingKernel_AVX2)) {
+        return CullingKernel_AVX2;
+    }
+    if (IsCullingKernelSupported(CullingKernel_SSE)) {
+        return CullingKernel_SSE;
+    }
+    return CullingKernel_Scalar;
+}
+
+const char *GetCullingKernelName(CullingKernel kernel) {
+    switch (kernel) {
+        case CullingKernel_Scalar: return "scalar";
+        case CullingKernel_SSE: return "SSE";
+        case CullingKernel_AVX2: return "AVX2";
+        default: return "unknown";
+    }
+}
+
+bool FrustumCuller::SetKernel(CullingKernel kernel) {
+    if (!IsCullingKernelSupported(kernel)) {
+        return false;
+    }
+    m_Kernel = kernel;
+    return true;
+}
+
+void FrustumCuller::Clear() {
+    m_CenterX.clear();
+    m_CenterY.clear();
+    m_CenterZ.clear();
+    m_Radius.clear();
+}
+
+void FrustumCuller::Reserve(uint32_t count) {
+    m_CenterX.reserve(count);
+    m_CenterY.reserve(count);
+    m_CenterZ.reserve(count);
+    m_Radius.reserve(count);
+}
+
+uint32_t FrustumCuller::Add(const BoundingSphere &sphere) {
+    const uint32_t index = GetCount();
+    m_CenterX.push_back(sphere.Center[0]);
+    m_CenterY.push_back(sphere.Center[1]);
+    m_CenterZ.push_back(sphere.Center[2]);
+    m_Radius.push_back(sphere.Radius);
+    return index;
+}
+
+void FrustumCuller::Set(uint32_t index, const BoundingSphere &sphere) {
+    m_CenterX[index] = sphere.Center[0];
+    m_CenterY[index] = sphere.Center[1];
+    m_CenterZ[index] = sphere.Center[2];
+    m_Radius[index] = sphere.Radius;
+}
+
+void FrustumCuller::Cull(const Frustum &frustum, std::vector<uint32_t> &visible) {
+    const auto start = std::chrono::steady_clock::now();
+
+    const uint32_t count = GetCount();
+    const SphereArrays spheres = { m_CenterX.data(), m_CenterY.data(), m_CenterZ.data(), m_Radius.data() };
+    const KernelFunction kernel = GetKernelFunction(m_Kernel);
+
+    const uint32_t chunkCount = (count + ChunkSize - 1) / ChunkSize;
+    constexpr uint32_t ChunkStride = ChunkSize + 8;
+    m_ChunkVisible.resize(size_t{ chunkCount } * ChunkStride);
+    m_ChunkCounts.resize(chunkCount);
+
+    auto cullChunks = [&](uint32_t firstChunk, uint32_t endChunk) {
+        for (uint32_t chunk = firstChunk; chunk < endChunk; ++chunk) {
+            const uint32_t begin = chunk * ChunkSize;
+            const uint32_t end = std::min(begin + ChunkSize, count);
+            m_ChunkCounts[chunk] = kernel(spheres, frustum, begin, end, m_ChunkVisible.data() + size_t{ chunk } * ChunkStride);
+        }
+    };
+
+    if (m_Workers && chunkCount > 1) {
+        m_Workers->ParallelFor(chunkCount, 1, cullChunks);
+    } else {
+        cullChunks(0, chunkCount);
+    }
+
+    // Concatenate the chunks, which keeps the indices sorted.
+    uint32_t visibleCount = 0;
+    for (uint32_t chunk = 0; chunk < chunkCount; ++chunk) {
+        visibleCount += m_ChunkCounts[chunk];
+    }
+    visible.resize(visibleCount);
+
+    uint32_t *output = visible.data();
+    for (uint32_t chunk = 0; chunk < chunkCount; ++chunk) {
+        std::memcpy(output, m_ChunkVisible.data() + size_t{ chunk } * ChunkStride, m_ChunkCounts[chunk] * sizeof(uint32_t));
+        output += m_ChunkCounts[chunk];
+    }
+
+    m_Stats.Tested = count;
+    m_Stats.Visible = visibleCount;
+    m_Stats.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void PrintCullingStats(const CullingStats &stats, CullingKernel kernel) {
+    std::cout << "Frustum culling (" << GetCullingKernelName(kernel) << "):\n";
+    std::cout << " - last frame: " << stats.Visible << " of " << stats.Tested << " objects visible, culled in "
+              << stats.Seconds * 1000.0 << " ms\n";
+}
@@ -0,0 +1,316 @@
+#include "GeometryPool.hpp"
+
+#include <webgpu/webgpu.h>
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <utility>
+
+namespace {
+    // Buffer offsets and sizes used by wgpuQueueWriteBuffer and
+    // wgpuCommandEncoderCopyBufferToBuffer must be multiples of 4 bytes, so
+    // index ranges always start and end on an even uint16_t index.
+    constexpr uint32_t IndexAlignment = 2;
+
+    uint32_t AlignIndexCount(uint32_t indexCount) {
+        return (indexCount + IndexAlignment - 1) & ~(IndexAlignment - 1);
+    }
+}
+
+bool GeometryPool::Initialize(WGPUDevice device, WGPUQueue queue, GpuMemoryTracker &memory, const GeometryPoolDescriptor &descriptor) {
+    assert(descriptor.VertexStride % 4 == 0);
+
+    m_Device = device;
+    m_Queue = queue;
+    m_Memory = &memory;
+    m_Descriptor = descriptor;
+    m_Descriptor.MaxPages = std::max(descriptor.MaxPages, 1u);
+
+    // The first page is created right away, the others on demand.
+    return AddPage();
+}
+
+void GeometryPool::Terminate() {
+    if (m_Memory) {
+        for (Page &page : m_Pages) {
+            m_Memory->Release(page.VertexBuffer);
+            m_Memory->Release(page.IndexBuffer);
+        }
+    }
+    m_Pages.clear();
+    m_Entries.clear();
+    m_FreeHandles.clear();
+}
+
+GeometryHandle GeometryPool::Allocate(uint32_t vertexCount, uint32_t indexCount) {
+    if (vertexCount > m_Descriptor.VertexCapacity || AlignIndexCount(indexCount) > AlignIndexCount(m_Descriptor.IndexCapacity)) {
+        std::cerr << "Mesh does not fit in a geometry pool page (" << vertexCount << " vertices, " << indexCount
+                  << " indices requested), it must be split!\n";
+        return InvalidGeometryHandle;
+    }
+
+    // First fit over the pages, then a new page if allowed.
+    RangeAllocator::Allocation vertexAllocation;
+    RangeAllocator::Allocation indexAllocation;
+    uint32_t pageIndex = 0;
+    for (;; ++pageIndex) {
+        if (pageIndex == m_Pages.size()) {
+            if (m_Pages.size() == m_Descriptor.MaxPages) {
+                std::cerr << "Geometry pool is out of space (" << vertexCount << " vertices, " << indexCount
+                          << " indices requested, " << m_Pages.size() << " pages)!\n";
+                return InvalidGeometryHandle;
+            }
+            if (!AddPage()) {
+                return InvalidGeometryHandle;
+            }
+        }
+
+        Page &page = m_Pages[pageIndex];
+        vertexAllocation = page.VertexAllocator.Allocate(vertexCount);
+        if (!vertexAllocation.IsValid()) {
+            continue;
+        }
+        indexAllocation = page.IndexAllocator.Allocate(AlignIndexCount(indexCount), IndexAlignment);
+        if (!indexAllocation.IsValid()) {
+            page.VertexAllocator.Free(vertexAllocation);
+            continue;
+        }
+        break;
+    }
+
+    GeometryHandle handle;
+    if (!m_FreeHandles.empty()) {
+        handle = m_FreeHandles.back();
+        m_FreeHandles.pop_back();
+    } else {
+        handle = static_cast<GeometryHandle>(m_Entries.size());
+        m_Entries.emplace_back();
+    }
+
+    Entry &entry = m_Entries[handle];
+    entry.VertexAllocation = vertexAllocation;
+    entry.IndexAllocation = indexAllocation;
+    entry.Range.BaseVertex = vertexAllocation.Offset;
+    entry.Range.VertexCount = vertexCount;
+    entry.Range.FirstIndex = indexAllocation.Offset;
+    entry.Range.IndexCount = indexCount;
+    entry.Page = pageIndex;
+    entry.Alive = true;
+
+    return handle;
+}
+
+GeometryHandle GeometryPool::Add(const void *vertexData, uint32_t vertexCount, const uint16_t *indexData, uint32_t indexCount) {
+    const GeometryHandle handle = Allocate(vertexCount, indexCount);
+    if (handle != InvalidGeometryHandle) {
+        Upload(handle, vertexData, indexData);
+    }
+    return handle;
+}
+
+void GeometryPool::Upload(GeometryHandle handle, const void *vertexData, const uint16_t *indexData) const {
+    const GeometryRange &range = GetRange(handle);
+    const Page &page = m_Pages[m_Entries[handle].Page];
+
+    wgpuQueueWriteBuffer(
+        m_Queue,
+        page.VertexBuffer,
+        uint64_t{ range.BaseVertex } * m_Descriptor.VertexStride,
+        vertexData,
+        size_t{ range.VertexCount } * m_Descriptor.VertexStride
+    );
+
+    if (range.IndexCount % IndexAlignment == 0) {
+        wgpuQueueWriteBuffer(m_Queue, page.IndexBuffer, uint64_t{ range.FirstIndex } * sizeof(uint16_t), indexData, range.IndexCount * sizeof(uint16_t));
+    } else {
+        // Pad odd index counts so that the write size stays a multiple of 4.
+        std::vector<uint16_t> padded(indexData, indexData + range.IndexCount);
+        padded.resize(AlignIndexCount(range.IndexCount), 0);
+        wgpuQueueWriteBuffer(m_Queue, page.IndexBuffer, uint64_t{ range.FirstIndex } * sizeof(uint16_t), padded.data(), padded.size() * sizeof(uint16_t));
+    }
+}
+
+void GeometryPool::Free(GeometryHandle handle) {
+    assert(handle < m_Entries.size() && m_Entries[handle].Alive);
+
+    Entry &entry = m_Entries[handle];
+    m_Pages[entry.Page].VertexAllocator.Free(entry.VertexAllocation);
+    m_Pages[entry.Page].IndexAllocator.Free(entry.IndexAllocation);
+    entry = Entry{};
+
+    m_FreeHandles.push_back(handle);
+}
+
+const GeometryRange &GeometryPool::GetRange(GeometryHandle handle) const {
+    assert(handle < m_Entries.size() && m_Entries[handle].Alive);
+    return m_Entries[handle].Range;
+}
+
+uint32_t GeometryPool::GetPage(GeometryHandle handle) const {
+    assert(handle < m_Entries.size() && m_Entries[handle].Alive);
+    return m_Entries[handle].Page;
+}
+
+void GeometryPool::Bind(WGPURenderPassEncoder renderPass, uint32_t page, uint32_t slot) const {
+    const Page &bound = m_Pages[page];
+    wgpuRenderPassEncoderSetVertexBuffer(renderPass, slot, bound.VertexBuffer, 0, wgpuBufferGetSize(bound.VertexBuffer));
+    wgpuRenderPassEncoderSetIndexBuffer(renderPass, bound.IndexBuffer, WGPUIndexFormat_Uint16, 0, wgpuBufferGetSize(bound.IndexBuffer));
+}
+
+void GeometryPool::Draw(WGPURenderPassEncoder renderPass, GeometryHandle handle, uint32_t instanceCount, uint32_t firstInstance) const {
+    const GeometryRange &range = GetRange(handle);
+    wgpuRenderPassEncoderDrawIndexed(
+        renderPass,
+        range.IndexCount,
+        instanceCount,
+        range.FirstIndex,
+        static_cast<int32_t>(range.BaseVertex),
+        firstInstance
+    );
+}
+
+bool GeometryPool::Defragment(WGPUCommandEncoder encoder) {
+    bool compacted = false;
+    for (uint32_t page = 0; page < m_Pages.size(); ++page) {
+        compacted = DefragmentPage(encoder, page) || compacted;
+    }
+    return compacted;
+}
+
+bool GeometryPool::DefragmentPage(WGPUCommandEncoder encoder, uint32_t pageIndex) {
+    Page &page = m_Pages[pageIndex];
+    const RangeAllocator::Stats vertexStats = page.VertexAllocator.GetStats();
+    const RangeAllocator::Stats indexStats = page.IndexAllocator.GetStats();
+    if (vertexStats.FreeRangeCount <= 1 && indexStats.FreeRangeCount <= 1) {
+        return false;
+    }
+
+    // WebGPU does not allow overlapping copies within a buffer, so we compact
+    // into brand new buffers rather than shuffling ranges in place.
+    // Both copies of the page are alive until the swap below, which the
+    // memory budget must allow for.
+    BufferHandle vertexBuffer, indexBuffer;
+    CreateBuffers(vertexBuffer, indexBuffer);
+    if (!vertexBuffer || !indexBuffer) {
+        std::cerr << "Could not create buffers to defragment the geometry pool!\n";
+        m_Memory->Release(vertexBuffer);
+        m_Memory->Release(indexBuffer);
+        return false;
+    }
+
+    // Reallocating in address order from empty allocators packs the ranges
+    // one after the other.
+    std::vector<GeometryHandle> order;
+    for (GeometryHandle handle = 0; handle < m_Entries.size(); ++handle) {
+        if (m_Entries[handle].Alive && m_Entries[handle].Page == pageIndex) {
+            order.push_back(handle);
+        }
+    }
+    std::sort(order.begin(), order.end(), [this](GeometryHandle a, GeometryHandle b) {
+        return m_Entries[a].VertexAllocation.Offset < m_Entries[b].VertexAllocation.Offset;
+    });
+
+    page.VertexAllocator.Reset(m_Descriptor.VertexCapacity);
+    page.IndexAllocator.Reset(AlignIndexCount(m_Descriptor.IndexCapacity));
+
+    for (GeometryHandle handle : order) {
+        Entry &entry = m_Entries[handle];
+        const uint32_t alignedIndexCount = AlignIndexCount(entry.Range.IndexCount);
+
+        entry.VertexAllocation = page.VertexAllocator.Allocate(entry.Range.VertexCount);
+        entry.IndexAllocation = page.IndexAllocator.Allocate(alignedIndexCount, IndexAlignment);
+        assert(entry.VertexAllocation.IsValid() && entry.IndexAllocation.IsValid());
+
+        const uint64_t vertexBytes = uint64_t{ entry.Range.VertexCount } * m_Descriptor.VertexStride;
+        if (vertexBytes > 0) {
+            wgpuCommandEncoderCopyBufferToBuffer(
+                encoder,
+                page.VertexBuffer, uint64_t{ entry.Range.BaseVertex } * m_Descriptor.VertexStride,
+                vertexBuffer, uint64_t{ entry.VertexAllocation.Offset } * m_Descriptor.VertexStride,
+                vertexBytes
+            );
+        }
+
+        const uint64_t indexBytes = uint64_t{ alignedIndexCount } * sizeof(uint16_t);
+        if (indexBytes > 0) {
+            wgpuCommandEncoderCopyBufferToBuffer(
+                encoder,
+                page.IndexBuffer, uint64_t{ entry.Range.FirstIndex } * sizeof(uint16_t),
+                indexBuffer, uint64_t{ entry.IndexAllocation.Offset } * sizeof(uint16_t),
+                indexBytes
+            );
+        }
+
+        entry.Range.BaseVertex = entry.VertexAllocation.Offset;
+        entry.Range.FirstIndex = entry.IndexAllocation.Offset;
+        m_BytesMoved += vertexBytes + indexBytes;
+    }
+
+    // The encoder keeps the old buffers alive until the copies have run.
+    m_Memory->Release(page.VertexBuffer);
+    m_Memory->Release(page.IndexBuffer);
+    page.VertexBuffer = std::move(vertexBuffer);
+    page.IndexBuffer = std::move(indexBuffer);
+
+    ++m_DefragmentationCount;
+    return true;
+}
+
+GeometryPoolStats GeometryPool::GetStats() const {
+    GeometryPoolStats stats;
+    for (const Page &page : m_Pages) {
+        stats.Pages.push_back({ page.VertexAllocator.GetStats(), page.IndexAllocator.GetStats() });
+    }
+    stats.DefragmentationCount = m_DefragmentationCount;
+    stats.BytesMoved = m_BytesMoved;
+    return stats;
+}
+
+bool GeometryPool::AddPage() {
+    Page page;
+    CreateBuffers(page.VertexBuffer, page.IndexBuffer);
+    if (!page.VertexBuffer || !page.IndexBuffer) {
+        std::cerr << "Could not create the buffers of geometry pool page " << m_Pages.size() << "!\n";
+        m_Memory->Release(page.VertexBuffer);
+        m_Memory->Release(page.IndexBuffer);
+        return false;
+    }
+
+    page.VertexAllocator.Reset(m_Descriptor.VertexCapacity);
+    page.IndexAllocator.Reset(AlignIndexCount(m_Descriptor.IndexCapacity));
+    m_Pages.push_back(std::move(page));
+    return true;
+}
+
+void GeometryPool::CreateBuffers(BufferHandle &vertexBuffer, BufferHandle &indexBuffer) const {
+    WGPUBufferDescriptor bufferDesc;
+    bufferDesc.nextInChain = nullptr;
+    bufferDesc.label = "Geometry pool vertex buffer";
+    // CopySrc is needed to move ranges around when defragmenting.
+    bufferDesc.usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_CopySrc | WGPUBufferUsage_Vertex;
+    bufferDesc.size = uint64_t{ m_Descriptor.VertexCapacity } * m_Descriptor.VertexStride;
+    bufferDesc.mappedAtCreation = false;
+    vertexBuffer = m_Memory->CreateBuffer(m_Device, bufferDesc, GpuMemoryCategory_Vertex);
+
+    bufferDesc.label = "Geometry pool index buffer";
+    bufferDesc.usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_CopySrc | WGPUBufferUsage_Index;
+    bufferDesc.size = uint64_t{ AlignIndexCount(m_Descriptor.IndexCapacity) } * sizeof(uint16_t);
+    indexBuffer = m_Memory->CreateBuffer(m_Device, bufferDesc, GpuMemoryCategory_Index);
+}
+
+void PrintGeometryPoolStats(const GeometryPoolStats &stats) {
+    std::cout << "Geometry pool:\n";
+    for (size_t i = 0; i < stats.Pages.size(); ++i) {
+        const GeometryPageStats &page = stats.Pages[i];
+        std::cout << " - page " << i << " vertices: " << page.Vertices.UsedSize << " / " << page.Vertices.Capacity
+                  << " (" << page.Vertices.Utilization * 100.0f << "% used, "
+                  << page.Vertices.Fragmentation * 100.0f << "% fragmented, "
+                  << page.Vertices.FreeRangeCount << " free ranges)\n";
+        std::cout << " - page " << i << " indices: " << page.Indices.UsedSize << " / " << page.Indices.Capacity
+                  << " (" << page.Indices.Utilization * 100.0f << "% used, "
+                  << page.Indices.Fragmentation * 100.0f << "% fragmented, "
+                  << page.Indices.FreeRangeCount << " free ranges)\n";
+    }
+    std::cout << " - defragmentations: " << stats.DefragmentationCount << " (" << stats.BytesMoved << " bytes moved)\n";
+}
@@ -0,0 +1,220 @@
+#include "GpuMemoryTracker.hpp"
+
+#include <webgpu/webgpu.h>
+
+#include <algorithm>
+#include <iostream>
+
+namespace {
+    struct TexelBlock {
+        uint32_t Bytes = 4;
+        uint32_t Width = 1;
+        uint32_t Height = 1;
+    };
+
+    TexelBlock GetTexelBlock(WGPUTextureFormat format) {
+        switch (format) {
+            case WGPUTextureFormat_R8Unorm:
+            case WGPUTextureFormat_R8Snorm:
+            case WGPUTextureFormat_R8Uint:
+            case WGPUTextureFormat_R8Sint:
+            case WGPUTextureFormat_Stencil8:
+                return { 1 };
+            case WGPUTextureFormat_R16Uint:
+            case WGPUTextureFormat_R16Sint:
+            case WGPUTextureFormat_R16Float:
+            case WGPUTextureFormat_RG8Unorm:
+            case WGPUTextureFormat_RG8Snorm:
+            case WGPUTextureFormat_RG8Uint:
+            case WGPUTextureFormat_RG8Sint:
+            case WGPUTextureFormat_Depth16Unorm:
+                return { 2 };
+            case WGPUTextureFormat_RG32Float:
+            case WGPUTextureFormat_RG32Uint:
+            case WGPUTextureFormat_RG32Sint:
+            case WGPUTextureFormat_RGBA16Uint:
+            case WGPUTextureFormat_RGBA16Sint:
+            case WGPUTextureFormat_RGBA16Float:
+            // Depth and stencil are usually stored in separate planes.
+            case WGPUTextureFormat_Depth32FloatStencil8:
+                return { 8 };
+            case WGPUTextureFormat_RGBA32Float:
+            case WGPUTextureFormat_RGBA32Uint:
+            case WGPUTextureFormat_RGBA32Sint:
+                return { 16 };
+            case WGPUTextureFormat_BC1RGBAUnorm:
+            case WGPUTextureFormat_BC1RGBAUnormSrgb:
+            case WGPUTextureFormat_BC4RUnorm:
+            case WGPUTextureFormat_BC4RSnorm:
+                return { 8, 4, 4 };
+            case WGPUTextureFormat_BC2RGBAUnorm:
+            case WGPUTextureFormat_BC2RGBAUnormSrgb:
+            case WGPUTextureFormat_BC3RGBAUnorm:
+            case WGPUTextureFormat_BC3RGBAUnormSrgb:
+            case WGPUTextureFormat_BC5RGUnorm:
+            case WGPUTextureFormat_BC5RGSnorm:
+            case WGPUTextureFormat_BC6HRGBUfloat:
+            case WGPUTextureFormat_BC6HRGBFloat:
+            case WGPUTextureFormat_BC7RGBAUnorm:
+            case WGPUTextureFormat_BC7RGBAUnormSrgb:
+                return { 16, 4, 4 };
+            default:
+                // Every other format we use (RGBA8, BGRA8, R32, RG16, packed
+                // 32-bit formats, Depth24Plus, Depth32Float...) takes 4 bytes.
+                return { 4 };
+        }
+    }
+}
+
+const char *GetGpuMemoryCategoryName(GpuMemoryCategory category) {
+    static const char *names[GpuMemoryCategory_Count] = { "vertex", "index", "uniform", "staging", "texture", "storage" };
+    return category < GpuMemoryCategory_Count ? names[category] : "unknown";
+}
+
+void GpuMemoryTracker::SetBudget(uint64_t bytes) {
+    std::lock_guard lock(m_Mutex);
+    m_Stats.Budget = bytes;
+}
+
+BufferHandle GpuMemoryTracker::CreateBuffer(WGPUDevice device, const WGPUBufferDescriptor &descriptor, GpuMemoryCategory category) {
+    if (!Reserve(descriptor.size, category, descriptor.label)) {
+        return {};
+    }
+
+    BufferHandle buffer(wgpuDeviceCreateBuffer(device, &descriptor));
+    if (!buffer) {
+        Unreserve(descriptor.size, category);
+        return {};
+    }
+
+    Track(buffer.Get(), descriptor.size, category);
+    return buffer;
+}
+
+TextureHandle GpuMemoryTracker::CreateTexture(WGPUDevice device, const WGPUTextureDescriptor &descriptor, GpuMemoryCategory category) {
+    const uint64_t size = EstimateTextureSize(descriptor);
+    if (!Reserve(size, category, descriptor.label)) {
+        return {};
+    }
+
+    TextureHandle texture(wgpuDeviceCreateTexture(device, &descriptor));
+    if (!texture) {
+        Unreserve(size, category);
+        return {};
+    }
+
+    Track(texture.Get(), size, category);
+    return texture;
+}
+
+void GpuMemoryTracker::Release(BufferHandle &buffer) {
+    Untrack(buffer.Get());
+    buffer.Reset();
+}
+
+void GpuMemoryTracker::Release(TextureHandle &texture) {
+    Untrack(texture.Get());
+    texture.Reset();
+}
+
+void GpuMemoryTracker::EndFrame() {
+    std::lock_guard lock(m_Mutex);
+    m_Stats.FrameAllocatedBytes = m_FrameAllocatedBytes;
+    m_Stats.FrameFreedBytes = m_FrameFreedBytes;
+    m_Stats.PeakFrameChurnBytes = std::max(m_Stats.PeakFrameChurnBytes, m_FrameAllocatedBytes + m_FrameFreedBytes);
+    m_FrameAllocatedBytes = 0;
+    m_FrameFreedBytes = 0;
+}
+
+GpuMemoryStats GpuMemoryTracker::GetStats() const {
+    std::lock_guard lock(m_Mutex);
+    return m_Stats;
+}
+
+bool GpuMemoryTracker::Reserve(uint64_t size, GpuMemoryCategory category, const char *label) {
+    std::lock_guard lock(m_Mutex);
+
+    if (m_Stats.Budget != 0 && m_Stats.TotalLiveBytes + size > m_Stats.Budget) {
+        ++m_Stats.RefusedAllocations;
+        std::cerr << "GPU memory budget exceeded: refusing to allocate " << size << " bytes of "
+                  << GetGpuMemoryCategoryName(category) << " memory for \"" << (label ? label : "unnamed") << "\" ("
+                  << m_Stats.TotalLiveBytes << " of " << m_Stats.Budget << " bytes in use)!\n";
+        return false;
+    }
+
+    m_Stats.LiveBytes[category] += size;
+    m_Stats.PeakBytes[category] = std::max(m_Stats.PeakBytes[category], m_Stats.LiveBytes[category]);
+    m_Stats.TotalLiveBytes += size;
+    m_Stats.TotalPeakBytes = std::max(m_Stats.TotalPeakBytes, m_Stats.TotalLiveBytes);
+    m_FrameAllocatedBytes += size;
+    return true;
+}
+
+void GpuMemoryTracker::Track(const void *object, uint64_t size, GpuMemoryCategory category) {
+    std::lock_guard lock(m_Mutex);
+    m_Allocations[object] = { size, category };
+    ++m_Stats.LiveAllocations;
+}
+
+void GpuMemoryTracker::Unreserve(uint64_t size, GpuMemoryCategory category) {
+    std::lock_guard lock(m_Mutex);
+    m_Stats.LiveBytes[category] -= size;
+    m_Stats.TotalLiveBytes -= size;
+    // The frame may have ended since the reservation.
+    m_FrameAllocatedBytes -= std::min(m_FrameAllocatedBytes, size);
+}
+
+void GpuMemoryTracker::Untrack(const void *object) {
+    if (!object) {
+        return;
+    }
+
+    std::lock_guard lock(m_Mutex);
+    auto it = m_Allocations.find(object);
+    if (it == m_Allocations.end()) {
+        // Not created by us, e.g. a surface texture.
+        return;
+    }
+
+    const Allocation &allocation = it->second;
+    m_Stats.LiveBytes[allocation.Category] -= allocation.Size;
+    m_Stats.TotalLiveBytes -= allocation.Size;
+    m_FrameFreedBytes += allocation.Size;
+    --m_Stats.LiveAllocations;
+    m_Allocations.erase(it);
+}
+
+uint64_t EstimateTextureSize(const WGPUTextureDescriptor &descriptor) {
+    const TexelBlock block = GetTexelBlock(descriptor.format);
+    const bool is3D = descriptor.dimension == WGPUTextureDimension_3D;
+
+    uint64_t size = 0;
+    for (uint32_t level = 0; level < std::max(descriptor.mipLevelCount, 1u); ++level) {
+        const uint32_t width = std::max(descriptor.size.width >> level, 1u);
+        const uint32_t height = std::max(descriptor.size.height >> level, 1u);
+        // Array layers keep their count down the mip chain, 3D slices do not.
+        const uint32_t depth = is3D ? std::max(descriptor.size.depthOrArrayLayers >> level, 1u) : descriptor.size.depthOrArrayLayers;
+
+        const uint64_t blocksWide = (width + block.Width - 1) / block.Width;
+        const uint64_t blocksHigh = (height + block.Height - 1) / block.Height;
+        size += blocksWide * blocksHigh * depth * block.Bytes;
+    }
+
+    return size * std::max(descriptor.sampleCount, 1u);
+}
+
+void PrintGpuMemoryStats(const GpuMemoryStats &stats) {
+    std::cout << "GPU memory:\n";
+    std::cout << " - live: " << stats.TotalLiveBytes << " bytes in " << stats.LiveAllocations << " allocations, peak: " << stats.TotalPeakBytes << " bytes";
+    if (stats.Budget != 0) {
+        std::cout << " (budget: " << stats.Budget << " bytes)";
+    }
+    std::cout << '\n';
+    for (uint32_t i = 0; i < GpuMemoryCategory_Count; ++i) {
+        std::cout << " - " << GetGpuMemoryCategoryName(static_cast<GpuMemoryCategory>(i)) << ": "
+                  << stats.LiveBytes[i] << " bytes live, " << stats.PeakBytes[i] << " bytes peak\n";
+    }
+    std::cout << " - last frame: " << stats.FrameAllocatedBytes << " bytes allocated, " << stats.FrameFreedBytes
+              << " bytes freed (worst frame: " << stats.PeakFrameChurnBytes << " bytes)\n";
+    std::cout << " - refused allocations: " << stats.RefusedAllocations << '\n';
+}
@@ -0,0 +1,116 @@
+#include "GpuTimer.hpp"
+
+#include <webgpu/webgpu.h>
+
+#include <algorithm>
+#include <iostream>
+
+namespace {
+    constexpr uint32_t QueryCount = 2;
+    constexpr uint64_t ResultSize = QueryCount * sizeof(uint64_t);
+}
+
+bool GpuTimer::Initialize(WGPUDevice device, GpuMemoryTracker &memory, ReadbackRing &readback) {
+    m_Memory = &memory;
+    m_Readback = &readback;
+
+    if (!wgpuDeviceHasFeature(device, WGPUFeatureName_TimestampQuery)) {
+        return false;
+    }
+
+    WGPUQuerySetDescriptor querySetDesc = {};
+    querySetDesc.nextInChain = nullptr;
+    querySetDesc.label = "Frame timestamps";
+    querySetDesc.type = WGPUQueryType_Timestamp;
+    querySetDesc.count = QueryCount;
+    m_QuerySet.Reset(wgpuDeviceCreateQuerySet(device, &querySetDesc));
+
+    WGPUBufferDescriptor bufferDesc = {};
+    bufferDesc.nextInChain = nullptr;
+    bufferDesc.label = "Frame timestamps resolve buffer";
+    bufferDesc.usage = WGPUBufferUsage_QueryResolve | WGPUBufferUsage_CopySrc;
+    bufferDesc.size = ResultSize;
+    bufferDesc.mappedAtCreation = false;
+    m_ResolveBuffer = memory.CreateBuffer(device, bufferDesc, GpuMemoryCategory_Staging);
+
+    if (!m_QuerySet || !m_ResolveBuffer) {
+        std::cerr << "Could not create the frame timestamp queries!\n";
+        Terminate();
+        return false;
+    }
+
+    m_BeginWrites.querySet = m_QuerySet;
+    m_BeginWrites.beginningOfPassWriteIndex = 0;
+    m_BeginWrites.endOfPassWriteIndex = WGPU_QUERY_SET_INDEX_UNDEFINED;
+    m_EndWrites.querySet = m_QuerySet;
+    m_EndWrites.beginningOfPassWriteIndex = WGPU_QUERY_SET_INDEX_UNDEFINED;
+    m_EndWrites.endOfPassWriteIndex = 1;
+    m_PassWrites.querySet = m_QuerySet;
+    m_PassWrites.beginningOfPassWriteIndex = 0;
+    m_PassWrites.endOfPassWriteIndex = 1;
+
+    m_HasResult = false;
+    m_Stats = {};
+    return true;
+}
+
+void GpuTimer::Terminate() {
+    if (m_Memory) {
+        m_Memory->Release(m_ResolveBuffer);
+    }
+    m_QuerySet.Reset();
+    m_HasResult = false;
+}
+
+void GpuTimer::BeginFrame() {
+    m_FrameActive = IsAvailable() && m_Readback->HasFreeSlot();
+}
+
+void GpuTimer::Resolve(WGPUCommandEncoder encoder) {
+    if (!m_FrameActive) {
+        return;
+    }
+    m_FrameActive = false;
+
+    // Query results cannot be mapped directly, they go through a copy. The
+    // resolve buffer is reused every frame: the copy of the previous frame
+    // comes first in queue order.
+    wgpuCommandEncoderResolveQuerySet(encoder, m_QuerySet, 0, QueryCount, m_ResolveBuffer, 0);
+    m_Readback->ReadBuffer(encoder, m_ResolveBuffer, 0, ResultSize, [this](const ReadbackResult &result) {
+        const auto *timestamps = static_cast<const uint64_t *>(result.Data);
+        // Timestamps are in nanoseconds. Some GPUs reset their counter now
+        // and then, which shows up as a timestamp going backwards.
+        if (!timestamps || timestamps[1] <= timestamps[0]) {
+            return;
+        }
+
+        const double seconds = static_cast<double>(timestamps[1] - timestamps[0]) * 1e-9;
+        ++m_Stats.SampledFrames;
+        m_Stats.TotalSeconds += seconds;
+        m_Stats.LastSeconds = seconds;
+        m_Stats.MaxSeconds = std::max(m_Stats.MaxSeconds, seconds);
+        m_Result = seconds;
+        m_HasResult = true;
+    });
+}
+
+bool GpuTimer::Collect(double &seconds) {
+    if (!m_HasResult) {
+        return false;
+    }
+    seconds = m_Result;
+    m_HasResult = false;
+    return true;
+}
+
+void PrintGpuTimerStats(const GpuTimerStats &stats) {
+    std::cout << "GPU frame time:\n";
+    if (stats.SampledFrames == 0) {
+        std::cout << " - no frame sampled\n";
+        return;
+    }
+
+    std::cout << " - sampled frames: " << stats.SampledFrames << '\n';
+    std::cout << " - average: " << stats.TotalSeconds / stats.SampledFrames * 1000.0 << " ms, max: "
+              << stats.MaxSeconds * 1000.0 << " ms\n";
+}
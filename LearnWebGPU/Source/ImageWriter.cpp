@@ -0,0 +1,71 @@
+#include "ImageWriter.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+
+#include "FileLoader.hpp"
+
+void ImageWriter::Initialize(ThreadPool &workers, uint32_t maxPending) {
+    m_Workers = &workers;
+    m_MaxPending = std::max(maxPending, 1u);
+    m_Stats = {};
+}
+
+void ImageWriter::Write(std::filesystem::path path, uint32_t width, uint32_t height, std::vector<uint8_t> pixels, bool bgra) {
+    {
+        std::unique_lock lock(m_Mutex);
+        if (m_Pending >= m_MaxPending) {
+            const auto start = std::chrono::steady_clock::now();
+            m_Done.wait(lock, [this] { return m_Pending < m_MaxPending; });
+            ++m_Stats.BacklogWaits;
+            m_Stats.BacklogWaitSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        ++m_Pending;
+    }
+
+    // Jobs must be copyable, the pixels are shared rather than copied.
+    auto image = std::make_shared<std::vector<uint8_t>>(std::move(pixels));
+    m_Workers->Submit([this, path = std::move(path), width, height, image, bgra] {
+        const auto start = std::chrono::steady_clock::now();
+        const bool saved = SaveImagePPM(path, width, height, image->data(), bgra);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (!saved) {
+            std::cerr << "Could not write " << path.string() << '\n';
+        }
+
+        {
+            std::lock_guard lock(m_Mutex);
+            if (saved) {
+                ++m_Stats.ImagesWritten;
+                m_Stats.BytesWritten += uint64_t{ width } * height * 3;
+            } else {
+                ++m_Stats.Failures;
+            }
+            m_Stats.EncodeSeconds += seconds;
+            --m_Pending;
+        }
+        m_Done.notify_all();
+    });
+}
+
+void ImageWriter::Wait() {
+    std::unique_lock lock(m_Mutex);
+    m_Done.wait(lock, [this] { return m_Pending == 0; });
+}
+
+ImageWriterStats ImageWriter::GetStats() const {
+    std::lock_guard lock(m_Mutex);
+    return m_Stats;
+}
+
+void PrintImageWriterStats(const ImageWriterStats &stats) {
+    std::cout << "Image writer:\n";
+    std::cout << " - images written: " << stats.ImagesWritten << " (" << stats.Failures << " failures, "
+              << stats.BytesWritten / (1024.0 * 1024.0) << " MiB of pixels)\n";
+    if (stats.ImagesWritten > 0) {
+        std::cout << " - encoding: " << stats.EncodeSeconds / stats.ImagesWritten * 1000.0 << " ms per image\n";
+    }
+    std::cout << " - backlog waits: " << stats.BacklogWaits << " (" << stats.BacklogWaitSeconds * 1000.0 << " ms)\n";
+}
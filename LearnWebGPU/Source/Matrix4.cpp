@@ -0,0 +1,90 @@
+#include "Matrix4.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LEARNWEBGPU_X86 1
+#include <immintrin.h>
+#endif
+
+Matrix4 Matrix4::Translation(float x, float y, float z) {
+    Matrix4 matrix;
+    matrix(0, 3) = x;
+    matrix(1, 3) = y;
+    matrix(2, 3) = z;
+    return matrix;
+}
+
+Matrix4 Matrix4::Scaling(float x, float y, float z) {
+    Matrix4 matrix;
+    matrix(0, 0) = x;
+    matrix(1, 1) = y;
+    matrix(2, 2) = z;
+    return matrix;
+}
+
+Matrix4 Matrix4::RotationZ(float angle) {
+    const float c = std::cos(angle);
+    const float s = std::sin(angle);
+    Matrix4 matrix;
+    matrix(0, 0) = c;
+    matrix(0, 1) = -s;
+    matrix(1, 0) = s;
+    matrix(1, 1) = c;
+    return matrix;
+}
+
+void MultiplyMatrices(const Matrix4 &a, const Matrix4 &b, Matrix4 &result) {
+#ifdef LEARNWEBGPU_X86
+    // Column j of the result is a's columns weighted by column j of b.
+    const __m128 a0 = _mm_load_ps(a.M + 0);
+    const __m128 a1 = _mm_load_ps(a.M + 4);
+    const __m128 a2 = _mm_load_ps(a.M + 8);
+    const __m128 a3 = _mm_load_ps(a.M + 12);
+
+    __m128 columns[4];
+    for (int j = 0; j < 4; ++j) {
+        const float *bColumn = b.M + j * 4;
+        __m128 column = _mm_mul_ps(a0, _mm_set1_ps(bColumn[0]));
+        column = _mm_add_ps(column, _mm_mul_ps(a1, _mm_set1_ps(bColumn[1])));
+        column = _mm_add_ps(column, _mm_mul_ps(a2, _mm_set1_ps(bColumn[2])));
+        column = _mm_add_ps(column, _mm_mul_ps(a3, _mm_set1_ps(bColumn[3])));
+        columns[j] = column;
+    }
+
+    // Only store once everything is read, in case result aliases a or b.
+    for (int j = 0; j < 4; ++j) {
+        _mm_store_ps(result.M + j * 4, columns[j]);
+    }
+#else
+    Matrix4 product;
+    for (uint32_t column = 0; column < 4; ++column) {
+        for (uint32_t row = 0; row < 4; ++row) {
+            float sum = 0.0f;
+            for (uint32_t k = 0; k < 4; ++k) {
+                sum += a(row, k) * b(k, column);
+            }
+            product(row, column) = sum;
+        }
+    }
+    result = product;
+#endif
+}
+
+void TransformPoint(const Matrix4 &matrix, const float *point, float *result) {
+    float transformed[3];
+    for (uint32_t row = 0; row < 3; ++row) {
+        transformed[row] = matrix(row, 0) * point[0] + matrix(row, 1) * point[1] + matrix(row, 2) * point[2] + matrix(row, 3);
+    }
+    std::copy(transformed, transformed + 3, result);
+}
+
+float GetMaxScale(const Matrix4 &matrix) {
+    float maxLengthSquared = 0.0f;
+    for (uint32_t column = 0; column < 3; ++column) {
+        const float x = matrix(0, column), y = matrix(1, column), z = matrix(2, column);
+        maxLengthSquared = std::max(maxLengthSquared, x * x + y * y + z * z);
+    }
+    return std::sqrt(maxLengthSquared);
+}
@@ -0,0 +1,112 @@
+#include "MeshRegistry.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+void MeshRegistry::Initialize(GeometryPool &pool, uint32_t vertexStride, const MeshSplitLimits &splitLimits) {
+    m_Pool = &pool;
+    m_FloatsPerVertex = vertexStride / sizeof(float);
+    m_SplitLimits = splitLimits;
+}
+
+void MeshRegistry::Terminate() {
+    for (const MeshInfo &mesh : m_Meshes) {
+        for (GeometryHandle part : mesh.Parts) {
+            m_Pool->Free(part);
+        }
+    }
+    m_Meshes.clear();
+    m_Names.clear();
+}
+
+MeshId MeshRegistry::Load(const fs::path &path) {
+    const std::string name = path.string();
+    const MeshId existing = Find(name);
+    if (existing != InvalidMeshId) {
+        ++m_DuplicateLoads;
+        return existing;
+    }
+
+    std::vector<float> pointData;
+    std::vector<uint32_t> indexData;
+    if (!LoadGeometry(path, pointData, indexData)) {
+        std::cerr << "Could not load the mesh " << name << "!\n";
+        return InvalidMeshId;
+    }
+    return Add(name, pointData, indexData);
+}
+
+MeshId MeshRegistry::Add(const std::string &name, const std::vector<float> &pointData, const std::vector<uint32_t> &indexData) {
+    const MeshId existing = Find(name);
+    if (existing != InvalidMeshId) {
+        ++m_DuplicateLoads;
+        return existing;
+    }
+
+    std::vector<MeshPart> parts;
+    if (!SplitMesh(pointData, m_FloatsPerVertex, indexData, m_SplitLimits, parts)) {
+        std::cerr << "Could not split the mesh " << name << "!\n";
+        return InvalidMeshId;
+    }
+
+    MeshInfo mesh;
+    mesh.Name = name;
+    mesh.VertexCount = static_cast<uint32_t>(pointData.size() / m_FloatsPerVertex);
+    mesh.IndexCount = static_cast<uint32_t>(indexData.size());
+    for (const MeshPart &part : parts) {
+        const GeometryHandle handle = m_Pool->Add(part.PointData.data(), part.VertexCount, part.IndexData.data(), static_cast<uint32_t>(part.IndexData.size()));
+        if (handle == InvalidGeometryHandle) {
+            std::cerr << "The geometry pool is full, could not add the mesh " << name << "!\n";
+            for (GeometryHandle added : mesh.Parts) {
+                m_Pool->Free(added);
+            }
+            return InvalidMeshId;
+        }
+        mesh.Parts.push_back(handle);
+    }
+
+    // A sphere around the bounding box of the 2D positions is good enough
+    // for culling.
+    float minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+    for (size_t i = 0; i + 1 < pointData.size(); i += m_FloatsPerVertex) {
+        minX = std::min(minX, pointData[i]);
+        maxX = std::max(maxX, pointData[i]);
+        minY = std::min(minY, pointData[i + 1]);
+        maxY = std::max(maxY, pointData[i + 1]);
+    }
+    if (mesh.VertexCount > 0) {
+        mesh.Bounds.Center[0] = 0.5f * (minX + maxX);
+        mesh.Bounds.Center[1] = 0.5f * (minY + maxY);
+        mesh.Bounds.Radius = 0.5f * std::hypot(maxX - minX, maxY - minY);
+    }
+
+    const auto id = static_cast<MeshId>(m_Meshes.size());
+    m_Meshes.push_back(std::move(mesh));
+    m_Names.emplace(name, id);
+    return id;
+}
+
+MeshId MeshRegistry::Find(const std::string &name) const {
+    const auto found = m_Names.find(name);
+    return found != m_Names.end() ? found->second : InvalidMeshId;
+}
+
+MeshRegistryStats MeshRegistry::GetStats() const {
+    MeshRegistryStats stats;
+    stats.Meshes = GetMeshCount();
+    for (const MeshInfo &mesh : m_Meshes) {
+        stats.Parts += static_cast<uint32_t>(mesh.Parts.size());
+        stats.Vertices += mesh.VertexCount;
+        stats.Indices += mesh.IndexCount;
+    }
+    stats.DuplicateLoads = m_DuplicateLoads;
+    return stats;
+}
+
+void PrintMeshRegistryStats(const MeshRegistryStats &stats) {
+    std::cout << "Meshes:\n";
+    std::cout << " - meshes: " << stats.Meshes << " (" << stats.Parts << " parts)\n";
+    std::cout << " - vertices: " << stats.Vertices << ", indices: " << stats.Indices << '\n';
+    std::cout << " - duplicate loads: " << stats.DuplicateLoads << '\n';
+}
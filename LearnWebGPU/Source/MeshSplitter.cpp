@@ -0,0 +1,82 @@
+#include "MeshSplitter.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+bool SplitMesh(const std::vector<float> &pointData, uint32_t floatsPerVertex, const std::vector<uint32_t> &indexData, const MeshSplitLimits &limits, std::vector<MeshPart> &parts) {
+    parts.clear();
+
+    const uint32_t maxVertices = std::min<uint32_t>(limits.MaxVertices, 1 << 16);
+    const uint32_t maxIndices = limits.MaxIndices - limits.MaxIndices % 3;
+    if (floatsPerVertex == 0 || maxVertices < 3 || maxIndices < 3) {
+        std::cerr << "Mesh split limits are smaller than a triangle!\n";
+        return false;
+    }
+    if (indexData.size() % 3 != 0) {
+        std::cerr << "Mesh index count is not a multiple of 3!\n";
+        return false;
+    }
+
+    const auto vertexCount = static_cast<uint32_t>(pointData.size() / floatsPerVertex);
+    for (uint32_t index : indexData) {
+        if (index >= vertexCount) {
+            std::cerr << "Mesh index " << index << " is out of range (" << vertexCount << " vertices)!\n";
+            return false;
+        }
+    }
+
+    // Common case: nothing to remap.
+    if (vertexCount <= maxVertices && indexData.size() <= maxIndices) {
+        MeshPart &part = parts.emplace_back();
+        part.PointData = pointData;
+        part.IndexData.assign(indexData.begin(), indexData.end());
+        part.VertexCount = vertexCount;
+        return true;
+    }
+
+    // Where each source vertex is in the current part, valid when its
+    // owner is the current part.
+    std::vector<uint32_t> remap(vertexCount, 0);
+    std::vector<uint32_t> owner(vertexCount, 0xffffffff);
+
+    MeshPart *part = nullptr;
+    for (size_t triangle = 0; triangle < indexData.size(); triangle += 3) {
+        const auto partIndex = static_cast<uint32_t>(parts.size() - 1);
+        uint32_t newVertices = 0;
+        if (part) {
+            for (size_t corner = 0; corner < 3; ++corner) {
+                newVertices += owner[indexData[triangle + corner]] != partIndex ? 1 : 0;
+            }
+        }
+        if (!part || part->VertexCount + newVertices > maxVertices || part->IndexData.size() + 3 > maxIndices) {
+            part = &parts.emplace_back();
+        }
+
+        const auto currentPart = static_cast<uint32_t>(parts.size() - 1);
+        for (size_t corner = 0; corner < 3; ++corner) {
+            const uint32_t index = indexData[triangle + corner];
+            if (owner[index] != currentPart) {
+                owner[index] = currentPart;
+                remap[index] = part->VertexCount++;
+                const auto first = pointData.begin() + size_t{ index } * floatsPerVertex;
+                part->PointData.insert(part->PointData.end(), first, first + floatsPerVertex);
+            }
+            part->IndexData.push_back(static_cast<uint16_t>(remap[index]));
+        }
+    }
+
+    return true;
+}
+
+uint32_t GetMaxPartCount(uint64_t indexCount, const MeshSplitLimits &limits) {
+    // A part is only closed when the next triangle does not fit, so it has
+    // at least limit - 2 vertices or indices. Each of its vertices is used
+    // by at least one of its indices, so it has at least that many indices.
+    const uint32_t maxVertices = std::min<uint32_t>(limits.MaxVertices, 1 << 16);
+    const uint32_t maxIndices = limits.MaxIndices - limits.MaxIndices % 3;
+    const uint32_t smallest = std::min(maxVertices, maxIndices);
+    if (smallest < 3) {
+        return 1;
+    }
+    return static_cast<uint32_t>(indexCount / (smallest - 2)) + 1;
+}
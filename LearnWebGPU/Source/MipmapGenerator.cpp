@@ -0,0 +1,184 @@
+#include "MipmapGenerator.hpp"
+
+#include <webgpu/webgpu.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <utility>
+
+#include "Compute.hpp"
+
+namespace {
+    constexpr const char *MipmapShader = "Resources/Shaders/Compute/mipmap.wgsl";
+
+    uint32_t GetLevelSize(uint32_t size, uint32_t level) {
+        return std::max(size >> level, 1u);
+    }
+
+    float SrgbToLinear(float color) {
+        return color <= 0.04045f ? color / 12.92f : std::pow((color + 0.055f) / 1.055f, 2.4f);
+    }
+
+    float LinearToSrgb(float color) {
+        return color <= 0.0031308f ? color * 12.92f : 1.055f * std::pow(color, 1.0f / 2.4f) - 0.055f;
+    }
+
+    // Same as footprint_weights() in the shader.
+    std::array<float, 3> GetFootprintWeights(uint32_t x, uint32_t sourceSize, uint32_t destinationSize) {
+        if (sourceSize == 1) {
+            return { 1.0f, 0.0f, 0.0f };
+        }
+        if (sourceSize % 2 == 0) {
+            return { 0.5f, 0.5f, 0.0f };
+        }
+        const float n = static_cast<float>(sourceSize);
+        const float m = static_cast<float>(destinationSize);
+        const float i = static_cast<float>(x);
+        return { (m - i) / n, m / n, (i + 1.0f) / n };
+    }
+}
+
+bool MipmapGenerator::Initialize(WGPUDevice device, ShaderCache &shaderCache) {
+    m_Device = device;
+
+    m_BindGroupLayout = CreateBindGroupLayout(device, "Mipmap bind group layout", {
+        SampledTextureLayoutEntry(0, WGPUTextureSampleType_UnfilterableFloat),
+        StorageTextureLayoutEntry(1, Format),
+    });
+    m_PipelineLayout = CreatePipelineLayout(device, "Mipmap pipeline layout", m_BindGroupLayout);
+    m_Downsample = CreateComputePipeline(device, shaderCache, { MipmapShader, "downsample", m_PipelineLayout });
+
+    if (!m_BindGroupLayout || !m_PipelineLayout || !m_Downsample) {
+        std::cerr << "Could not create the mipmap generator!\n";
+        Terminate();
+        return false;
+    }
+    return true;
+}
+
+void MipmapGenerator::Terminate() {
+    m_Downsample.Reset();
+    m_PipelineLayout.Reset();
+    m_BindGroupLayout.Reset();
+}
+
+uint32_t MipmapGenerator::Generate(WGPUCommandEncoder encoder, WGPUTexture texture) const {
+    const uint32_t levelCount = wgpuTextureGetMipLevelCount(texture);
+    if (levelCount <= 1) {
+        return 0;
+    }
+    const uint32_t width = wgpuTextureGetWidth(texture);
+    const uint32_t height = wgpuTextureGetHeight(texture);
+
+    WGPUComputePassDescriptor passDesc = {};
+    passDesc.nextInChain = nullptr;
+    passDesc.label = "Mipmap generation";
+    passDesc.timestampWrites = nullptr;
+    ComputePassEncoderHandle pass(wgpuCommandEncoderBeginComputePass(encoder, &passDesc));
+    wgpuComputePassEncoderSetPipeline(pass, m_Downsample);
+
+    // One view per level: the same level is written by one dispatch and read
+    // by the next one, which the usage tracking of a compute pass allows
+    // since they are separate dispatches.
+    WGPUTextureViewDescriptor viewDesc = {};
+    viewDesc.nextInChain = nullptr;
+    viewDesc.label = "Mip level view";
+    viewDesc.format = Format;
+    viewDesc.dimension = WGPUTextureViewDimension_2D;
+    viewDesc.mipLevelCount = 1;
+    viewDesc.baseArrayLayer = 0;
+    viewDesc.arrayLayerCount = 1;
+    viewDesc.aspect = WGPUTextureAspect_All;
+
+    viewDesc.baseMipLevel = 0;
+    TextureViewHandle sourceView(wgpuTextureCreateView(texture, &viewDesc));
+    for (uint32_t level = 1; level < levelCount; ++level) {
+        viewDesc.baseMipLevel = level;
+        TextureViewHandle destinationView(wgpuTextureCreateView(texture, &viewDesc));
+
+        // The pass keeps the bind group and the views alive until it runs.
+        BindGroupHandle bindGroup = CreateBindGroup(m_Device, m_BindGroupLayout, "Mipmap bind group", {
+            TextureBindingEntry(0, sourceView),
+            TextureBindingEntry(1, destinationView),
+        });
+        wgpuComputePassEncoderSetBindGroup(pass, 0, bindGroup, 0, nullptr);
+        wgpuComputePassEncoderDispatchWorkgroups(
+            pass,
+            DivideRoundUp(GetLevelSize(width, level), WorkgroupSize),
+            DivideRoundUp(GetLevelSize(height, level), WorkgroupSize),
+            1
+        );
+
+        sourceView = std::move(destinationView);
+    }
+
+    wgpuComputePassEncoderEnd(pass);
+    return levelCount - 1;
+}
+
+uint32_t GetMipLevelCount(uint32_t width, uint32_t height) {
+    uint32_t levelCount = 1;
+    for (uint32_t size = std::max(width, height); size > 1; size >>= 1) {
+        ++levelCount;
+    }
+    return levelCount;
+}
+
+std::vector<std::vector<uint8_t>> GenerateMipmapsReference(uint32_t width, uint32_t height, const uint8_t *pixels) {
+    // Decoding sRGB is the costly part, a table does it for every 8-bit
+    // value at once.
+    std::array<float, 256> toLinear;
+    for (uint32_t value = 0; value < 256; ++value) {
+        toLinear[value] = SrgbToLinear(static_cast<float>(value) / 255.0f);
+    }
+
+    const uint32_t levelCount = GetMipLevelCount(width, height);
+    std::vector<std::vector<uint8_t>> levels(levelCount - 1);
+
+    const uint8_t *source = pixels;
+    for (uint32_t level = 1; level < levelCount; ++level) {
+        const uint32_t sourceWidth = GetLevelSize(width, level - 1);
+        const uint32_t sourceHeight = GetLevelSize(height, level - 1);
+        const uint32_t levelWidth = GetLevelSize(width, level);
+        const uint32_t levelHeight = GetLevelSize(height, level);
+
+        std::vector<uint8_t> &destination = levels[level - 1];
+        destination.resize(size_t{ levelWidth } * levelHeight * 4);
+
+        for (uint32_t y = 0; y < levelHeight; ++y) {
+            const std::array<float, 3> weightsY = GetFootprintWeights(y, sourceHeight, levelHeight);
+            for (uint32_t x = 0; x < levelWidth; ++x) {
+                const std::array<float, 3> weightsX = GetFootprintWeights(x, sourceWidth, levelWidth);
+
+                float sum[4] = {};
+                for (uint32_t j = 0; j < 3; ++j) {
+                    for (uint32_t i = 0; i < 3; ++i) {
+                        const float weight = weightsX[i] * weightsY[j];
+                        if (weight <= 0.0f) {
+                            continue;
+                        }
+                        const uint32_t sourceX = std::min(2 * x + i, sourceWidth - 1);
+                        const uint32_t sourceY = std::min(2 * y + j, sourceHeight - 1);
+                        const uint8_t *texel = source + (size_t{ sourceY } * sourceWidth + sourceX) * 4;
+                        sum[0] += weight * toLinear[texel[0]];
+                        sum[1] += weight * toLinear[texel[1]];
+                        sum[2] += weight * toLinear[texel[2]];
+                        sum[3] += weight * static_cast<float>(texel[3]) / 255.0f;
+                    }
+                }
+
+                uint8_t *texel = destination.data() + (size_t{ y } * levelWidth + x) * 4;
+                for (uint32_t channel = 0; channel < 4; ++channel) {
+                    const float value = channel < 3 ? LinearToSrgb(sum[channel]) : sum[channel];
+                    texel[channel] = static_cast<uint8_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+                }
+            }
+        }
+
+        source = destination.data();
+    }
+
+    return levels;
+}
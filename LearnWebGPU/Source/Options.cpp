@@ -0,0 +1,171 @@
+#include "Options.hpp"
+
+#include <charconv>
+#include <iostream>
+#include <string_view>
+
+#include "RenderThread.hpp"
+
+namespace {
+    void PrintUsage(const char *program) {
+        std::cout << "Usage: " << program << " [options]\n";
+        std::cout << "Options:\n";
+        std::cout << "  --adapter <default|high-performance|low-power|software|benchmark>\n";
+        std::cout << "                           How to choose the adapter, software forces a CPU\n";
+        std::cout << "                           adapter on hosts without a GPU\n";
+        std::cout << "  --backend <vulkan|metal|d3d12|d3d11|opengl|opengles>\n";
+        std::cout << "                           Only consider adapters of this backend\n";
+        std::cout << "  --windows <count>        Show the scene in this many windows (1)\n";
+        std::cout << "  --on-demand              Only redraw when something changed\n";
+        std::cout << "  --memory-budget <MiB>    Refuse GPU allocations beyond this size\n";
+        std::cout << "  --scene <logo|overdraw|grid>\n";
+        std::cout << "                           What to draw\n";
+        std::cout << "  --mesh <path>            Draw this geometry file, may be repeated\n";
+        std::cout << "  --depth                  Render with a depth buffer\n";
+        std::cout << "  --unsorted               Do not sort opaque draws front to back\n";
+        std::cout << "  --dynamic-resolution <ms>\n";
+        std::cout << "                           Scale the rendering resolution to keep the GPU\n";
+        std::cout << "                           frame time under this budget\n";
+        std::cout << "  --texture <path>         Texture the objects with a PPM image\n";
+        std::cout << "  --screenshot <path>      Save the first complete frame as a PPM image,\n";
+        std::cout << "                           where F12 saves the next ones\n";
+        std::cout << "  --batch <file>           Render the frames listed in the file offscreen\n";
+        std::cout << "                           and save them as images, then exit\n";
+        std::cout << "  --batch-output <dir>     Where batch frames are saved (frames)\n";
+        std::cout << "  --batch-size <w>x<h>     Size of the batch frames (640x480)\n";
+        std::cout << "  --skip-inspection        Do not print the adapter and device capabilities\n";
+        std::cout << "  --startup-report <path>  Save the startup time breakdown as JSON at exit\n";
+        std::cout << "  --help                   Show this message\n";
+    }
+}
+
+bool ParseOptions(int argc, char **argv, AppOptions &options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--adapter" && i + 1 < argc) {
+            const std::string_view value = argv[++i];
+            if (value == "default") {
+                options.Adapter = AdapterPreference_Default;
+            } else if (value == "high-performance") {
+                options.Adapter = AdapterPreference_HighPerformance;
+            } else if (value == "low-power") {
+                options.Adapter = AdapterPreference_LowPower;
+            } else if (value == "software") {
+                options.Adapter = AdapterPreference_Software;
+            } else if (value == "benchmark") {
+                options.Adapter = AdapterPreference_Benchmark;
+            } else {
+                std::cerr << "Unknown adapter preference: " << value << '\n';
+                PrintUsage(argv[0]);
+                return false;
+            }
+        } else if (arg == "--backend" && i + 1 < argc) {
+            const std::string_view value = argv[++i];
+            if (value == "vulkan") {
+                options.Backend = WGPUBackendType_Vulkan;
+            } else if (value == "metal") {
+                options.Backend = WGPUBackendType_Metal;
+            } else if (value == "d3d12") {
+                options.Backend = WGPUBackendType_D3D12;
+            } else if (value == "d3d11") {
+                options.Backend = WGPUBackendType_D3D11;
+            } else if (value == "opengl") {
+                options.Backend = WGPUBackendType_OpenGL;
+            } else if (value == "opengles") {
+                options.Backend = WGPUBackendType_OpenGLES;
+            } else {
+                std::cerr << "Unknown backend: " << value << '\n';
+                PrintUsage(argv[0]);
+                return false;
+            }
+        } else if (arg == "--windows" && i + 1 < argc) {
+            const std::string_view value = argv[++i];
+            uint32_t count = 0;
+            const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), count);
+            if (error != std::errc() || end != value.data() + value.size() || count == 0 || count > MaxFrameViews) {
+                std::cerr << "Invalid window count: " << value << " (1 to " << MaxFrameViews << ")\n";
+                PrintUsage(argv[0]);
+                return false;
+            }
+            options.WindowCount = count;
+        } else if (arg == "--on-demand") {
+            options.OnDemand = true;
+        } else if (arg == "--memory-budget" && i + 1 < argc) {
+            const std::string_view value = argv[++i];
+            uint64_t mebibytes = 0;
+            const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), mebibytes);
+            if (error != std::errc() || end != value.data() + value.size()) {
+                std::cerr << "Invalid memory budget: " << value << '\n';
+                PrintUsage(argv[0]);
+                return false;
+            }
+            options.MemoryBudget = mebibytes * 1024 * 1024;
+        } else if (arg == "--scene" && i + 1 < argc) {
+            const std::string_view value = argv[++i];
+            if (value == "logo") {
+                options.Scene = SceneType_Logo;
+            } else if (value == "overdraw") {
+                options.Scene = SceneType_Overdraw;
+            } else if (value == "grid") {
+                options.Scene = SceneType_Grid;
+            } else {
+                std::cerr << "Unknown scene: " << value << '\n';
+                PrintUsage(argv[0]);
+                return false;
+            }
+        } else if (arg == "--mesh" && i + 1 < argc) {
+            options.MeshPaths.emplace_back(argv[++i]);
+        } else if (arg == "--depth") {
+            options.Depth = true;
+        } else if (arg == "--unsorted") {
+            options.SortDraws = false;
+        } else if (arg == "--dynamic-resolution" && i + 1 < argc) {
+            const std::string_view value = argv[++i];
+            double milliseconds = 0.0;
+            const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), milliseconds);
+            if (error != std::errc() || end != value.data() + value.size() || milliseconds <= 0.0) {
+                std::cerr << "Invalid frame time budget: " << value << '\n';
+                PrintUsage(argv[0]);
+                return false;
+            }
+            options.DynamicResolutionTarget = milliseconds / 1000.0;
+        } else if (arg == "--texture" && i + 1 < argc) {
+            options.TexturePath = argv[++i];
+        } else if (arg == "--screenshot" && i + 1 < argc) {
+            options.ScreenshotPath = argv[++i];
+            options.ScreenshotFirstFrame = true;
+        } else if (arg == "--batch" && i + 1 < argc) {
+            options.BatchPath = argv[++i];
+        } else if (arg == "--batch-output" && i + 1 < argc) {
+            options.BatchOutput = argv[++i];
+        } else if (arg == "--batch-size" && i + 1 < argc) {
+            const std::string_view value = argv[++i];
+            const char *valueEnd = value.data() + value.size();
+            uint32_t width = 0, height = 0;
+            const auto [widthEnd, widthError] = std::from_chars(value.data(), valueEnd, width);
+            bool valid = widthError == std::errc() && widthEnd != valueEnd && *widthEnd == 'x';
+            if (valid) {
+                const auto [heightEnd, heightError] = std::from_chars(widthEnd + 1, valueEnd, height);
+                valid = heightError == std::errc() && heightEnd == valueEnd;
+            }
+            if (!valid || width == 0 || height == 0) {
+                std::cerr << "Invalid batch size: " << value << '\n';
+                PrintUsage(argv[0]);
+                return false;
+            }
+            options.BatchWidth = width;
+            options.BatchHeight = height;
+        } else if (arg == "--skip-inspection") {
+            options.Inspect = false;
+        } else if (arg == "--startup-report" && i + 1 < argc) {
+            options.StartupReportPath = argv[++i];
+        } else {
+            if (arg != "--help") {
+                std::cerr << "Unknown option: " << arg << '\n';
+            }
+            PrintUsage(argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,317 @@
+#include "PipelineCache.hpp"
+
+#include <webgpu/webgpu.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include "Hash.hpp"
+
+namespace {
+    PipelineKey HashPipelineState(const RenderPipelineState &state, ShaderHash shaderHash) {
+        // The shader is identified by its contents rather than its path, so
+        // that editing a shader file gives a new key.
+        uint64_t hash = HashValue(shaderHash);
+        hash = HashString(state.VertexEntryPoint, hash);
+        hash = HashString(state.FragmentEntryPoint, hash);
+
+        hash = HashValue(state.Constants.size(), hash);
+        for (const auto &[name, value] : state.Constants) {
+            hash = HashString(name, hash);
+            hash = HashValue(value, hash);
+        }
+
+        hash = HashValue(state.VertexBuffers.size(), hash);
+        for (const VertexBufferState &buffer : state.VertexBuffers) {
+            hash = HashValue(buffer.ArrayStride, hash);
+            hash = HashValue(buffer.StepMode, hash);
+            hash = HashValue(buffer.Attributes.size(), hash);
+            for (const WGPUVertexAttribute &attribute : buffer.Attributes) {
+                hash = HashValue(attribute.format, hash);
+                hash = HashValue(attribute.offset, hash);
+                hash = HashValue(attribute.shaderLocation, hash);
+            }
+        }
+
+        hash = HashValue(state.Topology, hash);
+        hash = HashValue(state.FrontFace, hash);
+        hash = HashValue(state.CullMode, hash);
+
+        hash = HashValue(state.ColorFormat, hash);
+        hash = HashValue(state.BlendEnabled, hash);
+        if (state.BlendEnabled) {
+            for (const WGPUBlendComponent &component : { state.Blend.color, state.Blend.alpha }) {
+                hash = HashValue(component.operation, hash);
+                hash = HashValue(component.srcFactor, hash);
+                hash = HashValue(component.dstFactor, hash);
+            }
+        }
+        hash = HashValue(state.WriteMask, hash);
+
+        hash = HashValue(state.DepthFormat, hash);
+        if (state.DepthFormat != WGPUTextureFormat_Undefined) {
+            hash = HashValue(state.DepthWriteEnabled, hash);
+            hash = HashValue(state.DepthCompare, hash);
+        }
+
+        hash = HashValue(state.SampleCount, hash);
+        hash = HashValue(state.Layout, hash);
+
+        // Keep 0 for InvalidPipelineKey.
+        return hash == InvalidPipelineKey ? 1 : hash;
+    }
+
+    // The entries of a pipeline stage, which point into constants.
+    std::vector<WGPUConstantEntry> GetConstantEntries(const PipelineConstants &constants) {
+        std::vector<WGPUConstantEntry> entries;
+        entries.reserve(constants.size());
+        for (const auto &[name, value] : constants) {
+            WGPUConstantEntry entry = {};
+            entry.nextInChain = nullptr;
+            entry.key = name.c_str();
+            entry.value = value;
+            entries.push_back(entry);
+        }
+        return entries;
+    }
+}
+
+void PipelineCache::Initialize(WGPUDevice device, ShaderCache &shaderCache, ThreadPool &workers, EventPump &pump) {
+    m_Device = device;
+    m_ShaderCache = &shaderCache;
+    m_Workers = &workers;
+    m_Pump = &pump;
+}
+
+void PipelineCache::Terminate() {
+    std::unique_lock lock(m_Mutex);
+    while (m_Stats.Pending > 0) {
+        lock.unlock();
+        m_Pump->Wait();
+        lock.lock();
+    }
+
+    for (auto &[key, entry] : m_Entries) {
+        if (WGPURenderPipeline pipeline = entry->Pipeline.load()) {
+            wgpuRenderPipelineRelease(pipeline);
+        }
+    }
+    m_Entries.clear();
+}
+
+PipelineKey PipelineCache::Request(const RenderPipelineState &state) {
+    ShaderHash shaderHash;
+    if (!m_ShaderCache->GetSourceHash(state.ShaderPath, shaderHash, state.Defines)) {
+        return InvalidPipelineKey;
+    }
+
+    const PipelineKey key = HashPipelineState(state, shaderHash);
+
+    Entry *entry;
+    {
+        std::lock_guard lock(m_Mutex);
+        ++m_Stats.Requests;
+
+        auto [it, inserted] = m_Entries.try_emplace(key);
+        if (!inserted) {
+            ++m_Stats.Hits;
+            return key;
+        }
+
+        it->second = std::make_unique<Entry>();
+        entry = it->second.get();
+        entry->State = state;
+        ++m_Stats.Pending;
+    }
+
+    // Entries are never removed before Terminate(), so the coroutine can keep
+    // a reference to it. It runs until it hands the shader to a worker.
+    entry->Compilation = Compile(key, *entry, shaderHash);
+    entry->Compilation.Start();
+
+    return key;
+}
+
+PipelineKey PipelineCache::Specialize(PipelineKey key, const PipelineConstants &constants) {
+    RenderPipelineState state;
+    {
+        std::lock_guard lock(m_Mutex);
+        auto it = m_Entries.find(key);
+        if (it == m_Entries.end()) {
+            return InvalidPipelineKey;
+        }
+        state = it->second->State;
+    }
+
+    for (const auto &[name, value] : constants) {
+        state.Constants[name] = value;
+    }
+    return Request(state);
+}
+
+WGPURenderPipeline PipelineCache::Get(PipelineKey key, PipelineKey fallback) const {
+    std::lock_guard lock(m_Mutex);
+
+    auto it = m_Entries.find(key);
+    if (it != m_Entries.end()) {
+        if (WGPURenderPipeline pipeline = it->second->Pipeline.load(std::memory_order_acquire)) {
+            return pipeline;
+        }
+    }
+
+    if (fallback != InvalidPipelineKey) {
+        auto fallbackIt = m_Entries.find(fallback);
+        if (fallbackIt != m_Entries.end()) {
+            return fallbackIt->second->Pipeline.load(std::memory_order_acquire);
+        }
+    }
+
+    return nullptr;
+}
+
+WGPURenderPipeline PipelineCache::Wait(PipelineKey key) {
+    std::unique_lock lock(m_Mutex);
+
+    auto it = m_Entries.find(key);
+    if (it == m_Entries.end()) {
+        return nullptr;
+    }
+
+    // The compilation only completes when the events are pumped.
+    Entry &entry = *it->second;
+    while (!entry.Done) {
+        lock.unlock();
+        m_Pump->Wait();
+        lock.lock();
+    }
+    return entry.Pipeline.load();
+}
+
+PipelineCacheStats PipelineCache::GetStats() const {
+    std::lock_guard lock(m_Mutex);
+    return m_Stats;
+}
+
+Task<bool> PipelineCache::Compile(PipelineKey key, Entry &entry, ShaderHash shaderHash) {
+    const auto start = std::chrono::steady_clock::now();
+
+    const RenderPipelineState &state = entry.State;
+    // Compiling the shader module can take longer than the pipeline itself.
+    WGPUShaderModule shaderModule = co_await WorkerRequest<WGPUShaderModule>(*m_Pump, *m_Workers, [this, shaderHash] {
+        return m_ShaderCache->GetModule(shaderHash);
+    });
+
+    WGPURenderPipeline pipeline = nullptr;
+    if (shaderModule) {
+        WGPURenderPipelineDescriptor pipelineDesc = {};
+        pipelineDesc.nextInChain = nullptr;
+
+        std::vector<WGPUVertexBufferLayout> vertexBufferLayouts(state.VertexBuffers.size());
+        for (size_t i = 0; i < state.VertexBuffers.size(); ++i) {
+            vertexBufferLayouts[i].arrayStride = state.VertexBuffers[i].ArrayStride;
+            vertexBufferLayouts[i].stepMode = state.VertexBuffers[i].StepMode;
+            vertexBufferLayouts[i].attributeCount = state.VertexBuffers[i].Attributes.size();
+            vertexBufferLayouts[i].attributes = state.VertexBuffers[i].Attributes.data();
+        }
+
+        pipelineDesc.vertex.bufferCount = vertexBufferLayouts.size();
+        pipelineDesc.vertex.buffers = vertexBufferLayouts.data();
+        pipelineDesc.vertex.module = shaderModule;
+        pipelineDesc.vertex.entryPoint = state.VertexEntryPoint.c_str();
+        // The compiler sees the values, and folds them like literals.
+        const std::vector<WGPUConstantEntry> constants = GetConstantEntries(state.Constants);
+
+        pipelineDesc.vertex.constantCount = constants.size();
+        pipelineDesc.vertex.constants = constants.data();
+
+        pipelineDesc.primitive.topology = state.Topology;
+        // Only relevant for strip topologies, which we draw non-indexed.
+        pipelineDesc.primitive.stripIndexFormat = WGPUIndexFormat_Undefined;
+        pipelineDesc.primitive.frontFace = state.FrontFace;
+        pipelineDesc.primitive.cullMode = state.CullMode;
+
+        WGPUFragmentState fragmentState{};
+        fragmentState.module = shaderModule;
+        fragmentState.entryPoint = state.FragmentEntryPoint.c_str();
+        fragmentState.constantCount = constants.size();
+        fragmentState.constants = constants.data();
+
+        WGPUColorTargetState colorTarget{};
+        colorTarget.format = state.ColorFormat;
+        colorTarget.blend = state.BlendEnabled ? &state.Blend : nullptr;
+        colorTarget.writeMask = state.WriteMask;
+
+        fragmentState.targetCount = 1;
+        fragmentState.targets = &colorTarget;
+
+        pipelineDesc.fragment = &fragmentState;
+
+        WGPUDepthStencilState depthStencilState{};
+        if (state.DepthFormat != WGPUTextureFormat_Undefined) {
+            depthStencilState.format = state.DepthFormat;
+            depthStencilState.depthWriteEnabled = state.DepthWriteEnabled;
+            // Keep a fragment only if it is closer than what is already there.
+            depthStencilState.depthCompare = state.DepthCompare;
+            // We do not use the stencil buffer.
+            for (WGPUStencilFaceState *face : { &depthStencilState.stencilFront, &depthStencilState.stencilBack }) {
+                face->compare = WGPUCompareFunction_Always;
+                face->failOp = WGPUStencilOperation_Keep;
+                face->depthFailOp = WGPUStencilOperation_Keep;
+                face->passOp = WGPUStencilOperation_Keep;
+            }
+            depthStencilState.stencilReadMask = 0;
+            depthStencilState.stencilWriteMask = 0;
+            depthStencilState.depthBias = 0;
+            depthStencilState.depthBiasSlopeScale = 0.0f;
+            depthStencilState.depthBiasClamp = 0.0f;
+            pipelineDesc.depthStencil = &depthStencilState;
+        } else {
+            pipelineDesc.depthStencil = nullptr;
+        }
+
+        pipelineDesc.multisample.count = state.SampleCount;
+        // Default value for the mask, meaning "all bits on".
+        pipelineDesc.multisample.mask = ~0u;
+        pipelineDesc.multisample.alphaToCoverageEnabled = false;
+
+        pipelineDesc.layout = state.Layout;
+
+        pipeline = co_await CreateRenderPipelineAsync(*m_Pump, *m_Workers, m_Device, &pipelineDesc);
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    {
+        std::lock_guard lock(m_Mutex);
+        entry.Pipeline.store(pipeline, std::memory_order_release);
+        entry.Done = true;
+        --m_Stats.Pending;
+        if (pipeline) {
+            ++m_Stats.Compiles;
+            m_Stats.CompileSeconds += seconds;
+            m_Stats.LongestCompileSeconds = std::max(m_Stats.LongestCompileSeconds, seconds);
+        } else {
+            ++m_Stats.Failures;
+        }
+    }
+
+    if (!pipeline) {
+        std::cerr << "Could not create render pipeline for " << state.ShaderPath << '\n';
+    } else if (m_OnReady) {
+        m_OnReady(key);
+    }
+    co_return pipeline != nullptr;
+}
+
+void PrintPipelineCacheStats(const PipelineCacheStats &stats, const ShaderCacheStats &shaderStats) {
+    std::cout << "Pipeline cache:\n";
+    std::cout << " - requests: " << stats.Requests << " (" << stats.Hits << " hits)\n";
+    std::cout << " - pipelines compiled: " << stats.Compiles << " in " << stats.CompileSeconds * 1000.0
+              << " ms (longest " << stats.LongestCompileSeconds * 1000.0 << " ms)\n";
+    std::cout << " - failures: " << stats.Failures << ", still pending: " << stats.Pending << '\n';
+    std::cout << " - shader modules compiled: " << shaderStats.ModulesCompiled << " in " << shaderStats.CompileSeconds * 1000.0
+              << " ms (" << shaderStats.ModuleHits << " hits)\n";
+    std::cout << " - shader variants: " << shaderStats.Variants << " distinct sources from " << shaderStats.Permutations
+              << " permutations, " << shaderStats.ModulesCompiled << " compiled\n";
+}
@@ -0,0 +1,111 @@
+#include "PipelineStatistics.hpp"
+
+#include <webgpu/webgpu.h>
+#include <webgpu/wgpu.h>
+
+#include <iostream>
+
+namespace {
+    // Results come back in this order, one uint64_t each.
+    constexpr WGPUPipelineStatisticName Statistics[] = {
+        WGPUPipelineStatisticName_VertexShaderInvocations,
+        WGPUPipelineStatisticName_FragmentShaderInvocations,
+    };
+    constexpr uint32_t StatisticCount = sizeof(Statistics) / sizeof(Statistics[0]);
+    constexpr uint64_t ResultSize = StatisticCount * sizeof(uint64_t);
+}
+
+bool PipelineStatistics::Initialize(WGPUDevice device, GpuMemoryTracker &memory, ReadbackRing &readback) {
+    m_Memory = &memory;
+    m_Readback = &readback;
+
+    if (!wgpuDeviceHasFeature(device, static_cast<WGPUFeatureName>(WGPUNativeFeature_PipelineStatisticsQuery))) {
+        return false;
+    }
+
+    WGPUQuerySetDescriptorExtras extras = {};
+    extras.chain.next = nullptr;
+    extras.chain.sType = static_cast<WGPUSType>(WGPUSType_QuerySetDescriptorExtras);
+    extras.pipelineStatistics = Statistics;
+    extras.pipelineStatisticCount = StatisticCount;
+
+    WGPUQuerySetDescriptor querySetDesc = {};
+    querySetDesc.nextInChain = &extras.chain;
+    querySetDesc.label = "Pipeline statistics";
+    querySetDesc.type = static_cast<WGPUQueryType>(WGPUNativeQueryType_PipelineStatistics);
+    querySetDesc.count = 1;
+    m_QuerySet.Reset(wgpuDeviceCreateQuerySet(device, &querySetDesc));
+
+    WGPUBufferDescriptor bufferDesc = {};
+    bufferDesc.nextInChain = nullptr;
+    bufferDesc.label = "Pipeline statistics resolve buffer";
+    bufferDesc.usage = WGPUBufferUsage_QueryResolve | WGPUBufferUsage_CopySrc;
+    bufferDesc.size = ResultSize;
+    bufferDesc.mappedAtCreation = false;
+    m_ResolveBuffer = memory.CreateBuffer(device, bufferDesc, GpuMemoryCategory_Staging);
+
+    if (!m_QuerySet || !m_ResolveBuffer) {
+        std::cerr << "Could not create the pipeline statistics queries!\n";
+        Terminate();
+        return false;
+    }
+
+    m_Stats = {};
+    return true;
+}
+
+void PipelineStatistics::Terminate() {
+    if (m_Memory) {
+        m_Memory->Release(m_ResolveBuffer);
+    }
+    m_QuerySet.Reset();
+}
+
+void PipelineStatistics::BeginPass(WGPURenderPassEncoder renderPass) {
+    m_QueryActive = IsAvailable() && m_Readback->HasFreeSlot();
+    if (m_QueryActive) {
+        wgpuRenderPassEncoderBeginPipelineStatisticsQuery(renderPass, m_QuerySet, 0);
+    }
+}
+
+void PipelineStatistics::EndPass(WGPURenderPassEncoder renderPass) {
+    if (m_QueryActive) {
+        wgpuRenderPassEncoderEndPipelineStatisticsQuery(renderPass);
+    }
+}
+
+void PipelineStatistics::Resolve(WGPUCommandEncoder encoder) {
+    if (!m_QueryActive) {
+        return;
+    }
+    m_QueryActive = false;
+
+    // Query results cannot be mapped directly, they go through a copy.
+    wgpuCommandEncoderResolveQuerySet(encoder, m_QuerySet, 0, 1, m_ResolveBuffer, 0);
+    m_Readback->ReadBuffer(encoder, m_ResolveBuffer, 0, ResultSize, [this](const ReadbackResult &result) {
+        const auto *results = static_cast<const uint64_t *>(result.Data);
+        if (results) {
+            ++m_Stats.SampledFrames;
+            m_Stats.VertexInvocations += results[0];
+            m_Stats.FragmentInvocations += results[1];
+            m_Stats.LastFragmentInvocations = results[1];
+        }
+    });
+}
+
+void PrintPipelineStatistics(const PipelineStatisticsStats &stats, uint64_t pixelCount) {
+    std::cout << "Pipeline statistics:\n";
+    if (stats.SampledFrames == 0) {
+        std::cout << " - no frame sampled\n";
+        return;
+    }
+
+    const double fragmentsPerFrame = static_cast<double>(stats.FragmentInvocations) / stats.SampledFrames;
+    std::cout << " - sampled frames: " << stats.SampledFrames << '\n';
+    std::cout << " - vertex invocations per frame: " << static_cast<double>(stats.VertexInvocations) / stats.SampledFrames << '\n';
+    std::cout << " - fragment invocations per frame: " << fragmentsPerFrame;
+    if (pixelCount > 0) {
+        std::cout << " (" << fragmentsPerFrame / pixelCount << " per pixel)";
+    }
+    std::cout << '\n';
+}
@@ -0,0 +1,283 @@
+#include "RangeAllocator.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+namespace {
+    constexpr uint32_t SecondLevelLog2 = RangeAllocator::SecondLevelLog2;
+    constexpr uint32_t SecondLevelCount = RangeAllocator::SecondLevelCount;
+
+    uint32_t FindLastSet(uint32_t value) {
+        return static_cast<uint32_t>(std::bit_width(value)) - 1;
+    }
+
+    uint32_t FindFirstSet(uint32_t value) {
+        return static_cast<uint32_t>(std::countr_zero(value));
+    }
+
+    // Compute the bin a free range of the given size is stored in. Sizes
+    // below SecondLevelCount get an exact bin each, larger sizes are
+    // bucketed by their most significant bit, then by the next 3 bits.
+    void MappingInsert(uint32_t size, uint32_t &firstLevel, uint32_t &secondLevel) {
+        if (size < SecondLevelCount) {
+            firstLevel = 0;
+            secondLevel = size;
+        } else {
+            const uint32_t msb = FindLastSet(size);
+            firstLevel = msb - SecondLevelLog2 + 1;
+            secondLevel = (size >> (msb - SecondLevelLog2)) ^ SecondLevelCount;
+        }
+    }
+
+    // Same as MappingInsert, but rounds the size up to the next bin so that
+    // any range found in that bin is guaranteed to be large enough.
+    bool MappingSearch(uint32_t size, uint32_t &firstLevel, uint32_t &secondLevel) {
+        uint64_t rounded = size;
+        if (size >= SecondLevelCount) {
+            rounded += (uint64_t{ 1 } << (FindLastSet(size) - SecondLevelLog2)) - 1;
+        }
+        if (rounded > 0xffffffff) {
+            return false;
+        }
+        MappingInsert(static_cast<uint32_t>(rounded), firstLevel, secondLevel);
+        return true;
+    }
+}
+
+RangeAllocator::RangeAllocator(uint32_t capacity) {
+    Reset(capacity);
+}
+
+void RangeAllocator::Reset(uint32_t capacity) {
+    m_Capacity = capacity;
+    m_UsedSize = 0;
+    m_FreeRangeCount = 0;
+    m_AllocationCount = 0;
+
+    m_Nodes.clear();
+    m_UnusedNodes.clear();
+
+    m_FirstLevelBitmap = 0;
+    std::fill(std::begin(m_SecondLevelBitmaps), std::end(m_SecondLevelBitmaps), 0);
+    for (auto &heads : m_FreeHeads) {
+        std::fill(std::begin(heads), std::end(heads), InvalidNode);
+    }
+
+    if (capacity == 0) {
+        return;
+    }
+
+    const uint32_t node = CreateNode();
+    m_Nodes[node].Offset = 0;
+    m_Nodes[node].Size = capacity;
+    InsertFreeNode(node);
+}
+
+RangeAllocator::Allocation RangeAllocator::Allocate(uint32_t size, uint32_t alignment) {
+    assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+
+    if (size == 0) {
+        return {};
+    }
+
+    // Look for room for the worst case alignment padding, so that whatever
+    // the offset of the range we find, the aligned allocation fits in it.
+    const uint64_t searchSize = uint64_t{ size } + alignment - 1;
+    if (searchSize > m_Capacity) {
+        return {};
+    }
+
+    const uint32_t node = FindFreeNode(static_cast<uint32_t>(searchSize));
+    if (node == InvalidNode) {
+        return {};
+    }
+    RemoveFreeNode(node);
+
+    // Give the padding in front of the aligned offset back to the free lists.
+    const uint32_t alignedOffset = (m_Nodes[node].Offset + alignment - 1) & ~(alignment - 1);
+    const uint32_t padding = alignedOffset - m_Nodes[node].Offset;
+    if (padding > 0) {
+        const uint32_t front = CreateNode();
+        m_Nodes[front].Offset = m_Nodes[node].Offset;
+        m_Nodes[front].Size = padding;
+        m_Nodes[front].PrevPhysical = m_Nodes[node].PrevPhysical;
+        m_Nodes[front].NextPhysical = node;
+        if (m_Nodes[front].PrevPhysical != InvalidNode) {
+            m_Nodes[m_Nodes[front].PrevPhysical].NextPhysical = front;
+        }
+        m_Nodes[node].PrevPhysical = front;
+        m_Nodes[node].Offset = alignedOffset;
+        m_Nodes[node].Size -= padding;
+        InsertFreeNode(front);
+    }
+
+    // Same for what remains after the allocation.
+    if (m_Nodes[node].Size > size) {
+        const uint32_t back = CreateNode();
+        m_Nodes[back].Offset = m_Nodes[node].Offset + size;
+        m_Nodes[back].Size = m_Nodes[node].Size - size;
+        m_Nodes[back].PrevPhysical = node;
+        m_Nodes[back].NextPhysical = m_Nodes[node].NextPhysical;
+        if (m_Nodes[back].NextPhysical != InvalidNode) {
+            m_Nodes[m_Nodes[back].NextPhysical].PrevPhysical = back;
+        }
+        m_Nodes[node].NextPhysical = back;
+        m_Nodes[node].Size = size;
+        InsertFreeNode(back);
+    }
+
+    m_Nodes[node].Used = true;
+    m_UsedSize += size;
+    ++m_AllocationCount;
+
+    return { m_Nodes[node].Offset, node };
+}
+
+void RangeAllocator::Free(Allocation allocation) {
+    if (!allocation.IsValid()) {
+        return;
+    }
+
+    uint32_t node = allocation.Node;
+    assert(node < m_Nodes.size() && m_Nodes[node].Used);
+
+    m_Nodes[node].Used = false;
+    m_UsedSize -= m_Nodes[node].Size;
+    --m_AllocationCount;
+
+    // Merge with the previous range if it is free.
+    const uint32_t prev = m_Nodes[node].PrevPhysical;
+    if (prev != InvalidNode && !m_Nodes[prev].Used) {
+        RemoveFreeNode(prev);
+        m_Nodes[node].Offset = m_Nodes[prev].Offset;
+        m_Nodes[node].Size += m_Nodes[prev].Size;
+        m_Nodes[node].PrevPhysical = m_Nodes[prev].PrevPhysical;
+        if (m_Nodes[node].PrevPhysical != InvalidNode) {
+            m_Nodes[m_Nodes[node].PrevPhysical].NextPhysical = node;
+        }
+        DestroyNode(prev);
+    }
+
+    // And with the next one.
+    const uint32_t next = m_Nodes[node].NextPhysical;
+    if (next != InvalidNode && !m_Nodes[next].Used) {
+        RemoveFreeNode(next);
+        m_Nodes[node].Size += m_Nodes[next].Size;
+        m_Nodes[node].NextPhysical = m_Nodes[next].NextPhysical;
+        if (m_Nodes[node].NextPhysical != InvalidNode) {
+            m_Nodes[m_Nodes[node].NextPhysical].PrevPhysical = node;
+        }
+        DestroyNode(next);
+    }
+
+    InsertFreeNode(node);
+}
+
+RangeAllocator::Stats RangeAllocator::GetStats() const {
+    Stats stats;
+    stats.Capacity = m_Capacity;
+    stats.UsedSize = m_UsedSize;
+    stats.FreeSize = m_Capacity - m_UsedSize;
+    stats.FreeRangeCount = m_FreeRangeCount;
+    stats.AllocationCount = m_AllocationCount;
+
+    // The largest free range lives in the highest non-empty bin, but bins
+    // cover a span of sizes so we still have to walk that bin's list.
+    if (m_FirstLevelBitmap != 0) {
+        const uint32_t firstLevel = FindLastSet(m_FirstLevelBitmap);
+        const uint32_t secondLevel = FindLastSet(m_SecondLevelBitmaps[firstLevel]);
+        for (uint32_t node = m_FreeHeads[firstLevel][secondLevel]; node != InvalidNode; node = m_Nodes[node].NextFree) {
+            stats.LargestFreeRange = std::max(stats.LargestFreeRange, m_Nodes[node].Size);
+        }
+    }
+
+    if (m_Capacity > 0) {
+        stats.Utilization = static_cast<float>(m_UsedSize) / static_cast<float>(m_Capacity);
+    }
+    if (stats.FreeSize > 0) {
+        stats.Fragmentation = 1.0f - static_cast<float>(stats.LargestFreeRange) / static_cast<float>(stats.FreeSize);
+    }
+
+    return stats;
+}
+
+uint32_t RangeAllocator::CreateNode() {
+    if (!m_UnusedNodes.empty()) {
+        const uint32_t node = m_UnusedNodes.back();
+        m_UnusedNodes.pop_back();
+        m_Nodes[node] = Node{};
+        return node;
+    }
+    m_Nodes.emplace_back();
+    return static_cast<uint32_t>(m_Nodes.size() - 1);
+}
+
+void RangeAllocator::DestroyNode(uint32_t node) {
+    m_UnusedNodes.push_back(node);
+}
+
+void RangeAllocator::InsertFreeNode(uint32_t node) {
+    uint32_t firstLevel, secondLevel;
+    MappingInsert(m_Nodes[node].Size, firstLevel, secondLevel);
+
+    const uint32_t head = m_FreeHeads[firstLevel][secondLevel];
+    m_Nodes[node].PrevFree = InvalidNode;
+    m_Nodes[node].NextFree = head;
+    if (head != InvalidNode) {
+        m_Nodes[head].PrevFree = node;
+    }
+    m_FreeHeads[firstLevel][secondLevel] = node;
+
+    m_FirstLevelBitmap |= 1u << firstLevel;
+    m_SecondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+    ++m_FreeRangeCount;
+}
+
+void RangeAllocator::RemoveFreeNode(uint32_t node) {
+    uint32_t firstLevel, secondLevel;
+    MappingInsert(m_Nodes[node].Size, firstLevel, secondLevel);
+
+    const uint32_t prev = m_Nodes[node].PrevFree;
+    const uint32_t next = m_Nodes[node].NextFree;
+    if (prev != InvalidNode) {
+        m_Nodes[prev].NextFree = next;
+    } else {
+        m_FreeHeads[firstLevel][secondLevel] = next;
+    }
+    if (next != InvalidNode) {
+        m_Nodes[next].PrevFree = prev;
+    }
+    m_Nodes[node].PrevFree = InvalidNode;
+    m_Nodes[node].NextFree = InvalidNode;
+
+    if (m_FreeHeads[firstLevel][secondLevel] == InvalidNode) {
+        m_SecondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+        if (m_SecondLevelBitmaps[firstLevel] == 0) {
+            m_FirstLevelBitmap &= ~(1u << firstLevel);
+        }
+    }
+    --m_FreeRangeCount;
+}
+
+uint32_t RangeAllocator::FindFreeNode(uint32_t size) const {
+    uint32_t firstLevel, secondLevel;
+    if (!MappingSearch(size, firstLevel, secondLevel)) {
+        return InvalidNode;
+    }
+
+    // First look for a bin of the same power of two that is large enough...
+    uint32_t secondLevelMap = secondLevel < 32 ? m_SecondLevelBitmaps[firstLevel] & (~0u << secondLevel) : 0;
+    if (secondLevelMap == 0) {
+        // ...then in the next non-empty power of two.
+        const uint32_t firstLevelMap = firstLevel + 1 < FirstLevelCount ? m_FirstLevelBitmap & (~0u << (firstLevel + 1)) : 0;
+        if (firstLevelMap == 0) {
+            return InvalidNode;
+        }
+        firstLevel = FindFirstSet(firstLevelMap);
+        secondLevelMap = m_SecondLevelBitmaps[firstLevel];
+    }
+    secondLevel = FindFirstSet(secondLevelMap);
+
+    return m_FreeHeads[firstLevel][secondLevel];
+}
@@ -0,0 +1,341 @@
+#include "ReadbackRing.hpp"
+
+#include <webgpu/webgpu.h>
+
+#include <magic_enum/magic_enum.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace {
+    // Required by wgpuCommandEncoderCopyTextureToBuffer.
+    constexpr uint32_t RowPitchAlignment = 256;
+    // Slot buffers grow in steps of this size, so that requests of slightly
+    // different sizes (e.g. while resizing) do not reallocate every time.
+    constexpr uint64_t BufferGranularity = 64 * 1024;
+}
+
+uint32_t GetTexelSize(WGPUTextureFormat format) {
+    switch (format) {
+        case WGPUTextureFormat_R8Unorm:
+        case WGPUTextureFormat_R8Snorm:
+        case WGPUTextureFormat_R8Uint:
+        case WGPUTextureFormat_R8Sint:
+        case WGPUTextureFormat_Stencil8:
+            return 1;
+        case WGPUTextureFormat_R16Uint:
+        case WGPUTextureFormat_R16Sint:
+        case WGPUTextureFormat_R16Float:
+        case WGPUTextureFormat_RG8Unorm:
+        case WGPUTextureFormat_RG8Snorm:
+        case WGPUTextureFormat_RG8Uint:
+        case WGPUTextureFormat_RG8Sint:
+        case WGPUTextureFormat_Depth16Unorm:
+            return 2;
+        case WGPUTextureFormat_R32Float:
+        case WGPUTextureFormat_R32Uint:
+        case WGPUTextureFormat_R32Sint:
+        case WGPUTextureFormat_RG16Uint:
+        case WGPUTextureFormat_RG16Sint:
+        case WGPUTextureFormat_RG16Float:
+        case WGPUTextureFormat_RGBA8Unorm:
+        case WGPUTextureFormat_RGBA8UnormSrgb:
+        case WGPUTextureFormat_RGBA8Snorm:
+        case WGPUTextureFormat_RGBA8Uint:
+        case WGPUTextureFormat_RGBA8Sint:
+        case WGPUTextureFormat_BGRA8Unorm:
+        case WGPUTextureFormat_BGRA8UnormSrgb:
+        case WGPUTextureFormat_RGB10A2Unorm:
+        case WGPUTextureFormat_RG11B10Ufloat:
+        case WGPUTextureFormat_Depth32Float:
+            return 4;
+        case WGPUTextureFormat_RG32Float:
+        case WGPUTextureFormat_RG32Uint:
+        case WGPUTextureFormat_RG32Sint:
+        case WGPUTextureFormat_RGBA16Uint:
+        case WGPUTextureFormat_RGBA16Sint:
+        case WGPUTextureFormat_RGBA16Float:
+            return 8;
+        case WGPUTextureFormat_RGBA32Float:
+        case WGPUTextureFormat_RGBA32Uint:
+        case WGPUTextureFormat_RGBA32Sint:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+bool ReadbackRing::Initialize(WGPUDevice device, EventPump &pump, GpuMemoryTracker &memory, uint32_t slotCount) {
+    m_Device = device;
+    m_Pump = &pump;
+    m_Memory = &memory;
+
+    // Buffers are only created by the first requests that need them.
+    m_Slots = std::make_unique<Slot[]>(slotCount);
+    m_SlotCount = slotCount;
+    m_Head = 0;
+    m_Tail = 0;
+    m_Frame = 0;
+    m_Stats = {};
+
+    return slotCount > 0;
+}
+
+void ReadbackRing::Terminate() {
+    // Let pending maps complete so that their coroutines do not resume on
+    // slots that no longer exist.
+    while (IsMapping()) {
+        m_Pump->Wait();
+    }
+
+    for (uint32_t i = 0; i < m_SlotCount; ++i) {
+        Slot &slot = m_Slots[i];
+        if (slot.State == SlotState_Mapped) {
+            wgpuBufferUnmap(slot.Buffer);
+        }
+        slot.State = SlotState_Free;
+        slot.Callback = nullptr;
+        slot.Map = {};
+        if (m_Memory) {
+            m_Memory->Release(slot.Buffer);
+        }
+    }
+
+    m_Slots.reset();
+    m_SlotCount = 0;
+    m_Head = 0;
+    m_Tail = 0;
+    m_Packed = {};
+}
+
+bool ReadbackRing::ReadBuffer(WGPUCommandEncoder encoder, WGPUBuffer source, uint64_t offset, uint64_t size, ReadbackCallback callback) {
+    if (offset % 4 != 0 || size % 4 != 0 || size == 0) {
+        std::cerr << "Buffer readbacks must be a non-empty multiple of 4 bytes, at an offset multiple of 4!\n";
+        return false;
+    }
+
+    Slot *slot = AcquireSlot(size);
+    if (!slot) {
+        return false;
+    }
+
+    wgpuCommandEncoderCopyBufferToBuffer(encoder, source, offset, slot->Buffer, 0, size);
+
+    slot->Callback = std::move(callback);
+    slot->Size = size;
+    slot->Width = 0;
+    slot->Height = 0;
+    slot->RowBytes = 0;
+    slot->PaddedRowBytes = 0;
+    slot->Format = WGPUTextureFormat_Undefined;
+    return true;
+}
+
+bool ReadbackRing::ReadTexture(WGPUCommandEncoder encoder, WGPUTexture texture, uint32_t width, uint32_t height, ReadbackCallback callback, uint32_t mipLevel) {
+    const WGPUTextureFormat format = wgpuTextureGetFormat(texture);
+    const uint32_t texelSize = GetTexelSize(format);
+    if (texelSize == 0) {
+        std::cerr << "Cannot read back textures of format " << magic_enum::enum_name<WGPUTextureFormat>(format) << "!\n";
+        return false;
+    }
+    if (width == 0 || height == 0) {
+        return false;
+    }
+
+    const uint32_t rowBytes = width * texelSize;
+    const uint32_t paddedRowBytes = (rowBytes + RowPitchAlignment - 1) / RowPitchAlignment * RowPitchAlignment;
+    const uint64_t size = uint64_t{ paddedRowBytes } * height;
+
+    Slot *slot = AcquireSlot(size);
+    if (!slot) {
+        return false;
+    }
+
+    WGPUImageCopyTexture source = {};
+    source.nextInChain = nullptr;
+    source.texture = texture;
+    source.mipLevel = mipLevel;
+    source.origin = { 0, 0, 0 };
+    // Depth and stencil can only be copied one aspect at a time.
+    source.aspect = WGPUTextureAspect_All;
+    if (format == WGPUTextureFormat_Depth32Float || format == WGPUTextureFormat_Depth16Unorm) {
+        source.aspect = WGPUTextureAspect_DepthOnly;
+    } else if (format == WGPUTextureFormat_Stencil8) {
+        source.aspect = WGPUTextureAspect_StencilOnly;
+    }
+
+    WGPUImageCopyBuffer destination = {};
+    destination.nextInChain = nullptr;
+    destination.layout.nextInChain = nullptr;
+    destination.layout.offset = 0;
+    destination.layout.bytesPerRow = paddedRowBytes;
+    destination.layout.rowsPerImage = height;
+    destination.buffer = slot->Buffer;
+
+    const WGPUExtent3D copySize = { width, height, 1 };
+    wgpuCommandEncoderCopyTextureToBuffer(encoder, &source, &destination, &copySize);
+
+    slot->Callback = std::move(callback);
+    slot->Size = size;
+    slot->Width = width;
+    slot->Height = height;
+    slot->RowBytes = rowBytes;
+    slot->PaddedRowBytes = paddedRowBytes;
+    slot->Format = format;
+    return true;
+}
+
+void ReadbackRing::OnSubmitted() {
+    for (uint64_t i = m_Tail; i < m_Head; ++i) {
+        Slot &slot = m_Slots[i % m_SlotCount];
+        if (slot.State == SlotState_Recorded) {
+            // The previous map of the slot was collected, its coroutine is
+            // done.
+            slot.State = SlotState_Mapping;
+            slot.Map = MapSlot(slot);
+            slot.Map.Start();
+        }
+    }
+}
+
+void ReadbackRing::Collect() {
+    ++m_Frame;
+
+    // Maps only complete while the events are pumped. This does not wait
+    // for anything.
+    if (IsMapping()) {
+        m_Pump->Pump();
+    }
+
+    // Results are delivered in request order, a slow one holds back the
+    // ones that follow it.
+    while (m_Tail < m_Head) {
+        Slot &slot = m_Slots[m_Tail % m_SlotCount];
+        const uint32_t state = slot.State;
+        if (state != SlotState_Mapped && state != SlotState_Failed) {
+            break;
+        }
+
+        ReadbackResult result;
+        result.Width = slot.Width;
+        result.Height = slot.Height;
+        result.RowBytes = slot.RowBytes;
+        result.Format = slot.Format;
+        result.LatencyFrames = m_Frame - slot.RequestFrame;
+
+        const void *data = state == SlotState_Mapped ? wgpuBufferGetConstMappedRange(slot.Buffer, 0, slot.Size) : nullptr;
+        if (data && slot.PaddedRowBytes != slot.RowBytes) {
+            // Only textures have padded rows.
+            m_Packed.resize(size_t{ slot.RowBytes } * slot.Height);
+            for (uint32_t row = 0; row < slot.Height; ++row) {
+                std::memcpy(
+                    m_Packed.data() + size_t{ row } * slot.RowBytes,
+                    static_cast<const uint8_t *>(data) + size_t{ row } * slot.PaddedRowBytes,
+                    slot.RowBytes
+                );
+            }
+            result.Data = m_Packed.data();
+            result.Size = m_Packed.size();
+            m_Stats.PaddingBytes += slot.Size - result.Size;
+        } else if (data) {
+            result.Data = data;
+            result.Size = slot.Size;
+        }
+
+        if (result.Data) {
+            ++m_Stats.Completed;
+            m_Stats.BytesRead += slot.Size;
+            m_Stats.TotalLatencyFrames += result.LatencyFrames;
+        } else {
+            ++m_Stats.Failed;
+        }
+
+        if (slot.Callback) {
+            slot.Callback(result);
+        }
+
+        if (state == SlotState_Mapped) {
+            wgpuBufferUnmap(slot.Buffer);
+        }
+        slot.Callback = nullptr;
+        slot.State = SlotState_Free;
+        ++m_Tail;
+    }
+}
+
+void ReadbackRing::Flush() {
+    for (uint64_t i = m_Tail; i < m_Head; ++i) {
+        if (m_Slots[i % m_SlotCount].State == SlotState_Recorded) {
+            std::cerr << "Readbacks must be submitted before they can be flushed!\n";
+            return;
+        }
+    }
+
+    while (m_Tail < m_Head) {
+        if (IsMapping()) {
+            m_Pump->Wait();
+        }
+        Collect();
+    }
+}
+
+ReadbackRing::Slot *ReadbackRing::AcquireSlot(uint64_t size) {
+    if (!HasFreeSlot()) {
+        ++m_Stats.Dropped;
+        return nullptr;
+    }
+
+    Slot &slot = m_Slots[m_Head % m_SlotCount];
+    if (slot.Capacity < size) {
+        m_Memory->Release(slot.Buffer);
+        slot.Capacity = 0;
+
+        WGPUBufferDescriptor bufferDesc = {};
+        bufferDesc.nextInChain = nullptr;
+        bufferDesc.label = "Readback buffer";
+        bufferDesc.usage = WGPUBufferUsage_MapRead | WGPUBufferUsage_CopyDst;
+        bufferDesc.size = (size + BufferGranularity - 1) / BufferGranularity * BufferGranularity;
+        bufferDesc.mappedAtCreation = false;
+        slot.Buffer = m_Memory->CreateBuffer(m_Device, bufferDesc, GpuMemoryCategory_Staging);
+        if (!slot.Buffer) {
+            std::cerr << "Could not create a readback buffer of " << bufferDesc.size << " bytes!\n";
+            ++m_Stats.Dropped;
+            return nullptr;
+        }
+        slot.Capacity = bufferDesc.size;
+        ++m_Stats.BuffersCreated;
+    }
+
+    slot.State = SlotState_Recorded;
+    slot.RequestFrame = m_Frame;
+    ++m_Head;
+    ++m_Stats.Requests;
+    return &slot;
+}
+
+Task<bool> ReadbackRing::MapSlot(Slot &slot) {
+    const WGPUBufferMapAsyncStatus status = co_await MapBufferAsync(*m_Pump, slot.Buffer, WGPUMapMode_Read, 0, slot.Size);
+    slot.State = status == WGPUBufferMapAsyncStatus_Success ? SlotState_Mapped : SlotState_Failed;
+    co_return status == WGPUBufferMapAsyncStatus_Success;
+}
+
+bool ReadbackRing::IsMapping() const {
+    for (uint64_t i = m_Tail; i < m_Head; ++i) {
+        if (m_Slots[i % m_SlotCount].State == SlotState_Mapping) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PrintReadbackStats(const ReadbackStats &stats) {
+    std::cout << "Readback:\n";
+    std::cout << " - requests: " << stats.Requests << " (" << stats.Completed << " completed, "
+              << stats.Failed << " failed, " << stats.Dropped << " dropped)\n";
+    std::cout << " - bytes read: " << stats.BytesRead << " (" << stats.PaddingBytes << " bytes of row padding)\n";
+    if (stats.Completed > 0) {
+        std::cout << " - average latency: " << static_cast<double>(stats.TotalLatencyFrames) / stats.Completed << " frames\n";
+    }
+    std::cout << " - buffers created: " << stats.BuffersCreated << '\n';
+}
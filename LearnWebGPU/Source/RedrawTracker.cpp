@@ -0,0 +1,49 @@
+#include "RedrawTracker.hpp"
+
+#include <iostream>
+
+void RedrawTracker::MarkDirty(RedrawReason reason) {
+    m_PendingReasons.fetch_or(reason, std::memory_order_release);
+}
+
+uint32_t RedrawTracker::ConsumeReasons() {
+    const uint32_t reasons = m_PendingReasons.exchange(RedrawReason_None, std::memory_order_acquire);
+
+    ++m_Stats.Loops;
+    if (reasons == RedrawReason_None) {
+        ++m_Stats.IdleWakeups;
+        return reasons;
+    }
+
+    ++m_Stats.RedrawnFrames;
+    for (uint32_t i = 0; i < RedrawReason_Count; ++i) {
+        if (reasons & (1u << i)) {
+            ++m_Stats.ReasonCounts[i];
+        }
+    }
+    return reasons;
+}
+
+double RedrawTracker::GetWaitTimeout() const {
+    if (m_PendingReasons.load(std::memory_order_acquire) != RedrawReason_None) {
+        return 0.0;
+    }
+    return MaxIdleSeconds;
+}
+
+void RedrawTracker::RecordIdle(double seconds) {
+    m_Stats.IdleSeconds += seconds;
+}
+
+void PrintRedrawStats(const RedrawStats &stats) {
+    static const char *reasonNames[RedrawReason_Count] = { "input", "resize", "resource", "expose" };
+
+    std::cout << "On-demand rendering:\n";
+    std::cout << " - loop iterations: " << stats.Loops << '\n';
+    std::cout << " - redrawn frames: " << stats.RedrawnFrames << '\n';
+    std::cout << " - idle wakeups: " << stats.IdleWakeups << '\n';
+    std::cout << " - time spent idle: " << stats.IdleSeconds << " s\n";
+    for (uint32_t i = 0; i < RedrawReason_Count; ++i) {
+        std::cout << " - redraws for " << reasonNames[i] << ": " << stats.ReasonCounts[i] << '\n';
+    }
+}
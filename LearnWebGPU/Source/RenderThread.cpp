@@ -0,0 +1,78 @@
+#include "RenderThread.hpp"
+
+#include <atomic>
+#include <iostream>
+
+RenderThread::~RenderThread() {
+    Stop();
+}
+
+void RenderThread::Start(RenderFunction render, ConsumedFunction onConsumed) {
+    m_Render = std::move(render);
+    m_OnConsumed = std::move(onConsumed);
+    m_Thread = std::thread(&RenderThread::Run, this);
+}
+
+void RenderThread::Stop() {
+    if (!m_Thread.joinable()) {
+        return;
+    }
+
+    FramePacket quit;
+    quit.Quit = true;
+    while (!m_Queue.TryPush(quit)) {
+        m_Queue.WaitForSpace();
+    }
+
+    m_Thread.join();
+}
+
+bool RenderThread::TrySubmit(const FramePacket &packet) {
+    if (m_Queue.TryPush(packet)) {
+        return true;
+    }
+    ++m_ProducerWaits;
+    return false;
+}
+
+RenderThreadStats RenderThread::GetStats() const {
+    RenderThreadStats stats;
+    stats.RenderedPackets = m_RenderedPackets.load();
+    stats.ProducerWaits = m_ProducerWaits;
+    stats.ConsumerIdleSeconds = m_ConsumerIdleSeconds;
+    return stats;
+}
+
+void RenderThread::Run() {
+    FramePacket packet;
+    while (true) {
+        if (!m_Queue.TryPop(packet)) {
+            const Clock::time_point start = Clock::now();
+            m_Queue.WaitForItem();
+            m_ConsumerIdleSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+            continue;
+        }
+
+        if (m_OnConsumed) {
+            // Pairs with the fence of a producer about to sleep: the slot
+            // just freed must be visible before onConsumed reads whether it
+            // sleeps, or both sides may see stale values.
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            m_OnConsumed();
+        }
+
+        if (packet.Quit) {
+            break;
+        }
+
+        m_Render(packet);
+        m_RenderedPackets.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void PrintRenderThreadStats(const RenderThreadStats &stats) {
+    std::cout << "Render thread:\n";
+    std::cout << " - rendered frames: " << stats.RenderedPackets << '\n';
+    std::cout << " - main thread waits: " << stats.ProducerWaits << '\n';
+    std::cout << " - render thread idle: " << stats.ConsumerIdleSeconds * 1000.0 << " ms\n";
+}
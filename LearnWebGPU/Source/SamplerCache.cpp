@@ -0,0 +1,71 @@
+#include "SamplerCache.hpp"
+
+#include <webgpu/webgpu.h>
+
+#include <iostream>
+
+#include "Hash.hpp"
+
+namespace {
+    // Field by field, so that padding never gets hashed.
+    uint64_t HashSamplerState(const SamplerState &state) {
+        uint64_t hash = HashValue(state.AddressModeU);
+        hash = HashValue(state.AddressModeV, hash);
+        hash = HashValue(state.AddressModeW, hash);
+        hash = HashValue(state.MagFilter, hash);
+        hash = HashValue(state.MinFilter, hash);
+        hash = HashValue(state.MipmapFilter, hash);
+        hash = HashValue(state.LodMinClamp, hash);
+        hash = HashValue(state.LodMaxClamp, hash);
+        hash = HashValue(state.Compare, hash);
+        return HashValue(state.MaxAnisotropy, hash);
+    }
+}
+
+void SamplerCache::Initialize(WGPUDevice device) {
+    m_Device = device;
+}
+
+void SamplerCache::Terminate() {
+    std::lock_guard lock(m_Mutex);
+    m_Samplers.clear();
+}
+
+WGPUSampler SamplerCache::Get(const SamplerState &state) {
+    const uint64_t hash = HashSamplerState(state);
+
+    std::lock_guard lock(m_Mutex);
+    ++m_Stats.Requests;
+    auto it = m_Samplers.find(hash);
+    if (it != m_Samplers.end()) {
+        return it->second;
+    }
+
+    WGPUSamplerDescriptor samplerDesc = {};
+    samplerDesc.nextInChain = nullptr;
+    samplerDesc.label = "Cached sampler";
+    samplerDesc.addressModeU = state.AddressModeU;
+    samplerDesc.addressModeV = state.AddressModeV;
+    samplerDesc.addressModeW = state.AddressModeW;
+    samplerDesc.magFilter = state.MagFilter;
+    samplerDesc.minFilter = state.MinFilter;
+    samplerDesc.mipmapFilter = state.MipmapFilter;
+    samplerDesc.lodMinClamp = state.LodMinClamp;
+    samplerDesc.lodMaxClamp = state.LodMaxClamp;
+    samplerDesc.compare = state.Compare;
+    samplerDesc.maxAnisotropy = state.MaxAnisotropy;
+
+    SamplerHandle sampler(wgpuDeviceCreateSampler(m_Device, &samplerDesc));
+    if (!sampler) {
+        std::cerr << "Could not create a sampler!\n";
+        return nullptr;
+    }
+
+    ++m_Stats.SamplersCreated;
+    return m_Samplers.emplace(hash, std::move(sampler)).first->second;
+}
+
+SamplerCacheStats SamplerCache::GetStats() const {
+    std::lock_guard lock(m_Mutex);
+    return m_Stats;
+}
@@ -0,0 +1,162 @@
+#include "Scene.hpp"
+
+#include <random>
+
+namespace {
+    // The vertex colors of the logo are gamma encoded.
+    constexpr float ColorGamma = 2.2f;
+
+    // Enough copies of a screen-filling logo to shade every pixel dozens of
+    // times without a depth test.
+    constexpr uint32_t OverdrawSceneDrawCount = 256;
+
+    // Draw call and upload overhead rather than fill rate.
+    constexpr uint32_t GridSceneSize = 32;
+
+    Matrix4 CenterMesh(const MeshRegistry &meshes, MeshId mesh) {
+        const float *center = meshes.Get(mesh).Bounds.Center;
+        return Matrix4::Translation(-center[0], -center[1], -center[2]);
+    }
+}
+
+std::vector<SceneObject> BuildSceneObjects(SceneType type, const MeshRegistry &meshes) {
+    std::vector<SceneObject> objects;
+    const uint32_t meshCount = meshes.GetMeshCount();
+    if (meshCount == 0) {
+        return objects;
+    }
+
+    switch (type) {
+        case SceneType_Logo: {
+            // Side by side, a single mesh is centered in the window as it
+            // always was.
+            const float scale = 1.0f / meshCount;
+            for (MeshId mesh = 0; mesh < meshCount; ++mesh) {
+                const float x = 2.0f * scale * (mesh + 0.5f) - 1.0f;
+                objects.push_back({ mesh, Matrix4::Translation(x, 0.0f, 0.5f) * Matrix4::Scaling(scale, scale, 1.0f) * CenterMesh(meshes, mesh) });
+            }
+            break;
+        }
+        case SceneType_Overdraw: {
+            // A fixed seed so that every run draws the same scene, in the
+            // same (random) order.
+            std::mt19937 generator(42);
+            std::uniform_real_distribution<float> centerDistribution(-0.5f, 0.5f);
+            std::uniform_real_distribution<float> scaleDistribution(1.5f, 2.5f);
+            std::uniform_real_distribution<float> depthDistribution(0.05f, 0.95f);
+
+            objects.reserve(GetSceneObjectCount(type, meshCount));
+            for (uint32_t i = 0; i < OverdrawSceneDrawCount; ++i) {
+                const float scale = scaleDistribution(generator);
+                const float x = centerDistribution(generator);
+                const float y = centerDistribution(generator);
+                const float depth = depthDistribution(generator);
+                const MeshId mesh = i % meshCount;
+                objects.push_back({ mesh, Matrix4::Translation(x, y, depth) * Matrix4::Scaling(scale, scale, 1.0f) * CenterMesh(meshes, mesh) });
+            }
+            break;
+        }
+        case SceneType_Grid: {
+            const float scale = 1.5f / GridSceneSize;
+            objects.reserve(GetSceneObjectCount(type, meshCount));
+            for (uint32_t y = 0; y < GridSceneSize; ++y) {
+                for (uint32_t x = 0; x < GridSceneSize; ++x) {
+                    const float offsetX = -0.9f + 1.8f * (x + 0.5f) / GridSceneSize;
+                    const float offsetY = -0.9f + 1.8f * (y + 0.5f) / GridSceneSize;
+                    const MeshId mesh = (y * GridSceneSize + x) % meshCount;
+                    objects.push_back({ mesh, Matrix4::Translation(offsetX, offsetY, 0.5f) * Matrix4::Scaling(scale, scale, 1.0f) * CenterMesh(meshes, mesh) });
+                }
+            }
+            break;
+        }
+    }
+    return objects;
+}
+
+uint32_t GetSceneObjectCount(SceneType type, uint32_t meshCount) {
+    if (meshCount == 0) {
+        return 0;
+    }
+
+    switch (type) {
+        case SceneType_Logo:
+            return meshCount;
+        case SceneType_Overdraw:
+            return OverdrawSceneDrawCount;
+        case SceneType_Grid:
+            return GridSceneSize * GridSceneSize;
+    }
+    return 0;
+}
+
+RenderPipelineState GetScenePipelineState(WGPUTextureFormat colorFormat, WGPUTextureFormat depthFormat, WGPUPipelineLayout layout) {
+    RenderPipelineState state;
+    state.ShaderPath = "Resources/Shaders/basic.wgsl";
+    state.VertexEntryPoint = "vs_main";
+    state.FragmentEntryPoint = "fs_main";
+    // Values of the `override` declarations of the shader.
+    state.Constants["AspectRatio"] = SceneAspectRatio;
+    state.Constants["ColorGamma"] = ColorGamma;
+
+    // == For each attribute, describe its layout, i.e, how to interpret the raw data ==
+    VertexBufferState vertexBuffer;
+    vertexBuffer.Attributes.resize(SceneVertexAttributeCount);
+
+    // Position
+    // Corresponds to @location(...)
+    vertexBuffer.Attributes[0].shaderLocation = 0;
+    // Means vec2f in the shader.
+    vertexBuffer.Attributes[0].format = WGPUVertexFormat_Float32x2;
+    // Index of the first element.
+    vertexBuffer.Attributes[0].offset = 0;
+
+    // Color
+    vertexBuffer.Attributes[1].shaderLocation = 1;
+    vertexBuffer.Attributes[1].format = WGPUVertexFormat_Float32x3;
+    vertexBuffer.Attributes[1].offset = 2 * sizeof(float);
+
+    // == Common to attributes from the same buffer ==
+    vertexBuffer.ArrayStride = SceneVertexStride;
+    vertexBuffer.StepMode = WGPUVertexStepMode_Vertex;
+
+    state.VertexBuffers.push_back(vertexBuffer);
+
+    // Each sequence of 3 vertices is considered a triangle.
+    state.Topology = WGPUPrimitiveTopology_TriangleList;
+
+    // The face orientation is defined by assuming thate when looking
+    // from the front of the face, its corner vertices are enumerated
+    // in the counter-clockwise (CCW) order.
+    state.FrontFace = WGPUFrontFace_CCW;
+
+    // But the face orientation does not matter much because we do not
+    // cull (i.e. "hide") the faces pointing away from us (which is often
+    // used for optimization).
+    state.CullMode = WGPUCullMode_None;
+
+    state.ColorFormat = colorFormat;
+
+    // Everything we draw is opaque: with a depth buffer, we write depth and
+    // skip blending so that the hardware can reject hidden fragments early.
+    const bool depth = depthFormat != WGPUTextureFormat_Undefined;
+    if (depth) {
+        state.DepthFormat = depthFormat;
+        state.DepthWriteEnabled = true;
+        state.DepthCompare = WGPUCompareFunction_Less;
+    }
+
+    state.BlendEnabled = !depth;
+    state.Blend.color.srcFactor = WGPUBlendFactor_SrcAlpha;
+    state.Blend.color.dstFactor = WGPUBlendFactor_OneMinusSrcAlpha;
+    state.Blend.color.operation = WGPUBlendOperation_Add;
+
+    state.Blend.alpha.srcFactor = WGPUBlendFactor_Zero;
+    state.Blend.alpha.dstFactor = WGPUBlendFactor_One;
+    state.Blend.alpha.operation = WGPUBlendOperation_Add;
+
+    // Samples per pixel
+    state.SampleCount = 1;
+
+    state.Layout = layout;
+    return state;
+}
@@ -0,0 +1,145 @@
+#include "ShaderCache.hpp"
+
+#include <webgpu/webgpu.h>
+
+#include <chrono>
+#include <iostream>
+
+#include "FileLoader.hpp"
+#include "Hash.hpp"
+
+namespace {
+    // Beyond this, only the permutations that are requested get expanded.
+    constexpr size_t MaxEnumeratedOptions = 8;
+
+    uint64_t HashPermutation(const std::string &path, const ShaderDefines &defines) {
+        uint64_t hash = HashString(path);
+        for (const auto &[name, value] : defines) {
+            hash = HashString(name, hash);
+            hash = HashString(value, hash);
+        }
+        return hash;
+    }
+}
+
+void ShaderCache::Initialize(WGPUDevice device) {
+    m_Device = device;
+}
+
+void ShaderCache::Terminate() {
+    std::lock_guard lock(m_Mutex);
+    m_Modules.clear();
+    m_Sources.clear();
+    m_PermutationHashes.clear();
+    m_LoadedPaths.clear();
+}
+
+bool ShaderCache::GetSourceHash(const std::string &path, ShaderHash &hash, const ShaderDefines &defines) {
+    const uint64_t key = HashPermutation(path, defines);
+    {
+        std::lock_guard lock(m_Mutex);
+        auto it = m_PermutationHashes.find(key);
+        if (it != m_PermutationHashes.end()) {
+            hash = it->second;
+            return true;
+        }
+    }
+
+    PreprocessedShader shader;
+    if (!PreprocessShader(path, defines, shader)) {
+        return false;
+    }
+
+    hash = HashString(shader.Source);
+
+    bool firstLoad;
+    {
+        std::lock_guard lock(m_Mutex);
+        AddPermutation(key, hash, std::move(shader.Source));
+        firstLoad = m_LoadedPaths.insert(path).second;
+        if (firstLoad) {
+            ++m_Stats.SourcesLoaded;
+        }
+    }
+
+    if (firstLoad) {
+        ExpandPermutations(path, shader.Options);
+    }
+    return true;
+}
+
+WGPUShaderModule ShaderCache::GetModule(ShaderHash hash) {
+    std::string source;
+    {
+        std::lock_guard lock(m_Mutex);
+        auto it = m_Modules.find(hash);
+        if (it != m_Modules.end()) {
+            ++m_Stats.ModuleHits;
+            return it->second;
+        }
+        auto sourceIt = m_Sources.find(hash);
+        if (sourceIt == m_Sources.end()) {
+            return nullptr;
+        }
+        source = sourceIt->second;
+    }
+
+    // Compile without holding the lock so that different shaders can be
+    // compiled in parallel.
+    const auto start = std::chrono::steady_clock::now();
+    ShaderModuleHandle module(CreateShaderModule(source, m_Device));
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::lock_guard lock(m_Mutex);
+    auto [it, inserted] = m_Modules.try_emplace(hash, std::move(module));
+    if (!inserted) {
+        // Another thread compiled the same source in the meantime, ours is
+        // released when going out of scope.
+        ++m_Stats.ModuleHits;
+        return it->second;
+    }
+    ++m_Stats.ModulesCompiled;
+    m_Stats.CompileSeconds += seconds;
+    return it->second;
+}
+
+ShaderCacheStats ShaderCache::GetStats() const {
+    std::lock_guard lock(m_Mutex);
+    return m_Stats;
+}
+
+void ShaderCache::ExpandPermutations(const std::string &path, const std::vector<std::string> &options) {
+    if (options.size() > MaxEnumeratedOptions) {
+        return;
+    }
+
+    for (const ShaderDefines &defines : EnumeratePermutations(options)) {
+        const uint64_t key = HashPermutation(path, defines);
+        {
+            std::lock_guard lock(m_Mutex);
+            if (m_PermutationHashes.contains(key)) {
+                continue;
+            }
+        }
+
+        // Errors are printed, and reported again if the permutation is
+        // ever requested.
+        PreprocessedShader shader;
+        if (!PreprocessShader(path, defines, shader)) {
+            continue;
+        }
+
+        const ShaderHash hash = HashString(shader.Source);
+        std::lock_guard lock(m_Mutex);
+        AddPermutation(key, hash, std::move(shader.Source));
+    }
+}
+
+void ShaderCache::AddPermutation(uint64_t key, ShaderHash hash, std::string source) {
+    if (m_PermutationHashes.emplace(key, hash).second) {
+        ++m_Stats.Permutations;
+    }
+    if (m_Sources.try_emplace(hash, std::move(source)).second) {
+        ++m_Stats.Variants;
+    }
+}
@@ -0,0 +1,194 @@
+#include "ShaderPreprocessor.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <set>
+#include <sstream>
+
+#include "FileLoader.hpp"
+
+namespace {
+    struct Conditional {
+        // Whether the enclosing block is kept.
+        bool ParentActive = true;
+        bool Condition = true;
+        bool SeenElse = false;
+    };
+
+    struct PreprocessorState {
+        ShaderDefines Defines;
+        std::vector<Conditional> Conditionals;
+        std::set<std::string> Options;
+        PreprocessedShader *Shader = nullptr;
+    };
+
+    bool IsIdentifierStart(char c) {
+        return std::isalpha(static_cast<unsigned char>(c)) || c == '_';
+    }
+
+    bool IsIdentifierChar(char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+    }
+
+    bool IsActive(const PreprocessorState &state) {
+        return state.Conditionals.empty() || (state.Conditionals.back().ParentActive && state.Conditionals.back().Condition);
+    }
+
+    // Append line to the output, with the identifiers that have a value
+    // replaced by it.
+    void AppendLine(const std::string &line, PreprocessorState &state) {
+        std::string &output = state.Shader->Source;
+
+        size_t i = 0;
+        while (i < line.size()) {
+            if (!IsIdentifierStart(line[i])) {
+                output += line[i++];
+                continue;
+            }
+
+            size_t end = i + 1;
+            while (end < line.size() && IsIdentifierChar(line[end])) {
+                ++end;
+            }
+
+            const std::string identifier = line.substr(i, end - i);
+            auto it = state.Defines.find(identifier);
+            output += it != state.Defines.end() && !it->second.empty() ? it->second : identifier;
+            i = end;
+        }
+        output += '\n';
+    }
+
+    bool ProcessFile(const std::filesystem::path &path, PreprocessorState &state) {
+        const std::filesystem::path normalPath = path.lexically_normal();
+        std::vector<std::filesystem::path> &files = state.Shader->Files;
+        if (std::find(files.begin(), files.end(), normalPath) != files.end()) {
+            return true;
+        }
+        files.push_back(normalPath);
+
+        std::string text;
+        if (!LoadTextFile(normalPath, text)) {
+            std::cerr << "Could not load shader source " << normalPath.string() << '\n';
+            return false;
+        }
+
+        const size_t conditionalDepth = state.Conditionals.size();
+        auto fail = [&normalPath](uint32_t lineNumber, const std::string &message) {
+            std::cerr << normalPath.string() << ':' << lineNumber << ": " << message << '\n';
+            return false;
+        };
+
+        std::istringstream lines(text);
+        std::string line;
+        uint32_t lineNumber = 0;
+        while (std::getline(lines, line)) {
+            ++lineNumber;
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+
+            const size_t first = line.find_first_not_of(" \t");
+            if (first == std::string::npos || line[first] != '#') {
+                if (IsActive(state)) {
+                    AppendLine(line, state);
+                }
+                continue;
+            }
+
+            std::istringstream directive(line.substr(first + 1));
+            std::string keyword, name, value;
+            directive >> keyword >> name;
+            std::getline(directive >> std::ws, value);
+            while (!value.empty() && std::isspace(static_cast<unsigned char>(value.back()))) {
+                value.pop_back();
+            }
+
+            // Conditionals must be tracked even in blocks that are skipped.
+            if (keyword == "ifdef" || keyword == "ifndef") {
+                if (name.empty()) {
+                    return fail(lineNumber, "#" + keyword + " expects a name");
+                }
+                Conditional conditional;
+                conditional.ParentActive = IsActive(state);
+                conditional.Condition = state.Defines.contains(name) == (keyword == "ifdef");
+                state.Conditionals.push_back(conditional);
+                continue;
+            }
+            if (keyword == "else") {
+                if (state.Conditionals.size() == conditionalDepth || state.Conditionals.back().SeenElse) {
+                    return fail(lineNumber, "#else without #ifdef");
+                }
+                state.Conditionals.back().Condition = !state.Conditionals.back().Condition;
+                state.Conditionals.back().SeenElse = true;
+                continue;
+            }
+            if (keyword == "endif") {
+                if (state.Conditionals.size() == conditionalDepth) {
+                    return fail(lineNumber, "#endif without #ifdef");
+                }
+                state.Conditionals.pop_back();
+                continue;
+            }
+
+            if (!IsActive(state)) {
+                continue;
+            }
+
+            if (keyword == "include") {
+                if (name.size() < 2 || name.front() != '"' || name.back() != '"') {
+                    return fail(lineNumber, "#include expects a quoted path");
+                }
+                if (!ProcessFile(normalPath.parent_path() / name.substr(1, name.size() - 2), state)) {
+                    return fail(lineNumber, "included from here");
+                }
+            } else if (keyword == "define") {
+                if (name.empty()) {
+                    return fail(lineNumber, "#define expects a name");
+                }
+                state.Defines[name] = value;
+            } else if (keyword == "undef") {
+                state.Defines.erase(name);
+            } else if (keyword == "option") {
+                if (name.empty()) {
+                    return fail(lineNumber, "#option expects a name");
+                }
+                state.Options.insert(name);
+            } else {
+                return fail(lineNumber, "unknown directive #" + keyword);
+            }
+        }
+
+        if (state.Conditionals.size() != conditionalDepth) {
+            return fail(lineNumber, "missing #endif");
+        }
+        return true;
+    }
+}
+
+bool PreprocessShader(const std::filesystem::path &path, const ShaderDefines &defines, PreprocessedShader &shader) {
+    shader = {};
+
+    PreprocessorState state;
+    state.Defines = defines;
+    state.Shader = &shader;
+    if (!ProcessFile(path, state)) {
+        return false;
+    }
+
+    shader.Options.assign(state.Options.begin(), state.Options.end());
+    return true;
+}
+
+std::vector<ShaderDefines> EnumeratePermutations(const std::vector<std::string> &options) {
+    std::vector<ShaderDefines> permutations(size_t{ 1 } << options.size());
+    for (size_t mask = 0; mask < permutations.size(); ++mask) {
+        for (size_t i = 0; i < options.size(); ++i) {
+            if (mask & (size_t{ 1 } << i)) {
+                permutations[mask][options[i]] = "";
+            }
+        }
+    }
+    return permutations;
+}
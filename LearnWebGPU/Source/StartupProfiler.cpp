@@ -0,0 +1,161 @@
+#include "StartupProfiler.hpp"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#elif defined(__linux__)
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+namespace {
+    void WriteEntries(std::ofstream &file, const char *key, const std::vector<StartupPhase> &entries, bool withDuration) {
+        file << "  \"" << key << "\": [";
+        for (size_t i = 0; i < entries.size(); ++i) {
+            const StartupPhase &entry = entries[i];
+            file << (i == 0 ? "\n" : ",\n") << "    { \"name\": \"" << entry.Name << "\"";
+            if (withDuration) {
+                file << ", \"start_seconds\": " << entry.StartSeconds << ", \"seconds\": " << entry.Seconds;
+            } else {
+                file << ", \"seconds\": " << entry.StartSeconds;
+            }
+            if (entry.ResidentBytes > 0) {
+                file << ", \"resident_bytes\": " << entry.ResidentBytes;
+            }
+            file << " }";
+        }
+        file << (entries.empty() ? "]" : "\n  ]");
+    }
+}
+
+StartupProfiler::StartupProfiler() : m_Start(std::chrono::steady_clock::now()), m_PhaseStart(m_Start) {}
+
+void StartupProfiler::EndPhase(const char *name) {
+    const auto now = std::chrono::steady_clock::now();
+
+    StartupPhase phase;
+    phase.Name = name;
+    phase.StartSeconds = std::chrono::duration<double>(m_PhaseStart - m_Start).count();
+    phase.Seconds = std::chrono::duration<double>(now - m_PhaseStart).count();
+    phase.ResidentBytes = GetResidentMemory();
+
+    // Measuring the memory is not part of the next phase.
+    m_PhaseStart = std::chrono::steady_clock::now();
+
+    std::lock_guard lock(m_Mutex);
+    m_Phases.push_back(std::move(phase));
+}
+
+void StartupProfiler::MarkMilestone(const char *name) {
+    const double seconds = Elapsed();
+
+    std::lock_guard lock(m_Mutex);
+    const auto found = std::find_if(m_Milestones.begin(), m_Milestones.end(), [name](const StartupPhase &milestone) {
+        return milestone.Name == name;
+    });
+    if (found == m_Milestones.end()) {
+        StartupPhase milestone;
+        milestone.Name = name;
+        milestone.StartSeconds = seconds;
+        milestone.ResidentBytes = GetResidentMemory();
+        m_Milestones.push_back(std::move(milestone));
+    }
+}
+
+void StartupProfiler::RecordBackground(const char *name, double seconds) {
+    StartupPhase background;
+    background.Name = name;
+    background.Seconds = seconds;
+
+    std::lock_guard lock(m_Mutex);
+    m_Background.push_back(std::move(background));
+}
+
+bool StartupProfiler::WriteReport(const std::filesystem::path &path) const {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Could not write the startup report to " << path.string() << "!\n";
+        return false;
+    }
+
+    std::lock_guard lock(m_Mutex);
+    double total = 0.0;
+    for (const StartupPhase &phase : m_Phases) {
+        total = phase.StartSeconds + phase.Seconds;
+    }
+
+    file << "{\n";
+    file << "  \"initialization_seconds\": " << total << ",\n";
+    WriteEntries(file, "phases", m_Phases, true);
+    file << ",\n";
+    WriteEntries(file, "milestones", m_Milestones, false);
+    file << ",\n  \"background\": [";
+    for (size_t i = 0; i < m_Background.size(); ++i) {
+        file << (i == 0 ? "\n" : ",\n") << "    { \"name\": \"" << m_Background[i].Name << "\", \"seconds\": " << m_Background[i].Seconds << " }";
+    }
+    file << (m_Background.empty() ? "]" : "\n  ]") << "\n}\n";
+
+    return file.good();
+}
+
+std::vector<StartupPhase> StartupProfiler::GetPhases() const {
+    std::lock_guard lock(m_Mutex);
+    return m_Phases;
+}
+
+std::vector<StartupPhase> StartupProfiler::GetMilestones() const {
+    std::lock_guard lock(m_Mutex);
+    return m_Milestones;
+}
+
+double StartupProfiler::Elapsed() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_Start).count();
+}
+
+uint64_t GetResidentMemory() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters = {};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.WorkingSetSize;
+    }
+    return 0;
+#elif defined(__APPLE__)
+    mach_task_basic_info info = {};
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) == KERN_SUCCESS) {
+        return info.resident_size;
+    }
+    return 0;
+#elif defined(__linux__)
+    // The second field of statm is the resident size, in pages.
+    std::ifstream statm("/proc/self/statm");
+    uint64_t size = 0, resident = 0;
+    if (statm >> size >> resident) {
+        return resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    }
+    return 0;
+#else
+    return 0;
+#endif
+}
+
+void PrintStartupReport(const StartupProfiler &profiler) {
+    std::cout << "Startup:\n";
+    for (const StartupPhase &phase : profiler.GetPhases()) {
+        std::cout << " - " << phase.Name << ": " << phase.Seconds * 1000.0 << " ms";
+        if (phase.ResidentBytes > 0) {
+            std::cout << " (" << phase.ResidentBytes / (1024 * 1024) << " MiB resident)";
+        }
+        std::cout << '\n';
+    }
+    for (const StartupPhase &milestone : profiler.GetMilestones()) {
+        std::cout << " - " << milestone.Name << " at " << milestone.StartSeconds * 1000.0 << " ms\n";
+    }
+}
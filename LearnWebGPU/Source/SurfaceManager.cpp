@@ -0,0 +1,195 @@
+#include "SurfaceManager.hpp"
+
+#include <webgpu/webgpu.h>
+
+#include <magic_enum/magic_enum.hpp>
+
+#include <iostream>
+
+namespace {
+    // How long the size must stay the same before the surface follows it.
+    constexpr std::chrono::milliseconds ResizeDebounce(50);
+}
+
+bool SurfaceManager::Initialize(WGPUDevice device, WGPUSurface surface, WGPUTextureFormat format, uint32_t width, uint32_t height, WGPUPresentMode presentMode) {
+    m_Device = device;
+    m_Surface = surface;
+
+    m_Config = {};
+    m_Config.nextInChain = nullptr;
+    m_Config.device = device;
+    m_Config.format = format;
+    m_Config.viewFormatCount = 0;
+    m_Config.viewFormats = nullptr;
+    // Screenshots are copied straight from the surface textures.
+    m_Config.usage = WGPUTextureUsage_RenderAttachment | WGPUTextureUsage_CopySrc;
+    m_Config.presentMode = presentMode;
+    m_Config.alphaMode = WGPUCompositeAlphaMode_Auto;
+
+    m_PendingWidth = width;
+    m_PendingHeight = height;
+    Configure(width, height);
+
+    return m_Configured;
+}
+
+void SurfaceManager::Terminate() {
+    if (m_Configured) {
+        wgpuSurfaceUnconfigure(m_Surface);
+        m_Configured = false;
+    }
+    m_ResizeCallbacks.clear();
+}
+
+void SurfaceManager::Resize(uint32_t width, uint32_t height) {
+    // Reporting the same size again must not restart the debounce timer.
+    if (width == m_PendingWidth && height == m_PendingHeight) {
+        return;
+    }
+    m_PendingWidth = width;
+    m_PendingHeight = height;
+    m_ResizePending = width != m_Config.width || height != m_Config.height || !m_Configured;
+    m_LastResizeEvent = Clock::now();
+}
+
+void SurfaceManager::AddResizeCallback(ResizeCallback callback) {
+    m_ResizeCallbacks.push_back(std::move(callback));
+}
+
+bool SurfaceManager::AcquireNextFrame(SurfaceFrame &frame) {
+    frame = {};
+
+    // Apply the latest window size once it has settled, or immediately if the
+    // surface told us during the previous frame that it must be reconfigured.
+    if (m_ResizePending && (m_ReconfigureRequired || Clock::now() - m_LastResizeEvent >= ResizeDebounce)) {
+        Configure(m_PendingWidth, m_PendingHeight);
+    } else if (m_ReconfigureRequired) {
+        Configure(m_Config.width, m_Config.height);
+    }
+
+    // Nothing to render to while the window is minimized.
+    if (!m_Configured) {
+        ++m_Stats.SkippedFrames;
+        return false;
+    }
+
+    WGPUSurfaceTexture surfaceTexture;
+    // Outdated and lost surfaces are recoverable within the same frame: we
+    // reconfigure and try once more before giving up on the frame.
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        wgpuSurfaceGetCurrentTexture(m_Surface, &surfaceTexture);
+
+        if (surfaceTexture.status == WGPUSurfaceGetCurrentTextureStatus_Success) {
+            break;
+        }
+
+        // Whatever happened, a texture we got along with an error is of no
+        // use and must not leak.
+        if (surfaceTexture.texture) {
+            wgpuTextureRelease(surfaceTexture.texture);
+            surfaceTexture.texture = nullptr;
+        }
+
+        switch (surfaceTexture.status) {
+            case WGPUSurfaceGetCurrentTextureStatus_Timeout:
+                // The presentation engine is busy, try again next frame.
+                ++m_Stats.Timeouts;
+                ++m_Stats.SkippedFrames;
+                return false;
+            case WGPUSurfaceGetCurrentTextureStatus_Outdated:
+                ++m_Stats.Outdated;
+                Configure(m_PendingWidth, m_PendingHeight);
+                break;
+            case WGPUSurfaceGetCurrentTextureStatus_Lost:
+                ++m_Stats.Lost;
+                Configure(m_PendingWidth, m_PendingHeight);
+                break;
+            default:
+                // Out of memory or device lost: there is nothing the surface can
+                // do about it.
+                std::cerr << "Could not acquire surface texture: "
+                          << magic_enum::enum_name<WGPUSurfaceGetCurrentTextureStatus>(surfaceTexture.status) << '\n';
+                ++m_Stats.SkippedFrames;
+                return false;
+        }
+
+        if (!m_Configured) {
+            break;
+        }
+    }
+
+    if (surfaceTexture.status != WGPUSurfaceGetCurrentTextureStatus_Success) {
+        ++m_Stats.SkippedFrames;
+        return false;
+    }
+
+    // A suboptimal texture can still be rendered to and presented, we just
+    // reconfigure before the next one.
+    if (surfaceTexture.suboptimal) {
+        ++m_Stats.Suboptimal;
+        m_ReconfigureRequired = true;
+    }
+
+    WGPUTextureViewDescriptor viewDescriptor;
+    viewDescriptor.nextInChain = nullptr;
+    viewDescriptor.label = "Surface texture view";
+    viewDescriptor.format = wgpuTextureGetFormat(surfaceTexture.texture);
+    viewDescriptor.dimension = WGPUTextureViewDimension_2D;
+    viewDescriptor.baseMipLevel = 0;
+    viewDescriptor.mipLevelCount = 1;
+    viewDescriptor.baseArrayLayer = 0;
+    viewDescriptor.arrayLayerCount = 1;
+    viewDescriptor.aspect = WGPUTextureAspect_All;
+
+    frame.Texture.Reset(surfaceTexture.texture);
+    frame.View.Reset(wgpuTextureCreateView(surfaceTexture.texture, &viewDescriptor));
+    frame.Width = m_Config.width;
+    frame.Height = m_Config.height;
+
+    ++m_Stats.AcquiredFrames;
+    return true;
+}
+
+void SurfaceManager::Present(SurfaceFrame &frame) {
+    frame.View.Reset();
+    wgpuSurfacePresent(m_Surface);
+    frame = {};
+}
+
+void SurfaceManager::Configure(uint32_t width, uint32_t height) {
+    m_ResizePending = false;
+    m_ReconfigureRequired = false;
+
+    // A surface cannot be configured with a zero size, which is what we get
+    // while the window is minimized.
+    if (width == 0 || height == 0) {
+        if (m_Configured) {
+            wgpuSurfaceUnconfigure(m_Surface);
+            m_Configured = false;
+        }
+        return;
+    }
+
+    const bool sizeChanged = width != m_Config.width || height != m_Config.height;
+
+    m_Config.width = width;
+    m_Config.height = height;
+    wgpuSurfaceConfigure(m_Surface, &m_Config);
+    m_Configured = true;
+    ++m_Stats.Reconfigurations;
+
+    if (sizeChanged) {
+        for (const ResizeCallback &callback : m_ResizeCallbacks) {
+            callback(width, height);
+        }
+    }
+}
+
+void PrintSurfaceStats(const SurfaceStats &stats) {
+    std::cout << "Surface:\n";
+    std::cout << " - acquired frames: " << stats.AcquiredFrames << '\n';
+    std::cout << " - skipped frames: " << stats.SkippedFrames << '\n';
+    std::cout << " - reconfigurations: " << stats.Reconfigurations << '\n';
+    std::cout << " - timeouts: " << stats.Timeouts << ", outdated: " << stats.Outdated
+              << ", lost: " << stats.Lost << ", suboptimal: " << stats.Suboptimal << '\n';
+}
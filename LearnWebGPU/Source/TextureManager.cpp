@@ -0,0 +1,237 @@
+#include "TextureManager.hpp"
+
+#include <webgpu/webgpu.h>
+
+#include <chrono>
+#include <iostream>
+#include <utility>
+
+#include "FileLoader.hpp"
+
+namespace {
+    // Filtering happens on linear colors when sampling through this view.
+    constexpr WGPUTextureFormat SampledFormat = WGPUTextureFormat_RGBA8UnormSrgb;
+}
+
+bool TextureManager::Initialize(WGPUDevice device, WGPUQueue queue, ShaderCache &shaderCache, GpuMemoryTracker &memory, ThreadPool &workers) {
+    m_Device = device;
+    m_Queue = queue;
+    m_Memory = &memory;
+    m_Workers = &workers;
+
+    WGPUSupportedLimits supportedLimits = {};
+    supportedLimits.nextInChain = nullptr;
+    wgpuDeviceGetLimits(device, &supportedLimits);
+    m_MaxDimension = supportedLimits.limits.maxTextureDimension2D;
+
+    return m_Mipmaps.Initialize(device, shaderCache);
+}
+
+void TextureManager::Terminate() {
+    {
+        std::unique_lock lock(m_Mutex);
+        m_Decoded.wait(lock, [this] { return m_PendingDecodes == 0; });
+        m_DecodedImages.clear();
+    }
+
+    if (m_Memory) {
+        for (TextureId id = 0; id < m_Textures.size(); ++id) {
+            Release(id);
+        }
+    }
+    m_Textures.clear();
+    m_Mipmaps.Terminate();
+}
+
+TextureId TextureManager::Load(const std::string &path) {
+    const auto id = static_cast<TextureId>(m_Textures.size());
+    m_Textures.emplace_back().Name = path;
+
+    {
+        std::lock_guard lock(m_Mutex);
+        ++m_Stats.Requested;
+        ++m_PendingDecodes;
+    }
+
+    m_Workers->Submit([this, id, path] {
+        const auto start = std::chrono::steady_clock::now();
+        DecodedImage image;
+        image.Id = id;
+        if (!LoadImagePPM(path, image.Width, image.Height, image.Pixels)) {
+            std::cerr << "Could not load texture " << path << '\n';
+            image.Pixels.clear();
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        {
+            std::lock_guard lock(m_Mutex);
+            m_Stats.DecodeSeconds += seconds;
+            m_DecodedImages.push_back(std::move(image));
+        }
+        if (m_OnDecoded) {
+            m_OnDecoded(id);
+        }
+
+        // Last, so that Terminate() cannot return while the callback runs.
+        {
+            std::lock_guard lock(m_Mutex);
+            --m_PendingDecodes;
+        }
+        m_Decoded.notify_all();
+    });
+
+    return id;
+}
+
+TextureId TextureManager::Create(WGPUCommandEncoder encoder, const std::string &name, uint32_t width, uint32_t height, const uint8_t *pixels) {
+    const auto id = static_cast<TextureId>(m_Textures.size());
+    m_Textures.emplace_back().Name = name;
+
+    {
+        std::lock_guard lock(m_Mutex);
+        ++m_Stats.Requested;
+    }
+
+    if (!Upload(encoder, id, width, height, pixels)) {
+        std::lock_guard lock(m_Mutex);
+        ++m_Stats.Failed;
+        return InvalidTextureId;
+    }
+    return id;
+}
+
+uint32_t TextureManager::Update(WGPUCommandEncoder encoder) {
+    std::vector<DecodedImage> images;
+    {
+        std::lock_guard lock(m_Mutex);
+        images.swap(m_DecodedImages);
+    }
+
+    uint32_t readyCount = 0;
+    for (const DecodedImage &image : images) {
+        if (m_Textures[image.Id].Released) {
+            continue;
+        }
+        if (image.Pixels.empty() || !Upload(encoder, image.Id, image.Width, image.Height, image.Pixels.data())) {
+            std::lock_guard lock(m_Mutex);
+            ++m_Stats.Failed;
+            continue;
+        }
+        ++readyCount;
+    }
+    return readyCount;
+}
+
+void TextureManager::WaitForDecodes() {
+    std::unique_lock lock(m_Mutex);
+    m_Decoded.wait(lock, [this] { return m_PendingDecodes == 0; });
+}
+
+void TextureManager::Release(TextureId id) {
+    Entry &entry = m_Textures[id];
+    entry.View.Reset();
+    m_Memory->Release(entry.Texture);
+    entry.Released = true;
+}
+
+WGPUTextureView TextureManager::GetView(TextureId id) const {
+    return id < m_Textures.size() ? m_Textures[id].View.Get() : nullptr;
+}
+
+WGPUTexture TextureManager::GetTexture(TextureId id) const {
+    return id < m_Textures.size() ? m_Textures[id].Texture.Get() : nullptr;
+}
+
+TextureStats TextureManager::GetStats() const {
+    std::lock_guard lock(m_Mutex);
+    return m_Stats;
+}
+
+bool TextureManager::Upload(WGPUCommandEncoder encoder, TextureId id, uint32_t width, uint32_t height, const uint8_t *pixels) {
+    const auto start = std::chrono::steady_clock::now();
+    Entry &entry = m_Textures[id];
+
+    if (width > m_MaxDimension || height > m_MaxDimension) {
+        std::cerr << "Texture " << entry.Name << " is too large (" << width << 'x' << height
+                  << ", the device supports up to " << m_MaxDimension << ")!\n";
+        return false;
+    }
+
+    const uint32_t levelCount = GetMipLevelCount(width, height);
+
+    WGPUTextureDescriptor textureDesc = {};
+    textureDesc.nextInChain = nullptr;
+    textureDesc.label = entry.Name.c_str();
+    textureDesc.dimension = WGPUTextureDimension_2D;
+    textureDesc.format = MipmapGenerator::Format;
+    textureDesc.mipLevelCount = levelCount;
+    textureDesc.sampleCount = 1;
+    textureDesc.size = { width, height, 1 };
+    // Levels are generated through storage views, and can be read back to
+    // check them.
+    textureDesc.usage = WGPUTextureUsage_TextureBinding | WGPUTextureUsage_StorageBinding | WGPUTextureUsage_CopyDst | WGPUTextureUsage_CopySrc;
+    textureDesc.viewFormatCount = 1;
+    textureDesc.viewFormats = &SampledFormat;
+    entry.Texture = m_Memory->CreateTexture(m_Device, textureDesc, GpuMemoryCategory_Texture);
+    if (!entry.Texture) {
+        std::cerr << "Could not create texture " << entry.Name << '\n';
+        return false;
+    }
+
+    // Unlike copies from a buffer, writes have no 256 bytes row pitch to
+    // honor: rows stay tightly packed, and the implementation pads them in
+    // its own staging memory. The write happens before the commands of the
+    // next submission, so before the mip generation recorded below.
+    WGPUImageCopyTexture destination = {};
+    destination.nextInChain = nullptr;
+    destination.texture = entry.Texture;
+    destination.mipLevel = 0;
+    destination.origin = { 0, 0, 0 };
+    destination.aspect = WGPUTextureAspect_All;
+
+    WGPUTextureDataLayout source = {};
+    source.nextInChain = nullptr;
+    source.offset = 0;
+    source.bytesPerRow = 4 * width;
+    source.rowsPerImage = height;
+
+    const WGPUExtent3D size = { width, height, 1 };
+    const size_t byteSize = size_t{ width } * height * 4;
+    wgpuQueueWriteTexture(m_Queue, &destination, pixels, byteSize, &source, &size);
+
+    const uint32_t levelsGenerated = m_Mipmaps.Generate(encoder, entry.Texture);
+
+    WGPUTextureViewDescriptor viewDesc = {};
+    viewDesc.nextInChain = nullptr;
+    viewDesc.label = entry.Name.c_str();
+    viewDesc.format = SampledFormat;
+    viewDesc.dimension = WGPUTextureViewDimension_2D;
+    viewDesc.baseMipLevel = 0;
+    viewDesc.mipLevelCount = levelCount;
+    viewDesc.baseArrayLayer = 0;
+    viewDesc.arrayLayerCount = 1;
+    viewDesc.aspect = WGPUTextureAspect_All;
+    entry.View.Reset(wgpuTextureCreateView(entry.Texture, &viewDesc));
+    entry.Width = width;
+    entry.Height = height;
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::lock_guard lock(m_Mutex);
+    ++m_Stats.Loaded;
+    m_Stats.BytesUploaded += byteSize;
+    m_Stats.MipLevelsGenerated += levelsGenerated;
+    m_Stats.UploadSeconds += seconds;
+    return true;
+}
+
+void PrintTextureStats(const TextureStats &stats, const SamplerCacheStats &samplerStats) {
+    std::cout << "Textures:\n";
+    std::cout << " - loaded: " << stats.Loaded << " / " << stats.Requested << " (" << stats.Failed << " failures, "
+              << stats.BytesUploaded / (1024.0 * 1024.0) << " MiB uploaded, "
+              << stats.MipLevelsGenerated << " mip levels generated)\n";
+    if (stats.Loaded > 0) {
+        std::cout << " - decoding: " << stats.DecodeSeconds * 1000.0 << " ms on the workers, upload: "
+                  << stats.UploadSeconds / stats.Loaded * 1000.0 << " ms per texture\n";
+    }
+    std::cout << " - samplers: " << samplerStats.SamplersCreated << " for " << samplerStats.Requests << " requests\n";
+}
@@ -0,0 +1,117 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+ThreadPool::~ThreadPool() {
+    Stop();
+}
+
+void ThreadPool::Start(uint32_t threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency() - 1);
+    }
+
+    m_Stopping = false;
+    m_Threads.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; ++i) {
+        m_Threads.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+void ThreadPool::Stop() {
+    {
+        std::lock_guard lock(m_Mutex);
+        m_Stopping = true;
+    }
+    m_JobAvailable.notify_all();
+
+    for (std::thread &thread : m_Threads) {
+        thread.join();
+    }
+    m_Threads.clear();
+}
+
+void ThreadPool::Submit(Job job) {
+    {
+        std::lock_guard lock(m_Mutex);
+        m_Jobs.push_back(std::move(job));
+    }
+    m_JobAvailable.notify_one();
+}
+
+void ThreadPool::Wait() {
+    std::unique_lock lock(m_Mutex);
+    m_JobsDone.wait(lock, [this] { return m_Jobs.empty() && m_ActiveJobs == 0; });
+}
+
+void ThreadPool::ParallelFor(uint32_t count, uint32_t grainSize, const RangeJob &job) {
+    if (count == 0) {
+        return;
+    }
+
+    grainSize = std::max(grainSize, 1u);
+    const uint32_t rangeCount = (count + grainSize - 1) / grainSize;
+
+    // Shared with the helper jobs, which may only start running after we
+    // have returned if the workers are busy with something else.
+    struct State {
+        std::atomic<uint32_t> NextRange = 0;
+        std::atomic<uint32_t> DoneRanges = 0;
+    };
+    auto state = std::make_shared<State>();
+
+    // A helper that starts too late finds no range left and never touches
+    // the job, which is only guaranteed to live until we return.
+    auto work = [state, count, grainSize, rangeCount, &job] {
+        uint32_t range;
+        while ((range = state->NextRange.fetch_add(1)) < rangeCount) {
+            const uint32_t begin = range * grainSize;
+            job(begin, std::min(begin + grainSize, count));
+            if (state->DoneRanges.fetch_add(1) + 1 == rangeCount) {
+                state->DoneRanges.notify_all();
+            }
+        }
+    };
+
+    const uint32_t helperCount = std::min(GetThreadCount(), rangeCount - 1);
+    for (uint32_t i = 0; i < helperCount; ++i) {
+        Submit(work);
+    }
+
+    work();
+
+    uint32_t done;
+    while ((done = state->DoneRanges.load()) < rangeCount) {
+        state->DoneRanges.wait(done);
+    }
+}
+
+void ThreadPool::WorkerLoop() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock lock(m_Mutex);
+            m_JobAvailable.wait(lock, [this] { return m_Stopping || !m_Jobs.empty(); });
+            // Queued jobs are still run when stopping, only an empty queue
+            // ends the worker.
+            if (m_Jobs.empty()) {
+                return;
+            }
+            job = std::move(m_Jobs.front());
+            m_Jobs.pop_front();
+            ++m_ActiveJobs;
+        }
+
+        job();
+
+        {
+            std::lock_guard lock(m_Mutex);
+            --m_ActiveJobs;
+            if (m_Jobs.empty() && m_ActiveJobs == 0) {
+                m_JobsDone.notify_all();
+            }
+        }
+    }
+}
@@ -0,0 +1,205 @@
+#include "TransformHierarchy.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+namespace {
+    // Apply a permutation (newIndex -> oldIndex) to one of the arrays.
+    template<typename T>
+    void Permute(std::vector<T> &values, const std::vector<uint32_t> &order) {
+        std::vector<T> permuted(values.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            permuted[i] = values[order[i]];
+        }
+        values.swap(permuted);
+    }
+}
+
+void TransformHierarchy::Clear() {
+    m_Parents.clear();
+    m_Depths.clear();
+    m_Local.clear();
+    m_World.clear();
+    m_Dirty.clear();
+    m_PositionToNode.clear();
+    m_NodeToPosition.clear();
+    m_LevelStarts.clear();
+    m_Sorted = true;
+    m_AnyDirty = false;
+}
+
+void TransformHierarchy::Reserve(uint32_t count) {
+    m_Parents.reserve(count);
+    m_Depths.reserve(count);
+    m_Local.reserve(count);
+    m_World.reserve(count);
+    m_Dirty.reserve(count);
+    m_PositionToNode.reserve(count);
+    m_NodeToPosition.reserve(count);
+}
+
+TransformNode TransformHierarchy::AddNode(TransformNode parent, const Matrix4 &local) {
+    assert(parent == InvalidTransformNode || parent < m_NodeToPosition.size());
+
+    const auto node = static_cast<TransformNode>(m_NodeToPosition.size());
+    const auto position = static_cast<uint32_t>(m_Parents.size());
+
+    uint32_t parentPosition = NoParent;
+    uint32_t depth = 0;
+    if (parent != InvalidTransformNode) {
+        parentPosition = m_NodeToPosition[parent];
+        depth = m_Depths[parentPosition] + 1;
+    }
+
+    // Appending keeps the arrays sorted as long as depths never decrease.
+    if (m_Sorted) {
+        const uint32_t lastDepth = m_Depths.empty() ? 0 : m_Depths.back();
+        if (m_Depths.empty() || depth > lastDepth) {
+            // A new level starts where the last one ends. It cannot skip a
+            // level since the parent is at most at the last depth.
+            if (m_LevelStarts.empty()) {
+                m_LevelStarts.push_back(0);
+            }
+            m_LevelStarts.push_back(position + 1);
+        } else if (depth == lastDepth) {
+            m_LevelStarts.back() = position + 1;
+        } else {
+            m_Sorted = false;
+        }
+    }
+
+    m_Parents.push_back(parentPosition);
+    m_Depths.push_back(depth);
+    m_Local.push_back(local);
+    m_World.emplace_back();
+    m_Dirty.push_back(1);
+    m_PositionToNode.push_back(node);
+    m_NodeToPosition.push_back(position);
+    m_AnyDirty = true;
+
+    return node;
+}
+
+void TransformHierarchy::SetLocal(TransformNode node, const Matrix4 &local) {
+    const uint32_t position = m_NodeToPosition[node];
+    m_Local[position] = local;
+    m_Dirty[position] = 1;
+    m_AnyDirty = true;
+}
+
+uint32_t TransformHierarchy::Update() {
+    const auto start = std::chrono::steady_clock::now();
+
+    if (!m_Sorted) {
+        SortByDepth();
+    }
+
+    uint32_t recomputed = 0;
+    if (m_AnyDirty) {
+        // Levels are processed in order, so that parents are up to date (and
+        // their dirty flag propagated) before their children are looked at.
+        for (size_t level = 0; level + 1 < m_LevelStarts.size(); ++level) {
+            const uint32_t begin = m_LevelStarts[level];
+            const uint32_t end = m_LevelStarts[level + 1];
+
+            if (m_Workers && end - begin > GrainSize) {
+                std::atomic<uint32_t> levelRecomputed = 0;
+                m_Workers->ParallelFor(end - begin, GrainSize, [&](uint32_t jobBegin, uint32_t jobEnd) {
+                    levelRecomputed += UpdateRange(begin + jobBegin, begin + jobEnd);
+                });
+                recomputed += levelRecomputed.load();
+            } else {
+                recomputed += UpdateRange(begin, end);
+            }
+        }
+
+        // Children read the flags of their parents, so they can only be
+        // cleared once every level is done.
+        std::memset(m_Dirty.data(), 0, m_Dirty.size());
+        m_AnyDirty = false;
+    }
+
+    m_Stats.Nodes = GetNodeCount();
+    m_Stats.Levels = m_LevelStarts.empty() ? 0 : static_cast<uint32_t>(m_LevelStarts.size() - 1);
+    m_Stats.Recomputed = recomputed;
+    m_Stats.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return recomputed;
+}
+
+uint32_t TransformHierarchy::UpdateRange(uint32_t begin, uint32_t end) {
+    uint32_t recomputed = 0;
+    for (uint32_t i = begin; i < end; ++i) {
+        const uint32_t parent = m_Parents[i];
+        if (parent == NoParent) {
+            if (m_Dirty[i]) {
+                m_World[i] = m_Local[i];
+                ++recomputed;
+            }
+            continue;
+        }
+
+        // A moved parent moves the whole subtree.
+        m_Dirty[i] |= m_Dirty[parent];
+        if (m_Dirty[i]) {
+            MultiplyMatrices(m_World[parent], m_Local[i], m_World[i]);
+            ++recomputed;
+        }
+    }
+    return recomputed;
+}
+
+void TransformHierarchy::SortByDepth() {
+    const auto count = static_cast<uint32_t>(m_Parents.size());
+    const uint32_t maxDepth = count == 0 ? 0 : *std::max_element(m_Depths.begin(), m_Depths.end());
+
+    // Counting sort on depth: stable, so siblings keep their relative order.
+    m_LevelStarts.assign(maxDepth + 2, 0);
+    for (uint32_t depth : m_Depths) {
+        ++m_LevelStarts[depth + 1];
+    }
+    for (size_t level = 1; level < m_LevelStarts.size(); ++level) {
+        m_LevelStarts[level] += m_LevelStarts[level - 1];
+    }
+
+    std::vector<uint32_t> order(count);
+    std::vector<uint32_t> next(m_LevelStarts.begin(), m_LevelStarts.end() - 1);
+    for (uint32_t position = 0; position < count; ++position) {
+        order[next[m_Depths[position]]++] = position;
+    }
+
+    // Parents store positions, which all move.
+    std::vector<uint32_t> newPositions(count);
+    for (uint32_t position = 0; position < count; ++position) {
+        newPositions[order[position]] = position;
+    }
+    for (uint32_t &parent : m_Parents) {
+        if (parent != NoParent) {
+            parent = newPositions[parent];
+        }
+    }
+
+    Permute(m_Parents, order);
+    Permute(m_Depths, order);
+    Permute(m_Local, order);
+    Permute(m_World, order);
+    Permute(m_Dirty, order);
+    Permute(m_PositionToNode, order);
+
+    for (uint32_t position = 0; position < count; ++position) {
+        m_NodeToPosition[m_PositionToNode[position]] = position;
+    }
+
+    m_Sorted = true;
+    ++m_Stats.Rebuilds;
+}
+
+void PrintTransformStats(const TransformStats &stats) {
+    std::cout << "Transforms:\n";
+    std::cout << " - nodes: " << stats.Nodes << " in " << stats.Levels << " levels\n";
+    std::cout << " - last update: " << stats.Recomputed << " matrices recomputed in " << stats.Seconds * 1000.0 << " ms\n";
+    std::cout << " - depth re-sorts: " << stats.Rebuilds << '\n';
+}
@@ -0,0 +1,49 @@
+#include "WebGPUHandles.hpp"
+
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+#ifdef LEARNWEBGPU_TRACK_HANDLES
+namespace {
+    // Function-local statics so that counters registering themselves during
+    // static initialization always find the list constructed.
+    std::mutex &RegistryMutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    std::vector<HandleCounter *> &Registry() {
+        static std::vector<HandleCounter *> registry;
+        return registry;
+    }
+}
+
+HandleCounter::HandleCounter(const char *name) : Name(name) {
+    std::lock_guard lock(RegistryMutex());
+    Registry().push_back(this);
+}
+
+int64_t ReportLeakedHandles() {
+    std::lock_guard lock(RegistryMutex());
+
+    int64_t total = 0;
+    for (const HandleCounter *counter : Registry()) {
+        const int64_t alive = counter->Created.load() - counter->Released.load();
+        if (alive != 0) {
+            std::cerr << "Leaked " << counter->Name << ": " << alive
+                      << " (" << counter->Created.load() << " created)\n";
+        }
+        total += alive;
+    }
+
+    if (total == 0) {
+        std::cout << "No leaked WebGPU objects.\n";
+    }
+    return total;
+}
+#else
+int64_t ReportLeakedHandles() {
+    return 0;
+}
+#endif
@@ -1,17 +1,42 @@
 #include "Application.hpp"
+#include "StartupProfiler.hpp"
+#include "WebGPUHandles.hpp"
+
+int main(int argc, char **argv) {
+    // Startup phases are timed from here.
+    StartupProfiler startup;
+
+    AppOptions options;
+    if (!ParseOptions(argc, argv, options)) {
+        return 1;
+    }
+    startup.EndPhase("options");
 
-int main() {
     Application app;
 
-    if (!app.Initialize()) {
+    if (!app.Initialize(options, startup)) {
         return 1;
     }
 
-    while (app.IsRunning()) {
-        app.MainLoop();
+    int result = 0;
+    if (!options.BatchPath.empty()) {
+        result = app.RunBatch();
+    } else {
+        while (app.IsRunning()) {
+            app.MainLoop();
+        }
     }
 
     app.Terminate();
 
-    return 0;
+    if (!options.StartupReportPath.empty()) {
+        startup.WriteReport(options.StartupReportPath);
+    }
+
+    // Every handle owned through a wrapper must have been released by now.
+    if (ReportLeakedHandles() != 0) {
+        return 1;
+    }
+
+    return result;
 }
@@ -11,6 +11,12 @@ add_rules("plugin.vsxmake.autoupdate")
 set_languages("cxx20")
 set_optimize("fastest")
 
+-- Debug builds count every WebGPU object owned through a Handle and report
+-- the ones still alive at shutdown.
+if is_mode("debug") then
+    add_defines("LEARNWEBGPU_TRACK_HANDLES")
+end
+
 add_requires("glfw", "wgpu-native", "glfw3webgpu")
 
 local outputdir = "$(mode)-$(os)-$(arch)"
@@ -37,4 +43,27 @@ target("LearnWebGPU")
     
     add_headerfiles("LearnWebGPU/Resources/**")
 
-    add_packages("glfw", "wgpu-native", "glfw3webgpu")
\ No newline at end of file
+    add_packages("glfw", "wgpu-native", "glfw3webgpu")
+    -- GetProcessMemoryInfo, for the startup report.
+    add_syslinks("psapi")
+
+-- Benchmarks, run with the names of the ones to run (all by default).
+target("LearnWebGPU-bench")
+    set_kind("binary")
+
+    set_targetdir("build/" .. outputdir .. "/LearnWebGPU-bench/bin")
+    set_objectdir("build/" .. outputdir .. "/LearnWebGPU-bench/obj")
+
+    -- Everything from the application but its entry point.
+    add_files("LearnWebGPU/Bench/**.cpp", "LearnWebGPU/Source/**.cpp|main.cpp")
+    add_includedirs("LearnWebGPU/Include")
+    add_headerfiles("LearnWebGPU/Bench/**.hpp")
+
+    add_packages("glfw", "wgpu-native", "glfw3webgpu")
+    -- GetProcessMemoryInfo, for the startup report.
+    add_syslinks("psapi")
+
+    -- The kernel benchmark loads its shaders from there, like the application.
+    after_build(function (target)
+        os.cp("LearnWebGPU/Resources", target:targetdir())
+    end)